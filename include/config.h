@@ -9,13 +9,42 @@
  #ifndef CONFIG_H
  #define CONFIG_H
  
+ /* Pool limits sized exactly by the configuration compiler (tools/sysgen) */
+ #ifdef USE_SYSCONF
+ #include "sysconf_gen_limits.h"
+ #endif
+ 
  /* System capacity limits */
+ #ifndef MAX_TASKS
  #define MAX_TASKS                32      /* Maximum number of tasks in the system */
+ #endif
  #define MAX_PRIORITY_LEVELS      16      /* Number of priority levels supported */
+ #ifndef MAX_SEMAPHORES
  #define MAX_SEMAPHORES           16      /* Maximum number of semaphores */
+ #endif
+ #ifndef MAX_QUEUES
  #define MAX_QUEUES               16      /* Maximum number of message queues */
+ #endif
  #define MAX_QUEUE_SIZE           32      /* Maximum size of each message queue */
  #define MAX_TASK_NAME_LEN        16      /* Maximum length of task name */
+ #define MAX_WORKQUEUES           4       /* Maximum number of work queues */
+ #define MAX_RATELIMITS           8       /* Maximum number of rate limiters */
+ #define MAX_TIMETAG_TABLES       2       /* Maximum number of time-tag tables */
+ #ifndef MAX_CHAINS
+ #define MAX_CHAINS               4       /* Maximum number of cause-effect chains */
+ #endif
+ #define CHAIN_MAX_STAGES         8       /* Tasks per cause-effect chain */
+ #define CHAIN_HIST_BINS          32      /* Latency histogram bins per chain */
+ #define CHAIN_HIST_BIN_US        1000    /* Bin width for chains without a deadline */
+ #ifndef MAX_LET_VARS
+ #define MAX_LET_VARS             16      /* Maximum number of LET variables */
+ #endif
+ #ifndef MAX_LET_BINDINGS
+ #define MAX_LET_BINDINGS         32      /* LET task inputs and outputs, all variables */
+ #endif
+ #define MAX_SDF_GRAPHS           2       /* Maximum number of dataflow graphs */
+ #define SDF_MAX_ACTORS           8       /* Actors per dataflow graph */
+ #define SDF_MAX_EDGES            12      /* Edges per dataflow graph */
  
  /* Time parameters */
  #define SYSTEM_TICK_MS           10      /* System tick in milliseconds */
@@ -24,6 +53,13 @@
  #define DEFAULT_TIME_SLICE       10      /* Default time slice in system ticks */
  #define MAX_TIMEOUT              0xFFFFFFFF
  
+ /* Memory parameters */
+ #define KERNEL_HEAP_SIZE         (256 * 1024) /* TLSF heap pool for stacks, queues and tasks */
+ #define BASIC_TASK_MAX_ACTIVATIONS 4     /* Queued activations per basic task */
+ #define ENABLE_KERNEL_ARENA      0       /* Place TCBs and the heap pool in a huge-page arena */
+ #define ARENA_HUGE_PAGE_SIZE     (2 * 1024 * 1024) /* Host huge page size */
+ #define CACHE_LINE_SIZE          64      /* Host cache line size */
+ 
  /* Scheduling policies */
  #define SCHEDULING_POLICY_PRIORITY   0   /* Priority-based scheduling */
  #define SCHEDULING_POLICY_RR         1   /* Round-robin scheduling */
@@ -40,6 +76,11 @@
  #define SIMULATE_JITTER          0       /* Simulate timing jitter */
  #define JITTER_MAX_PCT           5       /* Maximum jitter percentage */
  #define LOG_BUFFER_SIZE          4096    /* Size of the logging buffer */
+ #define ENABLE_RECORDER          0       /* Record statistics time series to a file */
+ #define ENABLE_TRACE             0       /* Record kernel events for trace_analyze */
+ #define ENABLE_SEQUENCER         1       /* Run stored command sequences */
+ #define ENABLE_RTA               1       /* Keep response-time analysis of periodic tasks current */
+ #define ENABLE_LET               1       /* Logical execution time communication (kernel/let.h) */
  
  /* Visualization options */
  #define ENABLE_VISUALIZATION     1       /* Enable console visualization */
@@ -55,4 +96,14 @@
  #define SIMULATE_RADIATION_EFFECTS 0     /* Simulate radiation-induced errors */
  #define SIMULATE_POWER_CONSTRAINTS 0     /* Simulate power limitations */
  
+ /* Host real-time execution (see drivers/hostrt.h) */
+ #define ENABLE_HOST_RT           0       /* Lock memory, pin threads and run under SCHED_FIFO */
+ #define HOST_PAGE_SIZE           4096    /* Prefault stride in bytes */
+ #define HOST_RT_TICK_CPU         1       /* CPU for the tick thread (-1 = no pinning) */
+ #define HOST_RT_SIM_CPU          2       /* CPU for the simulator thread (-1 = no pinning) */
+ #define HOST_RT_TICK_PRIORITY    80      /* SCHED_FIFO priority of the tick thread */
+ #define HOST_RT_SIM_PRIORITY     70      /* SCHED_FIFO priority of the simulator thread */
+ #define HOST_RT_STACK_PREFAULT   (512 * 1024) /* Host thread stack bytes to prefault */
+ #define HOST_RT_SELFCHECK_MS     2000    /* Jitter self-check duration (0 = skip) */
+ 
  #endif /* CONFIG_H */
\ No newline at end of file
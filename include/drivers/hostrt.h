@@ -0,0 +1,110 @@
+/**
+ * @file hostrt.h
+ * @brief Host real-time execution mode
+ *
+ * This file defines a startup mode that makes the simulator's timing
+ * trustworthy on a Linux host. It locks memory, prefaults task stacks,
+ * queue buffers and the kernel heap, pins the tick and simulator
+ * threads to (ideally isolated) CPUs and runs them under SCHED_FIFO. A
+ * self-check then measures the host wakeup jitter that is left, so
+ * deadline misses smaller than it can be recognized as host noise.
+ *
+ * The tick thread is created by timer_init() and inherits the
+ * scheduling policy and CPU affinity of its creator. Call
+ * hostrt_init() before timer_init() so the tick thread starts with the
+ * tick settings, then hostrt_set_role(HOSTRT_ROLE_SIMULATOR) so the
+ * simulator thread moves to its own CPU and priority.
+ */
+
+ #ifndef HOSTRT_H
+ #define HOSTRT_H
+
+ #include <stdint.h>
+ #include "../config.h"
+
+ /* Thread roles */
+ typedef enum {
+     HOSTRT_ROLE_TICK,            /* Timer thread driving the system tick */
+     HOSTRT_ROLE_SIMULATOR        /* Thread running the scheduler and tasks */
+ } hostrt_role_t;
+
+ /* Host real-time configuration */
+ typedef struct {
+     uint8_t lock_memory;         /* mlockall current and future mappings */
+     int tick_cpu;                /* CPU for the tick thread (-1 = no pinning) */
+     int sim_cpu;                 /* CPU for the simulator thread (-1 = no pinning) */
+     int tick_priority;           /* SCHED_FIFO priority of the tick thread (0 = leave policy) */
+     int sim_priority;            /* SCHED_FIFO priority of the simulator thread (0 = leave policy) */
+     uint32_t stack_prefault;     /* Host thread stack bytes to prefault */
+     uint32_t selfcheck_ms;       /* Jitter self-check duration (0 = skip) */
+     uint32_t jitter_limit_us;    /* Wakeup latency above which a wakeup counts as late */
+ } hostrt_config_t;
+
+ /* Default host real-time configuration */
+ #define HOSTRT_CONFIG_DEFAULT { 1, HOST_RT_TICK_CPU, HOST_RT_SIM_CPU, \
+                                 HOST_RT_TICK_PRIORITY, HOST_RT_SIM_PRIORITY, \
+                                 HOST_RT_STACK_PREFAULT, HOST_RT_SELFCHECK_MS, \
+                                 MILLISECONDS_PER_TICK * 100 }
+
+ /* What was achieved, and the residual jitter measured by the self-check */
+ typedef struct {
+     uint8_t memory_locked;       /* mlockall succeeded */
+     uint8_t tick_pinned;         /* Tick thread affinity applied */
+     uint8_t sim_pinned;          /* Simulator thread affinity applied */
+     uint8_t tick_fifo;           /* Tick thread runs under SCHED_FIFO */
+     uint8_t sim_fifo;            /* Simulator thread runs under SCHED_FIFO */
+     uint32_t prefaulted_bytes;   /* Bytes touched by hostrt_prefault() */
+     uint32_t samples;            /* Self-check wakeups */
+     uint32_t latency_min_us;     /* Wakeup latency statistics */
+     uint32_t latency_avg_us;
+     uint32_t latency_p99_us;
+     uint32_t latency_max_us;
+     uint32_t late_wakeups;       /* Wakeups later than jitter_limit_us */
+     uint32_t page_faults;        /* Page faults during the self-check */
+ } hostrt_status_t;
+
+ /**
+  * @brief Enter host real-time mode
+  * Locks memory and applies the tick role to the calling thread, so
+  * threads it creates next (the tick thread) inherit it. Missing
+  * privileges are reported as warnings and recorded in the status.
+  *
+  * @param config Host real-time configuration
+  * @return int 0 on success, negative error code on failure
+  */
+ int hostrt_init(const hostrt_config_t* config);
+
+ /**
+  * @brief Apply a role's CPU affinity and priority to the calling thread
+  *
+  * @param role Thread role
+  * @return int 0 on success, negative error code on failure
+  */
+ int hostrt_set_role(hostrt_role_t role);
+
+ /**
+  * @brief Prefault task stacks, queue buffers, the heap and the host stack
+  * Call after all tasks and queues are created, before the scheduler starts
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int hostrt_prefault(void);
+
+ /**
+  * @brief Measure residual host wakeup jitter on the calling thread
+  * Sleeps to absolute 1 ms deadlines for the configured duration
+  *
+  * @return int 0 if no wakeup exceeded the jitter limit, 1 if some did,
+  *             negative error code on failure
+  */
+ int hostrt_selfcheck(void);
+
+ /**
+  * @brief Get host real-time status
+  *
+  * @param status Pointer to status structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int hostrt_get_status(hostrt_status_t* status);
+
+ #endif /* HOSTRT_H */
@@ -0,0 +1,83 @@
+/**
+ * @file arena.h
+ * @brief Huge-page-backed kernel arena
+ *
+ * This file defines an optional arena that holds all task control
+ * blocks and the kernel heap pool (task stacks, queue buffers) in one
+ * region backed by huge pages. Scheduler walks over thousands of TCBs
+ * then touch a handful of TLB entries instead of one per 4 KB page.
+ *
+ * TCBs live in a slab of fixed slots. The slot stride is an odd number
+ * of cache lines, so the first line of each TCB (state, priority, time
+ * slice, context), which every scheduler pass reads, cycles through all
+ * cache sets instead of piling onto a few.
+ */
+
+ #ifndef ARENA_H
+ #define ARENA_H
+
+ #include <stdint.h>
+ #include "task.h"
+ #include "../config.h"
+
+ /* How the arena is backed */
+ typedef enum {
+     ARENA_BACKING_NONE,          /* Arena not mapped */
+     ARENA_BACKING_EXPLICIT,      /* Reserved huge pages (MAP_HUGETLB) */
+     ARENA_BACKING_TRANSPARENT,   /* Huge-page-aligned, transparent huge pages advised */
+     ARENA_BACKING_SMALL          /* Regular pages (no huge page support) */
+ } arena_backing_t;
+
+ /* Arena statistics */
+ typedef struct {
+     arena_backing_t backing;     /* Backing obtained */
+     uint32_t size;               /* Mapped bytes */
+     uint32_t huge_bytes;         /* Bytes currently backed by huge pages */
+     uint32_t tcb_stride;         /* Bytes between TCB slots */
+     uint32_t tcb_slots;          /* TCB slots in the slab */
+     uint32_t tcb_used;           /* TCB slots in use */
+     uint32_t heap_size;          /* Bytes handed to the kernel heap */
+ } arena_stats_t;
+
+ /**
+  * @brief Map the arena
+  * Tries explicit huge pages, then transparent huge pages, then regular
+  * pages. Must be called before heap_init().
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int arena_init(void);
+
+ /**
+  * @brief Get the heap pool carved from the arena
+  *
+  * @param size Receives the pool size in bytes
+  * @return void* Pool start, NULL if the arena is not mapped
+  */
+ void* arena_heap_pool(uint32_t* size);
+
+ /**
+  * @brief Allocate a TCB slot
+  *
+  * @return task_t* Zeroed TCB, NULL if the slab is full or not mapped
+  */
+ task_t* arena_tcb_alloc(void);
+
+ /**
+  * @brief Return a TCB slot to the slab
+  *
+  * @param task TCB obtained from arena_tcb_alloc()
+  * @return int 0 on success, negative error code on failure
+  */
+ int arena_tcb_free(task_t* task);
+
+ /**
+  * @brief Get arena statistics
+  * huge_bytes is read from /proc/self/smaps when available
+  *
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int arena_get_stats(arena_stats_t* stats);
+
+ #endif /* ARENA_H */
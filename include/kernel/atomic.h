@@ -0,0 +1,150 @@
+/**
+ * @file atomic.h
+ * @brief Atomic operations for lock-free kernel fast paths
+ *
+ * Thin wrappers around the GCC __atomic builtins. On a real target these
+ * map to LDREX/STREX or equivalent; they are used by IPC objects to
+ * complete uncontended operations without entering a critical section.
+ */
+
+ #ifndef ATOMIC_H
+ #define ATOMIC_H
+
+ #include <stdint.h>
+
+ /**
+  * @brief Atomically load a 32-bit value
+  *
+  * @param ptr Location to load
+  * @return uint32_t Current value
+  */
+ static inline uint32_t atomic_load_u32(const volatile uint32_t* ptr) {
+     return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+ }
+
+ /**
+  * @brief Atomically store a 32-bit value
+  *
+  * @param ptr Location to store to
+  * @param value Value to store
+  */
+ static inline void atomic_store_u32(volatile uint32_t* ptr, uint32_t value) {
+     __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+ }
+
+ /**
+  * @brief Load a 32-bit value without ordering
+  * For data read between the sequence loads of a seqlock
+  *
+  * @param ptr Location to load
+  * @return uint32_t Current value
+  */
+ static inline uint32_t atomic_load_relaxed_u32(const volatile uint32_t* ptr) {
+     return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+ }
+
+ /**
+  * @brief Store a 32-bit value without ordering
+  * For data written between the sequence stores of a seqlock
+  *
+  * @param ptr Location to store to
+  * @param value Value to store
+  */
+ static inline void atomic_store_relaxed_u32(volatile uint32_t* ptr, uint32_t value) {
+     __atomic_store_n(ptr, value, __ATOMIC_RELAXED);
+ }
+
+ /**
+  * @brief Order earlier loads before later loads and stores
+  */
+ static inline void atomic_fence_acquire(void) {
+     __atomic_thread_fence(__ATOMIC_ACQUIRE);
+ }
+
+ /**
+  * @brief Order earlier loads and stores before later stores
+  */
+ static inline void atomic_fence_release(void) {
+     __atomic_thread_fence(__ATOMIC_RELEASE);
+ }
+
+ /**
+  * @brief Compare-and-swap a 32-bit value
+  *
+  * @param ptr Location to update
+  * @param expected Value the location must hold
+  * @param desired Value to store on match
+  * @return int 1 if the swap happened, 0 otherwise
+  */
+ static inline int atomic_cas_u32(volatile uint32_t* ptr, uint32_t expected, uint32_t desired) {
+     return __atomic_compare_exchange_n(ptr, &expected, desired, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+ }
+
+ /**
+  * @brief Atomically add to a 32-bit value
+  *
+  * @param ptr Location to update
+  * @param value Value to add
+  * @return uint32_t New value
+  */
+ static inline uint32_t atomic_add_u32(volatile uint32_t* ptr, uint32_t value) {
+     return __atomic_add_fetch(ptr, value, __ATOMIC_ACQ_REL);
+ }
+
+ /**
+  * @brief Atomically subtract from a 32-bit value
+  *
+  * @param ptr Location to update
+  * @param value Value to subtract
+  * @return uint32_t New value
+  */
+ static inline uint32_t atomic_sub_u32(volatile uint32_t* ptr, uint32_t value) {
+     return __atomic_sub_fetch(ptr, value, __ATOMIC_ACQ_REL);
+ }
+
+ /**
+  * @brief Atomically load a pointer-sized value
+  *
+  * @param ptr Location to load
+  * @return uintptr_t Current value
+  */
+ static inline uintptr_t atomic_load_ptr(const volatile uintptr_t* ptr) {
+     return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+ }
+
+ /**
+  * @brief Atomically store a pointer-sized value
+  *
+  * @param ptr Location to store to
+  * @param value Value to store
+  */
+ static inline void atomic_store_ptr(volatile uintptr_t* ptr, uintptr_t value) {
+     __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+ }
+
+ /**
+  * @brief Atomically exchange a pointer-sized value
+  *
+  * @param ptr Location to update
+  * @param value Value to store
+  * @return uintptr_t Previous value
+  */
+ static inline uintptr_t atomic_xchg_ptr(volatile uintptr_t* ptr, uintptr_t value) {
+     return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL);
+ }
+
+ /**
+  * @brief Compare-and-swap a pointer-sized value
+  *
+  * @param ptr Location to update
+  * @param expected Value the location must hold
+  * @param desired Value to store on match
+  * @return int 1 if the swap happened, 0 otherwise
+  */
+ static inline int atomic_cas_ptr(volatile uintptr_t* ptr, uintptr_t expected, uintptr_t desired) {
+     return __atomic_compare_exchange_n(ptr, &expected, desired, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+ }
+
+ #endif /* ATOMIC_H */
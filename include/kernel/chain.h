@@ -0,0 +1,110 @@
+/**
+ * @file chain.h
+ * @brief End-to-end latency of cause-effect chains
+ *
+ * A chain is a sequence of tasks linked by message queues, e.g. sensor
+ * sampling -> attitude control -> actuation. The first task stamps the
+ * data it samples (chain_sample()); each message sent on a linking
+ * queue carries the sender's stamp and hands it to the receiver, so the
+ * stamp follows the data through every stage. When the last task acts
+ * on the data (chain_complete()), the age of the sample is recorded in
+ * the chain's latency histogram; later outputs from the same sample are
+ * only counted, so the histogram holds the first-output latency that
+ * the analysis bounds.
+ *
+ * A task that reads several tracked queues works on the stamp of the
+ * last message it received. Times are microseconds of the simulation
+ * clock. The matching analytical bounds (worst-case data age and
+ * reaction time) come from tools/rta_chain.
+ */
+
+ #ifndef CHAIN_H
+ #define CHAIN_H
+
+ #include <stdint.h>
+ #include "task.h"
+ #include "ipc.h"
+ #include "../config.h"
+
+ /* Chain latency statistics */
+ typedef struct {
+     uint32_t samples;            /* chain_sample() calls */
+     uint32_t completions;        /* Latencies recorded */
+     uint32_t repeats;            /* Completions on an already recorded sample (not in the histogram) */
+     uint32_t unstamped;          /* Completions without a sample time */
+     uint32_t misses;             /* Latencies over the chain deadline */
+     uint32_t min_us;             /* Shortest latency */
+     uint32_t max_us;             /* Longest latency */
+     uint64_t total_us;           /* Sum of latencies (mean = total / completions) */
+     uint32_t bin_us;             /* Histogram bin width */
+     uint32_t hist[CHAIN_HIST_BINS]; /* Latency histogram, last bin collects overflow */
+ } chain_stats_t;
+
+ /* Cause-effect chain */
+ typedef struct {
+     task_t* tasks[CHAIN_MAX_STAGES];  /* Stages in data-flow order */
+     queue_t* links[CHAIN_MAX_STAGES]; /* links[i] feeds tasks[i] (links[0] unused) */
+     uint8_t stage_count;         /* Stages added */
+     uint32_t deadline_us;        /* End-to-end deadline (0 = none) */
+     uint64_t last_stamp;         /* Sample time of the last completion */
+     chain_stats_t stats;         /* Statistics */
+     char name[MAX_TASK_NAME_LEN];/* Chain name */
+ } chain_t;
+
+ /**
+  * @brief Create an empty chain
+  * The histogram spans twice the deadline, or CHAIN_HIST_BINS bins of
+  * CHAIN_HIST_BIN_US without one.
+  *
+  * @param name Chain name
+  * @param deadline_us End-to-end deadline in microseconds (0 = none)
+  * @return chain_t* Pointer to created chain, NULL on failure
+  */
+ chain_t* chain_create(const char* name, uint32_t deadline_us);
+
+ /**
+  * @brief Delete a chain (its queues keep carrying stamps)
+  *
+  * @param chain Chain to delete
+  * @return int 0 on success, negative error code on failure
+  */
+ int chain_delete(chain_t* chain);
+
+ /**
+  * @brief Append a stage
+  *
+  * @param chain Chain
+  * @param task Task of the stage
+  * @param input Queue from the previous stage (NULL for the first stage only)
+  * @return int 0 on success, negative error code on failure
+  */
+ int chain_add_stage(chain_t* chain, task_t* task, queue_t* input);
+
+ /**
+  * @brief Stamp the data the current task has just sampled
+  * Called by the first stage when it reads its input.
+  *
+  * @param chain Chain
+  * @return int 0 on success, negative error code on failure
+  */
+ int chain_sample(chain_t* chain);
+
+ /**
+  * @brief Record the latency of the data the current task acts on
+  * Called by the last stage when it produces the chain's output.
+  *
+  * @param chain Chain
+  * @return int 0 on success, negative error code on failure (no sample time)
+  */
+ int chain_complete(chain_t* chain);
+
+ /**
+  * @brief Get chain latency statistics
+  *
+  * @param chain Chain
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int chain_get_stats(chain_t* chain, chain_stats_t* stats);
+
+ #endif /* CHAIN_H */
@@ -0,0 +1,102 @@
+/**
+ * @file heap.h
+ * @brief Real-time heap for kernel objects and application tasks
+ *
+ * This file defines a Two-Level Segregated Fit (TLSF) allocator with
+ * O(1) allocation and release, per-task usage accounting and optional
+ * per-task quotas. Kernel objects (task stacks, queue buffers) and
+ * application buffers are served from the same bounded pool.
+ */
+
+ #ifndef HEAP_H
+ #define HEAP_H
+
+ #include <stdint.h>
+ #include <stddef.h>
+ #include "task.h"
+
+ /* Heap statistics */
+ typedef struct {
+     uint32_t pool_size;           /* Total pool size in bytes */
+     uint32_t used_bytes;          /* Bytes currently allocated (payload) */
+     uint32_t peak_used_bytes;     /* Highest used_bytes observed */
+     uint32_t free_bytes;          /* Bytes available in free blocks */
+     uint32_t largest_free_block;  /* Largest single allocation that can succeed */
+     uint32_t free_block_count;    /* Number of free blocks */
+     uint32_t alloc_count;         /* Successful allocations */
+     uint32_t free_count;          /* Successful releases */
+     uint32_t failed_allocs;       /* Allocations refused (no memory or quota) */
+     float fragmentation;          /* 1 - largest_free_block / free_bytes (0.0-1.0) */
+ } heap_stats_t;
+
+ /**
+  * @brief Initialize the heap over the kernel pool
+  * The pool is static, or carved from the kernel arena when
+  * ENABLE_KERNEL_ARENA is set. Must be called before any task or IPC
+  * object is created
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int heap_init(void);
+
+ /**
+  * @brief Allocate memory charged to the current task
+  * Allocations made before the scheduler runs are charged to the kernel
+  *
+  * @param size Number of bytes to allocate
+  * @return void* Pointer to allocated memory, NULL on failure
+  */
+ void* heap_alloc(size_t size);
+
+ /**
+  * @brief Allocate memory charged to a specific owner
+  *
+  * @param owner Task to charge (NULL for kernel-owned memory)
+  * @param size Number of bytes to allocate
+  * @return void* Pointer to allocated memory, NULL on failure
+  */
+ void* heap_alloc_for(task_t* owner, size_t size);
+
+ /**
+  * @brief Release memory obtained from heap_alloc() or heap_alloc_for()
+  *
+  * @param ptr Pointer to release (NULL is ignored)
+  * @return void
+  */
+ void heap_free(void* ptr);
+
+ /**
+  * @brief Set a task's heap quota
+  *
+  * @param task Task to limit
+  * @param quota Maximum bytes the task may own (0 for unlimited)
+  * @return int 0 on success, negative error code on failure
+  */
+ int heap_set_quota(task_t* task, uint32_t quota);
+
+ /**
+  * @brief Transfer all blocks owned by a task to the kernel
+  * Called when a task is deleted with outstanding allocations
+  *
+  * @param task Task being released
+  * @return uint32_t Number of bytes that were still owned by the task
+  */
+ uint32_t heap_release_task(task_t* task);
+
+ /**
+  * @brief Get heap statistics
+  *
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int heap_get_stats(heap_stats_t* stats);
+
+ /**
+  * @brief Touch every page of the heap pool so later use cannot page-fault
+  * Must be called before the scheduler starts
+  *
+  * @return uint32_t Number of bytes touched
+  */
+ uint32_t heap_prefault(void);
+
+ #endif /* HEAP_H */
@@ -3,7 +3,7 @@
  * @brief Inter-Process Communication mechanisms for RTOS
  *
  * This file defines the IPC mechanisms for the RTOS, including semaphores, 
- * message queues, and mutexes.
+ * message queues, mutexes and token-bucket rate limiters.
  */
 
  #ifndef IPC_H
@@ -16,20 +16,37 @@
  
  /* Semaphore structure */
  typedef struct {
-     uint32_t count;              /* Current semaphore count */
+     volatile uint32_t count;     /* Current semaphore count (atomic) */
      uint32_t max_count;          /* Maximum semaphore count */
+     volatile uint32_t waiters;   /* Tasks in the slow path (atomic) */
      task_t* waiting_tasks;       /* List of tasks waiting for the semaphore */
      char name[MAX_TASK_NAME_LEN];/* Semaphore name */
  } semaphore_t;
  
+ /* Mutex state word: owner task pointer, low bit flags waiters */
+ #define MUTEX_STATE_UNLOCKED  ((uintptr_t)0)
+ #define MUTEX_STATE_WAITERS   ((uintptr_t)1)
+ 
  /* Mutex structure (binary semaphore with priority inheritance) */
  typedef struct {
-     uint8_t locked;              /* 0 = unlocked, 1 = locked */
-     task_t* owner;               /* Task that owns the mutex (if locked) */
+     volatile uintptr_t state;    /* Owner pointer | MUTEX_STATE_WAITERS (atomic) */
      task_t* waiting_tasks;       /* List of tasks waiting for the mutex */
      char name[MAX_TASK_NAME_LEN];/* Mutex name */
  } mutex_t;
  
+ /* Token-bucket rate limiter
+  * Kept as a single theoretical arrival time (GCRA), so refill is computed
+  * lazily from timestamps on acquire rather than updated every tick. */
+ typedef struct {
+     uint64_t tat_us;             /* Time at which the bucket is full again (timer_get_us()) */
+     uint32_t interval_us;        /* Microseconds per token (1 / rate) */
+     uint32_t burst;              /* Bucket depth in tokens */
+     uint32_t granted;            /* Tokens granted */
+     uint32_t throttled;          /* Acquisitions that had to wait */
+     uint32_t rejected;           /* Acquisitions refused (timeout too short) */
+     char name[MAX_TASK_NAME_LEN];/* Rate limiter name */
+ } ratelimit_t;
+ 
  /* Message queue structure */
  typedef struct {
      void* buffer;                /* Queue buffer */
@@ -40,6 +57,9 @@
      uint32_t tail;               /* Tail index (newest message) */
      task_t* waiting_send;        /* Tasks waiting to send (when queue full) */
      task_t* waiting_recv;        /* Tasks waiting to receive (when queue empty) */
+     uint8_t owns_buffer;         /* 1 if buffer was allocated from the kernel heap */
+     ratelimit_t* ratelimit;      /* Shapes senders, NULL for none */
+     uint64_t* stamps;            /* Per-slot chain sample times (us), NULL if untracked */
      char name[MAX_TASK_NAME_LEN];/* Queue name */
  } queue_t;
  
@@ -62,6 +82,14 @@
   */
  int ipc_init(void);
  
+ /**
+  * @brief Touch every page of all queue buffers so later use cannot page-fault
+  * Must be called before the scheduler starts
+  * 
+  * @return uint32_t Number of bytes touched
+  */
+ uint32_t ipc_prefault(void);
+ 
  /* Semaphore functions */
  
  /**
@@ -150,6 +178,14 @@
   */
  int mutex_is_locked(mutex_t* mutex);
  
+ /**
+  * @brief Get the task that currently owns a mutex
+  * 
+  * @param mutex Mutex to query
+  * @return task_t* Owner task, NULL if unlocked
+  */
+ task_t* mutex_get_owner(mutex_t* mutex);
+ 
  /* Message queue functions */
  
  /**
@@ -162,6 +198,18 @@
   */
  queue_t* queue_create(const char* name, size_t msg_size, uint32_t capacity);
  
+ /**
+  * @brief Create a message queue over a caller-provided buffer
+  * 
+  * @param name Queue name
+  * @param msg_size Size of each message in bytes
+  * @param capacity Maximum number of messages
+  * @param buffer Storage for msg_size * capacity bytes
+  * @return queue_t* Pointer to created queue, NULL on failure
+  */
+ queue_t* queue_create_static(const char* name, size_t msg_size, uint32_t capacity,
+                              void* buffer);
+ 
  /**
   * @brief Delete a message queue
   * 
@@ -207,6 +255,27 @@
   */
  int queue_peek(queue_t* queue, void* msg);
  
+ /**
+  * @brief Shape a queue's senders with a rate limiter
+  * Each queue_send() first takes one token, within the same timeout.
+  * Several queues may share one limiter to split a channel's budget.
+  * 
+  * @param queue Queue to shape
+  * @param limiter Rate limiter, NULL to remove shaping
+  * @return int 0 on success, negative error code on failure
+  */
+ int queue_set_ratelimit(queue_t* queue, ratelimit_t* limiter);
+ 
+ /**
+  * @brief Carry chain sample times through a queue (see chain.h)
+  * Each message takes the sender's chain_stamp and hands it to the
+  * receiver. Idempotent; the stamps are freed with the queue.
+  * 
+  * @param queue Queue to track
+  * @return int 0 on success, negative error code on failure
+  */
+ int queue_track_stamps(queue_t* queue);
+ 
  /* Event group functions */
  
  /**
@@ -262,4 +331,58 @@
   */
  uint32_t event_group_get_flags(event_group_t* group);
  
+ /* Rate limiter functions */
+ 
+ /**
+  * @brief Create a token-bucket rate limiter
+  * The bucket starts full
+  * 
+  * @param name Rate limiter name
+  * @param rate Sustained rate in tokens per second, 1 to (burst + 1) * 1000 /
+  *             MILLISECONDS_PER_TICK: waiters sleep whole ticks, so a single
+  *             sender is served at most burst + 1 tokens per tick
+  * @param burst Bucket depth in tokens (largest burst admitted at once)
+  * @return ratelimit_t* Pointer to created rate limiter, NULL on failure
+  */
+ ratelimit_t* ratelimit_create(const char* name, uint32_t rate, uint32_t burst);
+ 
+ /**
+  * @brief Delete a rate limiter
+  * Detach it from any queue first
+  * 
+  * @param limiter Rate limiter to delete
+  * @return int 0 on success, negative error code on failure
+  */
+ int ratelimit_delete(ratelimit_t* limiter);
+ 
+ /**
+  * @brief Take tokens, waiting for the refill if needed
+  * A waiting caller reserves its tokens up front, so waiters are served
+  * in arrival order and the call fails at once if the wait would exceed
+  * the timeout.
+  * 
+  * @param limiter Rate limiter
+  * @param tokens Tokens to take (at most the burst size)
+  * @param timeout Timeout in ticks (0 for non-blocking, MAX_TIMEOUT for infinite)
+  * @return int 0 on success, negative error code on failure or timeout
+  */
+ int ratelimit_acquire(ratelimit_t* limiter, uint32_t tokens, uint32_t timeout);
+ 
+ /**
+  * @brief Give back tokens taken for an operation that then failed
+  * 
+  * @param limiter Rate limiter
+  * @param tokens Tokens to return
+  * @return int 0 on success, negative error code on failure
+  */
+ int ratelimit_refund(ratelimit_t* limiter, uint32_t tokens);
+ 
+ /**
+  * @brief Get the tokens that could be taken now without waiting
+  * 
+  * @param limiter Rate limiter to query
+  * @return uint32_t Available tokens
+  */
+ uint32_t ratelimit_get_available(ratelimit_t* limiter);
+ 
  #endif /* IPC_H */
\ No newline at end of file
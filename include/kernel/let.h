@@ -0,0 +1,161 @@
+/**
+ * @file let.h
+ * @brief Logical execution time (LET) communication
+ *
+ * Under LET, a periodic task reads its inputs at its release and its
+ * outputs become visible at its deadline, whatever happens in between.
+ * Every LET variable has one published value; each task bound to it
+ * gets its own copy. At a release the kernel copies the published value
+ * into the task's input copies, and at the deadline it publishes the
+ * task's output copy. The task only touches its own copies
+ * (let_input(), let_output()), so no lock is needed and the data seen
+ * by every job is fixed by the timeline alone, not by the scheduling
+ * policy or the preemption pattern.
+ *
+ * The timeline follows each task's period, deadline and offset. The
+ * kernel batches all copies that fall on one tick from the tick handler,
+ * before releasing the tick's jobs: first every output due at that tick
+ * is published, then every input due is read. So a job released exactly
+ * at another task's deadline sees that task's new output.
+ *
+ * A job ends when it calls let_job_done(), before waiting for its next
+ * release. A job not ended by its deadline, whether running, ready or
+ * blocked, publishes nothing that period; a task whose job has not ended
+ * by its next release keeps its old inputs. Both are counted as
+ * overruns. Each variable has at most one writer; LET tasks need a
+ * deadline no longer than their period.
+ */
+
+ #ifndef LET_H
+ #define LET_H
+
+ #include <stdint.h>
+ #include <stddef.h>
+ #include "task.h"
+ #include "../config.h"
+
+ /* LET variable */
+ typedef struct {
+     void* value;                 /* Published value */
+     size_t size;                 /* Value size in bytes */
+     task_t* writer;              /* Task bound as output, NULL if none */
+     char name[MAX_TASK_NAME_LEN];/* Variable name */
+ } let_var_t;
+
+ /* LET statistics */
+ typedef struct {
+     uint32_t instants;           /* Ticks with at least one copy */
+     uint32_t reads;              /* Input copies made at releases */
+     uint32_t publishes;          /* Output copies made at deadlines */
+     uint32_t read_overruns;      /* Releases whose previous job had not ended */
+     uint32_t publish_overruns;   /* Deadlines whose job had not ended */
+     uint32_t max_batch;          /* Most copies made on one tick */
+     uint64_t bytes;              /* Bytes copied */
+ } let_stats_t;
+
+ /**
+  * @brief Initialize the LET subsystem (called by task_init)
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int let_init(void);
+
+ /**
+  * @brief Create a LET variable
+  *
+  * @param name Variable name
+  * @param size Value size in bytes
+  * @param initial Initial value (NULL for zeros)
+  * @return let_var_t* Pointer to created variable, NULL on failure
+  */
+ let_var_t* let_var_create(const char* name, size_t size, const void* initial);
+
+ /**
+  * @brief Delete a LET variable and its bindings
+  *
+  * @param var Variable to delete
+  * @return int 0 on success, negative error code on failure
+  */
+ int let_var_delete(let_var_t* var);
+
+ /**
+  * @brief Give a periodic task an input copy of a variable, read at each release
+  *
+  * @param task Periodic task (deadline no longer than its period)
+  * @param var Variable
+  * @return int 0 on success, negative error code on failure
+  */
+ int let_bind_input(task_t* task, let_var_t* var);
+
+ /**
+  * @brief Make a periodic task the writer of a variable, published at each deadline
+  *
+  * @param task Periodic task (deadline no longer than its period)
+  * @param var Variable without a writer
+  * @return int 0 on success, negative error code on failure
+  */
+ int let_bind_output(task_t* task, let_var_t* var);
+
+ /**
+  * @brief The current task's input copy of a variable (fixed for the whole job)
+  *
+  * @param var Variable
+  * @return const void* Input copy, NULL if the task is not bound to the variable
+  */
+ const void* let_input(const let_var_t* var);
+
+ /**
+  * @brief The current task's output copy of a variable (published at its deadline)
+  *
+  * @param var Variable
+  * @return void* Output copy, NULL if the task is not the variable's writer
+  */
+ void* let_output(let_var_t* var);
+
+ /**
+  * @brief End the current task's job: its outputs are final and its inputs
+  * may be refreshed at the next release (call once per job, before waiting)
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int let_job_done(void);
+
+ /**
+  * @brief Copy the published value of a variable (for tasks outside LET)
+  *
+  * @param var Variable
+  * @param dst Receives var->size bytes
+  * @return int 0 on success, negative error code on failure
+  */
+ int let_var_read(const let_var_t* var, void* dst);
+
+ /**
+  * @brief Make the copies due at a tick (called by the tick handler)
+  *
+  * @param now Current tick
+  */
+ void let_tick(uint32_t now);
+
+ /**
+  * @brief Realign a task's copy instants after its period, deadline or offset changed
+  *
+  * @param task Task
+  */
+ void let_task_update(const task_t* task);
+
+ /**
+  * @brief Drop a task's bindings (called when the task is deleted)
+  *
+  * @param task Task being deleted
+  */
+ void let_task_remove(const task_t* task);
+
+ /**
+  * @brief Get LET statistics
+  *
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int let_get_stats(let_stats_t* stats);
+
+ #endif /* LET_H */
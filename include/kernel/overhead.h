@@ -0,0 +1,109 @@
+/**
+ * @file overhead.h
+ * @brief Kernel overhead timing model for the simulator
+ *
+ * On the host a context switch, a tick or a queue operation takes a few
+ * hundred nanoseconds; on the flight processor it may take many
+ * microseconds, so the simulator's schedules look better than the
+ * target's. With a model loaded, every kernel operation charges the
+ * difference between its target cost and its host cost as busy time on
+ * the simulator thread, and the target's overheads show up in response
+ * times and deadline misses.
+ *
+ * Charges accumulate in nanoseconds and are paid in whole microseconds
+ * (timer_delay_us()), so sub-microsecond costs still add up. The tick
+ * may run on the timer thread, so its charge waits for the next
+ * operation or context switch on the simulator thread.
+ *
+ * Model files come from tools/ovh_calibrate, one operation per line:
+ *
+ *     # op            target_ns  host_ns
+ *     context_switch  12000      450
+ */
+
+ #ifndef OVERHEAD_H
+ #define OVERHEAD_H
+
+ #include <stdint.h>
+
+ /* Charged kernel operations */
+ typedef enum {
+     OVH_CONTEXT_SWITCH,          /* Switch between tasks (scheduler) */
+     OVH_TICK,                    /* scheduler_tick() */
+     OVH_QUEUE_SEND,              /* queue_send() */
+     OVH_QUEUE_RECEIVE,           /* queue_receive() */
+     OVH_SEM_TAKE,                /* semaphore_take() */
+     OVH_SEM_GIVE,                /* semaphore_give() */
+     OVH_MUTEX_LOCK,              /* mutex_lock() */
+     OVH_MUTEX_UNLOCK,            /* mutex_unlock() */
+     OVH_OP_COUNT
+ } overhead_op_t;
+
+ /* Operation names used in model files, in overhead_op_t order */
+ #define OVERHEAD_OP_NAMES { "context_switch", "tick", "queue_send", "queue_receive", \
+                             "sem_take", "sem_give", "mutex_lock", "mutex_unlock" }
+
+ /* Overhead model */
+ typedef struct {
+     uint32_t target_ns[OVH_OP_COUNT]; /* Cost of each operation on the target */
+     uint32_t host_ns[OVH_OP_COUNT];   /* Cost of each operation on the host */
+ } overhead_model_t;
+
+ /* Overhead statistics */
+ typedef struct {
+     uint32_t count[OVH_OP_COUNT];     /* Charged operations */
+     uint64_t charged_ns;              /* Time charged */
+     uint64_t paid_us;                 /* Time spent busy-waiting */
+ } overhead_stats_t;
+
+ /* Nonzero while a model is loaded; checked inline so disabled hooks cost one load */
+ extern volatile uint8_t overhead_enabled;
+
+ /**
+  * @brief Load a model (NULL to stop charging)
+  *
+  * @param model Model to copy
+  * @return int 0 on success, negative error code on failure
+  */
+ int overhead_set_model(const overhead_model_t* model);
+
+ /**
+  * @brief Load a model file written by tools/ovh_calibrate
+  *
+  * @param path Model file
+  * @return int 0 on success, negative error code on failure
+  */
+ int overhead_load(const char* path);
+
+ /**
+  * @brief Hash of the loaded model (0 if none), keys cached simulation results
+  *
+  * @return uint32_t Model hash
+  */
+ uint32_t overhead_hash(void);
+
+ /**
+  * @brief Charge an operation (use overhead_charge() from kernel paths)
+  *
+  * @param op Operation
+  */
+ void overhead_record(overhead_op_t op);
+
+ /**
+  * @brief Charge an operation if a model is loaded
+  */
+ static inline void overhead_charge(overhead_op_t op) {
+     if (overhead_enabled) {
+         overhead_record(op);
+     }
+ }
+
+ /**
+  * @brief Get overhead statistics
+  *
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int overhead_get_stats(overhead_stats_t* stats);
+
+ #endif /* OVERHEAD_H */
@@ -0,0 +1,192 @@
+/**
+ * @file rta.h
+ * @brief Incremental response-time analysis for fixed-priority tasks
+ *
+ * This file defines a response-time analysis (RTA) engine for periodic
+ * tasks under preemptive fixed-priority scheduling. The worst-case
+ * response time of task i is the least fixed point of
+ *
+ *     R = C_i + B_i + sum over j in hp(i) of ceil(R / T_j) * C_j
+ *
+ * where hp(i) holds every other task of equal or higher priority (equal
+ * priorities are assumed to interfere with each other). Deadlines longer
+ * than the period are analyzed as equal to it.
+ *
+ * The engine keeps the last fixed point of every task. When one task
+ * changes, it re-analyzes only the tasks whose interference can have
+ * changed, starting each from a proven lower bound: the task's previous
+ * response time when its interference only grew, and the response time
+ * of the next higher-priority task otherwise. A single-task change on a
+ * converged set usually costs one or two iterations per affected task.
+ *
+ * A task set is backed by caller-provided entry storage indexed by task
+ * ID. The kernel keeps one set for its own periodic tasks, indexed by
+ * the task table slot and updated from task_set_priority(),
+ * task_set_periodic() and task_set_wcet(); host tools build their own.
+ */
+
+ #ifndef RTA_H
+ #define RTA_H
+
+ #include <stdint.h>
+ #include "task.h"
+ #include "../config.h"
+
+ #define RTA_NONE             0xFFFF  /* No task (end of the priority list) */
+
+ /* Timing parameters of one task (all times in ticks) */
+ typedef struct {
+     uint32_t period;             /* Period or minimum inter-arrival time, > 0 */
+     uint32_t deadline;           /* Relative deadline (0 = period) */
+     uint32_t wcet;               /* Worst-case execution time */
+     uint32_t blocking;           /* Worst-case blocking by lower-priority tasks */
+     uint16_t priority;           /* 0 = highest (analysis tools use more levels than the kernel) */
+ } rta_params_t;
+
+ /* Analysis state of one task */
+ typedef struct {
+     rta_params_t params;
+     uint32_t response;           /* Worst-case response time; if unschedulable, a bound above the deadline */
+     uint16_t prev;               /* Next higher task in priority order */
+     uint16_t next;               /* Next lower task in priority order */
+     uint8_t used;                /* 1 if the task is part of the set */
+     uint8_t schedulable;         /* 1 if response <= deadline */
+ } rta_entry_t;
+
+ /* Analysis statistics */
+ typedef struct {
+     uint32_t updates;            /* Task changes applied */
+     uint32_t analyses;           /* Single-task analyses run */
+     uint32_t iterations;         /* Fixed-point iterations */
+ } rta_stats_t;
+
+ /* Task set */
+ typedef struct {
+     rta_entry_t* entries;        /* Indexed by task ID */
+     uint16_t capacity;           /* Number of entries */
+     uint16_t head;               /* Highest-priority task */
+     uint16_t count;              /* Tasks in the set */
+     uint16_t unschedulable;      /* Tasks whose response exceeds the deadline */
+     rta_stats_t stats;
+ } rta_set_t;
+
+ /**
+  * @brief Initialize an empty task set
+  *
+  * @param set Task set
+  * @param entries Storage for capacity entries
+  * @param capacity Number of task IDs (at most RTA_NONE)
+  * @return int 0 on success, negative error code on failure
+  */
+ int rta_set_init(rta_set_t* set, rta_entry_t* entries, uint16_t capacity);
+
+ /**
+  * @brief Add a task or change its parameters, re-analyzing affected tasks
+  *
+  * @param set Task set
+  * @param id Task ID
+  * @param params New timing parameters
+  * @return int 0 on success, negative error code on failure
+  */
+ int rta_set_task(rta_set_t* set, uint16_t id, const rta_params_t* params);
+
+ /**
+  * @brief Add or change a task only if the set stays schedulable
+  *
+  * @param set Task set
+  * @param id Task ID
+  * @param params New timing parameters
+  * @return int 0 if applied, negative if the set would be unschedulable (set unchanged)
+  */
+ int rta_admit(rta_set_t* set, uint16_t id, const rta_params_t* params);
+
+ /**
+  * @brief Remove a task, re-analyzing the tasks it interfered with
+  *
+  * @param set Task set
+  * @param id Task ID
+  * @return int 0 on success, negative error code on failure
+  */
+ int rta_remove_task(rta_set_t* set, uint16_t id);
+
+ /**
+  * @brief Re-analyze every task from scratch
+  *
+  * @param set Task set
+  * @return int 0 on success, negative error code on failure
+  */
+ int rta_analyze(rta_set_t* set);
+
+ /**
+  * @brief Check whether every task meets its deadline
+  *
+  * @param set Task set
+  * @return int 1 if schedulable, 0 if not
+  */
+ int rta_is_schedulable(const rta_set_t* set);
+
+ /**
+  * @brief Get the worst-case response time of a task
+  *
+  * @param set Task set
+  * @param id Task ID
+  * @param response Receives the response time in ticks
+  * @return int 1 if the task meets its deadline, 0 if not, negative on error
+  */
+ int rta_get_response(const rta_set_t* set, uint16_t id, uint32_t* response);
+
+ /**
+  * @brief Get analysis statistics
+  *
+  * @param set Task set
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int rta_get_stats(const rta_set_t* set, rta_stats_t* stats);
+
+ /**
+  * @brief Response time of one task against an explicit set of interferers
+  * Stateless building block for priority-assignment searches, which test
+  * many candidate hp sets; stops as soon as the response passes the deadline.
+  *
+  * @param task Task under analysis (its priority is ignored)
+  * @param interferers Tasks of higher or equal priority, not including task
+  * @param count Number of interferers
+  * @param response Receives the response time, or a bound above the deadline
+  * @return int 1 if the task meets its deadline, 0 if not, negative on error
+  */
+ int rta_response(const rta_params_t* task, const rta_params_t* interferers, uint32_t count,
+                  uint32_t* response);
+
+ /**
+  * @brief Initialize the kernel task set (called by task_init)
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int rta_system_init(void);
+
+ /**
+  * @brief Get the kernel task set
+  *
+  * @return rta_set_t* Set of the periodic kernel tasks, indexed by task ID
+  */
+ rta_set_t* rta_system_set(void);
+
+ /**
+  * @brief Bring a task's entry in the kernel set up to date
+  * Periodic tasks are added or re-analyzed, aperiodic ones removed
+  *
+  * @param task Task whose priority, period, deadline or WCET changed
+  * @return int 0 on success, negative error code on failure
+  */
+ int rta_task_update(const task_t* task);
+
+ /**
+  * @brief Remove a task from the kernel set
+  *
+  * @param task Task being deleted
+  * @return int 0 on success, negative error code on failure
+  */
+ int rta_task_remove(const task_t* task);
+
+ #endif /* RTA_H */
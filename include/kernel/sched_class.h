@@ -0,0 +1,66 @@
+/**
+ * @file sched_class.h
+ * @brief Pluggable scheduling-class interface for the RTOS scheduler
+ *
+ * A scheduling class owns the run-queue data structures for the tasks
+ * assigned to it and implements the policy-specific operations the core
+ * scheduler needs. Each scheduling policy is expressed as a stack of
+ * classes ordered from highest to lowest; the core scheduler asks each
+ * class in turn for a task to run, so e.g. EDF can be stacked above
+ * fixed-priority scheduling for non-periodic work.
+ */
+
+ #ifndef SCHED_CLASS_H
+ #define SCHED_CLASS_H
+
+ #include <stdint.h>
+ #include "task.h"
+
+ /* Maximum number of classes in a policy stack */
+ #define SCHED_CLASS_STACK_DEPTH  4
+
+ /* Scheduling class operations table */
+ typedef struct sched_class {
+     const char* name;                          /* Class name */
+
+     /* Reset class run queues (required) */
+     int (*init)(void);
+
+     /* Return 1 if the class accepts this task, NULL accepts all tasks */
+     int (*admit)(const task_t* task);
+
+     /* Insert a ready task into the class run queue (required) */
+     void (*enqueue)(task_t* task);
+
+     /* Remove a task from the class run queue (required) */
+     void (*dequeue)(task_t* task);
+
+     /* Return the task that should run next without dequeuing it (required) */
+     task_t* (*pick_next)(void);
+
+     /* Account a tick to the running task, return 1 to request preemption */
+     int (*tick)(task_t* current);
+
+     /* Task left the ready set by blocking or suspending */
+     void (*on_block)(task_t* task);
+
+     /* Task is about to re-enter the ready set after blocking */
+     void (*on_wake)(task_t* task);
+ } sched_class_t;
+
+ /* Built-in scheduling classes */
+ extern const sched_class_t sched_class_priority;
+ extern const sched_class_t sched_class_rr;
+ extern const sched_class_t sched_class_edf;
+ extern const sched_class_t sched_class_rms;
+
+ /**
+  * @brief Get the class stack implementing a scheduling policy
+  *
+  * @param policy Scheduling policy (SCHEDULING_POLICY_*)
+  * @param depth Pointer to store number of classes in the stack
+  * @return const sched_class_t* const* Classes ordered highest first, NULL if unknown
+  */
+ const sched_class_t* const* sched_class_get_stack(uint8_t policy, uint32_t* depth);
+
+ #endif /* SCHED_CLASS_H */
@@ -116,6 +116,15 @@
   */
  int scheduler_update_task_state(task_t* task, task_state_t new_state);
  
+ /**
+  * @brief Re-evaluate a task's scheduling class and run queue position
+  * Call after changing parameters a class orders by (priority, period, deadline)
+  * 
+  * @param task Task whose parameters changed
+  * @return int 0 on success, negative error code on failure
+  */
+ int scheduler_requeue_task(task_t* task);
+ 
  /**
   * @brief Process system tick
   * This function should be called every system tick
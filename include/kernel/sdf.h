@@ -0,0 +1,161 @@
+/**
+ * @file sdf.h
+ * @brief Synchronous dataflow (SDF) graphs
+ *
+ * An SDF graph is a set of actors joined by edges. Each time an actor
+ * fires it consumes a fixed number of tokens from every input edge and
+ * produces a fixed number on every output edge. An edge may start out
+ * holding initial (delay) tokens, which a feedback loop needs.
+ *
+ * sdf_compile() turns the graph into a periodic static schedule:
+ *
+ *   - Repetitions: the firings of each actor per graph iteration, from
+ *     the balance equations q_u * produce = q_v * consume.
+ *   - Periods: actor a fires every H / q_a ticks, where H is the
+ *     iteration period.
+ *   - Start times: the earliest start times such that every firing
+ *     finds its input tokens. Each producer firing counts as finished
+ *     by its deadline, which is its period.
+ *   - Buffer capacities: the most tokens each edge can hold under this
+ *     schedule, counting tokens produced at the producer's release and
+ *     consumed at the consumer's deadline.
+ *
+ * sdf_start() then creates one periodic task per actor and one message
+ * queue per edge, sized to those capacities. If the periodic tasks meet
+ * their deadlines (see kernel/rta.h), every firing finds its inputs and
+ * room for its outputs. So the graph sustains one iteration per H ticks
+ * with the smallest queues that tolerate any execution pattern within
+ * the periods.
+ *
+ * A graph is rejected if its rates are inconsistent, if it is not
+ * connected, or if a cycle holds too few initial tokens for this
+ * schedule.
+ */
+
+ #ifndef SDF_H
+ #define SDF_H
+
+ #include <stdint.h>
+ #include <stddef.h>
+ #include "task.h"
+ #include "ipc.h"
+ #include "../config.h"
+
+ /**
+  * Actor firing function
+  * inputs[i] holds the tokens consumed from the actor's i-th input edge,
+  * outputs[i] receives the tokens produced on its i-th output edge (edges
+  * in the order they were added).
+  */
+ typedef void (*sdf_fire_t)(void* ctx, const void* const* inputs, void* const* outputs);
+
+ /* Actor */
+ typedef struct {
+     char name[MAX_TASK_NAME_LEN];/* Actor (and task) name */
+     sdf_fire_t fire;             /* Firing function */
+     void* ctx;                   /* Firing function context */
+     uint8_t priority;            /* Task priority */
+     uint32_t wcet;               /* Worst-case execution time of a firing in ticks */
+     uint32_t repetitions;        /* Firings per iteration (sdf_compile()) */
+     uint32_t period;             /* Ticks between firings (sdf_compile()) */
+     uint32_t start;              /* First firing, ticks into the iteration (sdf_compile()) */
+     uint32_t first_release;      /* Tick of the first firing (sdf_start()) */
+     void* scratch;               /* Port buffers (sdf_start()) */
+     task_t* task;                /* Actor task (sdf_start()) */
+     uint32_t firings;            /* Completed firings */
+     uint32_t stalls;             /* Queue operations that had to be retried */
+     struct sdf_graph* graph;     /* Owning graph */
+ } sdf_actor_t;
+
+ /* Edge */
+ typedef struct {
+     uint8_t src;                 /* Producing actor */
+     uint8_t dst;                 /* Consuming actor */
+     uint32_t produce;            /* Tokens produced per firing of src */
+     uint32_t consume;            /* Tokens consumed per firing of dst */
+     uint32_t delay;              /* Initial tokens (zero-filled) */
+     size_t token_size;           /* Token size in bytes */
+     uint32_t capacity;           /* Queue capacity in tokens (sdf_compile()) */
+     queue_t* queue;              /* Queue (sdf_start()) */
+ } sdf_edge_t;
+
+ /* Dataflow graph */
+ typedef struct sdf_graph {
+     sdf_actor_t actors[SDF_MAX_ACTORS];
+     uint8_t actor_count;
+     sdf_edge_t edges[SDF_MAX_EDGES];
+     uint8_t edge_count;
+     uint32_t iteration;          /* Iteration period H in ticks (sdf_compile()) */
+     uint8_t compiled;            /* Schedule computed */
+     uint8_t started;             /* Tasks and queues created */
+     char name[MAX_TASK_NAME_LEN];/* Graph name */
+ } sdf_graph_t;
+
+ /**
+  * @brief Create an empty graph
+  *
+  * @param name Graph name
+  * @return sdf_graph_t* Pointer to created graph, NULL on failure
+  */
+ sdf_graph_t* sdf_create(const char* name);
+
+ /**
+  * @brief Delete a graph with its tasks and queues
+  *
+  * @param graph Graph to delete (not from one of its own actors)
+  * @return int 0 on success, negative error code on failure
+  */
+ int sdf_delete(sdf_graph_t* graph);
+
+ /**
+  * @brief Add an actor
+  *
+  * @param graph Graph (not yet compiled)
+  * @param name Actor name, also the name of its task
+  * @param fire Firing function
+  * @param ctx Firing function context
+  * @param priority Task priority
+  * @param wcet Worst-case execution time of a firing in ticks
+  * @return int Actor index, negative error code on failure
+  */
+ int sdf_add_actor(sdf_graph_t* graph, const char* name, sdf_fire_t fire, void* ctx,
+                   uint8_t priority, uint32_t wcet);
+
+ /**
+  * @brief Add an edge
+  *
+  * @param graph Graph (not yet compiled)
+  * @param src Producing actor index
+  * @param dst Consuming actor index
+  * @param produce Tokens produced per firing of src
+  * @param consume Tokens consumed per firing of dst
+  * @param token_size Token size in bytes
+  * @param delay Initial tokens on the edge
+  * @return int Edge index, negative error code on failure
+  */
+ int sdf_add_edge(sdf_graph_t* graph, uint8_t src, uint8_t dst, uint32_t produce, uint32_t consume,
+                  size_t token_size, uint32_t delay);
+
+ /**
+  * @brief Compute repetitions, periods, start times and buffer capacities
+  * The iteration period is rounded up so that every actor period and
+  * every token interval is a whole number of ticks.
+  *
+  * @param graph Graph
+  * @param iteration Iteration period in ticks (0 = shortest the WCETs allow)
+  * @return int 0 on success, negative error code on failure
+  */
+ int sdf_compile(sdf_graph_t* graph, uint32_t iteration);
+
+ /**
+  * @brief Create the actor tasks and edge queues of a compiled graph
+  * The first iteration starts at the next multiple of the iteration period.
+  * Tasks and queues come from the kernel pools (extra_tasks and
+  * extra_queues of a sysgen configuration).
+  *
+  * @param graph Compiled graph
+  * @return int 0 on success, negative error code on failure
+  */
+ int sdf_start(sdf_graph_t* graph);
+
+ #endif /* SDF_H */
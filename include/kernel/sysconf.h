@@ -0,0 +1,116 @@
+/**
+ * @file sysconf.h
+ * @brief Static system configuration tables
+ *
+ * This file defines the tables emitted by the configuration compiler
+ * (tools/sysgen) from a declarative system description. Every task and
+ * IPC object is backed by storage reserved at compile time, and
+ * sysconf_apply() instantiates them at startup without allocating.
+ */
+
+ #ifndef SYSCONF_H
+ #define SYSCONF_H
+ 
+ #include <stdint.h>
+ #include <stddef.h>
+ #include "task.h"
+ #include "ipc.h"
+ #include "chain.h"
+ #include "let.h"
+ 
+ /* Task entry */
+ typedef struct {
+     const char* name;            /* Task name */
+     uint8_t priority;            /* Task priority (0 = highest) */
+     task_type_t type;            /* Extended or basic task */
+     void (*entry)(void*);        /* Task function */
+     void* arg;                   /* Task function argument */
+     task_t* tcb;                 /* Preallocated TCB (extended tasks) */
+     uint32_t* stack;             /* Preallocated stack (extended tasks) */
+     uint32_t stack_size;         /* Stack size in bytes */
+     uint32_t period;             /* Period in ticks (0 = aperiodic) */
+     uint32_t deadline;           /* Relative deadline in ticks (0 = period) */
+     uint32_t wcet;               /* Worst-case execution time in ticks (0 = unknown) */
+     uint32_t offset;             /* Release offset in ticks */
+     task_t** handle;             /* Where to store the task pointer */
+ } sysconf_task_t;
+ 
+ /* Semaphore entry */
+ typedef struct {
+     const char* name;            /* Semaphore name */
+     uint32_t initial_count;      /* Initial count */
+     uint32_t max_count;          /* Maximum count */
+     semaphore_t** handle;        /* Where to store the semaphore pointer */
+ } sysconf_semaphore_t;
+ 
+ /* Mutex entry */
+ typedef struct {
+     const char* name;            /* Mutex name */
+     mutex_t** handle;            /* Where to store the mutex pointer */
+ } sysconf_mutex_t;
+ 
+ /* Message queue entry */
+ typedef struct {
+     const char* name;            /* Queue name */
+     size_t msg_size;             /* Message size in bytes */
+     uint32_t capacity;           /* Maximum number of messages */
+     void* buffer;                /* Preallocated msg_size * capacity buffer */
+     queue_t** handle;            /* Where to store the queue pointer */
+ } sysconf_queue_t;
+ 
+ /* Event group entry */
+ typedef struct {
+     const char* name;            /* Event group name */
+     event_group_t** handle;      /* Where to store the event group pointer */
+ } sysconf_event_group_t;
+ 
+ /* Cause-effect chain entry */
+ typedef struct {
+     const char* name;            /* Chain name */
+     task_t** const* tasks;       /* Handles of the stage tasks */
+     queue_t** const* links;      /* Handles of the queues between stages (stage_count - 1) */
+     uint32_t stage_count;        /* Number of stages */
+     uint32_t deadline_us;        /* End-to-end deadline (0 = none) */
+     chain_t** handle;            /* Where to store the chain pointer */
+ } sysconf_chain_t;
+ 
+ /* LET variable entry */
+ typedef struct {
+     const char* name;            /* Variable name */
+     size_t size;                 /* Value size in bytes */
+     task_t** writer;             /* Handle of the writing task (NULL = none) */
+     task_t** const* readers;     /* Handles of the reading tasks */
+     uint32_t reader_count;       /* Number of readers */
+     let_var_t** handle;          /* Where to store the variable pointer */
+ } sysconf_let_t;
+ 
+ /* Complete system configuration */
+ typedef struct {
+     const sysconf_task_t* tasks;             /* Tasks, sorted by priority */
+     uint32_t task_count;
+     const sysconf_semaphore_t* semaphores;
+     uint32_t semaphore_count;
+     const sysconf_mutex_t* mutexes;
+     uint32_t mutex_count;
+     const sysconf_queue_t* queues;
+     uint32_t queue_count;
+     const sysconf_event_group_t* event_groups;
+     uint32_t event_group_count;
+     const sysconf_chain_t* chains;
+     uint32_t chain_count;
+     const sysconf_let_t* lets;
+     uint32_t let_count;
+ } sysconf_t;
+ 
+ /**
+  * @brief Instantiate all objects of a system configuration
+  * IPC objects are created first so tasks can use them as soon as they run;
+  * LET variables and chains come last, once their tasks and queues exist.
+  * Must be called after the kernel subsystems are initialized.
+  * 
+  * @param cfg Configuration tables (usually generated)
+  * @return int 0 on success, negative error code on failure
+  */
+ int sysconf_apply(const sysconf_t* cfg);
+ 
+ #endif /* SYSCONF_H */
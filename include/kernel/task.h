@@ -21,6 +21,12 @@
      TASK_STATE_TERMINATED   /* Task has terminated */
  } task_state_t;
  
+ /* Task types */
+ typedef enum {
+     TASK_TYPE_EXTENDED,     /* Own stack, may block */
+     TASK_TYPE_BASIC         /* Run-to-completion on caller's stack, never blocks */
+ } task_type_t;
+ 
  /* Task block reasons */
  typedef enum {
      BLOCK_REASON_NONE,          /* Not blocked */
@@ -48,10 +54,15 @@
      uint32_t max_execution_time; /* Maximum execution time observed */
  } task_stats_t;
  
+ /* Scheduling class (see sched_class.h) */
+ struct sched_class;
+ 
  /* Task control block */
  typedef struct task_struct {
      char name[MAX_TASK_NAME_LEN];          /* Task name */
      task_state_t state;                    /* Current state */
+     task_type_t type;                      /* Extended or basic task */
+     uint8_t pending_activations;           /* Queued activations (basic tasks) */
      uint8_t priority;                      /* Task priority (0 = highest) */
      uint8_t original_priority;             /* Original priority (for priority inheritance) */
      uint32_t time_slice;                   /* Time slice in system ticks */
@@ -64,11 +75,24 @@
      void* block_object;                    /* Object task is blocked on */
      uint32_t period;                       /* Period for periodic tasks (in ticks) */
      uint32_t deadline;                     /* Relative deadline (in ticks) */
+     uint32_t wcet;                         /* Worst-case execution time budget (in ticks, 0 = unknown) */
+     uint32_t offset;                       /* Release offset (in ticks, releases at offset + k * period) */
      uint32_t next_release;                 /* Next release time for periodic tasks */
      uint32_t absolute_deadline;            /* Absolute deadline for current job */
+     uint64_t chain_stamp;                  /* Sample time (us) of the chain data being processed, 0 = none */
      task_stats_t stats;                    /* Task statistics */
      struct task_struct* next;              /* Next task in list */
      struct task_struct* prev;              /* Previous task in list */
+     const struct sched_class* sched_class; /* Scheduling class owning the task */
+     struct task_struct* rq_next;           /* Next task in class run queue */
+     struct task_struct* rq_prev;           /* Previous task in class run queue */
+     uint32_t rq_key;                       /* Class-private run queue key */
+     uint8_t on_rq;                         /* 1 if queued in its class run queue */
+     uint32_t heap_used;                    /* Heap bytes owned by the task */
+     uint32_t heap_peak;                    /* Peak heap bytes owned by the task */
+     uint32_t heap_quota;                   /* Heap quota in bytes (0 = unlimited) */
+     uint8_t static_alloc;                  /* 1 if TCB and stack are caller-provided */
+     uint8_t id;                            /* Slot in the task table (trace id) */
  } task_t;
  
  /* Function prototypes */
@@ -94,6 +118,50 @@
                     void (*task_func)(void*), void* task_arg,
                     uint32_t stack_size);
  
+ /**
+  * @brief Create a task in caller-provided storage
+  * Used for statically configured systems; nothing is allocated
+  * 
+  * @param name Task name
+  * @param priority Task priority (0 = highest)
+  * @param task_func Task function pointer
+  * @param task_arg Task function argument
+  * @param tcb Storage for the task control block
+  * @param stack Storage for the task stack
+  * @param stack_size Stack size in bytes
+  * @return task_t* Pointer to created task (tcb), NULL on failure
+  */
+ task_t* task_create_static(const char* name, uint8_t priority,
+                           void (*task_func)(void*), void* task_arg,
+                           task_t* tcb, uint32_t* stack, uint32_t stack_size);
+ 
+ /**
+  * @brief Create a basic (run-to-completion) task
+  * Basic tasks have no stack of their own: each job runs as a nested call
+  * on the stack of the task or tick that dispatched it, so that stack must
+  * have room for the deepest job. They are created suspended, run once per
+  * activation and must not block. Every basic task must have a higher
+  * priority than every extended task; a higher-priority basic task
+  * preempts by nesting on top of the running one.
+  * 
+  * @param name Task name
+  * @param priority Task priority (0 = highest)
+  * @param task_func Job function, must return
+  * @param task_arg Job function argument
+  * @return task_t* Pointer to created task, NULL on failure
+  */
+ task_t* task_create_basic(const char* name, uint8_t priority,
+                           void (*task_func)(void*), void* task_arg);
+ 
+ /**
+  * @brief Activate a basic task
+  * Activating a task that is already ready or running queues another run
+  * 
+  * @param task Basic task to activate
+  * @return int 0 on success, negative error code on failure
+  */
+ int task_activate(task_t* task);
+ 
  /**
   * @brief Delete a task
   * 
@@ -111,6 +179,17 @@
   */
  int task_set_priority(task_t* task, uint8_t priority);
  
+ /**
+  * @brief Boost or restore the running priority for priority inheritance
+  * Leaves the configured priority (original_priority) and the
+  * response-time analysis untouched; safe inside a critical section.
+  * 
+  * @param task Task to modify
+  * @param priority Running priority
+  * @return int 0 on success, negative error code on failure
+  */
+ int task_boost_priority(task_t* task, uint8_t priority);
+ 
  /**
   * @brief Get task priority
   * 
@@ -175,6 +254,27 @@
   */
  int task_set_periodic(task_t* task, uint32_t period, uint32_t deadline);
  
+ /**
+  * @brief Set the release offset of a periodic task
+  * Releases fall on offset + k * period ticks since boot, so tasks with
+  * different offsets stay phased against each other; the offset is kept
+  * if the task is made periodic later.
+  * 
+  * @param task Task to configure
+  * @param offset Release offset in ticks (less than the period, if one is set)
+  * @return int 0 on success, negative error code on failure
+  */
+ int task_set_offset(task_t* task, uint32_t offset);
+ 
+ /**
+  * @brief Set the worst-case execution time used by response-time analysis
+  * 
+  * @param task Task to configure
+  * @param wcet Worst-case execution time in ticks
+  * @return int 0 on success, negative error code on failure
+  */
+ int task_set_wcet(task_t* task, uint32_t wcet);
+ 
  /**
   * @brief Get task state as string
   * 
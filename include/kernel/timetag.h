@@ -0,0 +1,135 @@
+/**
+ * @file timetag.h
+ * @brief Time-tagged command tables
+ *
+ * This file defines tables of messages that are released into a queue
+ * at an absolute tick. Entries are kept in a binary min-heap keyed by
+ * release time, and a single one-shot software timer is armed for the
+ * earliest entry, so no task polls the table. Thousands of entries can
+ * be loaded at once (e.g. the command sequence for the next orbit) and
+ * any entry can be cancelled by the ID returned when it was inserted.
+ */
+
+ #ifndef TIMETAG_H
+ #define TIMETAG_H
+
+ #include <stdint.h>
+ #include <stddef.h>
+ #include "ipc.h"
+ #include "../drivers/time.h"
+ #include "../config.h"
+
+ /* Invalid entry ID */
+ #define TIMETAG_INVALID_ID  0
+
+ /* Heap node: release tick and the slot holding the message */
+ typedef struct {
+     uint32_t tick;               /* Release tick */
+     uint16_t slot;               /* Entry slot */
+ } timetag_node_t;
+
+ /* Time-tag table statistics */
+ typedef struct {
+     uint32_t inserted;           /* Entries inserted */
+     uint32_t released;           /* Entries delivered to the target queue */
+     uint32_t cancelled;          /* Entries cancelled */
+     uint32_t deferred;           /* Releases retried because the target was full */
+     uint32_t max_lateness;       /* Worst release delay past the tag, in ticks */
+ } timetag_stats_t;
+
+ /* Time-tag table */
+ typedef struct {
+     queue_t* target;             /* Queue the messages are released into */
+     size_t msg_size;             /* Message size (the target's message size) */
+     uint16_t capacity;           /* Maximum entries */
+     uint16_t count;              /* Entries pending */
+     timetag_node_t* heap;        /* Min-heap of pending entries */
+     uint16_t* heap_pos;          /* Heap index of each slot */
+     uint16_t* generation;        /* Per-slot generation, part of the entry ID */
+     uint16_t* free_slots;        /* Stack of unused slots */
+     uint16_t free_count;         /* Unused slots */
+     uint8_t* messages;           /* capacity * msg_size bytes */
+     timer_t* timer;              /* One-shot timer for the earliest entry */
+     uint32_t armed_tick;         /* Tick the timer is armed for */
+     uint8_t armed;               /* 1 if the timer is armed */
+     timetag_stats_t stats;       /* Statistics */
+     char name[MAX_TASK_NAME_LEN];/* Table name */
+ } timetag_table_t;
+
+ /* Bulk load entry */
+ typedef struct {
+     uint32_t tick;               /* Release tick */
+     const void* msg;             /* Message (msg_size bytes) */
+ } timetag_entry_t;
+
+ /**
+  * @brief Create a time-tag table releasing into a queue
+  *
+  * @param name Table name
+  * @param target Queue that receives released messages
+  * @param capacity Maximum pending entries (at most 65535)
+  * @return timetag_table_t* Pointer to created table, NULL on failure
+  */
+ timetag_table_t* timetag_create(const char* name, queue_t* target, uint16_t capacity);
+
+ /**
+  * @brief Delete a time-tag table, discarding pending entries
+  *
+  * @param table Table to delete
+  * @return int 0 on success, negative error code on failure
+  */
+ int timetag_delete(timetag_table_t* table);
+
+ /**
+  * @brief Insert one message to be released at a tick
+  * A tick that has already passed releases on the next tick
+  *
+  * @param table Time-tag table
+  * @param tick Release tick
+  * @param msg Message to release (copied)
+  * @param id Receives the entry ID for cancellation (may be NULL)
+  * @return int 0 on success, negative error code on failure (table full)
+  */
+ int timetag_insert(timetag_table_t* table, uint32_t tick, const void* msg, uint32_t* id);
+
+ /**
+  * @brief Insert many messages at once
+  * Builds the heap in O(n) and re-arms the timer once. Either all
+  * entries are inserted or none.
+  *
+  * @param table Time-tag table
+  * @param entries Entries to insert
+  * @param count Number of entries
+  * @param ids Receives one entry ID per entry (may be NULL)
+  * @return int 0 on success, negative error code on failure
+  */
+ int timetag_load(timetag_table_t* table, const timetag_entry_t* entries, uint32_t count,
+                  uint32_t* ids);
+
+ /**
+  * @brief Cancel a pending entry
+  *
+  * @param table Time-tag table
+  * @param id Entry ID returned on insertion
+  * @return int 0 on success, negative error code if the entry is not pending
+  */
+ int timetag_cancel(timetag_table_t* table, uint32_t id);
+
+ /**
+  * @brief Get the number of pending entries
+  *
+  * @param table Time-tag table
+  * @return uint32_t Pending entries
+  */
+ uint32_t timetag_get_count(timetag_table_t* table);
+
+ /**
+  * @brief Get time-tag table statistics
+  *
+  * @param table Time-tag table
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int timetag_get_stats(timetag_table_t* table, timetag_stats_t* stats);
+
+ #endif /* TIMETAG_H */
@@ -0,0 +1,117 @@
+/**
+ * @file trace.h
+ * @brief Kernel event trace
+ *
+ * This file defines a low-overhead trace of scheduling events (context
+ * switches, blocks, wakeups, periodic releases and mutex ownership).
+ * Events are appended to an in-memory buffer and written to a binary
+ * file in batches; tools/trace_analyze turns the file into response
+ * time, blocking and priority-inversion reports.
+ *
+ * File format (little-endian, host layout):
+ *
+ *     trace_header_t, trace_task_info_t[task_count], trace_event_t...
+ */
+
+ #ifndef TRACE_H
+ #define TRACE_H
+ 
+ #include <stdint.h>
+ #include "task.h"
+ 
+ /* Trace file magic and version */
+ #define TRACE_MAGIC              0x5454524FU  /* "ORTT" */
+ #define TRACE_VERSION            1
+ 
+ /* Events buffered before a batch is written */
+ #define TRACE_BUFFER_EVENTS      1024
+ 
+ /* Task id used when no task is involved */
+ #define TRACE_NO_TASK            0xFF
+ 
+ /* Event types */
+ typedef enum {
+     TRACE_SWITCH = 1,            /* task = next, arg = previous task */
+     TRACE_BLOCK,                 /* task blocks, arg = block reason, object = blocking object */
+     TRACE_UNBLOCK,               /* task becomes ready */
+     TRACE_RELEASE,               /* periodic release, object = absolute deadline (ticks) */
+     TRACE_MUTEX_LOCK,            /* task owns mutex object */
+     TRACE_MUTEX_UNLOCK           /* task releases mutex object */
+ } trace_event_type_t;
+ 
+ /* Trace event record */
+ typedef struct {
+     uint64_t timestamp_us;       /* Time of the event */
+     uint8_t type;                /* trace_event_type_t */
+     uint8_t task;                /* Task id (slot in the task table) */
+     uint8_t arg;                 /* Event-specific argument */
+     uint8_t reserved;
+     uint32_t object;             /* Event-specific object id or value */
+ } trace_event_t;
+ 
+ /* Task description written at trace start */
+ typedef struct {
+     uint8_t id;                  /* Task id used in events */
+     uint8_t priority;            /* Base priority */
+     uint8_t reserved[2];
+     uint32_t period;             /* Period in ticks (0 = aperiodic) */
+     uint32_t deadline;           /* Relative deadline in ticks */
+     char name[MAX_TASK_NAME_LEN];/* Task name */
+ } trace_task_info_t;
+ 
+ /* Trace file header */
+ typedef struct {
+     uint32_t magic;              /* TRACE_MAGIC */
+     uint16_t version;            /* TRACE_VERSION */
+     uint16_t task_count;         /* Number of trace_task_info_t records */
+     uint32_t tick_us;            /* Microseconds per tick */
+     uint32_t reserved;
+ } trace_header_t;
+ 
+ /* Nonzero while tracing; checked inline so disabled hooks cost one load */
+ extern volatile uint8_t trace_enabled;
+ 
+ /**
+  * @brief Start tracing to a file
+  * Tasks existing at this point are described in the file header
+  * 
+  * @param path Output file
+  * @return int 0 on success, negative error code on failure
+  */
+ int trace_start(const char* path);
+ 
+ /**
+  * @brief Stop tracing, write buffered events and close the file
+  * 
+  * @return int 0 on success, negative error code on failure
+  */
+ int trace_stop(void);
+ 
+ /**
+  * @brief Record an event (use trace_event() from kernel paths)
+  * 
+  * @param type Event type
+  * @param task Task the event concerns
+  * @param arg Event-specific argument
+  * @param object Event-specific object id or value
+  * @return void
+  */
+ void trace_record(uint8_t type, const task_t* task, uint8_t arg, uint32_t object);
+ 
+ /**
+  * @brief Record an event if tracing is enabled
+  */
+ static inline void trace_event(uint8_t type, const task_t* task, uint8_t arg, uint32_t object) {
+     if (trace_enabled) {
+         trace_record(type, task, arg, object);
+     }
+ }
+ 
+ /**
+  * @brief Compact id for a kernel object pointer
+  */
+ static inline uint32_t trace_object_id(const void* object) {
+     return (uint32_t)(uintptr_t)object;
+ }
+ 
+ #endif /* TRACE_H */
@@ -0,0 +1,134 @@
+/**
+ * @file workqueue.h
+ * @brief Deferred work service for the RTOS
+ *
+ * This file defines kernel work queues: caller-owned work items are
+ * submitted lock-free from any context and executed in batches by a
+ * dedicated worker task at a configurable priority. Delayed submission
+ * is driven by the software timer service.
+ */
+
+ #ifndef WORKQUEUE_H
+ #define WORKQUEUE_H
+
+ #include <stdint.h>
+ #include "task.h"
+ #include "ipc.h"
+ #include "../drivers/time.h"
+
+ /* Work function type */
+ typedef void (*work_func_t)(void* arg);
+
+ /* Work item (preallocated by the caller, never copied) */
+ typedef struct work_item {
+     work_func_t func;            /* Function to run in the worker task */
+     void* arg;                   /* Argument passed to func */
+     volatile uint32_t pending;   /* 1 while queued and not yet started (atomic) */
+     struct work_item* next;      /* Next item in the submission list */
+ } work_item_t;
+
+ /* Static initializer for work items */
+ #define WORK_ITEM_INITIALIZER(f, a) { .func = (f), .arg = (a), .pending = 0, .next = NULL }
+
+ /* Work queue statistics */
+ typedef struct {
+     uint32_t submitted;          /* Items accepted for execution */
+     uint32_t coalesced;          /* Submissions ignored because item was pending */
+     uint32_t executed;           /* Items executed */
+     uint32_t batches;            /* Worker wakeups that executed work */
+     uint32_t max_batch;          /* Largest batch executed in one wakeup */
+ } workqueue_stats_t;
+
+ /* Work queue */
+ typedef struct {
+     volatile uintptr_t pending_head; /* Lock-free LIFO of submitted items (atomic) */
+     semaphore_t* wakeup;         /* Signals the worker on empty -> non-empty */
+     task_t* worker;              /* Worker task */
+     workqueue_stats_t stats;     /* Statistics (updated by worker) */
+     char name[MAX_TASK_NAME_LEN];/* Work queue name */
+ } workqueue_t;
+
+ /* Delayed work item */
+ typedef struct {
+     work_item_t work;            /* Work run when the delay expires */
+     workqueue_t* wq;             /* Target queue of the pending delay */
+     timer_t* timer;              /* One-shot timer, created once at init */
+ } delayed_work_t;
+
+ /**
+  * @brief Initialize the work queue subsystem
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int workqueue_init(void);
+
+ /**
+  * @brief Create a work queue and its worker task
+  *
+  * @param name Work queue name (also used for the worker task)
+  * @param priority Worker task priority
+  * @param stack_size Worker stack size in bytes
+  * @return workqueue_t* Pointer to created work queue, NULL on failure
+  */
+ workqueue_t* workqueue_create(const char* name, uint8_t priority, uint32_t stack_size);
+
+ /**
+  * @brief Initialize a work item
+  *
+  * @param work Work item to initialize
+  * @param func Function to run
+  * @param arg Argument passed to func
+  * @return int 0 on success, negative error code on failure
+  */
+ int work_init(work_item_t* work, work_func_t func, void* arg);
+
+ /**
+  * @brief Submit a work item without blocking or locking
+  * Safe from tasks and interrupt-like contexts
+  *
+  * @param wq Work queue to submit to
+  * @param work Work item to run
+  * @return int 0 if queued, 1 if already pending, negative error code on failure
+  */
+ int workqueue_submit(workqueue_t* wq, work_item_t* work);
+
+ /**
+  * @brief Initialize a delayed work item
+  *
+  * @param dwork Delayed work item to initialize
+  * @param name Name for the backing timer
+  * @param func Function to run
+  * @param arg Argument passed to func
+  * @return int 0 on success, negative error code on failure
+  */
+ int delayed_work_init(delayed_work_t* dwork, const char* name, work_func_t func, void* arg);
+
+ /**
+  * @brief Submit a work item after a delay
+  *
+  * @param wq Work queue to submit to
+  * @param dwork Delayed work item
+  * @param delay_ms Delay in milliseconds (0 submits immediately)
+  * @return int 0 on success, negative error code on failure
+  */
+ int workqueue_submit_delayed(workqueue_t* wq, delayed_work_t* dwork, uint32_t delay_ms);
+
+ /**
+  * @brief Cancel a pending delay
+  * Work already handed to the queue still runs
+  *
+  * @param dwork Delayed work item
+  * @return int 0 on success, negative error code on failure
+  */
+ int delayed_work_cancel(delayed_work_t* dwork);
+
+ /**
+  * @brief Get work queue statistics
+  *
+  * @param wq Work queue to query
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int workqueue_get_stats(workqueue_t* wq, workqueue_stats_t* stats);
+
+ #endif /* WORKQUEUE_H */
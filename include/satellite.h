@@ -0,0 +1,31 @@
+/**
+ * @file satellite.h
+ * @brief Shared types of the satellite demo application
+ *
+ * Types exchanged through configured IPC objects live here so the
+ * generated system configuration can size their buffers.
+ */
+
+ #ifndef SATELLITE_H
+ #define SATELLITE_H
+ 
+ #include <stdint.h>
+ 
+ /* Command types */
+ typedef enum {
+     CMD_NOOP,
+     CMD_RESET,
+     CMD_SET_MODE,
+     CMD_TAKE_PICTURE,
+     CMD_DEPLOY_SOLAR_PANEL,
+     CMD_ADJUST_ORBIT
+ } command_type_t;
+ 
+ /* Command structure */
+ typedef struct {
+     command_type_t type;
+     uint32_t parameter;
+     uint32_t timestamp;          /* Execution tick; a future tick defers the command */
+ } command_t;
+ 
+ #endif /* SATELLITE_H */
@@ -0,0 +1,130 @@
+/**
+ * @file fdir.h
+ * @brief Fault detection, isolation and recovery (FDIR) limit checking
+ *
+ * This file defines a table of telemetry checks evaluated together once
+ * per monitoring cycle. Each check compares a sampled value against a
+ * low and high limit and a maximum change since the previous cycle, and
+ * must fail for a number of consecutive cycles (persistence) before it
+ * trips. Tripped checks raise event-group flags; a check that newly trips
+ * also runs its recovery action.
+ *
+ * The table is stored as a structure of arrays and evaluated several
+ * checks at a time with GCC vector extensions (scalar code elsewhere).
+ * Evaluation is branch-free apart from the rare trip, so a cycle costs
+ * the same per check whether one or thousands of checks are violated.
+ *
+ * Values are fed and evaluated from one task (the monitoring task); the
+ * table itself takes no locks.
+ */
+
+ #ifndef FDIR_H
+ #define FDIR_H
+
+ #include <stdint.h>
+ #include <math.h>
+ #include "../kernel/ipc.h"
+ #include "../config.h"
+
+ /* Table limits */
+ #define FDIR_MAX_CHECKS      4096    /* Checks in the table */
+ #define FDIR_MAX_ACTIONS     16      /* Recovery action slots */
+ #define FDIR_VECTOR_BYTES    16      /* SIMD register width used for evaluation */
+ #define FDIR_NO_ACTION       0xFF
+
+ /* Recovery action, run in the evaluating task when a check trips */
+ typedef void (*fdir_action_fn)(uint16_t check, float value, void* ctx);
+
+ /* Check definition (use FDIR_CHECK_DEFAULT and set the fields needed) */
+ typedef struct {
+     const char* name;            /* For log messages (not copied) */
+     float low;                   /* Violated below this value */
+     float high;                  /* Violated above this value */
+     float max_delta;             /* Violated if the value moves more than this per cycle */
+     uint16_t persistence;        /* Consecutive violated cycles before tripping (>= 1) */
+     uint32_t flags;              /* Event flags raised while tripped */
+     uint8_t action;              /* Action run when tripped, FDIR_NO_ACTION for none */
+ } fdir_check_t;
+
+ /* Unlimited check: set the limits that apply */
+ #define FDIR_CHECK_DEFAULT { NULL, -INFINITY, INFINITY, INFINITY, 1, 0, FDIR_NO_ACTION }
+
+ /* Result of one evaluation */
+ typedef struct {
+     uint32_t raised;             /* Event flags raised by tripped checks */
+     uint32_t tripped;            /* Checks currently tripped */
+     uint32_t new_trips;          /* Checks that tripped this cycle */
+ } fdir_result_t;
+
+ /* FDIR statistics */
+ typedef struct {
+     uint32_t checks;             /* Checks defined */
+     uint32_t evaluations;        /* Cycles evaluated */
+     uint32_t trips;              /* Trips since init */
+     uint32_t actions;            /* Recovery actions run */
+ } fdir_stats_t;
+
+ /**
+  * @brief Initialize the FDIR table
+  *
+  * @param events Event group that receives check flags (may be NULL)
+  * @return int 0 on success, negative error code on failure
+  */
+ int fdir_init(event_group_t* events);
+
+ /**
+  * @brief Add a check
+  *
+  * @param check Check definition
+  * @param id Receives the check ID used to feed values (may be NULL)
+  * @return int 0 on success, negative error code on failure
+  */
+ int fdir_add_check(const fdir_check_t* check, uint16_t* id);
+
+ /**
+  * @brief Register a recovery action
+  *
+  * @param slot Action slot (below FDIR_MAX_ACTIONS)
+  * @param fn Action function
+  * @param ctx Passed to the action
+  * @return int 0 on success, negative error code on failure
+  */
+ int fdir_register_action(uint8_t slot, fdir_action_fn fn, void* ctx);
+
+ /**
+  * @brief Sample the value of a check for the next evaluation
+  * The first sample of a check also seeds its delta reference
+  *
+  * @param id Check ID
+  * @param value Sampled value
+  * @return int 0 on success, negative error code on failure
+  */
+ int fdir_set_value(uint16_t id, float value);
+
+ /**
+  * @brief Evaluate every check once
+  * Flags owned by the checks are set when any of their checks is tripped
+  * and cleared otherwise.
+  *
+  * @param result Receives the evaluation result (may be NULL)
+  * @return int 0 on success, negative error code on failure
+  */
+ int fdir_evaluate(fdir_result_t* result);
+
+ /**
+  * @brief Check whether a check is tripped
+  *
+  * @param id Check ID
+  * @return int 1 if tripped, 0 if not, negative error code on failure
+  */
+ int fdir_is_tripped(uint16_t id);
+
+ /**
+  * @brief Get FDIR statistics
+  *
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int fdir_get_stats(fdir_stats_t* stats);
+
+ #endif /* FDIR_H */
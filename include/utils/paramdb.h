@@ -0,0 +1,198 @@
+/**
+ * @file paramdb.h
+ * @brief Telemetry parameter database
+ *
+ * This file defines a database of typed telemetry parameters. Each
+ * parameter has an application-chosen ID, a type, the tick it was last
+ * written and a validity flag. Values live in a packed table of 16-byte
+ * entries, four per cache line, indexed directly by ID.
+ *
+ * Every entry is guarded by its own sequence counter (seqlock): writers
+ * make the counter odd while they update the entry, and readers retry
+ * if the counter was odd or changed while they read. Readers never take
+ * a lock, so telemetry assembly, FDIR and the display can read while
+ * the owners write. Snapshots are consistent per parameter, not across
+ * parameters.
+ */
+
+ #ifndef PARAMDB_H
+ #define PARAMDB_H
+
+ #include <stdint.h>
+ #include "../config.h"
+
+ /* Database limits */
+ #define PARAMDB_MAX_PARAMS   512     /* Parameter IDs 0 .. PARAMDB_MAX_PARAMS-1 */
+
+ /* Parameter types */
+ typedef enum {
+     PARAM_TYPE_NONE,             /* Not defined */
+     PARAM_TYPE_U32,
+     PARAM_TYPE_I32,
+     PARAM_TYPE_F32,
+     PARAM_TYPE_BOOL
+ } param_type_t;
+
+ /* Parameter value */
+ typedef union {
+     uint32_t u32;
+     int32_t i32;
+     float f32;
+     uint32_t raw;
+ } param_value_t;
+
+ /* Consistent copy of one parameter */
+ typedef struct {
+     param_value_t value;         /* Last written value */
+     uint32_t timestamp;          /* Tick of the last write */
+     uint16_t id;                 /* Parameter ID */
+     uint8_t type;                /* param_type_t */
+     uint8_t valid;               /* 0 until written, or after invalidation */
+ } param_sample_t;
+
+ /* Database statistics */
+ typedef struct {
+     uint32_t defined;            /* Parameters defined */
+     uint32_t writes;             /* Writes since init */
+     uint32_t read_retries;       /* Reads repeated because of a concurrent write */
+ } paramdb_stats_t;
+
+ /**
+  * @brief Initialize the parameter database
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_init(void);
+
+ /**
+  * @brief Define a parameter
+  *
+  * @param id Parameter ID
+  * @param name Parameter name (not copied)
+  * @param type Parameter type
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_define(uint16_t id, const char* name, param_type_t type);
+
+ /**
+  * @brief Write a parameter
+  * The value must match the parameter's type; it becomes valid and is
+  * stamped with the current tick
+  *
+  * @param id Parameter ID
+  * @param type Type of the value (must match the definition)
+  * @param value New value
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_set(uint16_t id, param_type_t type, param_value_t value);
+
+ /**
+  * @brief Write an unsigned parameter
+  *
+  * @param id Parameter ID
+  * @param value New value
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_set_u32(uint16_t id, uint32_t value);
+
+ /**
+  * @brief Write a signed parameter
+  *
+  * @param id Parameter ID
+  * @param value New value
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_set_i32(uint16_t id, int32_t value);
+
+ /**
+  * @brief Write a floating-point parameter
+  *
+  * @param id Parameter ID
+  * @param value New value
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_set_f32(uint16_t id, float value);
+
+ /**
+  * @brief Write a boolean parameter
+  *
+  * @param id Parameter ID
+  * @param value New value (any nonzero value is stored as 1)
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_set_bool(uint16_t id, uint32_t value);
+
+ /**
+  * @brief Mark a parameter invalid (e.g. its sensor failed)
+  *
+  * @param id Parameter ID
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_invalidate(uint16_t id);
+
+ /**
+  * @brief Read a parameter
+  *
+  * @param id Parameter ID
+  * @param sample Receives a consistent copy of the parameter
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_get(uint16_t id, param_sample_t* sample);
+
+ /**
+  * @brief Read a numeric parameter as float
+  *
+  * @param id Parameter ID
+  * @param value Receives the value converted to float
+  * @return int 0 on success, negative error code if undefined or invalid
+  */
+ int paramdb_get_f32(uint16_t id, float* value);
+
+ /**
+  * @brief Read a numeric parameter as unsigned integer
+  * Floating-point values are truncated
+  *
+  * @param id Parameter ID
+  * @param value Receives the value converted to uint32_t
+  * @return int 0 on success, negative error code if undefined or invalid
+  */
+ int paramdb_get_u32(uint16_t id, uint32_t* value);
+
+ /**
+  * @brief Read a list of parameters
+  *
+  * @param ids Parameter IDs
+  * @param count Number of IDs
+  * @param samples Receives one sample per ID
+  * @return int 0 on success, negative error code if any ID is undefined
+  */
+ int paramdb_snapshot(const uint16_t* ids, uint32_t count, param_sample_t* samples);
+
+ /**
+  * @brief Read a contiguous block of parameters
+  * Reads entries in table order, the cheapest way to fill a packet
+  *
+  * @param first First parameter ID
+  * @param count Number of parameters
+  * @param samples Receives one sample per parameter (undefined ones have type NONE)
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_snapshot_range(uint16_t first, uint32_t count, param_sample_t* samples);
+
+ /**
+  * @brief Get the name of a parameter
+  *
+  * @param id Parameter ID
+  * @return const char* Name, NULL if undefined
+  */
+ const char* paramdb_get_name(uint16_t id);
+
+ /**
+  * @brief Get database statistics
+  *
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int paramdb_get_stats(paramdb_stats_t* stats);
+
+ #endif /* PARAMDB_H */
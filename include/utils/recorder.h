@@ -0,0 +1,116 @@
+/**
+ * @file recorder.h
+ * @brief Long-run time-series recorder for kernel and task statistics
+ *
+ * This file defines a recorder that samples scheduler statistics, heap
+ * usage, per-task statistics and queue depths at a fixed rate. Samples
+ * are taken from a software timer and handed to a low-priority writer
+ * task, which stores them in a compact columnar file through buffered
+ * I/O. Coarser levels are derived by periodic downsampling, so multi-day
+ * runs keep their long-term trends at a bounded file size.
+ *
+ * File format (all integers are unsigned LEB128 varints unless noted):
+ *
+ *     header:  "ORTS" version(u8) sample_period_ms downsample_factor
+ *              column_count { kind(u8) name_len(u8) name[name_len] }...
+ *     block:   'B' level rows { first_value zigzag_delta[rows-1] }...
+ *
+ * Each block stores its columns one after another. The first value of a
+ * column is absolute and the rest are zigzag-encoded deltas. A row at
+ * level n covers downsample_factor^n samples: counters keep the last
+ * value, gauges keep the maximum.
+ */
+
+ #ifndef RECORDER_H
+ #define RECORDER_H
+
+ #include <stdint.h>
+ #include "../kernel/task.h"
+ #include "../kernel/ipc.h"
+ #include "../config.h"
+
+ /* Recorder limits */
+ #define RECORDER_MAX_COLUMNS     48      /* Columns per sample row */
+ #define RECORDER_MAX_BLOCK_ROWS  64      /* Rows per encoded block */
+ #define RECORDER_MAX_LEVELS      4       /* Downsampling levels */
+ #define RECORDER_RING_ROWS       128     /* Samples buffered for the writer */
+ #define RECORDER_IO_BUFFER       8192    /* stdio buffer size in bytes */
+ #define RECORDER_FLUSH_BLOCKS    16      /* Blocks between explicit flushes */
+
+ /* Column kinds */
+ #define RECORDER_COLUMN_COUNTER  0       /* Monotonic, downsampled to last value */
+ #define RECORDER_COLUMN_GAUGE    1       /* Instantaneous, downsampled to maximum */
+
+ /* Recorder configuration */
+ typedef struct {
+     const char* path;            /* Output file */
+     uint32_t sample_period_ms;   /* Sampling interval */
+     uint32_t block_rows;         /* Rows per encoded block */
+     uint32_t downsample_factor;  /* Rows of level n folded into one row of level n+1 */
+     uint32_t levels;             /* Levels to write (1 = no downsampling) */
+     uint32_t full_rate_rows;     /* Level-0 rows written before only coarser levels remain (0 = all) */
+     uint8_t priority;            /* Writer task priority */
+ } recorder_config_t;
+
+ /* Default recorder configuration */
+ #define RECORDER_CONFIG_DEFAULT { "stats.orts", 1000, 64, 10, 3, 0, LOW_PRIORITY }
+
+ /* Recorder statistics */
+ typedef struct {
+     uint32_t samples;            /* Samples taken */
+     uint32_t dropped;            /* Samples lost because the writer fell behind */
+     uint32_t blocks_written;     /* Blocks written, all levels */
+     uint32_t bytes_written;      /* Encoded bytes written */
+ } recorder_stats_t;
+
+ /**
+  * @brief Initialize the recorder
+  * Scheduler and heap columns are added automatically
+  *
+  * @param config Recorder configuration
+  * @return int 0 on success, negative error code on failure
+  */
+ int recorder_init(const recorder_config_t* config);
+
+ /**
+  * @brief Add per-task columns (runtime, activations, misses, max execution)
+  * The task must outlive the recorder
+  *
+  * @param task Task to record
+  * @return int 0 on success, negative error code on failure
+  */
+ int recorder_add_task(task_t* task);
+
+ /**
+  * @brief Add a queue depth column
+  * The queue must outlive the recorder
+  *
+  * @param queue Queue to record
+  * @return int 0 on success, negative error code on failure
+  */
+ int recorder_add_queue(queue_t* queue);
+
+ /**
+  * @brief Open the output file and start sampling
+  * Columns cannot be added once started
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int recorder_start(void);
+
+ /**
+  * @brief Stop sampling, flush partial blocks and close the file
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int recorder_stop(void);
+
+ /**
+  * @brief Get recorder statistics
+  *
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int recorder_get_stats(recorder_stats_t* stats);
+
+ #endif /* RECORDER_H */
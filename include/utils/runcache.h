@@ -0,0 +1,128 @@
+/**
+ * @file runcache.h
+ * @brief Simulation result cache keyed by scenario hash
+ *
+ * This file defines an on-disk cache of simulation results. A run is
+ * identified by a 64-bit key hashed (FNV-1a) from everything that
+ * determines its outcome: the kernel build ID, the config.h hash, the
+ * system configuration hash emitted by sysgen, the scheduling policy and
+ * the run length. Sweeps that repeat a scenario read the stored result
+ * instead of running it again.
+ *
+ * File format: a header ("ORRC" version result_size) followed by
+ * fixed-size records { key, checksum, result }, appended in run order.
+ * The index (key to file offset) is rebuilt when the file is opened; a
+ * later record for the same key replaces an earlier one, and a torn or
+ * corrupt record at the end of the file is ignored.
+ */
+
+ #ifndef RUNCACHE_H
+ #define RUNCACHE_H
+
+ #include <stdint.h>
+ #include <stddef.h>
+ #include "../config.h"
+
+ /* Cache limits */
+ #define RUNCACHE_MAX_ENTRIES     4096    /* Results indexed per file (power of two) */
+ #define RUNCACHE_MAX_TASKS       16      /* Tasks per stored result */
+ #define RUNCACHE_NAME_LEN        16      /* Stored task name length */
+
+ /* Scenario key */
+ typedef uint64_t runcache_key_t;
+
+ /* Result of one task */
+ typedef struct {
+     char name[RUNCACHE_NAME_LEN];
+     uint32_t activations;        /* Number of activations */
+     uint32_t deadline_misses;    /* Number of deadline misses */
+     uint32_t max_execution_time; /* Longest observed execution (ticks) */
+     uint32_t total_runtime;      /* Total run time (ticks) */
+ } runcache_task_result_t;
+
+ /* Result of one run */
+ typedef struct {
+     uint32_t ticks;              /* Simulated run length */
+     uint32_t context_switches;   /* Scheduler context switches */
+     uint32_t deadline_misses;    /* Total deadline misses */
+     float cpu_load;              /* CPU load (0.0-1.0) */
+     uint32_t task_count;         /* Valid entries in tasks */
+     runcache_task_result_t tasks[RUNCACHE_MAX_TASKS];
+ } runcache_result_t;
+
+ /* Cache statistics */
+ typedef struct {
+     uint32_t entries;            /* Results in the index */
+     uint32_t hits;               /* Lookups answered from the file */
+     uint32_t misses;             /* Lookups that found nothing */
+     uint32_t stores;             /* Results appended */
+     uint32_t dropped;            /* Corrupt records skipped while loading */
+ } runcache_stats_t;
+
+ /**
+  * @brief Start a scenario key
+  *
+  * @param key Key to initialize
+  */
+ void runcache_key_init(runcache_key_t* key);
+
+ /**
+  * @brief Mix bytes into a scenario key
+  *
+  * @param key Key
+  * @param data Bytes to add
+  * @param length Number of bytes
+  */
+ void runcache_key_add(runcache_key_t* key, const void* data, size_t length);
+
+ /**
+  * @brief Mix a 32-bit value into a scenario key (byte order independent)
+  *
+  * @param key Key
+  * @param value Value to add
+  */
+ void runcache_key_add_u32(runcache_key_t* key, uint32_t value);
+
+ /**
+  * @brief Open a cache file, creating it if needed, and index its records
+  *
+  * @param path Cache file path
+  * @return int 0 on success, negative error code on failure
+  */
+ int runcache_open(const char* path);
+
+ /**
+  * @brief Look up a stored result
+  *
+  * @param key Scenario key
+  * @param result Receives the stored result
+  * @return int 0 on a hit, negative if not cached or on error
+  */
+ int runcache_lookup(runcache_key_t key, runcache_result_t* result);
+
+ /**
+  * @brief Store the result of a run
+  * The record is appended and flushed before returning
+  *
+  * @param key Scenario key
+  * @param result Result to store
+  * @return int 0 on success, negative error code on failure
+  */
+ int runcache_store(runcache_key_t key, const runcache_result_t* result);
+
+ /**
+  * @brief Close the cache file
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int runcache_close(void);
+
+ /**
+  * @brief Get cache statistics
+  *
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int runcache_get_stats(runcache_stats_t* stats);
+
+ #endif /* RUNCACHE_H */
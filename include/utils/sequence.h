@@ -0,0 +1,186 @@
+/**
+ * @file sequence.h
+ * @brief Stored-sequence engine for onboard automation
+ *
+ * This file defines a compact bytecode VM that runs many command
+ * sequences cooperatively inside one RTOS task. A sequence can wait,
+ * branch on telemetry, loop and issue commands; while it waits it costs
+ * only its slot, so hundreds of sequences do not need hundreds of tasks.
+ *
+ * Programs are verified once when loaded (opcodes, operand bounds, jump
+ * targets, stack depth), so the dispatch loop runs without checks. The
+ * loop uses threaded code (computed goto) under GCC and a switch
+ * elsewhere.
+ *
+ * Encoding: one opcode byte followed by little-endian operands. Jump
+ * offsets are signed 16-bit, relative to the next instruction. Values
+ * are signed 32-bit. Programs are written with the SEQ_* macros below:
+ *
+ *     static const uint8_t low_power[] = {
+ *         SEQ_TLM(TLM_BATTERY_PCT), SEQ_PUSH8(30), SEQ_OP(SEQ_LT),
+ *         SEQ_JZ(4),                              // skip the command
+ *         SEQ_PUSH8(MODE_SAFE), SEQ_CMD(CMD_SET_MODE),
+ *         SEQ_WAIT(100), SEQ_JMP(-21),            // re-check every second
+ *     };
+ */
+
+ #ifndef SEQUENCE_H
+ #define SEQUENCE_H
+
+ #include <stdint.h>
+ #include "../config.h"
+
+ /* Engine limits */
+ #define SEQ_MAX_SEQUENCES   256     /* Sequence slots */
+ #define SEQ_MAX_CODE        4096    /* Maximum program length in bytes */
+ #define SEQ_STACK_DEPTH     8       /* Operand stack entries per sequence */
+ #define SEQ_LOCALS          4       /* Local variables per sequence */
+ #define SEQ_BUDGET          256     /* Instructions per turn before yielding a tick */
+ #define SEQ_INVALID_HANDLE  0
+
+ /* Opcodes (operands in brackets) */
+ typedef enum {
+     SEQ_END,             /* Finish the sequence */
+     SEQ_PUSH8,           /* [i8]  push sign-extended byte */
+     SEQ_PUSH32,          /* [i32] push word */
+     SEQ_POP,             /* drop top */
+     SEQ_DUP,             /* duplicate top */
+     SEQ_LOAD,            /* [u8]  push local */
+     SEQ_STORE,           /* [u8]  pop into local */
+     SEQ_TLM,             /* [u16] push telemetry point */
+     SEQ_ADD,             /* a b -> a+b */
+     SEQ_SUB,             /* a b -> a-b */
+     SEQ_LT,              /* a b -> a<b */
+     SEQ_GT,              /* a b -> a>b */
+     SEQ_EQ,              /* a b -> a==b */
+     SEQ_NOT,             /* a -> !a */
+     SEQ_AND,             /* a b -> a&&b */
+     SEQ_OR,              /* a b -> a||b */
+     SEQ_JMP,             /* [i16] jump */
+     SEQ_JZ,              /* [i16] pop, jump if zero */
+     SEQ_JNZ,             /* [i16] pop, jump if not zero */
+     SEQ_LOOP,            /* [u8 i16] decrement local, jump if still positive */
+     SEQ_WAIT,            /* [u32] sleep for ticks */
+     SEQ_WAITS,           /* pop ticks, sleep */
+     SEQ_CMD,             /* [u8]  pop parameter, issue command of this type */
+     SEQ_OPCODE_COUNT
+ } seq_opcode_t;
+
+ /* Encoding helpers */
+ #define SEQ_OP(op)          (uint8_t)(op)
+ #define SEQ_B16(v)          (uint8_t)((v) & 0xFF), (uint8_t)(((v) >> 8) & 0xFF)
+ #define SEQ_B32(v)          SEQ_B16((uint32_t)(v) & 0xFFFF), SEQ_B16(((uint32_t)(v) >> 16) & 0xFFFF)
+ #define SEQ_PUSH8(v)        SEQ_OP(SEQ_PUSH8), (uint8_t)(int8_t)(v)
+ #define SEQ_PUSH32(v)       SEQ_OP(SEQ_PUSH32), SEQ_B32(v)
+ #define SEQ_LOAD(n)         SEQ_OP(SEQ_LOAD), (uint8_t)(n)
+ #define SEQ_STORE(n)        SEQ_OP(SEQ_STORE), (uint8_t)(n)
+ #define SEQ_TLM(id)         SEQ_OP(SEQ_TLM), SEQ_B16(id)
+ #define SEQ_JMP(off)        SEQ_OP(SEQ_JMP), SEQ_B16((uint16_t)(int16_t)(off))
+ #define SEQ_JZ(off)         SEQ_OP(SEQ_JZ), SEQ_B16((uint16_t)(int16_t)(off))
+ #define SEQ_JNZ(off)        SEQ_OP(SEQ_JNZ), SEQ_B16((uint16_t)(int16_t)(off))
+ #define SEQ_LOOP(n, off)    SEQ_OP(SEQ_LOOP), (uint8_t)(n), SEQ_B16((uint16_t)(int16_t)(off))
+ #define SEQ_WAIT(ticks)     SEQ_OP(SEQ_WAIT), SEQ_B32(ticks)
+ #define SEQ_CMD(type)       SEQ_OP(SEQ_CMD), (uint8_t)(type)
+
+ /* Sequence states */
+ typedef enum {
+     SEQ_STATE_FREE,      /* Slot never used */
+     SEQ_STATE_READY,     /* Runnable at wake_tick */
+     SEQ_STATE_DONE,      /* Reached SEQ_END */
+     SEQ_STATE_STOPPED,   /* Stopped by seq_stop() */
+     SEQ_STATE_FAULT      /* Runtime fault (stack, command rejected) */
+ } seq_state_t;
+
+ /* Telemetry and command hooks supplied by the application */
+ typedef int32_t (*seq_telemetry_fn)(uint16_t point, void* ctx);
+ typedef int (*seq_command_fn)(uint8_t type, int32_t parameter, void* ctx);
+
+ /* Engine configuration */
+ typedef struct {
+     seq_telemetry_fn telemetry;  /* Reads a telemetry point */
+     seq_command_fn command;      /* Issues a command, 0 on success */
+     void* ctx;                   /* Passed to both hooks */
+     uint8_t priority;            /* Engine task priority */
+ } seq_engine_config_t;
+
+ /* Status of one sequence */
+ typedef struct {
+     seq_state_t state;
+     uint32_t pc;                 /* Next instruction offset */
+     uint32_t wake_tick;          /* Tick the sequence next runs at */
+     uint32_t commands;           /* Commands issued */
+     uint32_t instructions;       /* Instructions executed */
+ } seq_status_t;
+
+ /* Engine statistics */
+ typedef struct {
+     uint32_t loaded;             /* Sequences loaded */
+     uint32_t active;             /* Sequences currently running */
+     uint32_t completed;          /* Sequences that reached SEQ_END */
+     uint32_t faults;             /* Sequences that faulted */
+     uint32_t turns;              /* Engine wakeups */
+     uint32_t instructions;       /* Instructions executed, all sequences */
+ } seq_engine_stats_t;
+
+ /**
+  * @brief Initialize the sequence engine
+  *
+  * @param config Engine configuration
+  * @return int 0 on success, negative error code on failure
+  */
+ int seq_engine_init(const seq_engine_config_t* config);
+
+ /**
+  * @brief Create the engine task and wakeup semaphore
+  *
+  * @return int 0 on success, negative error code on failure
+  */
+ int seq_engine_start(void);
+
+ /**
+  * @brief Verify and start a sequence
+  * The code is not copied and must outlive the sequence
+  *
+  * @param code Bytecode
+  * @param length Bytecode length in bytes
+  * @param handle Receives the sequence handle (may be NULL)
+  * @return int 0 on success, negative error code on failure (invalid code, no slot)
+  */
+ int seq_load(const uint8_t* code, uint32_t length, uint32_t* handle);
+
+ /**
+  * @brief Stop a running sequence
+  *
+  * @param handle Sequence handle
+  * @return int 0 on success, negative error code if the sequence is not running
+  */
+ int seq_stop(uint32_t handle);
+
+ /**
+  * @brief Get the status of a sequence
+  * Finished sequences stay readable until a new load reuses their slot
+  *
+  * @param handle Sequence handle
+  * @param status Pointer to status structure to fill
+  * @return int 0 on success, negative error code on failure (stale handle)
+  */
+ int seq_get_status(uint32_t handle, seq_status_t* status);
+
+ /**
+  * @brief Run every due sequence once
+  * Called by the engine task; exposed for tests and host tools
+  *
+  * @param now Current tick
+  * @return uint32_t Ticks until the next sequence is due (at least 1, MAX_TIMEOUT if none)
+  */
+ uint32_t seq_engine_run(uint32_t now);
+
+ /**
+  * @brief Get engine statistics
+  *
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int seq_engine_get_stats(seq_engine_stats_t* stats);
+
+ #endif /* SEQUENCE_H */
@@ -0,0 +1,151 @@
+/**
+ * @file tmcodec.h
+ * @brief Housekeeping telemetry compression
+ *
+ * This file defines a streaming codec for frames of housekeeping
+ * telemetry (a tick and up to 32 parameter values). Each value is
+ * predicted from the same parameter in the previous frame: integers are
+ * delta coded and floats XOR coded, and both are written as varints, so
+ * slowly changing parameters shrink to about one byte. Frames collect
+ * in a block of at most TMCODEC_BLOCK_SIZE bytes; a full block can then
+ * be passed through a small LZ77 stage that removes repeated patterns
+ * (e.g. counters stepping in lockstep) before it goes to the sink.
+ *
+ * Every block restarts prediction, so a block decodes on its own and a
+ * lost block costs only its own frames. Memory is fixed: the encoder
+ * and decoder hold one block each and the LZ hash table.
+ *
+ * The codec has no kernel dependencies, so host tools (the downlink
+ * decoder, tools/tmcodec_bench) link it as is.
+ */
+
+ #ifndef TMCODEC_H
+ #define TMCODEC_H
+
+ #include <stdint.h>
+
+ /* Codec limits */
+ #define TMCODEC_MAX_FIELDS   32      /* Parameters per frame */
+ #define TMCODEC_BLOCK_SIZE   1024    /* Delta-coded bytes per block */
+ #define TMCODEC_LZ_HASH_BITS 10      /* LZ match finder table: 2^bits entries */
+ #define TMCODEC_MAX_OUTPUT   (TMCODEC_BLOCK_SIZE + TMCODEC_BLOCK_SIZE / 255 + 16)
+
+ /* Field predictors */
+ #define TMCODEC_FIELD_INT    0       /* Integer: zigzag delta */
+ #define TMCODEC_FIELD_FLOAT  1       /* IEEE float: XOR with previous bits */
+
+ /* Encoder flags */
+ #define TMCODEC_FLAG_LZ      0x01    /* Run the LZ stage on each block */
+
+ /* Receives each finished block */
+ typedef int (*tmcodec_sink_fn)(const uint8_t* block, uint32_t length, void* ctx);
+
+ /* Receives each decoded frame */
+ typedef void (*tmcodec_frame_fn)(uint32_t tick, const uint32_t* values, uint32_t valid, void* ctx);
+
+ /* Encoder statistics */
+ typedef struct {
+     uint32_t frames;             /* Frames encoded */
+     uint32_t blocks;             /* Blocks emitted */
+     uint32_t lz_blocks;          /* Blocks the LZ stage made smaller */
+     uint32_t input_bytes;        /* Uncompressed size (tick and valid values, 4 bytes each) */
+     uint32_t coded_bytes;        /* Size after delta/XOR coding */
+     uint32_t output_bytes;       /* Size handed to the sink */
+ } tmcodec_stats_t;
+
+ /* Prediction state shared by encoder and decoder */
+ typedef struct {
+     uint8_t count;                          /* Fields per frame */
+     uint8_t types[TMCODEC_MAX_FIELDS];      /* TMCODEC_FIELD_* */
+     uint32_t prev[TMCODEC_MAX_FIELDS];      /* Previous value bits */
+     uint32_t prev_tick;                     /* Previous frame tick */
+     uint32_t prev_valid;                    /* Previous valid mask */
+ } tmcodec_model_t;
+
+ /* Encoder */
+ typedef struct {
+     tmcodec_model_t model;
+     uint8_t flags;                          /* TMCODEC_FLAG_* */
+     tmcodec_sink_fn sink;
+     void* ctx;
+     uint8_t block[TMCODEC_BLOCK_SIZE];      /* Delta-coded frames */
+     uint32_t length;                        /* Bytes in block */
+     uint8_t out[TMCODEC_MAX_OUTPUT];        /* Block after the LZ stage */
+     uint16_t hash[1 << TMCODEC_LZ_HASH_BITS];
+     tmcodec_stats_t stats;
+ } tmcodec_encoder_t;
+
+ /* Decoder */
+ typedef struct {
+     tmcodec_model_t model;
+     uint8_t block[TMCODEC_BLOCK_SIZE];      /* Block after LZ decoding */
+ } tmcodec_decoder_t;
+
+ /**
+  * @brief Initialize an encoder
+  *
+  * @param enc Encoder
+  * @param types Predictor of each field (TMCODEC_FIELD_*)
+  * @param count Number of fields (at most TMCODEC_MAX_FIELDS)
+  * @param flags TMCODEC_FLAG_* options
+  * @param sink Receives finished blocks
+  * @param ctx Passed to the sink
+  * @return int 0 on success, negative error code on failure
+  */
+ int tmcodec_encoder_init(tmcodec_encoder_t* enc, const uint8_t* types, uint8_t count,
+                          uint8_t flags, tmcodec_sink_fn sink, void* ctx);
+
+ /**
+  * @brief Encode one frame
+  * Emits the current block first if the frame might not fit
+  *
+  * @param enc Encoder
+  * @param tick Frame tick
+  * @param values Raw bits of each field (floats as their bit patterns)
+  * @param valid Bit i set if field i is valid; invalid fields are not sent
+  * @return int 0 on success, negative error code on failure (sink failed)
+  */
+ int tmcodec_encode(tmcodec_encoder_t* enc, uint32_t tick, const uint32_t* values, uint32_t valid);
+
+ /**
+  * @brief Emit the current block even if it is not full
+  *
+  * @param enc Encoder
+  * @return int 0 on success, negative error code on failure (sink failed)
+  */
+ int tmcodec_flush(tmcodec_encoder_t* enc);
+
+ /**
+  * @brief Get encoder statistics
+  *
+  * @param enc Encoder
+  * @param stats Pointer to statistics structure to fill
+  * @return int 0 on success, negative error code on failure
+  */
+ int tmcodec_get_stats(tmcodec_encoder_t* enc, tmcodec_stats_t* stats);
+
+ /**
+  * @brief Initialize a decoder
+  *
+  * @param dec Decoder
+  * @param types Predictor of each field, as given to the encoder
+  * @param count Number of fields
+  * @return int 0 on success, negative error code on failure
+  */
+ int tmcodec_decoder_init(tmcodec_decoder_t* dec, const uint8_t* types, uint8_t count);
+
+ /**
+  * @brief Decode one block
+  * Invalid fields are reported with their last valid value
+  *
+  * @param dec Decoder
+  * @param block Block as emitted by the encoder
+  * @param length Block length
+  * @param frame Called for each decoded frame
+  * @param ctx Passed to the frame callback
+  * @return int Frames decoded, negative error code if the block is corrupt
+  */
+ int tmcodec_decode(tmcodec_decoder_t* dec, const uint8_t* block, uint32_t length,
+                    tmcodec_frame_fn frame, void* ctx);
+
+ #endif /* TMCODEC_H */
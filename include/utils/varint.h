@@ -0,0 +1,81 @@
+/**
+ * @file varint.h
+ * @brief LEB128 varints and zigzag coding shared by the telemetry encoders
+ *
+ * Used by the telemetry codec (utils/tmcodec.h) and the flight recorder
+ * (utils/recorder.h): values are written 7 bits per byte, low bits first,
+ * with the top bit set on every byte but the last.
+ */
+
+ #ifndef VARINT_H
+ #define VARINT_H
+
+ #include <stdint.h>
+
+ /**
+  * @brief Zigzag-encode a signed delta so small magnitudes stay small
+  *
+  * @param value Signed value
+  * @return uint32_t Encoded value
+  */
+ static inline uint32_t varint_zigzag(int32_t value) {
+     return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+ }
+
+ /**
+  * @brief Undo zigzag encoding
+  *
+  * @param value Encoded value
+  * @return int32_t Signed value
+  */
+ static inline int32_t varint_unzigzag(uint32_t value) {
+     return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+ }
+
+ /**
+  * @brief Append an unsigned LEB128 varint
+  *
+  * @param out Output buffer, room for 10 bytes
+  * @param value Value to write
+  * @return uint32_t Bytes written
+  */
+ static inline uint32_t varint_put(uint8_t* out, uint64_t value) {
+     uint32_t n = 0;
+
+     while (value >= 0x80) {
+         out[n++] = (uint8_t)(value | 0x80);
+         value >>= 7;
+     }
+     out[n++] = (uint8_t)value;
+
+     return n;
+ }
+
+ /**
+  * @brief Read an unsigned LEB128 varint of at most 35 bits
+  *
+  * @param in Input buffer
+  * @param length Input length
+  * @param pos Read position, advanced past the varint
+  * @param value Decoded value
+  * @return int 0 on success, -1 if truncated or too long
+  */
+ static inline int varint_get(const uint8_t* in, uint32_t length, uint32_t* pos, uint64_t* value) {
+     uint64_t result = 0;
+
+     for (int shift = 0; shift < 35; shift += 7) {
+         if (*pos >= length) {
+             return -1;
+         }
+         uint8_t byte = in[(*pos)++];
+         result |= (uint64_t)(byte & 0x7F) << shift;
+         if ((byte & 0x80) == 0) {
+             *value = result;
+             return 0;
+         }
+     }
+
+     return -1;
+ }
+
+ #endif /* VARINT_H */
@@ -0,0 +1,337 @@
+/**
+ * @file hostrt.c
+ * @brief Implementation of the host real-time execution mode
+ *
+ * Every step degrades gracefully: without CAP_SYS_NICE or a sufficient
+ * RLIMIT_MEMLOCK the simulator still runs, the failure is logged and
+ * recorded in the status, and the self-check shows what that costs.
+ */
+
+ #define _GNU_SOURCE
+ #include <string.h>
+ #include <errno.h>
+ #include <time.h>
+ #include <sched.h>
+ #include <pthread.h>
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include "../../include/drivers/hostrt.h"
+ #include "../../include/kernel/task.h"
+ #include "../../include/kernel/heap.h"
+ #include "../../include/kernel/ipc.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ /* Self-check probe period and latency histogram (1 us bins) */
+ #define HOSTRT_PROBE_PERIOD_US   1000
+ #define HOSTRT_HIST_BINS         4096
+
+ /* External reference to task list */
+ extern task_t* task_list[MAX_TASKS];
+
+ static hostrt_config_t config;
+ static hostrt_status_t status;
+ static uint8_t initialized = 0;
+ static uint32_t latency_hist[HOSTRT_HIST_BINS];
+
+ /**
+  * Pin the calling thread to one CPU
+  */
+ static int pin_thread(int cpu) {
+     cpu_set_t set;
+
+     CPU_ZERO(&set);
+     CPU_SET(cpu, &set);
+
+     int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+     if (err != 0) {
+         LOG_WARNING("Cannot pin thread to CPU %d: %s", cpu, strerror(err));
+         return -1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Run the calling thread under SCHED_FIFO
+  */
+ static int set_fifo(int priority) {
+     struct sched_param param;
+
+     memset(&param, 0, sizeof(param));
+     param.sched_priority = priority;
+
+     int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+     if (err != 0) {
+         LOG_WARNING("Cannot set SCHED_FIFO priority %d: %s", priority, strerror(err));
+         return -1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Touch every page of a memory range, preserving its contents
+  */
+ static uint32_t prefault_range(void* start, uint32_t size) {
+     volatile uint8_t* p = (volatile uint8_t*)start;
+
+     if (p == NULL || size == 0) {
+         return 0;
+     }
+
+     for (uint32_t offset = 0; offset < size; offset += HOST_PAGE_SIZE) {
+         p[offset] = p[offset];
+     }
+     p[size - 1] = p[size - 1];
+
+     return size;
+ }
+
+ /**
+  * Touch the host stack below the caller so deep calls cannot page-fault
+  */
+ static uint32_t prefault_stack(uint32_t bytes) {
+     if (bytes == 0) {
+         return 0;
+     }
+
+     uint8_t area[bytes];
+     return prefault_range(area, bytes);
+ }
+
+ /**
+  * Monotonic time in microseconds
+  */
+ static uint64_t now_us(void) {
+     struct timespec ts;
+
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+ }
+
+ /**
+  * Page faults taken by the process so far
+  */
+ static uint32_t page_faults(void) {
+     struct rusage usage;
+
+     if (getrusage(RUSAGE_SELF, &usage) != 0) {
+         return 0;
+     }
+
+     return (uint32_t)(usage.ru_minflt + usage.ru_majflt);
+ }
+
+ /**
+  * Enter host real-time mode
+  */
+ int hostrt_init(const hostrt_config_t* cfg) {
+     if (cfg == NULL) {
+         LOG_ERROR("NULL host real-time configuration");
+         return -1;
+     }
+
+     if ((cfg->tick_priority != 0 &&
+          (cfg->tick_priority < sched_get_priority_min(SCHED_FIFO) ||
+           cfg->tick_priority > sched_get_priority_max(SCHED_FIFO))) ||
+         (cfg->sim_priority != 0 &&
+          (cfg->sim_priority < sched_get_priority_min(SCHED_FIFO) ||
+           cfg->sim_priority > sched_get_priority_max(SCHED_FIFO)))) {
+         LOG_ERROR("SCHED_FIFO priority out of range");
+         return -1;
+     }
+
+     memcpy(&config, cfg, sizeof(hostrt_config_t));
+     memset(&status, 0, sizeof(hostrt_status_t));
+     initialized = 1;
+
+     LOG_INFO("Entering host real-time mode");
+
+     /* Lock everything mapped now and later, so nothing can be paged out */
+     if (config.lock_memory) {
+         if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+             status.memory_locked = 1;
+         } else {
+             LOG_WARNING("mlockall failed: %s (check RLIMIT_MEMLOCK)", strerror(errno));
+         }
+     }
+
+     /* Threads created from here on (the tick thread) inherit the tick role */
+     return hostrt_set_role(HOSTRT_ROLE_TICK);
+ }
+
+ /**
+  * Apply a role's CPU affinity and priority to the calling thread
+  */
+ int hostrt_set_role(hostrt_role_t role) {
+     if (!initialized) {
+         LOG_ERROR("Host real-time mode not initialized");
+         return -1;
+     }
+
+     int cpu = (role == HOSTRT_ROLE_TICK) ? config.tick_cpu : config.sim_cpu;
+     int priority = (role == HOSTRT_ROLE_TICK) ? config.tick_priority : config.sim_priority;
+     uint8_t pinned = 0;
+     uint8_t fifo = 0;
+
+     if (cpu >= 0) {
+         pinned = (pin_thread(cpu) == 0);
+     }
+
+     if (priority > 0) {
+         fifo = (set_fifo(priority) == 0);
+     }
+
+     if (role == HOSTRT_ROLE_TICK) {
+         status.tick_pinned = pinned;
+         status.tick_fifo = fifo;
+     } else {
+         status.sim_pinned = pinned;
+         status.sim_fifo = fifo;
+     }
+
+     LOG_INFO("%s thread: cpu=%d%s, priority=%d%s",
+              (role == HOSTRT_ROLE_TICK) ? "Tick" : "Simulator",
+              cpu, pinned ? "" : " (not pinned)",
+              priority, fifo ? " SCHED_FIFO" : " (not real-time)");
+
+     return 0;
+ }
+
+ /**
+  * Prefault task stacks, queue buffers, the heap and the host stack
+  */
+ int hostrt_prefault(void) {
+     if (!initialized) {
+         LOG_ERROR("Host real-time mode not initialized");
+         return -1;
+     }
+
+     uint32_t total = 0;
+
+     /* Kernel heap: dynamic stacks and queue buffers */
+     total += heap_prefault();
+
+     /* Statically configured task stacks live outside the heap */
+     for (int i = 0; i < MAX_TASKS; i++) {
+         task_t* task = task_list[i];
+         if (task != NULL && task->static_alloc && task->context.stack_ptr != NULL) {
+             total += prefault_range(task->context.stack_ptr, task->context.stack_size);
+         }
+     }
+
+     /* Queue buffers, including caller-provided ones */
+     total += ipc_prefault();
+
+     /* Host stack that the scheduler and task functions run on */
+     total += prefault_stack(config.stack_prefault);
+
+     status.prefaulted_bytes = total;
+
+     LOG_INFO("Prefaulted %u bytes", total);
+
+     return 0;
+ }
+
+ /**
+  * Measure residual host wakeup jitter on the calling thread
+  */
+ int hostrt_selfcheck(void) {
+     if (!initialized) {
+         LOG_ERROR("Host real-time mode not initialized");
+         return -1;
+     }
+
+     if (config.selfcheck_ms == 0) {
+         return 0;
+     }
+
+     uint32_t samples = config.selfcheck_ms * 1000 / HOSTRT_PROBE_PERIOD_US;
+     uint64_t sum = 0;
+     uint32_t min = UINT32_MAX;
+     uint32_t max = 0;
+     uint32_t late = 0;
+
+     memset(latency_hist, 0, sizeof(latency_hist));
+
+     LOG_INFO("Measuring host jitter for %u ms", config.selfcheck_ms);
+
+     uint32_t faults_before = page_faults();
+     struct timespec next;
+     clock_gettime(CLOCK_MONOTONIC, &next);
+
+     for (uint32_t i = 0; i < samples; i++) {
+         /* Sleep to an absolute deadline, so wakeup errors do not accumulate */
+         next.tv_nsec += HOSTRT_PROBE_PERIOD_US * 1000L;
+         if (next.tv_nsec >= 1000000000L) {
+             next.tv_nsec -= 1000000000L;
+             next.tv_sec++;
+         }
+         while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {
+         }
+
+         uint64_t target = (uint64_t)next.tv_sec * 1000000ULL + (uint64_t)next.tv_nsec / 1000ULL;
+         uint64_t now = now_us();
+         uint32_t latency = (now > target) ? (uint32_t)(now - target) : 0;
+
+         sum += latency;
+         if (latency < min) {
+             min = latency;
+         }
+         if (latency > max) {
+             max = latency;
+         }
+         if (latency > config.jitter_limit_us) {
+             late++;
+         }
+         latency_hist[(latency < HOSTRT_HIST_BINS) ? latency : HOSTRT_HIST_BINS - 1]++;
+     }
+
+     status.page_faults = page_faults() - faults_before;
+
+     /* 99th percentile from the histogram */
+     uint32_t target_count = samples - samples / 100;
+     uint32_t seen = 0;
+     uint32_t p99 = max;
+     for (uint32_t bin = 0; bin < HOSTRT_HIST_BINS; bin++) {
+         seen += latency_hist[bin];
+         if (seen >= target_count) {
+             p99 = (bin < HOSTRT_HIST_BINS - 1) ? bin : max;
+             break;
+         }
+     }
+
+     status.samples = samples;
+     status.latency_min_us = (samples > 0) ? min : 0;
+     status.latency_avg_us = (samples > 0) ? (uint32_t)(sum / samples) : 0;
+     status.latency_p99_us = p99;
+     status.latency_max_us = max;
+     status.late_wakeups = late;
+
+     LOG_INFO("Host jitter: min=%u us, avg=%u us, p99=%u us, max=%u us, page faults=%u",
+              status.latency_min_us, status.latency_avg_us, status.latency_p99_us,
+              status.latency_max_us, status.page_faults);
+
+     if (late > 0 || !status.memory_locked || !status.sim_fifo) {
+         LOG_WARNING("%u of %u wakeups later than %u us; deadline misses below %u us "
+                     "may be host artifacts",
+                     late, samples, config.jitter_limit_us, status.latency_max_us);
+     }
+
+     return (late > 0) ? 1 : 0;
+ }
+
+ /**
+  * Get host real-time status
+  */
+ int hostrt_get_status(hostrt_status_t* out_status) {
+     if (out_status == NULL) {
+         LOG_ERROR("NULL status pointer");
+         return -1;
+     }
+
+     memcpy(out_status, &status, sizeof(hostrt_status_t));
+
+     return 0;
+ }
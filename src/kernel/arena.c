@@ -0,0 +1,249 @@
+/**
+ * @file arena.c
+ * @brief Implementation of the huge-page-backed kernel arena
+ *
+ * Layout: [TCB slab: MAX_TASKS slots][heap pool: KERNEL_HEAP_SIZE],
+ * rounded up to whole huge pages. Both parts are carved once at init;
+ * the slab recycles slots through a free index stack and the heap pool
+ * is managed by the TLSF allocator.
+ */
+
+ #define _GNU_SOURCE
+ #include <stdio.h>
+ #include <string.h>
+ #include <sys/mman.h>
+ #include "../../include/kernel/arena.h"
+ #include "../../include/kernel/context.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ #define ARENA_ALIGN_UP(x, a)  (((x) + ((a) - 1)) & ~((uintptr_t)(a) - 1))
+
+ /* Mapped region */
+ static uint8_t* arena_base = NULL;
+ static uint32_t arena_size = 0;
+ static arena_backing_t arena_backing = ARENA_BACKING_NONE;
+
+ /* TCB slab */
+ static uint8_t* tcb_slab = NULL;
+ static uint32_t tcb_stride = 0;
+ static uint16_t tcb_free[MAX_TASKS];
+ static uint32_t tcb_free_count = 0;
+
+ /* Heap pool */
+ static uint8_t* heap_pool_base = NULL;
+ static uint32_t heap_pool_size = 0;
+
+ /**
+  * Try reserved huge pages
+  */
+ static void* map_explicit(uint32_t size) {
+ #ifdef MAP_HUGETLB
+     void* p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+     return (p == MAP_FAILED) ? NULL : p;
+ #else
+     (void)size;
+     return NULL;
+ #endif
+ }
+
+ /**
+  * Map a huge-page-aligned region and advise transparent huge pages
+  */
+ static void* map_aligned(uint32_t size, arena_backing_t* backing) {
+     size_t span = (size_t)size + ARENA_HUGE_PAGE_SIZE;
+     uint8_t* raw = mmap(NULL, span, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+     if (raw == MAP_FAILED) {
+         return NULL;
+     }
+
+     /* Trim to a huge-page boundary so the kernel can use whole huge pages */
+     uint8_t* aligned = (uint8_t*)ARENA_ALIGN_UP((uintptr_t)raw, ARENA_HUGE_PAGE_SIZE);
+     size_t head = (size_t)(aligned - raw);
+     size_t tail = span - head - size;
+     if (head > 0) {
+         munmap(raw, head);
+     }
+     if (tail > 0) {
+         munmap(aligned + size, tail);
+     }
+
+     *backing = ARENA_BACKING_SMALL;
+ #ifdef MADV_HUGEPAGE
+     if (madvise(aligned, size, MADV_HUGEPAGE) == 0) {
+         *backing = ARENA_BACKING_TRANSPARENT;
+     }
+ #endif
+
+     return aligned;
+ }
+
+ /**
+  * Map the arena
+  */
+ int arena_init(void) {
+     if (arena_base != NULL) {
+         return 0;
+     }
+
+     /* Odd number of cache lines per slot spreads hot lines over all sets */
+     uint32_t lines = (uint32_t)((sizeof(task_t) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE);
+     if ((lines & 1) == 0) {
+         lines++;
+     }
+     tcb_stride = lines * CACHE_LINE_SIZE;
+
+     uint32_t slab_size = (uint32_t)ARENA_ALIGN_UP(tcb_stride * MAX_TASKS, CACHE_LINE_SIZE);
+     uint32_t size = (uint32_t)ARENA_ALIGN_UP(slab_size + KERNEL_HEAP_SIZE, ARENA_HUGE_PAGE_SIZE);
+
+     void* region = map_explicit(size);
+     arena_backing_t backing = ARENA_BACKING_EXPLICIT;
+     if (region == NULL) {
+         region = map_aligned(size, &backing);
+     }
+     if (region == NULL) {
+         LOG_ERROR("Failed to map kernel arena (%u bytes)", size);
+         return -1;
+     }
+
+     arena_base = (uint8_t*)region;
+     arena_size = size;
+     arena_backing = backing;
+
+     tcb_slab = arena_base;
+     heap_pool_base = arena_base + slab_size;
+     heap_pool_size = size - slab_size;
+
+     /* Hand out low slots first so live TCBs stay packed */
+     tcb_free_count = 0;
+     for (int i = MAX_TASKS - 1; i >= 0; i--) {
+         tcb_free[tcb_free_count++] = (uint16_t)i;
+     }
+
+     LOG_INFO("Kernel arena: %u bytes (%s), TCB stride %u, heap %u bytes",
+              size,
+              backing == ARENA_BACKING_EXPLICIT ? "explicit huge pages" :
+              backing == ARENA_BACKING_TRANSPARENT ? "transparent huge pages" : "small pages",
+              tcb_stride, heap_pool_size);
+
+     return 0;
+ }
+
+ /**
+  * Get the heap pool carved from the arena
+  */
+ void* arena_heap_pool(uint32_t* size) {
+     if (arena_base == NULL || size == NULL) {
+         return NULL;
+     }
+
+     *size = heap_pool_size;
+     return heap_pool_base;
+ }
+
+ /**
+  * Allocate a TCB slot
+  */
+ task_t* arena_tcb_alloc(void) {
+     if (arena_base == NULL) {
+         return NULL;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     if (tcb_free_count == 0) {
+         context_exit_critical(prev_state);
+         return NULL;
+     }
+     uint16_t slot = tcb_free[--tcb_free_count];
+
+     context_exit_critical(prev_state);
+
+     task_t* task = (task_t*)(tcb_slab + (uint32_t)slot * tcb_stride);
+     memset(task, 0, sizeof(task_t));
+
+     return task;
+ }
+
+ /**
+  * Return a TCB slot to the slab
+  */
+ int arena_tcb_free(task_t* task) {
+     uint8_t* p = (uint8_t*)task;
+
+     if (arena_base == NULL || p < tcb_slab || p >= tcb_slab + tcb_stride * MAX_TASKS ||
+         (uint32_t)(p - tcb_slab) % tcb_stride != 0) {
+         LOG_ERROR("TCB %p not from the kernel arena", (void*)task);
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+     tcb_free[tcb_free_count++] = (uint16_t)((uint32_t)(p - tcb_slab) / tcb_stride);
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
+
+ /**
+  * Bytes of the arena backed by huge pages, from /proc/self/smaps
+  */
+ static uint32_t arena_huge_bytes(void) {
+     FILE* smaps = fopen("/proc/self/smaps", "r");
+     char line[256];
+     uint32_t total = 0;
+     int in_arena = 0;
+
+     if (smaps == NULL) {
+         return 0;
+     }
+
+     while (fgets(line, sizeof(line), smaps) != NULL) {
+         unsigned long start, end;
+         unsigned long kb;
+
+         /* Mapping headers start with "start-end " */
+         if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+             in_arena = (start < (uintptr_t)(arena_base + arena_size) &&
+                         end > (uintptr_t)arena_base);
+             continue;
+         }
+
+         if (in_arena &&
+             (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 ||
+              sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1)) {
+             total += (uint32_t)(kb * 1024);
+         }
+     }
+
+     fclose(smaps);
+
+     return total;
+ }
+
+ /**
+  * Get arena statistics
+  */
+ int arena_get_stats(arena_stats_t* stats) {
+     if (stats == NULL) {
+         LOG_ERROR("NULL stats pointer");
+         return -1;
+     }
+
+     memset(stats, 0, sizeof(arena_stats_t));
+     stats->backing = arena_backing;
+
+     if (arena_base == NULL) {
+         return 0;
+     }
+
+     stats->size = arena_size;
+     stats->huge_bytes = arena_huge_bytes();
+     stats->tcb_stride = tcb_stride;
+     stats->tcb_slots = MAX_TASKS;
+     stats->tcb_used = MAX_TASKS - tcb_free_count;
+     stats->heap_size = heap_pool_size;
+
+     return 0;
+ }
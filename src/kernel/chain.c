@@ -0,0 +1,204 @@
+/**
+ * @file chain.c
+ * @brief Implementation of cause-effect chain latency measurement
+ *
+ * Stamps live in the tasks (task_t.chain_stamp) and in the slots of the
+ * linking queues (queue_track_stamps()), so propagation costs one copy
+ * per message and needs no per-chain lookup on the IPC path.
+ */
+
+ #include <string.h>
+ #include "../../include/kernel/chain.h"
+ #include "../../include/kernel/context.h"
+ #include "../../include/drivers/time.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ /* Chain storage */
+ static chain_t chains[MAX_CHAINS];
+ static uint8_t chain_used[MAX_CHAINS];
+
+ /**
+  * Check that a pointer is an allocated chain
+  */
+ static int chain_valid(const chain_t* chain) {
+     for (int i = 0; i < MAX_CHAINS; i++) {
+         if (&chains[i] == chain && chain_used[i]) {
+             return 1;
+         }
+     }
+
+     return 0;
+ }
+
+ /**
+  * Create an empty chain
+  */
+ chain_t* chain_create(const char* name, uint32_t deadline_us) {
+     int index = -1;
+
+     if (name == NULL) {
+         LOG_ERROR("Invalid chain parameters");
+         return NULL;
+     }
+
+     /* Find free slot */
+     for (int i = 0; i < MAX_CHAINS; i++) {
+         if (!chain_used[i]) {
+             index = i;
+             break;
+         }
+     }
+
+     if (index == -1) {
+         LOG_ERROR("No free chain slots");
+         return NULL;
+     }
+
+     /* Initialize chain */
+     chain_t* chain = &chains[index];
+     memset(chain, 0, sizeof(chain_t));
+     chain->deadline_us = deadline_us;
+     chain->stats.min_us = UINT32_MAX;
+     chain->stats.bin_us = (deadline_us > 0) ? (2 * deadline_us + CHAIN_HIST_BINS - 1) / CHAIN_HIST_BINS
+                                             : CHAIN_HIST_BIN_US;
+     strncpy(chain->name, name, MAX_TASK_NAME_LEN - 1);
+     chain->name[MAX_TASK_NAME_LEN - 1] = '\0';
+
+     /* Mark as used */
+     chain_used[index] = 1;
+
+     LOG_INFO("Created chain '%s' (deadline=%u us)", chain->name, deadline_us);
+
+     return chain;
+ }
+
+ /**
+  * Delete a chain
+  */
+ int chain_delete(chain_t* chain) {
+     if (chain == NULL || !chain_valid(chain)) {
+         LOG_ERROR("Invalid chain pointer");
+         return -1;
+     }
+
+     chain_used[chain - chains] = 0;
+
+     LOG_INFO("Deleted chain '%s'", chain->name);
+     return 0;
+ }
+
+ /**
+  * Append a stage
+  */
+ int chain_add_stage(chain_t* chain, task_t* task, queue_t* input) {
+     if (chain == NULL || task == NULL || !chain_valid(chain) ||
+         (input == NULL) != (chain->stage_count == 0)) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     if (chain->stage_count >= CHAIN_MAX_STAGES) {
+         LOG_ERROR("Chain '%s' has more than %d stages", chain->name, CHAIN_MAX_STAGES);
+         return -1;
+     }
+
+     if (input != NULL && queue_track_stamps(input) != 0) {
+         return -1;
+     }
+
+     chain->tasks[chain->stage_count] = task;
+     chain->links[chain->stage_count] = input;
+     chain->stage_count++;
+
+     return 0;
+ }
+
+ /**
+  * Stamp the data the current task has just sampled
+  */
+ int chain_sample(chain_t* chain) {
+     task_t* current = task_get_current();
+
+     if (chain == NULL || current == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     current->chain_stamp = timer_get_us();
+
+     uint32_t prev_state = context_enter_critical();
+     chain->stats.samples++;
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
+
+ /**
+  * Record the latency of the data the current task acts on
+  */
+ int chain_complete(chain_t* chain) {
+     task_t* current = task_get_current();
+
+     if (chain == NULL || current == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     uint64_t stamp = current->chain_stamp;
+     uint64_t now = timer_get_us();
+     chain_stats_t* stats = &chain->stats;
+
+     uint32_t prev_state = context_enter_critical();
+
+     if (stamp == 0 || stamp > now) {
+         stats->unstamped++;
+         context_exit_critical(prev_state);
+         return -1;
+     }
+
+     /* The same sample acted on again: the first output already counted */
+     if (stamp == chain->last_stamp) {
+         stats->repeats++;
+         context_exit_critical(prev_state);
+         return 0;
+     }
+     chain->last_stamp = stamp;
+
+     uint64_t age = now - stamp;
+     uint32_t latency = (age > UINT32_MAX) ? UINT32_MAX : (uint32_t)age;
+     uint32_t bin = latency / stats->bin_us;
+
+     stats->hist[(bin < CHAIN_HIST_BINS) ? bin : CHAIN_HIST_BINS - 1]++;
+     stats->completions++;
+     stats->total_us += latency;
+     if (latency < stats->min_us) {
+         stats->min_us = latency;
+     }
+     if (latency > stats->max_us) {
+         stats->max_us = latency;
+     }
+     if (chain->deadline_us > 0 && latency > chain->deadline_us) {
+         stats->misses++;
+     }
+
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
+
+ /**
+  * Get chain latency statistics
+  */
+ int chain_get_stats(chain_t* chain, chain_stats_t* stats) {
+     if (chain == NULL || stats == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+     memcpy(stats, &chain->stats, sizeof(chain_stats_t));
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
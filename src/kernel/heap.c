@@ -0,0 +1,508 @@
+/**
+ * @file heap.c
+ * @brief Implementation of the TLSF real-time heap
+ *
+ * Free blocks are kept in segregated lists indexed by a first level
+ * (power of two) and a second level (linear subdivision of that power).
+ * Two bitmaps record which lists are non-empty, so finding a suitable
+ * block is a pair of find-first-set operations regardless of heap state.
+ */
+
+ #include <string.h>
+ #include "../../include/kernel/heap.h"
+ #include "../../include/kernel/task.h"
+ #include "../../include/kernel/context.h"
+ #include "../../include/kernel/arena.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ /* Allocation granularity */
+ #define HEAP_ALIGN_LOG2      3
+ #define HEAP_ALIGN           (1u << HEAP_ALIGN_LOG2)
+
+ /* Second level: 16 lists per power of two */
+ #define SL_INDEX_COUNT_LOG2  4
+ #define SL_INDEX_COUNT       (1u << SL_INDEX_COUNT_LOG2)
+
+ /* First level: sizes below SMALL_BLOCK_SIZE share first-level list 0 */
+ #define FL_INDEX_SHIFT       (SL_INDEX_COUNT_LOG2 + HEAP_ALIGN_LOG2)
+ #define FL_INDEX_MAX         26
+ #define FL_INDEX_COUNT       (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+ #define SMALL_BLOCK_SIZE     (1u << FL_INDEX_SHIFT)
+
+ /* Block size flag (sizes are aligned so bit 0 is free) */
+ #define BLOCK_FREE           1u
+
+ #if KERNEL_HEAP_SIZE >= (1 << FL_INDEX_MAX)
+ #error "KERNEL_HEAP_SIZE exceeds the TLSF first-level index range"
+ #endif
+
+ /* Block header, followed by the payload */
+ typedef struct heap_block {
+     struct heap_block* prev_phys;   /* Previous block in memory, NULL for the first */
+     uint32_t size;                  /* Payload size | BLOCK_FREE */
+     task_t* owner;                  /* Owning task of a used block, NULL for kernel */
+ } heap_block_t;
+
+ /* Free-list links, stored in the payload of free blocks */
+ typedef struct {
+     heap_block_t* next_free;        /* Next block in the same size class */
+     heap_block_t* prev_free;        /* Previous block in the same size class */
+ } heap_links_t;
+
+ #define ALIGN_UP(x)          (((x) + (HEAP_ALIGN - 1)) & ~(uint32_t)(HEAP_ALIGN - 1))
+ #define BLOCK_HEADER_SIZE    ALIGN_UP((uint32_t)sizeof(heap_block_t))
+ #define BLOCK_MIN_SIZE       ALIGN_UP((uint32_t)sizeof(heap_links_t))
+
+ /* Backing pool: static, or carved from the huge-page kernel arena */
+ #if !ENABLE_KERNEL_ARENA
+ static uint8_t heap_static_pool[KERNEL_HEAP_SIZE] __attribute__((aligned(16)));
+ #endif
+ static uint8_t* heap_pool = NULL;
+ static uint32_t heap_pool_size = 0;
+
+ /* Segregated free lists and their occupancy bitmaps */
+ static uint32_t fl_bitmap;
+ static uint32_t sl_bitmap[FL_INDEX_COUNT];
+ static heap_block_t* free_lists[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+ /* First block in the pool (for walks) */
+ static heap_block_t* first_block = NULL;
+
+ /* Heap statistics */
+ static heap_stats_t stats;
+
+ /* Bit helpers */
+
+ static int heap_ffs(uint32_t word) {
+     return (word != 0) ? __builtin_ctz(word) : -1;
+ }
+
+ static int heap_fls(uint32_t word) {
+     return (word != 0) ? 31 - __builtin_clz(word) : -1;
+ }
+
+ /* Block helpers */
+
+ static uint32_t block_size(const heap_block_t* block) {
+     return block->size & ~BLOCK_FREE;
+ }
+
+ static int block_is_free(const heap_block_t* block) {
+     return (block->size & BLOCK_FREE) != 0;
+ }
+
+ static void* block_payload(const heap_block_t* block) {
+     return (uint8_t*)block + BLOCK_HEADER_SIZE;
+ }
+
+ static heap_block_t* block_from_payload(const void* ptr) {
+     return (heap_block_t*)((uint8_t*)ptr - BLOCK_HEADER_SIZE);
+ }
+
+ static heap_block_t* block_next(const heap_block_t* block) {
+     return (heap_block_t*)((uint8_t*)block_payload(block) + block_size(block));
+ }
+
+ static heap_links_t* block_links(const heap_block_t* block) {
+     return (heap_links_t*)block_payload(block);
+ }
+
+ /**
+  * Map a block size to the free list that holds it
+  */
+ static void mapping_insert(uint32_t size, int* fli, int* sli) {
+     if (size < SMALL_BLOCK_SIZE) {
+         *fli = 0;
+         *sli = (int)(size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+     } else {
+         int fl = heap_fls(size);
+         *sli = (int)((size >> (fl - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT);
+         *fli = fl - (FL_INDEX_SHIFT - 1);
+     }
+ }
+
+ /**
+  * Map a request size to the first list whose blocks are all large enough
+  */
+ static void mapping_search(uint32_t size, int* fli, int* sli) {
+     if (size >= SMALL_BLOCK_SIZE) {
+         uint32_t round = (1u << (heap_fls(size) - SL_INDEX_COUNT_LOG2)) - 1;
+         size += round;
+     }
+     mapping_insert(size, fli, sli);
+ }
+
+ /**
+  * Find a non-empty list at or above (fli, sli)
+  */
+ static heap_block_t* search_suitable_block(int* fli, int* sli) {
+     if (*fli >= FL_INDEX_COUNT) {
+         return NULL;
+     }
+
+     uint32_t sl_map = sl_bitmap[*fli] & (~0u << *sli);
+     if (sl_map == 0) {
+         /* No block in this first level, move to the next non-empty one */
+         uint32_t fl_map = (*fli + 1 < 32) ? (fl_bitmap & (~0u << (*fli + 1))) : 0;
+         if (fl_map == 0) {
+             return NULL;
+         }
+
+         *fli = heap_ffs(fl_map);
+         sl_map = sl_bitmap[*fli];
+     }
+
+     *sli = heap_ffs(sl_map);
+     return free_lists[*fli][*sli];
+ }
+
+ /**
+  * Unlink a free block from its list
+  */
+ static void remove_free_block(heap_block_t* block, int fli, int sli) {
+     heap_links_t* links = block_links(block);
+
+     if (links->prev_free != NULL) {
+         block_links(links->prev_free)->next_free = links->next_free;
+     } else {
+         free_lists[fli][sli] = links->next_free;
+     }
+
+     if (links->next_free != NULL) {
+         block_links(links->next_free)->prev_free = links->prev_free;
+     }
+
+     /* Clear bitmaps when the list empties */
+     if (free_lists[fli][sli] == NULL) {
+         sl_bitmap[fli] &= ~(1u << sli);
+         if (sl_bitmap[fli] == 0) {
+             fl_bitmap &= ~(1u << fli);
+         }
+     }
+
+     stats.free_bytes -= block_size(block);
+     stats.free_block_count--;
+ }
+
+ /**
+  * Push a free block onto the head of its list
+  */
+ static void insert_free_block(heap_block_t* block) {
+     int fli, sli;
+     mapping_insert(block_size(block), &fli, &sli);
+
+     heap_links_t* links = block_links(block);
+     links->prev_free = NULL;
+     links->next_free = free_lists[fli][sli];
+
+     if (links->next_free != NULL) {
+         block_links(links->next_free)->prev_free = block;
+     }
+     free_lists[fli][sli] = block;
+
+     fl_bitmap |= (1u << fli);
+     sl_bitmap[fli] |= (1u << sli);
+
+     block->size |= BLOCK_FREE;
+     stats.free_bytes += block_size(block);
+     stats.free_block_count++;
+ }
+
+ /**
+  * Unlink a free block, computing its list from its size
+  */
+ static void remove_free_block_sized(heap_block_t* block) {
+     int fli, sli;
+     mapping_insert(block_size(block), &fli, &sli);
+     remove_free_block(block, fli, sli);
+ }
+
+ /**
+  * Charge or credit a block to its owner
+  */
+ static void heap_account(task_t* owner, uint32_t size, int charge) {
+     if (charge) {
+         stats.used_bytes += size;
+         if (stats.used_bytes > stats.peak_used_bytes) {
+             stats.peak_used_bytes = stats.used_bytes;
+         }
+
+         if (owner != NULL) {
+             owner->heap_used += size;
+             if (owner->heap_used > owner->heap_peak) {
+                 owner->heap_peak = owner->heap_used;
+             }
+         }
+     } else {
+         stats.used_bytes -= size;
+
+         if (owner != NULL) {
+             owner->heap_used -= size;
+         }
+     }
+ }
+
+ /**
+  * Initialize the heap over the kernel pool
+  */
+ int heap_init(void) {
+ #if ENABLE_KERNEL_ARENA
+     if (arena_init() != 0) {
+         return -1;
+     }
+     heap_pool = (uint8_t*)arena_heap_pool(&heap_pool_size);
+
+     /* The arena rounds up to whole huge pages; stay within the TLSF range */
+     if (heap_pool_size >= (1u << FL_INDEX_MAX)) {
+         heap_pool_size = (1u << FL_INDEX_MAX) - HEAP_ALIGN;
+     }
+ #else
+     heap_pool = heap_static_pool;
+     heap_pool_size = KERNEL_HEAP_SIZE;
+ #endif
+
+     LOG_INFO("Initializing heap (%u bytes)", heap_pool_size);
+
+     memset(&stats, 0, sizeof(heap_stats_t));
+     memset(sl_bitmap, 0, sizeof(sl_bitmap));
+     memset(free_lists, 0, sizeof(free_lists));
+     fl_bitmap = 0;
+
+     uint32_t pool_size = heap_pool_size & ~(uint32_t)(HEAP_ALIGN - 1);
+     if (pool_size < 2 * BLOCK_HEADER_SIZE + BLOCK_MIN_SIZE) {
+         LOG_ERROR("Heap pool too small");
+         return -1;
+     }
+
+     /* One large free block followed by a zero-size used sentinel */
+     first_block = (heap_block_t*)heap_pool;
+     first_block->prev_phys = NULL;
+     first_block->size = pool_size - 2 * BLOCK_HEADER_SIZE;
+     first_block->owner = NULL;
+
+     heap_block_t* sentinel = block_next(first_block);
+     sentinel->prev_phys = first_block;
+     sentinel->size = 0;
+     sentinel->owner = NULL;
+
+     insert_free_block(first_block);
+
+     stats.pool_size = pool_size;
+
+     LOG_INFO("Heap initialized");
+     return 0;
+ }
+
+ /**
+  * Allocate memory charged to the current task
+  */
+ void* heap_alloc(size_t size) {
+     return heap_alloc_for(task_get_current(), size);
+ }
+
+ /**
+  * Allocate memory charged to a specific owner
+  */
+ void* heap_alloc_for(task_t* owner, size_t size) {
+     if (size == 0 || size >= (1u << FL_INDEX_MAX)) {
+         LOG_ERROR("Invalid allocation size %u", (uint32_t)size);
+         return NULL;
+     }
+
+     uint32_t adjusted = ALIGN_UP((uint32_t)size);
+     if (adjusted < BLOCK_MIN_SIZE) {
+         adjusted = BLOCK_MIN_SIZE;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     /* Enforce per-task quota */
+     if (owner != NULL && owner->heap_quota != 0 &&
+         owner->heap_used + adjusted > owner->heap_quota) {
+         stats.failed_allocs++;
+         context_exit_critical(prev_state);
+         LOG_WARNING("Task '%s' heap quota exceeded (%u + %u > %u)",
+                     owner->name, owner->heap_used, adjusted, owner->heap_quota);
+         return NULL;
+     }
+
+     /* Find a list guaranteed to satisfy the request */
+     int fli, sli;
+     mapping_search(adjusted, &fli, &sli);
+     heap_block_t* block = search_suitable_block(&fli, &sli);
+     if (block == NULL) {
+         stats.failed_allocs++;
+         context_exit_critical(prev_state);
+         LOG_WARNING("Heap exhausted allocating %u bytes", adjusted);
+         return NULL;
+     }
+
+     remove_free_block(block, fli, sli);
+     block->size &= ~BLOCK_FREE;
+
+     /* Split off the tail if it can hold another block */
+     uint32_t total = block_size(block);
+     if (total >= adjusted + BLOCK_HEADER_SIZE + BLOCK_MIN_SIZE) {
+         heap_block_t* remainder = (heap_block_t*)((uint8_t*)block_payload(block) + adjusted);
+         remainder->prev_phys = block;
+         remainder->size = total - adjusted - BLOCK_HEADER_SIZE;
+         remainder->owner = NULL;
+         block_next(remainder)->prev_phys = remainder;
+
+         block->size = adjusted;
+         insert_free_block(remainder);
+     }
+
+     block->owner = owner;
+     heap_account(owner, block_size(block), 1);
+     stats.alloc_count++;
+
+     context_exit_critical(prev_state);
+
+     return block_payload(block);
+ }
+
+ /**
+  * Release memory obtained from the heap
+  */
+ void heap_free(void* ptr) {
+     if (ptr == NULL) {
+         return;
+     }
+
+     if ((uint8_t*)ptr < heap_pool + BLOCK_HEADER_SIZE ||
+         (uint8_t*)ptr >= heap_pool + heap_pool_size) {
+         LOG_ERROR("Pointer %p not from heap", ptr);
+         return;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     heap_block_t* block = block_from_payload(ptr);
+     if (block_is_free(block)) {
+         context_exit_critical(prev_state);
+         LOG_ERROR("Double free of %p", ptr);
+         return;
+     }
+
+     heap_account(block->owner, block_size(block), 0);
+     block->owner = NULL;
+     stats.free_count++;
+
+     /* Coalesce with the previous physical block */
+     heap_block_t* prev = block->prev_phys;
+     if (prev != NULL && block_is_free(prev)) {
+         remove_free_block_sized(prev);
+         prev->size = block_size(prev) + BLOCK_HEADER_SIZE + block_size(block);
+         block = prev;
+         block_next(block)->prev_phys = block;
+     }
+
+     /* Coalesce with the next physical block */
+     heap_block_t* next = block_next(block);
+     if (block_is_free(next)) {
+         remove_free_block_sized(next);
+         block->size = block_size(block) + BLOCK_HEADER_SIZE + block_size(next);
+         block_next(block)->prev_phys = block;
+     }
+
+     insert_free_block(block);
+
+     context_exit_critical(prev_state);
+ }
+
+ /**
+  * Set a task's heap quota
+  */
+ int heap_set_quota(task_t* task, uint32_t quota) {
+     if (task == NULL) {
+         LOG_ERROR("NULL task pointer");
+         return -1;
+     }
+
+     task->heap_quota = quota;
+
+     LOG_INFO("Set task '%s' heap quota to %u bytes", task->name, quota);
+     return 0;
+ }
+
+ /**
+  * Transfer all blocks owned by a task to the kernel
+  */
+ uint32_t heap_release_task(task_t* task) {
+     if (task == NULL || first_block == NULL) {
+         return 0;
+     }
+
+     uint32_t released = task->heap_used;
+     if (released == 0) {
+         return 0;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     /* Walk physical blocks up to the zero-size sentinel */
+     for (heap_block_t* block = first_block; block_size(block) != 0; block = block_next(block)) {
+         if (!block_is_free(block) && block->owner == task) {
+             block->owner = NULL;
+         }
+     }
+     task->heap_used = 0;
+
+     context_exit_critical(prev_state);
+
+     LOG_WARNING("Task '%s' released with %u heap bytes outstanding", task->name, released);
+     return released;
+ }
+
+ /**
+  * Get heap statistics
+  */
+ int heap_get_stats(heap_stats_t* out_stats) {
+     if (out_stats == NULL) {
+         LOG_ERROR("NULL stats pointer");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     /* Largest free block lives in the highest non-empty list */
+     uint32_t largest = 0;
+     int fli = heap_fls(fl_bitmap);
+     if (fli >= 0) {
+         int sli = heap_fls(sl_bitmap[fli]);
+         for (heap_block_t* block = free_lists[fli][sli]; block != NULL;
+              block = block_links(block)->next_free) {
+             if (block_size(block) > largest) {
+                 largest = block_size(block);
+             }
+         }
+     }
+     stats.largest_free_block = largest;
+
+     if (stats.free_bytes > 0) {
+         stats.fragmentation = 1.0f - (float)largest / (float)stats.free_bytes;
+     } else {
+         stats.fragmentation = 0.0f;
+     }
+
+     memcpy(out_stats, &stats, sizeof(heap_stats_t));
+
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
+
+ /**
+  * Touch every page of the pool, preserving its contents
+  */
+ uint32_t heap_prefault(void) {
+     volatile uint8_t* pool = heap_pool;
+
+     for (uint32_t offset = 0; offset < heap_pool_size; offset += HOST_PAGE_SIZE) {
+         pool[offset] = pool[offset];
+     }
+
+     return heap_pool_size;
+ }
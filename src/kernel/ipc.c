@@ -1,12 +1,7 @@
 /**
- * Send a message to a queue
+ * Put a message into a queue, blocking while it is full
  */
- int queue_send(queue_t* queue, const void* msg, uint32_t timeout) {
-    if (queue == NULL || msg == NULL) {
-        LOG_ERROR("Invalid parameters");
-        return -1;
-    }
-    
+static int queue_put(queue_t* queue, const void* msg, uint32_t timeout) {
     /* Enter critical section */
     uint32_t prev_state = context_enter_critical();
     
@@ -33,6 +28,12 @@
                 memcpy(task_buffer, msg, queue->msg_size);
             }
             
+            /* Hand the sender's chain sample time over with the message */
+            if (queue->stamps != NULL) {
+                task_t* sender = task_get_current();
+                task->chain_stamp = (sender != NULL) ? sender->chain_stamp : 0;
+            }
+            
             /* Unblock the task */
             scheduler_unblock_task(task);
             
@@ -102,6 +103,10 @@
     /* Queue not full, add message */
     uint8_t* buffer = (uint8_t*)queue->buffer;
     memcpy(buffer + (queue->tail * queue->msg_size), msg, queue->msg_size);
+    if (queue->stamps != NULL) {
+        task_t* sender = task_get_current();
+        queue->stamps[queue->tail] = (sender != NULL) ? sender->chain_stamp : 0;
+    }
     
     /* Update tail pointer */
     queue->tail = (queue->tail + 1) % queue->capacity;
@@ -113,6 +118,42 @@
     return 0;
 }
 
+/**
+ * Send a message to a queue
+ */
+ int queue_send(queue_t* queue, const void* msg, uint32_t timeout) {
+    if (queue == NULL || msg == NULL) {
+        LOG_ERROR("Invalid parameters");
+        return -1;
+    }
+    
+    overhead_charge(OVH_QUEUE_SEND);
+    
+    if (queue->ratelimit == NULL) {
+        return queue_put(queue, msg, timeout);
+    }
+    
+    /* Shaped queue: wait for a token first, charging the wait to the timeout */
+    uint32_t start = time_get_ticks();
+    
+    if (ratelimit_acquire(queue->ratelimit, 1, timeout) != 0) {
+        return -1;
+    }
+    
+    if (timeout != MAX_TIMEOUT) {
+        uint32_t waited = time_get_ticks() - start;
+        timeout = (waited < timeout) ? timeout - waited : 0;
+    }
+    
+    /* Only a message that was sent uses up its token */
+    int result = queue_put(queue, msg, timeout);
+    if (result != 0) {
+        ratelimit_refund(queue->ratelimit, 1);
+    }
+    
+    return result;
+}
+
 /**
  * Receive a message from a queue
  */
@@ -122,6 +163,8 @@ int queue_receive(queue_t* queue, void* msg, uint32_t timeout) {
         return -1;
     }
     
+    overhead_charge(OVH_QUEUE_RECEIVE);
+    
     /* Enter critical section */
     uint32_t prev_state = context_enter_critical();
     
@@ -148,6 +191,14 @@ int queue_receive(queue_t* queue, void* msg, uint32_t timeout) {
                 memcpy(msg, task_buffer, queue->msg_size);
             }
             
+            /* Take over the sender's chain sample time */
+            if (queue->stamps != NULL) {
+                task_t* receiver = task_get_current();
+                if (receiver != NULL) {
+                    receiver->chain_stamp = task->chain_stamp;
+                }
+            }
+            
             /* Unblock the task */
             scheduler_unblock_task(task);
             
@@ -217,6 +268,12 @@ int queue_receive(queue_t* queue, void* msg, uint32_t timeout) {
     /* Queue not empty, get message */
     uint8_t* buffer = (uint8_t*)queue->buffer;
     memcpy(msg, buffer + (queue->head * queue->msg_size), queue->msg_size);
+    if (queue->stamps != NULL) {
+        task_t* receiver = task_get_current();
+        if (receiver != NULL) {
+            receiver->chain_stamp = queue->stamps[queue->head];
+        }
+    }
     
     /* Update head pointer */
     queue->head = (queue->head + 1) % queue->capacity;
@@ -242,6 +299,9 @@ int queue_receive(queue_t* queue, void* msg, uint32_t timeout) {
         if (task_buffer != NULL) {
             uint8_t* buffer = (uint8_t*)queue->buffer;
             memcpy(buffer + (queue->tail * queue->msg_size), task_buffer, queue->msg_size);
+            if (queue->stamps != NULL) {
+                queue->stamps[queue->tail] = task->chain_stamp;
+            }
             
             /* Update tail pointer */
             queue->tail = (queue->tail + 1) % queue->capacity;
@@ -630,10 +690,15 @@ uint32_t event_group_get_flags(event_group_t* group) {
 #include <stdlib.h>
 #include <string.h>
 #include "../../include/kernel/ipc.h"
+#include "../../include/kernel/atomic.h"
+#include "../../include/kernel/heap.h"
+#include "../../include/kernel/trace.h"
+#include "../../include/kernel/overhead.h"
 #include "../../include/kernel/task.h"
 #include "../../include/kernel/scheduler.h"
 #include "../../include/kernel/context.h"
 #include "../../include/kernel/time.h"
+#include "../../include/drivers/time.h"
 #include "../../include/utils/logger.h"
 #include "../../include/utils/list.h"
 #include "../../include/config.h"
@@ -643,12 +708,14 @@ static semaphore_t semaphores[MAX_SEMAPHORES];
 static mutex_t mutexes[MAX_SEMAPHORES];  /* Reuse same limit */
 static queue_t queues[MAX_QUEUES];
 static event_group_t event_groups[MAX_SEMAPHORES];  /* Reuse same limit */
+static ratelimit_t ratelimits[MAX_RATELIMITS];
 
 /* Track usage of IPC objects */
 static uint8_t semaphore_used[MAX_SEMAPHORES];
 static uint8_t mutex_used[MAX_SEMAPHORES];
 static uint8_t queue_used[MAX_QUEUES];
 static uint8_t event_group_used[MAX_SEMAPHORES];
+static uint8_t ratelimit_used[MAX_RATELIMITS];
 
 /**
  * Initialize the IPC subsystem
@@ -661,11 +728,36 @@ int ipc_init(void) {
     memset(mutex_used, 0, sizeof(mutex_used));
     memset(queue_used, 0, sizeof(queue_used));
     memset(event_group_used, 0, sizeof(event_group_used));
+    memset(ratelimit_used, 0, sizeof(ratelimit_used));
     
     LOG_INFO("IPC subsystem initialized");
     return 0;
 }
 
+/**
+ * Touch every page of all queue buffers, preserving their contents
+ */
+uint32_t ipc_prefault(void) {
+    uint32_t total = 0;
+    
+    for (int i = 0; i < MAX_QUEUES; i++) {
+        if (!queue_used[i] || queues[i].buffer == NULL) {
+            continue;
+        }
+        
+        volatile uint8_t* buffer = (volatile uint8_t*)queues[i].buffer;
+        size_t size = queues[i].msg_size * queues[i].capacity;
+        
+        for (size_t offset = 0; offset < size; offset += HOST_PAGE_SIZE) {
+            buffer[offset] = buffer[offset];
+        }
+        buffer[size - 1] = buffer[size - 1];
+        total += (uint32_t)size;
+    }
+    
+    return total;
+}
+
 /* Semaphore functions */
 
 /**
@@ -698,6 +790,7 @@ semaphore_t* semaphore_create(const char* name, uint32_t initial_count, uint32_t
     sem = &semaphores[index];
     sem->count = initial_count;
     sem->max_count = max_count;
+    sem->waiters = 0;
     sem->waiting_tasks = NULL;
     strncpy(sem->name, name, MAX_TASK_NAME_LEN - 1);
     sem->name[MAX_TASK_NAME_LEN - 1] = '\0';
@@ -754,6 +847,22 @@ int semaphore_delete(semaphore_t* sem) {
     return 0;
 }
 
+/**
+ * Try to take a semaphore without blocking
+ */
+static int semaphore_try_take(semaphore_t* sem) {
+    uint32_t count = atomic_load_u32(&sem->count);
+    
+    while (count > 0) {
+        if (atomic_cas_u32(&sem->count, count, count - 1)) {
+            return 1;
+        }
+        count = atomic_load_u32(&sem->count);
+    }
+    
+    return 0;
+}
+
 /**
  * Take (acquire) a semaphore
  */
@@ -763,13 +872,22 @@ int semaphore_take(semaphore_t* sem, uint32_t timeout) {
         return -1;
     }
     
+    overhead_charge(OVH_SEM_TAKE);
+    
+    /* Fast path: uncontended take is a single CAS */
+    if (semaphore_try_take(sem)) {
+        return 0;
+    }
+    
     /* Enter critical section */
     uint32_t prev_state = context_enter_critical();
     
-    /* Check if semaphore is available */
-    if (sem->count > 0) {
-        /* Semaphore available, decrement count */
-        sem->count--;
+    /* Announce ourselves before re-checking so a concurrent give takes the slow path */
+    atomic_add_u32(&sem->waiters, 1);
+    
+    /* Check if semaphore became available */
+    if (semaphore_try_take(sem)) {
+        atomic_sub_u32(&sem->waiters, 1);
         context_exit_critical(prev_state);
         return 0;
     }
@@ -778,6 +896,7 @@ int semaphore_take(semaphore_t* sem, uint32_t timeout) {
     
     /* If timeout is 0, return immediately */
     if (timeout == 0) {
+        atomic_sub_u32(&sem->waiters, 1);
         context_exit_critical(prev_state);
         return -1;  /* Timeout */
     }
@@ -786,6 +905,7 @@ int semaphore_take(semaphore_t* sem, uint32_t timeout) {
     task_t* current = task_get_current();
     if (current == NULL) {
         LOG_ERROR("No current task");
+        atomic_sub_u32(&sem->waiters, 1);
         context_exit_critical(prev_state);
         return -1;
     }
@@ -806,6 +926,12 @@ int semaphore_take(semaphore_t* sem, uint32_t timeout) {
     int result = scheduler_block_task(current, BLOCK_REASON_SEMAPHORE, sem);
     if (result != 0) {
         LOG_ERROR("Failed to block task");
+        sem->waiting_tasks = current->next;
+        if (sem->waiting_tasks != NULL) {
+            sem->waiting_tasks->prev = NULL;
+        }
+        current->next = NULL;
+        atomic_sub_u32(&sem->waiters, 1);
         context_exit_critical(prev_state);
         return -1;
     }
@@ -820,7 +946,25 @@ int semaphore_take(semaphore_t* sem, uint32_t timeout) {
     
     /* Check if we got the semaphore */
     if (current->block_reason != BLOCK_REASON_NONE) {
-        /* Timeout occurred */
+        /* Timeout occurred, remove from waiting list */
+        prev_state = context_enter_critical();
+        
+        if (current->prev != NULL) {
+            current->prev->next = current->next;
+        } else if (sem->waiting_tasks == current) {
+            sem->waiting_tasks = current->next;
+        }
+        
+        if (current->next != NULL) {
+            current->next->prev = current->prev;
+        }
+        
+        current->next = NULL;
+        current->prev = NULL;
+        atomic_sub_u32(&sem->waiters, 1);
+        
+        context_exit_critical(prev_state);
+        
         return -1;
     }
     
@@ -836,11 +980,27 @@ int semaphore_give(semaphore_t* sem) {
         return -1;
     }
     
+    overhead_charge(OVH_SEM_GIVE);
+    
+    /* Fast path: nobody waiting, just bump the count */
+    while (atomic_load_u32(&sem->waiters) == 0) {
+        uint32_t count = atomic_load_u32(&sem->count);
+        
+        if (count >= sem->max_count) {
+            LOG_WARNING("Semaphore '%s' already at maximum count", sem->name);
+            return -1;
+        }
+        
+        if (atomic_cas_u32(&sem->count, count, count + 1)) {
+            return 0;
+        }
+    }
+    
     /* Enter critical section */
     uint32_t prev_state = context_enter_critical();
     
     /* Check if at maximum count */
-    if (sem->count >= sem->max_count) {
+    if (atomic_load_u32(&sem->count) >= sem->max_count) {
         LOG_WARNING("Semaphore '%s' already at maximum count", sem->name);
         context_exit_critical(prev_state);
         return -1;
@@ -861,6 +1021,9 @@ int semaphore_give(semaphore_t* sem) {
         task->next = NULL;
         task->prev = NULL;
         
+        /* Hand the unit directly to the waiter */
+        atomic_sub_u32(&sem->waiters, 1);
+        
         /* Unblock the task */
         scheduler_unblock_task(task);
         
@@ -873,8 +1036,8 @@ int semaphore_give(semaphore_t* sem) {
         return 0;
     }
     
-    /* No tasks waiting, increment count */
-    sem->count++;
+    /* Waiter has not queued yet, increment count for its re-check */
+    atomic_add_u32(&sem->count, 1);
     
     /* Exit critical section */
     context_exit_critical(prev_state);
@@ -891,16 +1054,18 @@ uint32_t semaphore_get_count(semaphore_t* sem) {
         return 0;
     }
     
-    /* Enter critical section */
-    uint32_t prev_state = context_enter_critical();
-    uint32_t count = sem->count;
-    context_exit_critical(prev_state);
-    
-    return count;
+    return atomic_load_u32(&sem->count);
 }
 
 /* Mutex functions */
 
+/**
+ * Extract the owner task from a mutex state word
+ */
+static task_t* mutex_state_owner(uintptr_t state) {
+    return (task_t*)(state & ~MUTEX_STATE_WAITERS);
+}
+
 /**
  * Create a mutex
  */
@@ -929,8 +1094,7 @@ mutex_t* mutex_create(const char* name) {
     
     /* Initialize mutex */
     mutex = &mutexes[index];
-    mutex->locked = 0;
-    mutex->owner = NULL;
+    mutex->state = MUTEX_STATE_UNLOCKED;
     mutex->waiting_tasks = NULL;
     strncpy(mutex->name, name, MAX_TASK_NAME_LEN - 1);
     mutex->name[MAX_TASK_NAME_LEN - 1] = '\0';
@@ -967,13 +1131,13 @@ int mutex_delete(mutex_t* mutex) {
     }
     
     /* Check if mutex is locked */
-    if (mutex->locked) {
+    task_t* owner = mutex_state_owner(atomic_load_ptr(&mutex->state));
+    if (owner != NULL) {
         LOG_WARNING("Deleting locked mutex '%s'", mutex->name);
         
         /* Restore owner's priority if needed */
-        if (mutex->owner != NULL && 
-            mutex->owner->priority != mutex->owner->original_priority) {
-            task_set_priority(mutex->owner, mutex->owner->original_priority);
+        if (owner->priority != owner->original_priority) {
+            task_boost_priority(owner, owner->original_priority);
         }
     }
     
@@ -1006,46 +1170,59 @@ int mutex_lock(mutex_t* mutex, uint32_t timeout) {
         return -1;
     }
     
-    /* Enter critical section */
-    uint32_t prev_state = context_enter_critical();
+    overhead_charge(OVH_MUTEX_LOCK);
     
     /* Get current task */
     task_t* current = task_get_current();
     if (current == NULL) {
         LOG_ERROR("No current task");
-        context_exit_critical(prev_state);
-        return -1;
-    }
-    
-    /* Check if mutex is already locked by this task */
-    if (mutex->locked && mutex->owner == current) {
-        LOG_WARNING("Task '%s' attempting to lock mutex '%s' it already owns",
-                   current->name, mutex->name);
-        context_exit_critical(prev_state);
         return -1;
     }
     
-    /* Check if mutex is available */
-    if (!mutex->locked) {
-        /* Mutex available, lock it */
-        mutex->locked = 1;
-        mutex->owner = current;
-        context_exit_critical(prev_state);
+    /* Fast path: uncontended lock claims ownership with a single CAS */
+    if (atomic_cas_ptr(&mutex->state, MUTEX_STATE_UNLOCKED, (uintptr_t)current)) {
+        trace_event(TRACE_MUTEX_LOCK, current, 0, trace_object_id(mutex));
         return 0;
     }
     
-    /* Mutex not available */
+    /* Enter critical section */
+    uint32_t prev_state = context_enter_critical();
     
-    /* If timeout is 0, return immediately */
-    if (timeout == 0) {
-        context_exit_critical(prev_state);
-        return -1;  /* Timeout */
+    /* Mark the mutex contended so the owner's unlock takes the slow path */
+    uintptr_t state = atomic_load_ptr(&mutex->state);
+    for (;;) {
+        /* Released since the fast path failed, take it */
+        if (state == MUTEX_STATE_UNLOCKED) {
+            if (atomic_cas_ptr(&mutex->state, MUTEX_STATE_UNLOCKED, (uintptr_t)current)) {
+                context_exit_critical(prev_state);
+                trace_event(TRACE_MUTEX_LOCK, current, 0, trace_object_id(mutex));
+                return 0;
+            }
+        } else if (mutex_state_owner(state) == current) {
+            /* Check if mutex is already locked by this task */
+            LOG_WARNING("Task '%s' attempting to lock mutex '%s' it already owns",
+                       current->name, mutex->name);
+            context_exit_critical(prev_state);
+            return -1;
+        } else if (timeout == 0) {
+            /* If timeout is 0, return immediately */
+            context_exit_critical(prev_state);
+            return -1;  /* Timeout */
+        } else if ((state & MUTEX_STATE_WAITERS) != 0 ||
+                   atomic_cas_ptr(&mutex->state, state, state | MUTEX_STATE_WAITERS)) {
+            break;
+        }
+        
+        state = atomic_load_ptr(&mutex->state);
     }
     
+    /* Mutex not available */
+    task_t* owner = mutex_state_owner(state);
+    
     /* Priority inheritance - boost owner's priority if needed */
-    if (current->priority < mutex->owner->priority) {
+    if (current->priority < owner->priority) {
         /* Current task has higher priority (lower value) */
-        task_set_priority(mutex->owner, current->priority);
+        task_boost_priority(owner, current->priority);
     }
     
     /* Set up delay if timeout is not infinite */
@@ -1064,6 +1241,11 @@ int mutex_lock(mutex_t* mutex, uint32_t timeout) {
     int result = scheduler_block_task(current, BLOCK_REASON_MUTEX, mutex);
     if (result != 0) {
         LOG_ERROR("Failed to block task");
+        mutex->waiting_tasks = current->next;
+        if (mutex->waiting_tasks != NULL) {
+            mutex->waiting_tasks->prev = NULL;
+        }
+        current->next = NULL;
         context_exit_critical(prev_state);
         return -1;
     }
@@ -1074,7 +1256,7 @@ int mutex_lock(mutex_t* mutex, uint32_t timeout) {
     /* Trigger context switch */
     scheduler_context_switch();
     
-    /* When we get here, either the mutex was unlocked or timeout occurred */
+    /* When we get here, either the mutex was handed to us or timeout occurred */
     
     /* Check if we got the mutex */
     if (current->block_reason != BLOCK_REASON_NONE) {
@@ -1096,6 +1278,15 @@ int mutex_lock(mutex_t* mutex, uint32_t timeout) {
         current->next = NULL;
         current->prev = NULL;
         
+        /* Last waiter gone, let the owner unlock on the fast path again */
+        if (mutex->waiting_tasks == NULL) {
+            state = atomic_load_ptr(&mutex->state);
+            while ((state & MUTEX_STATE_WAITERS) != 0 &&
+                   !atomic_cas_ptr(&mutex->state, state, state & ~MUTEX_STATE_WAITERS)) {
+                state = atomic_load_ptr(&mutex->state);
+            }
+        }
+        
         context_exit_critical(prev_state);
         
         return -1;
@@ -1113,26 +1304,35 @@ int mutex_unlock(mutex_t* mutex) {
         return -1;
     }
     
-    /* Enter critical section */
-    uint32_t prev_state = context_enter_critical();
+    overhead_charge(OVH_MUTEX_UNLOCK);
     
     /* Get current task */
     task_t* current = task_get_current();
     if (current == NULL) {
         LOG_ERROR("No current task");
-        context_exit_critical(prev_state);
         return -1;
     }
     
+    /* Fast path: no waiters, release ownership with a single CAS */
+    if (atomic_cas_ptr(&mutex->state, (uintptr_t)current, MUTEX_STATE_UNLOCKED)) {
+        trace_event(TRACE_MUTEX_UNLOCK, current, 0, trace_object_id(mutex));
+        return 0;
+    }
+    
+    /* Enter critical section */
+    uint32_t prev_state = context_enter_critical();
+    
+    uintptr_t state = atomic_load_ptr(&mutex->state);
+    
     /* Check if mutex is locked */
-    if (!mutex->locked) {
+    if (state == MUTEX_STATE_UNLOCKED) {
         LOG_WARNING("Attempting to unlock mutex '%s' that is not locked", mutex->name);
         context_exit_critical(prev_state);
         return -1;
     }
     
     /* Check if current task owns the mutex */
-    if (mutex->owner != current) {
+    if (mutex_state_owner(state) != current) {
         LOG_WARNING("Task '%s' attempting to unlock mutex '%s' it doesn't own",
                    current->name, mutex->name);
         context_exit_critical(prev_state);
@@ -1141,9 +1341,11 @@ int mutex_unlock(mutex_t* mutex) {
     
     /* Restore owner's priority if it was boosted */
     if (current->priority != current->original_priority) {
-        task_set_priority(current, current->original_priority);
+        task_boost_priority(current, current->original_priority);
     }
     
+    trace_event(TRACE_MUTEX_UNLOCK, current, 0, trace_object_id(mutex));
+    
     /* Check if tasks are waiting */
     if (mutex->waiting_tasks != NULL) {
         /* Unblock highest priority waiting task */
@@ -1175,8 +1377,10 @@ int mutex_unlock(mutex_t* mutex) {
         highest->next = NULL;
         highest->prev = NULL;
         
-        /* Set new owner */
-        mutex->owner = highest;
+        /* Hand ownership to the waiter, keeping the contended flag if others remain */
+        atomic_store_ptr(&mutex->state, (uintptr_t)highest |
+                         (mutex->waiting_tasks != NULL ? MUTEX_STATE_WAITERS : 0));
+        trace_event(TRACE_MUTEX_LOCK, highest, 0, trace_object_id(mutex));
         
         /* Unblock the task */
         scheduler_unblock_task(highest);
@@ -1191,8 +1395,7 @@ int mutex_unlock(mutex_t* mutex) {
     }
     
     /* No tasks waiting, unlock mutex */
-    mutex->locked = 0;
-    mutex->owner = NULL;
+    atomic_store_ptr(&mutex->state, MUTEX_STATE_UNLOCKED);
     
     /* Exit critical section */
     context_exit_critical(prev_state);
@@ -1209,12 +1412,19 @@ int mutex_is_locked(mutex_t* mutex) {
         return -1;
     }
     
-    /* Enter critical section */
-    uint32_t prev_state = context_enter_critical();
-    int locked = mutex->locked;
-    context_exit_critical(prev_state);
+    return atomic_load_ptr(&mutex->state) != MUTEX_STATE_UNLOCKED;
+}
+
+/**
+ * Get the task that currently owns a mutex
+ */
+task_t* mutex_get_owner(mutex_t* mutex) {
+    if (mutex == NULL) {
+        LOG_ERROR("NULL mutex pointer");
+        return NULL;
+    }
     
-    return locked;
+    return mutex_state_owner(atomic_load_ptr(&mutex->state));
 }
 
 /* Message queue functions */
@@ -1223,11 +1433,39 @@ int mutex_is_locked(mutex_t* mutex) {
  * Create a message queue
  */
 queue_t* queue_create(const char* name, size_t msg_size, uint32_t capacity) {
+    /* Validate parameters */
+    if (name == NULL || msg_size == 0 || capacity == 0) {
+        LOG_ERROR("Invalid queue parameters");
+        return NULL;
+    }
+    
+    /* Allocate buffer for queue messages (kernel-owned) */
+    void* buffer = heap_alloc_for(NULL, msg_size * capacity);
+    if (buffer == NULL) {
+        LOG_ERROR("Failed to allocate queue buffer");
+        return NULL;
+    }
+    
+    queue_t* queue = queue_create_static(name, msg_size, capacity, buffer);
+    if (queue == NULL) {
+        heap_free(buffer);
+        return NULL;
+    }
+    
+    queue->owns_buffer = 1;
+    return queue;
+}
+
+/**
+ * Create a message queue over a caller-provided buffer
+ */
+queue_t* queue_create_static(const char* name, size_t msg_size, uint32_t capacity,
+                             void* buffer) {
     queue_t* queue = NULL;
     int index = -1;
     
     /* Validate parameters */
-    if (name == NULL || msg_size == 0 || capacity == 0) {
+    if (name == NULL || msg_size == 0 || capacity == 0 || buffer == NULL) {
         LOG_ERROR("Invalid queue parameters");
         return NULL;
     }
@@ -1245,13 +1483,6 @@ queue_t* queue_create(const char* name, size_t msg_size, uint32_t capacity) {
         return NULL;
     }
     
-    /* Allocate buffer for queue messages */
-    void* buffer = malloc(msg_size * capacity);
-    if (buffer == NULL) {
-        LOG_ERROR("Failed to allocate queue buffer");
-        return NULL;
-    }
-    
     /* Initialize queue */
     queue = &queues[index];
     queue->buffer = buffer;
@@ -1262,6 +1493,9 @@ queue_t* queue_create(const char* name, size_t msg_size, uint32_t capacity) {
     queue->tail = 0;
     queue->waiting_send = NULL;
     queue->waiting_recv = NULL;
+    queue->owns_buffer = 0;
+    queue->ratelimit = NULL;
+    queue->stamps = NULL;
     strncpy(queue->name, name, MAX_TASK_NAME_LEN - 1);
     queue->name[MAX_TASK_NAME_LEN - 1] = '\0';
     
@@ -1323,9 +1557,13 @@ int queue_delete(queue_t* queue) {
         }
     }
     
-    /* Free buffer */
-    if (queue->buffer != NULL) {
-        free(queue->buffer);
+    /* Free buffer (static buffers belong to the caller) */
+    if (queue->buffer != NULL && queue->owns_buffer) {
+        heap_free(queue->buffer);
+    }
+    if (queue->stamps != NULL) {
+        heap_free(queue->stamps);
+        queue->stamps = NULL;
     }
     
     /* Mark as unused */
@@ -1333,4 +1571,226 @@ int queue_delete(queue_t* queue) {
     
     LOG_INFO("Deleted queue '%s'", queue->name);
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * Shape a queue's senders with a rate limiter
+ */
+int queue_set_ratelimit(queue_t* queue, ratelimit_t* limiter) {
+    if (queue == NULL) {
+        LOG_ERROR("NULL queue pointer");
+        return -1;
+    }
+    
+    queue->ratelimit = limiter;
+    
+    return 0;
+}
+
+/**
+ * Carry chain sample times through a queue
+ */
+int queue_track_stamps(queue_t* queue) {
+    if (queue == NULL) {
+        LOG_ERROR("NULL queue pointer");
+        return -1;
+    }
+    
+    if (queue->stamps != NULL) {
+        return 0;
+    }
+    
+    uint64_t* stamps = (uint64_t*)heap_alloc_for(NULL, queue->capacity * sizeof(uint64_t));
+    if (stamps == NULL) {
+        LOG_ERROR("Failed to allocate stamps for queue '%s'", queue->name);
+        return -1;
+    }
+    
+    /* Messages already queued carry no sample time */
+    memset(stamps, 0, queue->capacity * sizeof(uint64_t));
+    
+    uint32_t prev_state = context_enter_critical();
+    queue->stamps = stamps;
+    context_exit_critical(prev_state);
+    
+    return 0;
+}
+
+/* Rate limiter functions */
+
+/**
+ * Limiter clock: microseconds, so tokens refill between ticks
+ */
+static uint64_t ratelimit_now(void) {
+    return timer_get_us();
+}
+
+/**
+ * Create a token-bucket rate limiter
+ */
+ratelimit_t* ratelimit_create(const char* name, uint32_t rate, uint32_t burst) {
+    ratelimit_t* limiter = NULL;
+    int index = -1;
+    
+    /* Validate parameters */
+    if (name == NULL || rate == 0 || rate > 1000000 || burst == 0) {
+        LOG_ERROR("Invalid rate limiter parameters");
+        return NULL;
+    }
+    
+    /* Waiters sleep whole ticks, so a sender gets at most burst + 1 tokens per tick */
+    if (rate > (burst + 1) * 1000 / MILLISECONDS_PER_TICK) {
+        LOG_ERROR("Rate %u/s needs a burst of at least %u at a %u ms tick",
+                  rate, (rate * MILLISECONDS_PER_TICK + 999) / 1000 - 1, MILLISECONDS_PER_TICK);
+        return NULL;
+    }
+    
+    /* Find free slot */
+    for (int i = 0; i < MAX_RATELIMITS; i++) {
+        if (!ratelimit_used[i]) {
+            index = i;
+            break;
+        }
+    }
+    
+    if (index == -1) {
+        LOG_ERROR("No free rate limiter slots");
+        return NULL;
+    }
+    
+    /* Initialize rate limiter; tat == now means a full bucket */
+    limiter = &ratelimits[index];
+    memset(limiter, 0, sizeof(ratelimit_t));
+    limiter->interval_us = 1000000 / rate;
+    limiter->burst = burst;
+    strncpy(limiter->name, name, MAX_TASK_NAME_LEN - 1);
+    limiter->name[MAX_TASK_NAME_LEN - 1] = '\0';
+    
+    /* Mark as used */
+    ratelimit_used[index] = 1;
+    
+    LOG_INFO("Created rate limiter '%s' (rate=%u/s, burst=%u)", limiter->name, rate, burst);
+    
+    return limiter;
+}
+
+/**
+ * Delete a rate limiter
+ */
+int ratelimit_delete(ratelimit_t* limiter) {
+    if (limiter == NULL) {
+        LOG_ERROR("NULL rate limiter pointer");
+        return -1;
+    }
+    
+    /* Find index of this rate limiter */
+    int index = -1;
+    for (int i = 0; i < MAX_RATELIMITS; i++) {
+        if (&ratelimits[i] == limiter) {
+            index = i;
+            break;
+        }
+    }
+    
+    if (index == -1) {
+        LOG_ERROR("Invalid rate limiter pointer");
+        return -1;
+    }
+    
+    /* Mark as unused */
+    ratelimit_used[index] = 0;
+    
+    LOG_INFO("Deleted rate limiter '%s'", limiter->name);
+    return 0;
+}
+
+/**
+ * Take tokens, waiting for the refill if needed
+ */
+int ratelimit_acquire(ratelimit_t* limiter, uint32_t tokens, uint32_t timeout) {
+    if (limiter == NULL || tokens == 0 || tokens > limiter->burst) {
+        LOG_ERROR("Invalid parameters");
+        return -1;
+    }
+    
+    /* Enter critical section */
+    uint32_t prev_state = context_enter_critical();
+    
+    uint64_t now = ratelimit_now();
+    uint64_t tat = (limiter->tat_us > now) ? limiter->tat_us : now;
+    uint64_t new_tat = tat + (uint64_t)tokens * limiter->interval_us;
+    uint64_t limit = now + (uint64_t)limiter->burst * limiter->interval_us;
+    
+    /* Enough tokens in the bucket */
+    if (new_tat <= limit) {
+        limiter->tat_us = new_tat;
+        limiter->granted += tokens;
+        context_exit_critical(prev_state);
+        return 0;
+    }
+    
+    /* Ticks until the bucket has refilled enough */
+    uint64_t us_per_tick = MILLISECONDS_PER_TICK * 1000;
+    uint64_t wait_ticks = (new_tat - limit + us_per_tick - 1) / us_per_tick;
+    
+    if (timeout == 0 || (timeout != MAX_TIMEOUT && wait_ticks > timeout) ||
+        task_get_current() == NULL) {
+        limiter->rejected++;
+        context_exit_critical(prev_state);
+        return -1;  /* Timeout */
+    }
+    
+    /* Reserve the tokens now, so later callers queue up behind us */
+    limiter->tat_us = new_tat;
+    limiter->granted += tokens;
+    limiter->throttled++;
+    
+    /* Exit critical section */
+    context_exit_critical(prev_state);
+    
+    task_delay((uint32_t)wait_ticks);
+    
+    return 0;
+}
+
+/**
+ * Give back tokens taken for an operation that then failed
+ */
+int ratelimit_refund(ratelimit_t* limiter, uint32_t tokens) {
+    if (limiter == NULL || tokens == 0) {
+        LOG_ERROR("Invalid parameters");
+        return -1;
+    }
+    
+    uint32_t prev_state = context_enter_critical();
+    
+    uint64_t credit = (uint64_t)tokens * limiter->interval_us;
+    limiter->tat_us = (limiter->tat_us > credit) ? limiter->tat_us - credit : 0;
+    limiter->granted = (limiter->granted > tokens) ? limiter->granted - tokens : 0;
+    
+    context_exit_critical(prev_state);
+    
+    return 0;
+}
+
+/**
+ * Get the tokens that could be taken now without waiting
+ */
+uint32_t ratelimit_get_available(ratelimit_t* limiter) {
+    if (limiter == NULL) {
+        LOG_ERROR("NULL rate limiter pointer");
+        return 0;
+    }
+    
+    uint32_t prev_state = context_enter_critical();
+    
+    uint64_t now = ratelimit_now();
+    uint64_t debt = (limiter->tat_us > now) ? limiter->tat_us - now : 0;
+    uint64_t capacity = (uint64_t)limiter->burst * limiter->interval_us;
+    uint32_t available = (debt >= capacity) ? 0 :
+                         (uint32_t)((capacity - debt) / limiter->interval_us);
+    
+    context_exit_critical(prev_state);
+    
+    return available;
+}
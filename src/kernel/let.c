@@ -0,0 +1,511 @@
+/**
+ * @file let.c
+ * @brief Implementation of logical execution time communication
+ *
+ * Each task bound to a variable owns one heap copy of it. The copy
+ * instants of every LET task are kept per task table slot and only the
+ * earliest one is checked on a tick, so ticks without a release or
+ * deadline of a LET task cost one comparison.
+ */
+
+ #include <string.h>
+ #include "../../include/kernel/let.h"
+ #include "../../include/kernel/context.h"
+ #include "../../include/kernel/heap.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ /* A task's copy of a variable */
+ typedef struct {
+     task_t* task;                /* Bound task */
+     let_var_t* var;              /* Variable */
+     void* copy;                  /* Task's copy */
+     uint8_t output;              /* 1 = published at deadlines, 0 = read at releases */
+     uint8_t used;                /* Slot in use */
+ } let_binding_t;
+
+ /* Copy instants of a task */
+ typedef struct {
+     const task_t* task;          /* Task in this table slot */
+     uint32_t read_at;            /* Next release */
+     uint32_t publish_at;         /* Deadline of the job released at or before read_at */
+     uint8_t bindings;            /* Bindings of the task (0 = not on the timeline) */
+     uint8_t started;             /* First release passed */
+     uint8_t done;                /* Current job called let_job_done() */
+ } let_timeline_t;
+
+ /* Variable and binding storage */
+ static let_var_t vars[MAX_LET_VARS];
+ static uint8_t var_used[MAX_LET_VARS];
+ static let_binding_t bindings[MAX_LET_BINDINGS];
+
+ /* Timelines, indexed by task table slot */
+ static let_timeline_t timelines[MAX_TASKS];
+
+ /* Earliest copy instant over all timelines */
+ static uint32_t next_event;
+ static uint8_t timeline_count;
+
+ static let_stats_t let_stats;
+
+ /**
+  * Check that a pointer is an allocated variable
+  */
+ static int var_valid(const let_var_t* var) {
+     for (int i = 0; i < MAX_LET_VARS; i++) {
+         if (&vars[i] == var && var_used[i]) {
+             return 1;
+         }
+     }
+
+     return 0;
+ }
+
+ /**
+  * Recompute the earliest copy instant (called in a critical section)
+  */
+ static void update_next_event(void) {
+     uint8_t first = 1;
+
+     for (int i = 0; i < MAX_TASKS; i++) {
+         const let_timeline_t* line = &timelines[i];
+
+         if (line->bindings == 0) {
+             continue;
+         }
+         uint32_t at = (line->publish_at < line->read_at) ? line->publish_at : line->read_at;
+         if (first || at < next_event) {
+             next_event = at;
+             first = 0;
+         }
+     }
+ }
+
+ /**
+  * Put a task's first copy instants on its timeline (called in a critical section)
+  */
+ static void timeline_align(let_timeline_t* line, const task_t* task) {
+     line->task = task;
+     line->read_at = task->next_release;
+     line->publish_at = task->next_release + task->deadline;
+     line->started = 0;
+     line->done = 0;
+ }
+
+ /**
+  * Find the binding of a task to a variable
+  */
+ static let_binding_t* binding_find(const task_t* task, const let_var_t* var, uint8_t output) {
+     for (int i = 0; i < MAX_LET_BINDINGS; i++) {
+         let_binding_t* binding = &bindings[i];
+
+         if (binding->used && binding->task == task && binding->var == var && binding->output == output) {
+             return binding;
+         }
+     }
+
+     return NULL;
+ }
+
+ /**
+  * Drop a binding and its copy (called in a critical section)
+  */
+ static void binding_drop(let_binding_t* binding) {
+     let_timeline_t* line = &timelines[binding->task->id];
+
+     if (binding->output) {
+         binding->var->writer = NULL;
+     }
+     heap_free(binding->copy);
+     binding->used = 0;
+
+     if (--line->bindings == 0) {
+         line->task = NULL;
+         timeline_count--;
+     }
+ }
+
+ /**
+  * Initialize the LET subsystem
+  */
+ int let_init(void) {
+     memset(vars, 0, sizeof(vars));
+     memset(var_used, 0, sizeof(var_used));
+     memset(bindings, 0, sizeof(bindings));
+     memset(timelines, 0, sizeof(timelines));
+     memset(&let_stats, 0, sizeof(let_stats));
+     next_event = 0;
+     timeline_count = 0;
+
+     return 0;
+ }
+
+ /**
+  * Create a LET variable
+  */
+ let_var_t* let_var_create(const char* name, size_t size, const void* initial) {
+     int index = -1;
+
+     if (name == NULL || size == 0) {
+         LOG_ERROR("Invalid LET variable parameters");
+         return NULL;
+     }
+
+     /* Find free slot */
+     for (int i = 0; i < MAX_LET_VARS; i++) {
+         if (!var_used[i]) {
+             index = i;
+             break;
+         }
+     }
+
+     if (index == -1) {
+         LOG_ERROR("No free LET variable slots");
+         return NULL;
+     }
+
+     /* Allocate published value */
+     void* value = heap_alloc_for(NULL, size);
+     if (value == NULL) {
+         LOG_ERROR("Failed to allocate LET variable '%s'", name);
+         return NULL;
+     }
+     if (initial != NULL) {
+         memcpy(value, initial, size);
+     } else {
+         memset(value, 0, size);
+     }
+
+     /* Initialize variable */
+     let_var_t* var = &vars[index];
+     var->value = value;
+     var->size = size;
+     var->writer = NULL;
+     strncpy(var->name, name, MAX_TASK_NAME_LEN - 1);
+     var->name[MAX_TASK_NAME_LEN - 1] = '\0';
+
+     /* Mark as used */
+     var_used[index] = 1;
+
+     LOG_INFO("Created LET variable '%s' (%u bytes)", var->name, (unsigned)size);
+
+     return var;
+ }
+
+ /**
+  * Delete a LET variable and its bindings
+  */
+ int let_var_delete(let_var_t* var) {
+     if (var == NULL || !var_valid(var)) {
+         LOG_ERROR("Invalid LET variable pointer");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     for (int i = 0; i < MAX_LET_BINDINGS; i++) {
+         if (bindings[i].used && bindings[i].var == var) {
+             binding_drop(&bindings[i]);
+         }
+     }
+     update_next_event();
+     var_used[var - vars] = 0;
+
+     context_exit_critical(prev_state);
+
+     heap_free(var->value);
+     var->value = NULL;
+
+     LOG_INFO("Deleted LET variable '%s'", var->name);
+     return 0;
+ }
+
+ /**
+  * Bind a task to a variable in one direction
+  */
+ static int let_bind(task_t* task, let_var_t* var, uint8_t output) {
+     int index = -1;
+
+     if (task == NULL || var == NULL || !var_valid(var)) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     if (task->period == 0 || task->deadline == 0 || task->deadline > task->period) {
+         LOG_ERROR("LET task '%s' needs a period and a deadline no longer than it", task->name);
+         return -1;
+     }
+
+     if (output && var->writer != NULL) {
+         LOG_ERROR("LET variable '%s' already written by '%s'", var->name, var->writer->name);
+         return -1;
+     }
+
+     if (binding_find(task, var, output) != NULL) {
+         LOG_ERROR("Task '%s' already bound to LET variable '%s'", task->name, var->name);
+         return -1;
+     }
+
+     /* Find free slot */
+     for (int i = 0; i < MAX_LET_BINDINGS; i++) {
+         if (!bindings[i].used) {
+             index = i;
+             break;
+         }
+     }
+
+     if (index == -1) {
+         LOG_ERROR("No free LET binding slots");
+         return -1;
+     }
+
+     void* copy = heap_alloc_for(NULL, var->size);
+     if (copy == NULL) {
+         LOG_ERROR("Failed to allocate LET copy of '%s' for '%s'", var->name, task->name);
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     memcpy(copy, var->value, var->size);
+
+     let_binding_t* binding = &bindings[index];
+     binding->task = task;
+     binding->var = var;
+     binding->copy = copy;
+     binding->output = output;
+     binding->used = 1;
+     if (output) {
+         var->writer = task;
+     }
+
+     /* The task joins the timeline at its next release */
+     let_timeline_t* line = &timelines[task->id];
+     if (line->bindings++ == 0) {
+         timeline_align(line, task);
+         timeline_count++;
+     }
+     update_next_event();
+
+     context_exit_critical(prev_state);
+
+     LOG_INFO("Bound task '%s' to LET variable '%s' as %s", task->name, var->name,
+              output ? "writer" : "reader");
+     return 0;
+ }
+
+ /**
+  * Give a periodic task an input copy of a variable
+  */
+ int let_bind_input(task_t* task, let_var_t* var) {
+     return let_bind(task, var, 0);
+ }
+
+ /**
+  * Make a periodic task the writer of a variable
+  */
+ int let_bind_output(task_t* task, let_var_t* var) {
+     return let_bind(task, var, 1);
+ }
+
+ /**
+  * The current task's input copy of a variable
+  */
+ const void* let_input(const let_var_t* var) {
+     let_binding_t* binding = binding_find(task_get_current(), var, 0);
+
+     return (binding != NULL) ? binding->copy : NULL;
+ }
+
+ /**
+  * The current task's output copy of a variable
+  */
+ void* let_output(let_var_t* var) {
+     let_binding_t* binding = binding_find(task_get_current(), var, 1);
+
+     return (binding != NULL) ? binding->copy : NULL;
+ }
+
+ /**
+  * End the current task's job
+  */
+ int let_job_done(void) {
+     task_t* current = task_get_current();
+
+     if (current == NULL) {
+         LOG_ERROR("No current task");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     let_timeline_t* line = &timelines[current->id];
+     if (line->bindings == 0 || line->task != current) {
+         context_exit_critical(prev_state);
+         LOG_ERROR("Task '%s' has no LET bindings", current->name);
+         return -1;
+     }
+     line->done = 1;
+
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
+
+ /**
+  * Copy the published value of a variable
+  */
+ int let_var_read(const let_var_t* var, void* dst) {
+     if (var == NULL || dst == NULL || !var_valid(var)) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+     memcpy(dst, var->value, var->size);
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
+
+ /**
+  * Make the copies due at a tick
+  */
+ void let_tick(uint32_t now) {
+     uint8_t publish_due[MAX_TASKS];
+     uint8_t read_due[MAX_TASKS];
+     uint32_t copies = 0;
+
+     if (timeline_count == 0 || now < next_event) {
+         return;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     /* Decide which tasks copy at this tick, and step their timelines */
+     for (int i = 0; i < MAX_TASKS; i++) {
+         let_timeline_t* line = &timelines[i];
+         publish_due[i] = 0;
+         read_due[i] = 0;
+
+         if (line->bindings == 0) {
+             continue;
+         }
+         const task_t* task = line->task;
+
+         /* A job blocked mid-job is as unfinished as a running one */
+         if (line->started && now >= line->publish_at) {
+             if (!line->done) {
+                 let_stats.publish_overruns++;
+             } else {
+                 publish_due[i] = 1;
+             }
+             while (line->publish_at <= now) {
+                 line->publish_at += task->period;
+             }
+         }
+
+         if (now >= line->read_at) {
+             /* Before the first release the task is still setting up */
+             if (line->started && !line->done) {
+                 let_stats.read_overruns++;
+             } else {
+                 read_due[i] = 1;
+                 line->done = 0;
+             }
+             while (line->read_at <= now) {
+                 line->read_at += task->period;
+             }
+             line->started = 1;
+         }
+     }
+
+     /* Publish first, so jobs released at this tick see the new outputs */
+     for (int i = 0; i < MAX_LET_BINDINGS; i++) {
+         let_binding_t* binding = &bindings[i];
+
+         if (binding->used && binding->output && publish_due[binding->task->id]) {
+             memcpy(binding->var->value, binding->copy, binding->var->size);
+             let_stats.publishes++;
+             let_stats.bytes += binding->var->size;
+             copies++;
+         }
+     }
+
+     for (int i = 0; i < MAX_LET_BINDINGS; i++) {
+         let_binding_t* binding = &bindings[i];
+
+         if (binding->used && !binding->output && read_due[binding->task->id]) {
+             memcpy(binding->copy, binding->var->value, binding->var->size);
+             let_stats.reads++;
+             let_stats.bytes += binding->var->size;
+             copies++;
+         }
+     }
+
+     if (copies > 0) {
+         let_stats.instants++;
+         if (copies > let_stats.max_batch) {
+             let_stats.max_batch = copies;
+         }
+     }
+
+     update_next_event();
+
+     context_exit_critical(prev_state);
+ }
+
+ /**
+  * Realign a task's copy instants
+  */
+ void let_task_update(const task_t* task) {
+     if (task == NULL) {
+         return;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     let_timeline_t* line = &timelines[task->id];
+     if (line->bindings > 0 && line->task == task) {
+         timeline_align(line, task);
+         update_next_event();
+     }
+
+     context_exit_critical(prev_state);
+ }
+
+ /**
+  * Drop a task's bindings
+  */
+ void let_task_remove(const task_t* task) {
+     if (task == NULL) {
+         return;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     for (int i = 0; i < MAX_LET_BINDINGS; i++) {
+         if (bindings[i].used && bindings[i].task == task) {
+             binding_drop(&bindings[i]);
+         }
+     }
+     update_next_event();
+
+     context_exit_critical(prev_state);
+ }
+
+ /**
+  * Get LET statistics
+  */
+ int let_get_stats(let_stats_t* stats) {
+     if (stats == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+     memcpy(stats, &let_stats, sizeof(let_stats_t));
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
@@ -18,25 +18,54 @@
  #include "../include/kernel/time.h"
  #include "../include/kernel/context.h"
  #include "../include/kernel/ipc.h"
- #include "../include/drivers/timer.h"
+ #include "../include/kernel/heap.h"
+ #include "../include/kernel/workqueue.h"
+ #include "../include/kernel/timetag.h"
+ #include "../include/kernel/sysconf.h"
+ #include "../include/kernel/rta.h"
+ #include "../include/drivers/time.h"
  #include "../include/drivers/uart.h"
+ #include "../include/drivers/hostrt.h"
  #include "../include/utils/logger.h"
+ #include "../include/utils/recorder.h"
+ #include "../include/utils/sequence.h"
+ #include "../include/utils/fdir.h"
+ #include "../include/utils/paramdb.h"
+ #include "../include/utils/tmcodec.h"
+ #include "../include/utils/runcache.h"
+ #include "../include/kernel/trace.h"
+ #include "../include/kernel/overhead.h"
  #include "../include/config.h"
+ #include "../include/satellite.h"
  
- /* Demo task prototypes */
- static void task_telemetry(void* arg);
- static void task_attitude_control(void* arg);
- static void task_thermal_control(void* arg);
- static void task_command_handler(void* arg);
- static void task_housekeeping(void* arg);
- static void task_payload_control(void* arg);
- static void task_system_monitor(void* arg);
- 
- /* Global shared resources */
- static semaphore_t* telemetry_sem;
- static queue_t* command_queue;
- static event_group_t* system_events;
- static mutex_t* resource_mutex;
+ /* Generated from config/satellite.sysconf: tasks, IPC objects and handles */
+ #include "sysconf_gen.h"
+ 
+ /* Generated by the build: BUILD_ID (kernel sources) and CONFIG_HASH (config.h) */
+ #include "build_id.h"
+ 
+ /* Demo task prototypes (referenced by the generated configuration) */
+ void task_telemetry(void* arg);
+ void task_attitude_control(void* arg);
+ void task_thermal_control(void* arg);
+ void task_command_handler(void* arg);
+ void task_housekeeping(void* arg);
+ void task_payload_control(void* arg);
+ void task_system_monitor(void* arg);
+ 
+ /* Global shared resources (configured objects come from sysconf_gen.h) */
+ static workqueue_t* deferred_wq;
+ 
+ /* FDIR checks fed by the environment update */
+ #define FDIR_ACTION_SAFE_MODE    0
+ static uint16_t fdir_temperature;
+ static uint16_t fdir_temperature_rate;
+ static uint16_t fdir_battery;
+ static uint16_t fdir_battery_critical;
+ 
+ /* Time-tagged commands waiting for their execution tick */
+ #define COMMAND_TABLE_SIZE 1024
+ static timetag_table_t* command_table;
  
  /* Event flags */
  #define EVENT_THERMAL_ALERT      (1 << 0)
@@ -45,23 +74,6 @@
  #define EVENT_COMMAND_RECEIVED   (1 << 3)
  #define EVENT_LOW_POWER          (1 << 4)
  
- /* Command types */
- typedef enum {
-     CMD_NOOP,
-     CMD_RESET,
-     CMD_SET_MODE,
-     CMD_TAKE_PICTURE,
-     CMD_DEPLOY_SOLAR_PANEL,
-     CMD_ADJUST_ORBIT
- } command_type_t;
- 
- /* Command structure */
- typedef struct {
-     command_type_t type;
-     uint32_t parameter;
-     uint32_t timestamp;
- } command_t;
- 
  /* Satellite modes */
  typedef enum {
      MODE_SAFE,
@@ -81,12 +93,54 @@
      uint8_t payload_active;
      uint32_t uptime;              /* in seconds */
      uint32_t command_count;
-     uint32_t telemetry_packets;
  } satellite_state;
  
+ /* Telemetry parameters: published by the state owners, read without locks */
+ enum {
+     PARAM_MODE,
+     PARAM_ORBIT_POSITION,
+     PARAM_BATTERY_LEVEL,
+     PARAM_TEMPERATURE,
+     PARAM_SOLAR_PANELS,
+     PARAM_PAYLOAD_ACTIVE,
+     PARAM_UPTIME,
+     PARAM_COMMAND_COUNT,
+     PARAM_TELEMETRY_PACKETS,
+     PARAM_DOWNLINK_BYTES,
+     PARAM_COUNT
+ };
+ 
+ /* Processed command awaiting deferred logging */
+ typedef struct {
+     command_t cmd;
+     uint8_t accepted;             /* 0 if the command was rejected in the current state */
+ } command_record_t;
+ 
+ /* Command log ring: command handler produces, deferred work queue consumes */
+ #define COMMAND_LOG_SIZE 16
+ static command_record_t command_log[COMMAND_LOG_SIZE];
+ static volatile uint32_t command_log_head = 0;
+ static volatile uint32_t command_log_tail = 0;
+ static void command_log_flush(void* arg);
+ static work_item_t command_log_work = WORK_ITEM_INITIALIZER(command_log_flush, NULL);
+ 
+ /* Housekeeping downlink: frames are compressed in the deferred work queue */
+ static tmcodec_encoder_t downlink_codec;
+ static uint32_t downlink_bytes = 0;
+ static void downlink_frame(void* arg);
+ static work_item_t downlink_work = WORK_ITEM_INITIALIZER(downlink_frame, NULL);
+ 
  /* Flag to indicate if simulator should continue running */
  static volatile int running = 1;
  
+ /* Scenario options, set from the command line */
+ static uint32_t run_ticks = 0;               /* Run length (0 = until Ctrl+C) */
+ static uint32_t run_start = 0;
+ static uint8_t run_policy = DEFAULT_SCHEDULING_POLICY;
+ static const char* run_cache_path = NULL;    /* Result cache file, NULL if unused */
+ static const char* run_overhead_path = NULL; /* Overhead model file, NULL if unused */
+ static runcache_key_t run_key;
+ 
  /* Signal handler for graceful termination */
  static void signal_handler(int sig) {
      printf("\nReceived signal %d, shutting down...\n", sig);
@@ -106,23 +160,54 @@
      satellite_state.payload_active = 0;
      satellite_state.uptime = 0;
      satellite_state.command_count = 0;
-     satellite_state.telemetry_packets = 0;
+     
+     paramdb_define(PARAM_MODE, "mode", PARAM_TYPE_U32);
+     paramdb_define(PARAM_ORBIT_POSITION, "orbit_position", PARAM_TYPE_U32);
+     paramdb_define(PARAM_BATTERY_LEVEL, "battery_level", PARAM_TYPE_F32);
+     paramdb_define(PARAM_TEMPERATURE, "temperature", PARAM_TYPE_F32);
+     paramdb_define(PARAM_SOLAR_PANELS, "solar_panels", PARAM_TYPE_BOOL);
+     paramdb_define(PARAM_PAYLOAD_ACTIVE, "payload_active", PARAM_TYPE_BOOL);
+     paramdb_define(PARAM_UPTIME, "uptime", PARAM_TYPE_U32);
+     paramdb_define(PARAM_COMMAND_COUNT, "command_count", PARAM_TYPE_U32);
+     paramdb_define(PARAM_TELEMETRY_PACKETS, "telemetry_packets", PARAM_TYPE_U32);
+     paramdb_define(PARAM_DOWNLINK_BYTES, "downlink_bytes", PARAM_TYPE_U32);
+     paramdb_set_u32(PARAM_TELEMETRY_PACKETS, 0);
+     paramdb_set_u32(PARAM_DOWNLINK_BYTES, 0);
      
      LOG_INFO("Satellite state initialized");
  }
  
+ /**
+  * Publish the satellite state to the parameter database
+  * Called by the state owners with resource_mutex held
+  */
+ static void satellite_publish(void) {
+     paramdb_set_u32(PARAM_MODE, (uint32_t)satellite_state.mode);
+     paramdb_set_u32(PARAM_ORBIT_POSITION, satellite_state.orbit_position);
+     paramdb_set_f32(PARAM_BATTERY_LEVEL, satellite_state.battery_level);
+     paramdb_set_f32(PARAM_TEMPERATURE, satellite_state.temperature);
+     paramdb_set_bool(PARAM_SOLAR_PANELS, satellite_state.solar_panels_deployed);
+     paramdb_set_bool(PARAM_PAYLOAD_ACTIVE, satellite_state.payload_active);
+     paramdb_set_u32(PARAM_UPTIME, satellite_state.uptime);
+     paramdb_set_u32(PARAM_COMMAND_COUNT, satellite_state.command_count);
+ }
+ 
  /**
   * Display satellite status
   */
  static void display_status(void) {
      printf("\033[2J\033[H"); /* Clear screen and move cursor to home */
      
+     /* Read the published state; no lock needed */
+     param_sample_t p[PARAM_COUNT];
+     paramdb_snapshot_range(0, PARAM_COUNT, p);
+     
      printf("=== Satellite RTOS Simulator ===\n");
-     printf("Uptime: %u seconds\n", satellite_state.uptime);
+     printf("Uptime: %u seconds\n", p[PARAM_UPTIME].value.u32);
      
      /* Display mode */
      printf("Mode: ");
-     switch (satellite_state.mode) {
+     switch (p[PARAM_MODE].value.u32) {
          case MODE_SAFE:        printf("SAFE\n"); break;
          case MODE_NORMAL:      printf("NORMAL\n"); break;
          case MODE_LOW_POWER:   printf("LOW POWER\n"); break;
@@ -132,13 +217,14 @@
      }
      
      /* Display other states */
-     printf("Orbit Position: %u degrees\n", satellite_state.orbit_position);
-     printf("Battery Level: %.1f%%\n", satellite_state.battery_level * 100.0f);
-     printf("Temperature: %.1f°C\n", satellite_state.temperature);
-     printf("Solar Panels: %s\n", satellite_state.solar_panels_deployed ? "DEPLOYED" : "STOWED");
-     printf("Payload: %s\n", satellite_state.payload_active ? "ACTIVE" : "INACTIVE");
-     printf("Commands Processed: %u\n", satellite_state.command_count);
-     printf("Telemetry Packets: %u\n", satellite_state.telemetry_packets);
+     printf("Orbit Position: %u degrees\n", p[PARAM_ORBIT_POSITION].value.u32);
+     printf("Battery Level: %.1f%%\n", p[PARAM_BATTERY_LEVEL].value.f32 * 100.0f);
+     printf("Temperature: %.1f°C\n", p[PARAM_TEMPERATURE].value.f32);
+     printf("Solar Panels: %s\n", p[PARAM_SOLAR_PANELS].value.u32 ? "DEPLOYED" : "STOWED");
+     printf("Payload: %s\n", p[PARAM_PAYLOAD_ACTIVE].value.u32 ? "ACTIVE" : "INACTIVE");
+     printf("Commands Processed: %u\n", p[PARAM_COMMAND_COUNT].value.u32);
+     printf("Telemetry Packets: %u\n", p[PARAM_TELEMETRY_PACKETS].value.u32);
+     printf("Downlink: %u bytes\n", p[PARAM_DOWNLINK_BYTES].value.u32);
      
      /* Display system events */
      printf("\nActive System Events:\n");
@@ -159,7 +245,33 @@
      printf("CPU Load: %.1f%%\n", stats.cpu_load * 100.0f);
      printf("Tasks Created: %u\n", stats.tasks_created);
      printf("Deadline Misses: %u\n", stats.deadline_misses);
+ #if ENABLE_RTA
+     printf("Response-Time Analysis: %s\n",
+            rta_is_schedulable(rta_system_set()) ? "schedulable" : "DEADLINES AT RISK");
+ #endif
+     if (overhead_enabled) {
+         overhead_stats_t ovh;
+         overhead_get_stats(&ovh);
+         printf("Kernel Overhead: %llu us charged, %llu us paid\n",
+                (unsigned long long)(ovh.charged_ns / 1000), (unsigned long long)ovh.paid_us);
+     }
      
+     /* End-to-end latency of the configured cause-effect chains */
+     for (uint32_t i = 0; i < sysconf_system.chain_count; i++) {
+         chain_stats_t cs;
+         if (chain_get_stats(*sysconf_system.chains[i].handle, &cs) != 0) {
+             continue;
+         }
+         if (cs.completions == 0) {
+             printf("Chain %s: no latency yet\n", sysconf_system.chains[i].name);
+             continue;
+         }
+         printf("Chain %s: min %u us, mean %llu us, max %u us, %u/%u over deadline\n",
+                sysconf_system.chains[i].name, cs.min_us,
+                (unsigned long long)(cs.total_us / cs.completions), cs.max_us,
+                cs.misses, cs.completions);
+     }
+
      /* Display task status */
      printf("\nTask States:\n");
      printf("%-20s %-10s %-10s %-15s\n", "Task Name", "Priority", "State", "Runtime (ms)");
@@ -193,6 +305,64 @@
      printf("\nPress Ctrl+C to exit\n");
  }
  
+ /**
+  * FDIR recovery: command safe mode
+  */
+ static void fdir_safe_mode(uint16_t check, float value, void* ctx) {
+     command_t cmd;
+     (void)check;
+     (void)value;
+     (void)ctx;
+ 
+     cmd.type = CMD_SET_MODE;
+     cmd.parameter = MODE_SAFE;
+     cmd.timestamp = time_get_ticks();
+     queue_send(command_queue, &cmd, 0);
+ }
+ 
+ /**
+  * Define the satellite limit checks
+  */
+ static int satellite_fdir_init(void) {
+     fdir_check_t check = FDIR_CHECK_DEFAULT;
+ 
+     if (fdir_init(system_events) != 0 ||
+         fdir_register_action(FDIR_ACTION_SAFE_MODE, fdir_safe_mode, NULL) != 0) {
+         return -1;
+     }
+ 
+     check.name = "temperature";
+     check.low = 0.0f;
+     check.high = 40.0f;
+     check.flags = EVENT_THERMAL_ALERT;
+     if (fdir_add_check(&check, &fdir_temperature) != 0) {
+         return -1;
+     }
+ 
+     /* A jump of more than 5 degrees in one cycle is a sensor fault, not physics */
+     check = (fdir_check_t)FDIR_CHECK_DEFAULT;
+     check.name = "temperature_rate";
+     check.max_delta = 5.0f;
+     if (fdir_add_check(&check, &fdir_temperature_rate) != 0) {
+         return -1;
+     }
+ 
+     check = (fdir_check_t)FDIR_CHECK_DEFAULT;
+     check.name = "battery";
+     check.low = 0.2f;
+     check.flags = EVENT_LOW_POWER;
+     if (fdir_add_check(&check, &fdir_battery) != 0) {
+         return -1;
+     }
+ 
+     check = (fdir_check_t)FDIR_CHECK_DEFAULT;
+     check.name = "battery_critical";
+     check.low = 0.1f;
+     check.persistence = 5;
+     check.action = FDIR_ACTION_SAFE_MODE;
+     return fdir_add_check(&check, &fdir_battery_critical);
+ }
+ 
  /**
   * Simulate environment changes
   */
@@ -241,45 +411,35 @@
          satellite_state.temperature -= 0.5f;
      }
      
-     /* Trigger thermal alert if temperature is too high or too low */
-     if (satellite_state.temperature > 40.0f || satellite_state.temperature < 0.0f) {
-         event_group_set_flags(system_events, EVENT_THERMAL_ALERT);
-     } else {
-         event_group_clear_flags(system_events, EVENT_THERMAL_ALERT);
-     }
-     
-     /* Trigger low power alert if battery level is too low */
-     if (satellite_state.battery_level < 0.2f) {
-         event_group_set_flags(system_events, EVENT_LOW_POWER);
-     } else {
-         event_group_clear_flags(system_events, EVENT_LOW_POWER);
-     }
+     /* Limit checks raise EVENT_THERMAL_ALERT and EVENT_LOW_POWER */
+     fdir_set_value(fdir_temperature, satellite_state.temperature);
+     fdir_set_value(fdir_temperature_rate, satellite_state.temperature);
+     fdir_set_value(fdir_battery, satellite_state.battery_level);
+     fdir_set_value(fdir_battery_critical, satellite_state.battery_level);
+     fdir_evaluate(NULL);
      
      /* Increment uptime */
      satellite_state.uptime++;
+     
+     satellite_publish();
  }
  
  /**
   * Telemetry task
   * Collects and transmits satellite telemetry
   */
- static void task_telemetry(void* arg) {
+ void task_telemetry(void* arg) {
+     uint32_t packets = 0;
+     
      LOG_INFO("Telemetry task starting");
      
      while (running) {
          /* Take semaphore to ensure exclusive access to telemetry system */
          if (semaphore_take(telemetry_sem, 100) == 0) {
-             /* Lock resource mutex for satellite state access */
-             mutex_lock(resource_mutex, MAX_TIMEOUT);
-             
-             /* Simulate telemetry collection and transmission */
+             /* Packet assembly and compression run in the low-priority work queue */
              LOG_DEBUG("Collecting telemetry data");
-             
-             /* In a real system, we would read sensors, format data, etc. */
-             satellite_state.telemetry_packets++;
-             
-             /* Unlock resource mutex */
-             mutex_unlock(resource_mutex);
+             paramdb_set_u32(PARAM_TELEMETRY_PACKETS, ++packets);
+             workqueue_submit(deferred_wq, &downlink_work);
              
              /* Release semaphore */
              semaphore_give(telemetry_sem);
@@ -293,11 +453,59 @@
      }
  }
  
+ /**
+  * Downlink sink: hand a compressed block to the radio
+  */
+ static int downlink_send(const uint8_t* block, uint32_t length, void* ctx) {
+     (void)block;
+     (void)ctx;
+ 
+     /* In a real system, we would queue the block for the transmitter */
+     downlink_bytes += length;
+     LOG_DEBUG("Downlinked %u-byte telemetry block", length);
+     return paramdb_set_u32(PARAM_DOWNLINK_BYTES, downlink_bytes);
+ }
+ 
+ /**
+  * Set up the downlink codec: one field per telemetry parameter
+  */
+ static int downlink_init(void) {
+     uint8_t types[PARAM_COUNT];
+     param_sample_t p[PARAM_COUNT];
+ 
+     paramdb_snapshot_range(0, PARAM_COUNT, p);
+     for (int i = 0; i < PARAM_COUNT; i++) {
+         types[i] = (p[i].type == PARAM_TYPE_F32) ? TMCODEC_FIELD_FLOAT : TMCODEC_FIELD_INT;
+     }
+ 
+     return tmcodec_encoder_init(&downlink_codec, types, PARAM_COUNT, TMCODEC_FLAG_LZ,
+                                 downlink_send, NULL);
+ }
+ 
+ /**
+  * Compress one housekeeping frame
+  * Runs in the deferred work queue, reading the parameter database
+  */
+ static void downlink_frame(void* arg) {
+     param_sample_t p[PARAM_COUNT];
+     uint32_t values[PARAM_COUNT];
+     uint32_t valid = 0;
+     (void)arg;
+ 
+     paramdb_snapshot_range(0, PARAM_COUNT, p);
+     for (int i = 0; i < PARAM_COUNT; i++) {
+         values[i] = p[i].value.raw;
+         valid |= (uint32_t)p[i].valid << i;
+     }
+ 
+     tmcodec_encode(&downlink_codec, time_get_ticks(), values, valid);
+ }
+ 
  /**
   * Attitude control task
   * Maintains satellite orientation
   */
- static void task_attitude_control(void* arg) {
+ void task_attitude_control(void* arg) {
      LOG_INFO("Attitude control task starting");
      
      while (running) {
@@ -325,7 +533,7 @@
   * Thermal control task
   * Manages satellite temperature
   */
- static void task_thermal_control(void* arg) {
+ void task_thermal_control(void* arg) {
      LOG_INFO("Thermal control task starting");
      
      while (running) {
@@ -344,6 +552,7 @@
              } else if (satellite_state.temperature < 0.0f) {
                  satellite_state.temperature += 2.0f;
              }
+             paramdb_set_f32(PARAM_TEMPERATURE, satellite_state.temperature);
              
              /* Unlock resource mutex */
              mutex_unlock(resource_mutex);
@@ -354,23 +563,87 @@
      }
  }
  
+ /**
+  * Deferred command logging
+  * Runs in the deferred work queue, outside resource_mutex
+  */
+ static void command_log_flush(void* arg) {
+     (void)arg;
+     
+     while (command_log_tail != command_log_head) {
+         command_record_t* rec = &command_log[command_log_tail % COMMAND_LOG_SIZE];
+         
+         LOG_INFO("Processing command: %d", rec->cmd.type);
+         
+         switch (rec->cmd.type) {
+             case CMD_NOOP:
+                 break;
+                 
+             case CMD_RESET:
+                 LOG_WARNING("System reset command received");
+                 break;
+                 
+             case CMD_SET_MODE:
+                 if (rec->accepted) {
+                     LOG_INFO("Mode changed to: %d", (int)rec->cmd.parameter);
+                 }
+                 break;
+                 
+             case CMD_TAKE_PICTURE:
+                 if (rec->accepted) {
+                     LOG_INFO("Taking picture");
+                 } else {
+                     LOG_WARNING("Cannot take picture, payload not active");
+                 }
+                 break;
+                 
+             case CMD_DEPLOY_SOLAR_PANEL:
+                 if (rec->accepted) {
+                     LOG_INFO("Deploying solar panels");
+                 } else {
+                     LOG_WARNING("Solar panels already deployed");
+                 }
+                 break;
+                 
+             case CMD_ADJUST_ORBIT:
+                 LOG_INFO("Adjusting orbit");
+                 break;
+                 
+             default:
+                 LOG_WARNING("Unknown command type: %d", rec->cmd.type);
+                 break;
+         }
+         
+         command_log_tail++;
+     }
+ }
+ 
  /**
   * Command handler task
   * Processes commands from ground station
   */
- static void task_command_handler(void* arg) {
+ void task_command_handler(void* arg) {
      LOG_INFO("Command handler task starting");
      command_t cmd;
      
      while (running) {
          /* Wait for command in queue */
          if (queue_receive(command_queue, &cmd, MAX_TIMEOUT) == 0) {
+             uint8_t accepted = 1;
+             uint8_t take_picture = 0;
+             
+             /* Time-tagged command: park it until its execution tick */
+             if ((int32_t)(cmd.timestamp - time_get_ticks()) > 0) {
+                 if (timetag_insert(command_table, cmd.timestamp, &cmd, NULL) != 0) {
+                     LOG_WARNING("Time-tagged command %d rejected", cmd.type);
+                 }
+                 continue;
+             }
+             
              /* Lock resource mutex for satellite state access */
              mutex_lock(resource_mutex, MAX_TIMEOUT);
              
-             LOG_INFO("Processing command: %d", cmd.type);
-             
-             /* Process command based on type */
+             /* Apply state changes only; logging is deferred */
              switch (cmd.type) {
                  case CMD_NOOP:
                      /* No operation, just acknowledge */
@@ -378,7 +651,6 @@
                      
                  case CMD_RESET:
                      /* Simulate system reset */
-                     LOG_WARNING("System reset command received");
                      satellite_state.mode = MODE_SAFE;
                      satellite_state.payload_active = 0;
                      break;
@@ -387,46 +659,55 @@
                      /* Set satellite mode */
                      if (cmd.parameter <= MODE_MAINTENANCE) {
                          satellite_state.mode = (satellite_mode_t)cmd.parameter;
-                         LOG_INFO("Mode changed to: %d", satellite_state.mode);
+                     } else {
+                         accepted = 0;
                      }
                      break;
                      
                  case CMD_TAKE_PICTURE:
                      /* Simulate taking picture with payload */
-                     if (satellite_state.payload_active) {
-                         LOG_INFO("Taking picture");
-                         event_group_set_flags(system_events, EVENT_PAYLOAD_READY);
-                     } else {
-                         LOG_WARNING("Cannot take picture, payload not active");
-                     }
+                     take_picture = satellite_state.payload_active;
+                     accepted = take_picture;
                      break;
                      
                  case CMD_DEPLOY_SOLAR_PANEL:
                      /* Deploy solar panels */
-                     if (!satellite_state.solar_panels_deployed) {
-                         LOG_INFO("Deploying solar panels");
-                         satellite_state.solar_panels_deployed = 1;
-                     } else {
-                         LOG_WARNING("Solar panels already deployed");
-                     }
+                     accepted = !satellite_state.solar_panels_deployed;
+                     satellite_state.solar_panels_deployed = 1;
                      break;
                      
                  case CMD_ADJUST_ORBIT:
                      /* Simulate orbit adjustment */
-                     LOG_INFO("Adjusting orbit");
                      break;
                      
                  default:
-                     LOG_WARNING("Unknown command type: %d", cmd.type);
+                     accepted = 0;
                      break;
              }
              
              /* Increment command counter */
              satellite_state.command_count++;
+             satellite_publish();
              
              /* Unlock resource mutex */
              mutex_unlock(resource_mutex);
              
+             /* FDIR commands end the chain; ground and sequence commands carry no sample */
+             chain_complete(fdir_chain);
+             
+             /* Queue the record for the deferred logger, dropping it if the ring is full */
+             if (command_log_head - command_log_tail < COMMAND_LOG_SIZE) {
+                 command_record_t* rec = &command_log[command_log_head % COMMAND_LOG_SIZE];
+                 rec->cmd = cmd;
+                 rec->accepted = accepted;
+                 command_log_head++;
+                 workqueue_submit(deferred_wq, &command_log_work);
+             }
+             
+             if (take_picture) {
+                 event_group_set_flags(system_events, EVENT_PAYLOAD_READY);
+             }
+             
              /* Set command received event flag */
              event_group_set_flags(system_events, EVENT_COMMAND_RECEIVED);
          }
@@ -437,7 +718,7 @@
   * Housekeeping task
   * Performs routine maintenance
   */
- static void task_housekeeping(void* arg) {
+ void task_housekeeping(void* arg) {
      LOG_INFO("Housekeeping task starting");
      
      while (running) {
@@ -461,7 +742,7 @@
   * Payload control task
   * Manages satellite payload (e.g., camera, instruments)
   */
- static void task_payload_control(void* arg) {
+ void task_payload_control(void* arg) {
      LOG_INFO("Payload control task starting");
      
      while (running) {
@@ -485,14 +766,87 @@
      }
  }
  
+ /**
+  * Gather the result of the run from the scheduler and task statistics
+  */
+ static void run_collect(runcache_result_t* result) {
+     scheduler_stats_t stats;
+     
+     memset(result, 0, sizeof(*result));
+     scheduler_get_stats(&stats);
+     result->ticks = time_get_ticks() - run_start;
+     result->context_switches = stats.context_switches;
+     result->deadline_misses = stats.deadline_misses;
+     result->cpu_load = stats.cpu_load;
+     
+     for (uint32_t i = 0; i < sysconf_system.task_count && result->task_count < RUNCACHE_MAX_TASKS; i++) {
+         task_t* task = task_get_by_name(sysconf_system.tasks[i].name);
+         task_stats_t task_stats;
+         
+         if (task == NULL || task_get_stats(task, &task_stats) != 0) {
+             continue;
+         }
+         
+         runcache_task_result_t* out = &result->tasks[result->task_count++];
+         snprintf(out->name, sizeof(out->name), "%s", sysconf_system.tasks[i].name);
+         out->activations = task_stats.num_activations;
+         out->deadline_misses = task_stats.deadline_misses;
+         out->max_execution_time = task_stats.max_execution_time;
+         out->total_runtime = task_stats.total_runtime;
+     }
+ }
+ 
+ /**
+  * Print the result of a run
+  */
+ static void run_print(const runcache_result_t* result, int cached) {
+     printf("\n=== Run result%s ===\n", cached ? " (cached)" : "");
+     printf("Scenario: %016llx\n", (unsigned long long)run_key);
+     printf("Length: %u ms\n", time_ticks_to_ms(result->ticks));
+     printf("Context Switches: %u\n", result->context_switches);
+     printf("CPU Load: %.1f%%\n", result->cpu_load * 100.0f);
+     printf("Deadline Misses: %u\n", result->deadline_misses);
+     
+     printf("\n%-16s %-12s %-10s %-14s %-12s\n",
+            "Task Name", "Activations", "Misses", "Max Exec (ms)", "Runtime (ms)");
+     for (uint32_t i = 0; i < result->task_count; i++) {
+         const runcache_task_result_t* t = &result->tasks[i];
+         printf("%-16s %-12u %-10u %-14u %-12u\n", t->name, t->activations, t->deadline_misses,
+                time_ticks_to_ms(t->max_execution_time), time_ticks_to_ms(t->total_runtime));
+     }
+ }
+ 
+ /**
+  * End a timed run: report, cache the result and exit
+  */
+ static void run_finish(void) {
+     runcache_result_t result;
+     
+     run_collect(&result);
+ #if ENABLE_TRACE
+     trace_stop();
+ #endif
+     
+     if (run_cache_path != NULL) {
+         runcache_store(run_key, &result);
+         runcache_close();
+     }
+     
+     run_print(&result, 0);
+     exit(result.deadline_misses != 0 ? 2 : 0);
+ }
+ 
  /**
   * System monitor task
   * Monitors system health and updates status display
   */
- static void task_system_monitor(void* arg) {
+ void task_system_monitor(void* arg) {
      LOG_INFO("System monitor task starting");
      
      while (running) {
+         /* Sensor readings start the FDIR chain: a tripped check commands safe mode */
+         chain_sample(fdir_chain);
+         
          /* Update environment simulation */
          mutex_lock(resource_mutex, MAX_TIMEOUT);
          update_environment();
@@ -501,11 +855,134 @@
          /* Update status display */
          display_status();
          
+         /* Timed runs end here */
+         if (run_ticks != 0 && time_get_ticks() - run_start >= run_ticks) {
+             run_finish();
+         }
+         
          /* Monitor processing period */
          time_delay_ms(1000);
      }
  }
  
+ #if ENABLE_SEQUENCER
+ /* Telemetry points readable by stored sequences */
+ enum {
+     TLM_BATTERY_PCT,
+     TLM_TEMPERATURE_C,
+     TLM_MODE,
+     TLM_ORBIT_DEG,
+     TLM_SOLAR_PANELS,
+     TLM_PAYLOAD
+ };
+ 
+ /* Watch the battery and drop to low power below 30%, checked every 10 s */
+ static const uint8_t seq_low_power_watch[] = {
+     SEQ_TLM(TLM_BATTERY_PCT), SEQ_PUSH8(30), SEQ_OP(SEQ_LT),
+     SEQ_TLM(TLM_MODE), SEQ_PUSH8(MODE_LOW_POWER), SEQ_OP(SEQ_EQ), SEQ_OP(SEQ_NOT),
+     SEQ_OP(SEQ_AND), SEQ_JZ(4),
+     SEQ_PUSH8(MODE_LOW_POWER), SEQ_CMD(CMD_SET_MODE),
+     SEQ_WAIT(1000), SEQ_JMP(-29)
+ };
+ 
+ /* Wait for orbit position 90, then take three pictures 5 s apart */
+ static const uint8_t seq_imaging_pass[] = {
+     SEQ_TLM(TLM_ORBIT_DEG), SEQ_PUSH8(89), SEQ_OP(SEQ_GT), SEQ_JNZ(8),
+     SEQ_WAIT(100), SEQ_JMP(-17),
+     SEQ_PUSH8(3), SEQ_STORE(0),
+     SEQ_PUSH8(0), SEQ_CMD(CMD_TAKE_PICTURE), SEQ_WAIT(500), SEQ_LOOP(0, -13),
+     SEQ_OP(SEQ_END)
+ };
+ 
+ /**
+  * Read a telemetry point for the sequence engine
+  */
+ static int32_t sequence_telemetry(uint16_t point, void* ctx) {
+     (void)ctx;
+ 
+     float value = 0.0f;
+     uint32_t u = 0;
+     
+     switch (point) {
+         case TLM_BATTERY_PCT:   paramdb_get_f32(PARAM_BATTERY_LEVEL, &value); return (int32_t)(value * 100.0f);
+         case TLM_TEMPERATURE_C: paramdb_get_f32(PARAM_TEMPERATURE, &value); return (int32_t)value;
+         case TLM_MODE:          paramdb_get_u32(PARAM_MODE, &u); return (int32_t)u;
+         case TLM_ORBIT_DEG:     paramdb_get_u32(PARAM_ORBIT_POSITION, &u); return (int32_t)u;
+         case TLM_SOLAR_PANELS:  paramdb_get_u32(PARAM_SOLAR_PANELS, &u); return (int32_t)u;
+         case TLM_PAYLOAD:       paramdb_get_u32(PARAM_PAYLOAD_ACTIVE, &u); return (int32_t)u;
+         default:                return 0;
+     }
+ }
+ 
+ /**
+  * Issue a sequence command through the command queue
+  */
+ static int sequence_command(uint8_t type, int32_t parameter, void* ctx) {
+     command_t cmd;
+     (void)ctx;
+ 
+     cmd.type = (command_type_t)type;
+     cmd.parameter = (uint32_t)parameter;
+     cmd.timestamp = time_get_ticks();
+ 
+     return queue_send(command_queue, &cmd, 0);
+ }
+ #endif
+ 
+ /**
+  * Print command line usage
+  */
+ static void usage(const char* program) {
+     fprintf(stderr, "Usage: %s [-t seconds] [-p policy] [-c cache-file] [-o model-file]\n", program);
+     fprintf(stderr, "  -t seconds     Stop after this much simulated time and print the result\n");
+     fprintf(stderr, "  -p policy      0 = priority, 1 = round-robin, 2 = EDF, 3 = RMS\n");
+     fprintf(stderr, "  -c cache-file  With -t: reuse the result of an identical earlier run\n");
+     fprintf(stderr, "  -o model-file  Charge target kernel overheads (from tools/ovh_calibrate)\n");
+     fprintf(stderr, "Timed runs exit with status 2 if any deadline was missed\n");
+ }
+ 
+ /**
+  * Parse the command line into the scenario options
+  */
+ static int parse_options(int argc, char* argv[]) {
+     for (int i = 1; i < argc; i++) {
+         const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+         
+         if (strcmp(argv[i], "-t") == 0 && value != NULL) {
+             run_ticks = time_ms_to_ticks((uint32_t)strtoul(value, NULL, 10) * 1000);
+         } else if (strcmp(argv[i], "-p") == 0 && value != NULL) {
+             run_policy = (uint8_t)strtoul(value, NULL, 10);
+             if (run_policy > SCHEDULING_POLICY_RMS) {
+                 return -1;
+             }
+         } else if (strcmp(argv[i], "-c") == 0 && value != NULL) {
+             run_cache_path = value;
+         } else if (strcmp(argv[i], "-o") == 0 && value != NULL) {
+             run_overhead_path = value;
+         } else {
+             return -1;
+         }
+         i++;
+     }
+     
+     /* Only runs with a fixed length have a result to cache */
+     return (run_cache_path != NULL && run_ticks == 0) ? -1 : 0;
+ }
+ 
+ /**
+  * Derive the scenario key: everything that determines the result of a run
+  */
+ static void run_make_key(void) {
+     runcache_key_init(&run_key);
+     runcache_key_add_u32(&run_key, BUILD_ID);
+     runcache_key_add_u32(&run_key, CONFIG_HASH);
+     runcache_key_add_u32(&run_key, (uint32_t)SYSCONF_HASH);
+     runcache_key_add_u32(&run_key, (uint32_t)(SYSCONF_HASH >> 32));
+     runcache_key_add_u32(&run_key, run_policy);
+     runcache_key_add_u32(&run_key, run_ticks);
+     runcache_key_add_u32(&run_key, overhead_hash());
+ }
+ 
  /**
   * Main entry point
   */
@@ -520,50 +997,112 @@
      
      LOG_INFO("Starting RTOS Task Scheduler Simulator");
      
+     if (parse_options(argc, argv) != 0) {
+         usage(argv[0]);
+         return 1;
+     }
+     
+     /* The overhead model changes the result, so load it before deriving the key */
+     if (run_overhead_path != NULL && overhead_load(run_overhead_path) != 0) {
+         return 1;
+     }
+     
+     /* Sweeps repeat scenarios: answer from the cache when this one has run before */
+     run_make_key();
+     if (run_cache_path != NULL) {
+         runcache_result_t cached;
+         
+         if (runcache_open(run_cache_path) != 0) {
+             return 1;
+         }
+         if (runcache_lookup(run_key, &cached) == 0) {
+             runcache_close();
+             run_print(&cached, 1);
+             return cached.deadline_misses != 0 ? 2 : 0;
+         }
+     }
+     
      /* Register signal handler for Ctrl+C */
      signal(SIGINT, signal_handler);
      
      /* Initialize RTOS components */
      context_init();
+ #if ENABLE_HOST_RT
+     /* Lock memory; the tick thread created next inherits the tick role */
+     hostrt_config_t hostrt_cfg = HOSTRT_CONFIG_DEFAULT;
+     hostrt_init(&hostrt_cfg);
+ #endif
      timer_init();
+ #if ENABLE_HOST_RT
+     hostrt_set_role(HOSTRT_ROLE_SIMULATOR);
+ #endif
+     heap_init();
      task_init();
-     scheduler_init(DEFAULT_SCHEDULING_POLICY);
+     scheduler_init(run_policy);
      ipc_init();
+     workqueue_init();
      time_init();
      
-     /* Create IPC objects */
-     telemetry_sem = semaphore_create("telemetry", 1, 1);
-     command_queue = queue_create("commands", sizeof(command_t), 10);
-     system_events = event_group_create("events");
-     resource_mutex = mutex_create("resource");
+     /* Create configured IPC objects and tasks from static tables */
+     if (sysconf_apply(&sysconf_system) != 0) {
+         LOG_ERROR("Failed to apply system configuration");
+         return -1;
+     }
+     
+     /* Create deferred work queue for non-urgent work */
+     deferred_wq = workqueue_create("deferred", LOW_PRIORITY, DEFAULT_STACK_SIZE);
+     if (!deferred_wq) {
+         LOG_ERROR("Failed to create deferred work queue");
+         return -1;
+     }
      
-     if (!telemetry_sem || !command_queue || !system_events || !resource_mutex) {
-         LOG_ERROR("Failed to create IPC objects");
+     /* Released time-tagged commands re-enter the command queue when due */
+     command_table = timetag_create("cmd_table", command_queue, COMMAND_TABLE_SIZE);
+     if (!command_table) {
+         LOG_ERROR("Failed to create command table");
          return -1;
      }
      
      /* Initialize satellite state */
+     paramdb_init();
      satellite_init();
+     satellite_publish();
+     if (downlink_init() != 0) {
+         LOG_ERROR("Failed to initialize telemetry downlink");
+         return -1;
+     }
+     if (satellite_fdir_init() != 0) {
+         LOG_ERROR("Failed to initialize FDIR checks");
+         return -1;
+     }
      
-     /* Create tasks */
-     task_create("telemetry", 2, task_telemetry, NULL, DEFAULT_STACK_SIZE);
-     task_create("attitude", 1, task_attitude_control, NULL, DEFAULT_STACK_SIZE);
-     task_create("thermal", 1, task_thermal_control, NULL, DEFAULT_STACK_SIZE);
-     task_create("command", 0, task_command_handler, NULL, DEFAULT_STACK_SIZE);
-     task_create("housekeep", 3, task_housekeeping, NULL, DEFAULT_STACK_SIZE);
-     task_create("payload", 2, task_payload_control, NULL, DEFAULT_STACK_SIZE);
-     task_create("monitor", 4, task_system_monitor, NULL, DEFAULT_STACK_SIZE);
-     
-     /* Set some tasks as periodic */
-     task_t* telemetry_task = task_get_by_name("telemetry");
-     if (telemetry_task) {
-         task_set_periodic(telemetry_task, time_ms_to_ticks(5000), time_ms_to_ticks(4800));
+ #if ENABLE_RECORDER
+     /* Record long-run statistics for trend analysis */
+     recorder_config_t recorder_cfg = RECORDER_CONFIG_DEFAULT;
+     if (recorder_init(&recorder_cfg) == 0) {
+         task_t* recorded[] = { command_task, attitude_task, thermal_task, telemetry_task,
+                                payload_task, housekeeping_task, monitor_task };
+         for (int i = 0; i < (int)(sizeof(recorded) / sizeof(recorded[0])); i++) {
+             recorder_add_task(recorded[i]);
+         }
+         recorder_add_queue(command_queue);
+         recorder_start();
      }
+ #endif
      
-     task_t* housekeeping_task = task_get_by_name("housekeep");
-     if (housekeeping_task) {
-         task_set_periodic(housekeeping_task, time_ms_to_ticks(10000), time_ms_to_ticks(9500));
+ #if ENABLE_SEQUENCER
+     /* Onboard automation: stored sequences share one engine task */
+     seq_engine_config_t seq_cfg = { sequence_telemetry, sequence_command, NULL, HOUSEKEEPING_PRIORITY };
+     if (seq_engine_init(&seq_cfg) == 0 && seq_engine_start() == 0) {
+         seq_load(seq_low_power_watch, sizeof(seq_low_power_watch), NULL);
+         seq_load(seq_imaging_pass, sizeof(seq_imaging_pass), NULL);
      }
+ #endif
+     
+ #if ENABLE_TRACE
+     /* Trace scheduling events for offline analysis (tools/trace_analyze) */
+     trace_start("kernel.trace");
+ #endif
      
      /* Generate some initial commands for demonstration */
      command_t cmd;
@@ -577,12 +1116,28 @@
      cmd.timestamp = time_get_ticks();
      queue_send(command_queue, &cmd, 0);
      
+     /* Time-tagged: take a picture one minute into the run */
+     cmd.type = CMD_TAKE_PICTURE;
+     cmd.parameter = 0;
+     cmd.timestamp = time_get_ticks() + time_ms_to_ticks(60000);
+     queue_send(command_queue, &cmd, 0);
+     
+ #if ENABLE_HOST_RT
+     /* Fault everything in, then report the jitter left over from the host */
+     hostrt_prefault();
+     hostrt_selfcheck();
+ #endif
+     
      /* Start the scheduler */
      LOG_INFO("Starting scheduler");
+     run_start = time_get_ticks();
      scheduler_start();
      
      /* We should never get here, as scheduler takes over */
      LOG_ERROR("Scheduler returned unexpectedly");
+ #if ENABLE_TRACE
+     trace_stop();
+ #endif
      
      return 0;
  }
\ No newline at end of file
@@ -0,0 +1,183 @@
+/**
+ * @file overhead.c
+ * @brief Implementation of the kernel overhead timing model
+ *
+ * Only the excess of the target cost over the host cost is charged: the
+ * host already spends its own cost running the operation.
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include "../../include/kernel/overhead.h"
+ #include "../../include/kernel/context.h"
+ #include "../../include/drivers/time.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ #define OVERHEAD_MAX_LINE        128
+
+ volatile uint8_t overhead_enabled = 0;
+
+ static overhead_model_t model;
+ static uint32_t excess_ns[OVH_OP_COUNT];
+
+ /* Charged but not yet paid */
+ static uint32_t pending_ns = 0;
+
+ static overhead_stats_t overhead_stats;
+
+ static const char* const op_names[OVH_OP_COUNT] = OVERHEAD_OP_NAMES;
+
+ /**
+  * Load a model
+  */
+ int overhead_set_model(const overhead_model_t* new_model) {
+     uint32_t prev_state = context_enter_critical();
+
+     overhead_enabled = 0;
+     pending_ns = 0;
+     memset(&overhead_stats, 0, sizeof(overhead_stats));
+
+     if (new_model == NULL) {
+         memset(&model, 0, sizeof(model));
+         context_exit_critical(prev_state);
+         return 0;
+     }
+
+     memcpy(&model, new_model, sizeof(model));
+     uint8_t any = 0;
+     for (int op = 0; op < OVH_OP_COUNT; op++) {
+         excess_ns[op] = (model.target_ns[op] > model.host_ns[op]) ? model.target_ns[op] - model.host_ns[op] : 0;
+         any |= (excess_ns[op] > 0);
+     }
+     overhead_enabled = any;
+
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
+
+ /**
+  * Load a model file
+  */
+ int overhead_load(const char* path) {
+     overhead_model_t loaded;
+     char line[OVERHEAD_MAX_LINE];
+     int line_no = 0;
+
+     if (path == NULL) {
+         LOG_ERROR("NULL overhead model path");
+         return -1;
+     }
+
+     FILE* file = fopen(path, "r");
+     if (file == NULL) {
+         LOG_ERROR("Failed to open overhead model '%s'", path);
+         return -1;
+     }
+
+     memset(&loaded, 0, sizeof(loaded));
+     while (fgets(line, sizeof(line), file) != NULL) {
+         char name[32];
+         unsigned int target;
+         unsigned int host;
+         int op;
+
+         line_no++;
+         char* hash = strchr(line, '#');
+         if (hash != NULL) {
+             *hash = '\0';
+         }
+         if (sscanf(line, " %31s", name) != 1) {
+             continue;
+         }
+
+         if (sscanf(line, " %31s %u %u", name, &target, &host) != 3) {
+             LOG_ERROR("%s:%d: expected '<op> <target_ns> <host_ns>'", path, line_no);
+             fclose(file);
+             return -1;
+         }
+         op = 0;
+         while (op < OVH_OP_COUNT && strcmp(op_names[op], name) != 0) {
+             op++;
+         }
+         if (op == OVH_OP_COUNT) {
+             LOG_ERROR("%s:%d: unknown operation '%s'", path, line_no, name);
+             fclose(file);
+             return -1;
+         }
+         loaded.target_ns[op] = target;
+         loaded.host_ns[op] = host;
+     }
+     fclose(file);
+
+     overhead_set_model(&loaded);
+
+     LOG_INFO("Loaded overhead model '%s' (context switch %u ns, tick %u ns on target)",
+              path, loaded.target_ns[OVH_CONTEXT_SWITCH], loaded.target_ns[OVH_TICK]);
+     return 0;
+ }
+
+ /**
+  * Hash of the loaded model
+  */
+ uint32_t overhead_hash(void) {
+     uint32_t hash = 2166136261U;
+
+     if (!overhead_enabled) {
+         return 0;
+     }
+
+     const uint8_t* bytes = (const uint8_t*)&model;
+     for (size_t i = 0; i < sizeof(model); i++) {
+         hash = (hash ^ bytes[i]) * 16777619U;
+     }
+
+     return hash;
+ }
+
+ /**
+  * Charge an operation
+  */
+ void overhead_record(overhead_op_t op) {
+     uint32_t pay_us = 0;
+
+     if ((unsigned)op >= OVH_OP_COUNT) {
+         return;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     overhead_stats.count[op]++;
+     overhead_stats.charged_ns += excess_ns[op];
+     pending_ns += excess_ns[op];
+
+     /* The tick handler may not run on the simulator thread */
+     if (op != OVH_TICK && pending_ns >= 1000) {
+         pay_us = pending_ns / 1000;
+         pending_ns -= pay_us * 1000;
+         overhead_stats.paid_us += pay_us;
+     }
+
+     context_exit_critical(prev_state);
+
+     if (pay_us > 0) {
+         timer_delay_us(pay_us);
+     }
+ }
+
+ /**
+  * Get overhead statistics
+  */
+ int overhead_get_stats(overhead_stats_t* stats) {
+     if (stats == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+     memcpy(stats, &overhead_stats, sizeof(overhead_stats_t));
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
@@ -0,0 +1,423 @@
+/**
+ * @file rta.c
+ * @brief Implementation of incremental response-time analysis
+ *
+ * Tasks form a doubly linked list in priority order (FIFO within a
+ * level), so hp(i) is a prefix of the list and the tasks a change can
+ * affect are a contiguous run of it. Iterating the fixed-point equation
+ * from any lower bound of the least fixed point reaches that fixed point,
+ * and every iterate is itself a lower bound, so a task that stopped above
+ * its deadline still leaves a valid seed behind.
+ *
+ * The analysis only reads task parameters and never logs, so host tools
+ * link this file without the rest of the kernel.
+ */
+
+ #include <string.h>
+ #include "../../include/kernel/rta.h"
+ #include "../../include/config.h"
+
+ /* Kernel task set, indexed by task table slot */
+ static rta_entry_t system_entries[MAX_TASKS];
+ static rta_set_t system_set;
+
+ /**
+  * Deadline used by the test: constrained to the period
+  */
+ static uint32_t test_deadline(const rta_params_t* p) {
+     uint32_t deadline = (p->deadline > 0) ? p->deadline : p->period;
+     return (deadline < p->period) ? deadline : p->period;
+ }
+
+ /**
+  * Remove a task from the priority list
+  */
+ static void list_unlink(rta_set_t* set, uint16_t id) {
+     rta_entry_t* e = &set->entries[id];
+
+     if (e->prev != RTA_NONE) {
+         set->entries[e->prev].next = e->next;
+     } else {
+         set->head = e->next;
+     }
+     if (e->next != RTA_NONE) {
+         set->entries[e->next].prev = e->prev;
+     }
+     e->prev = RTA_NONE;
+     e->next = RTA_NONE;
+ }
+
+ /**
+  * Insert a task after the last task of equal or higher priority
+  */
+ static void list_link(rta_set_t* set, uint16_t id) {
+     rta_entry_t* e = &set->entries[id];
+     uint16_t prev = RTA_NONE;
+     uint16_t next = set->head;
+
+     while (next != RTA_NONE && set->entries[next].params.priority <= e->params.priority) {
+         prev = next;
+         next = set->entries[next].next;
+     }
+
+     e->prev = prev;
+     e->next = next;
+     if (prev != RTA_NONE) {
+         set->entries[prev].next = id;
+     } else {
+         set->head = id;
+     }
+     if (next != RTA_NONE) {
+         set->entries[next].prev = id;
+     }
+ }
+
+ /**
+  * Record the outcome of an analysis and keep the unschedulable count
+  */
+ static void set_result(rta_set_t* set, rta_entry_t* e, uint64_t response, int schedulable) {
+     if (e->schedulable && !schedulable) {
+         set->unschedulable++;
+     } else if (!e->schedulable && schedulable) {
+         set->unschedulable--;
+     }
+
+     e->response = (response > UINT32_MAX) ? UINT32_MAX : (uint32_t)response;
+     e->schedulable = (uint8_t)schedulable;
+ }
+
+ /**
+  * Find the least fixed point for one task, starting from a lower bound
+  */
+ static void analyze_task(rta_set_t* set, uint16_t id, uint64_t seed) {
+     rta_entry_t* e = &set->entries[id];
+     uint16_t priority = e->params.priority;
+     uint64_t base = (uint64_t)e->params.wcet + e->params.blocking;
+     uint64_t deadline = test_deadline(&e->params);
+     uint64_t w = (seed > base) ? seed : base;
+
+     set->stats.analyses++;
+
+     /* A task with no execution or blocking completes at release; the bound below needs base > 0 */
+     if (base == 0) {
+         set_result(set, e, 0, 1);
+         return;
+     }
+
+     /*
+      * The nearest strictly higher-priority task p gives a second bound:
+      * hp(i) contains hp(p) and p, so R_i >= R_p + C_i + B_i - B_p
+      */
+     uint16_t p = e->prev;
+     while (p != RTA_NONE && set->entries[p].params.priority == priority) {
+         p = set->entries[p].prev;
+     }
+     if (p != RTA_NONE && base >= set->entries[p].params.blocking) {
+         uint64_t bound = set->entries[p].response + base - set->entries[p].params.blocking;
+         if (bound > w) {
+             w = bound;
+         }
+     }
+
+     while (w <= deadline) {
+         uint64_t next = base;
+
+         set->stats.iterations++;
+         for (uint16_t j = set->head; j != RTA_NONE; j = set->entries[j].next) {
+             const rta_params_t* hp = &set->entries[j].params;
+             if (hp->priority > priority) {
+                 break;
+             }
+             if (j != id) {
+                 next += ((w + hp->period - 1) / hp->period) * hp->wcet;
+             }
+         }
+
+         if (next == w) {
+             set_result(set, e, w, 1);
+             return;
+         }
+         w = next;
+     }
+
+     set_result(set, e, w, 0);
+ }
+
+ /**
+  * Response time of a task against an explicit set of interferers
+  */
+ int rta_response(const rta_params_t* task, const rta_params_t* interferers, uint32_t count,
+                  uint32_t* response) {
+     if (task == NULL || (interferers == NULL && count > 0) || response == NULL) {
+         return -1;
+     }
+
+     uint64_t base = (uint64_t)task->wcet + task->blocking;
+     uint64_t deadline = test_deadline(task);
+     uint64_t w = base;
+
+     /* Every interferer releases a job at the critical instant */
+     if (base > 0) {
+         for (uint32_t j = 0; j < count; j++) {
+             w += interferers[j].wcet;
+         }
+     }
+
+     while (w <= deadline) {
+         uint64_t next = base;
+
+         for (uint32_t j = 0; j < count && next <= deadline; j++) {
+             next += ((w + interferers[j].period - 1) / interferers[j].period) * interferers[j].wcet;
+         }
+         if (next == w) {
+             *response = (uint32_t)w;
+             return 1;
+         }
+         w = next;
+     }
+
+     *response = (w > UINT32_MAX) ? UINT32_MAX : (uint32_t)w;
+     return 0;
+ }
+
+ /**
+  * Initialize an empty task set
+  */
+ int rta_set_init(rta_set_t* set, rta_entry_t* entries, uint16_t capacity) {
+     if (set == NULL || entries == NULL || capacity == 0 || capacity == RTA_NONE) {
+         return -1;
+     }
+
+     memset(entries, 0, (size_t)capacity * sizeof(rta_entry_t));
+     memset(set, 0, sizeof(rta_set_t));
+     set->entries = entries;
+     set->capacity = capacity;
+     set->head = RTA_NONE;
+
+     return 0;
+ }
+
+ /**
+  * Add a task or change its parameters
+  */
+ int rta_set_task(rta_set_t* set, uint16_t id, const rta_params_t* params) {
+     if (set == NULL || params == NULL || id >= set->capacity || params->period == 0) {
+         return -1;
+     }
+
+     rta_entry_t* e = &set->entries[id];
+     rta_params_t old = e->params;
+     int existed = e->used;
+
+     if (existed && old.period == params->period && old.deadline == params->deadline &&
+         old.wcet == params->wcet && old.blocking == params->blocking &&
+         old.priority == params->priority) {
+         return 0;
+     }
+     set->stats.updates++;
+
+     /* Only tasks at or below the higher of the two priorities can see the change */
+     uint16_t low = params->priority;
+     uint16_t high = 0xFFFF;
+     int same_load = existed && old.wcet == params->wcet && old.period == params->period;
+     if (existed) {
+         low = (old.priority < params->priority) ? old.priority : params->priority;
+         if (same_load) {
+             /* A pure priority move only changes hp(i) between the two levels */
+             high = (old.priority > params->priority) ? old.priority : params->priority;
+         }
+     }
+
+     e->params = *params;
+     if (!existed) {
+         e->used = 1;
+         e->schedulable = 1;
+         e->response = 0;
+         set->count++;
+         list_link(set, id);
+     } else if (old.priority != params->priority) {
+         list_unlink(set, id);
+         list_link(set, id);
+     }
+
+     for (uint16_t j = set->head; j != RTA_NONE; j = set->entries[j].next) {
+         rta_entry_t* t = &set->entries[j];
+         uint16_t priority = t->params.priority;
+         int grew;
+
+         if (priority < low) {
+             continue;
+         }
+         if (priority > high) {
+             break;
+         }
+
+         if (j == id) {
+             /* More execution or blocking, or a lower level (a superset of hp) */
+             grew = existed && params->wcet >= old.wcet && params->blocking >= old.blocking &&
+                    params->priority >= old.priority;
+         } else {
+             /* The changed task's contribution to t: absent before, or no lighter now */
+             int before = existed && old.priority <= priority;
+             int after = params->priority <= priority;
+             grew = !before || (after && params->wcet >= old.wcet && params->period <= old.period);
+         }
+
+         analyze_task(set, j, grew ? t->response : 0);
+     }
+
+     return 0;
+ }
+
+ /**
+  * Add or change a task only if the set stays schedulable
+  */
+ int rta_admit(rta_set_t* set, uint16_t id, const rta_params_t* params) {
+     if (set == NULL || params == NULL || id >= set->capacity) {
+         return -1;
+     }
+
+     rta_params_t old = set->entries[id].params;
+     int existed = set->entries[id].used;
+
+     if (rta_set_task(set, id, params) != 0) {
+         return -1;
+     }
+
+     /* Reject the change if any task misses its deadline; undo incrementally */
+     if (set->unschedulable != 0) {
+         if (existed) {
+             rta_set_task(set, id, &old);
+         } else {
+             rta_remove_task(set, id);
+         }
+         return -1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Remove a task
+  */
+ int rta_remove_task(rta_set_t* set, uint16_t id) {
+     if (set == NULL || id >= set->capacity) {
+         return -1;
+     }
+
+     rta_entry_t* e = &set->entries[id];
+     if (!e->used) {
+         return 0;
+     }
+
+     /* Tasks at or below its level lose an interferer: re-analyze without old seeds */
+     uint16_t priority = e->params.priority;
+     set_result(set, e, 0, 1);
+     list_unlink(set, id);
+     memset(e, 0, sizeof(*e));
+     set->count--;
+     set->stats.updates++;
+
+     for (uint16_t j = set->head; j != RTA_NONE; j = set->entries[j].next) {
+         if (set->entries[j].params.priority >= priority) {
+             analyze_task(set, j, 0);
+         }
+     }
+
+     return 0;
+ }
+
+ /**
+  * Re-analyze every task from scratch
+  */
+ int rta_analyze(rta_set_t* set) {
+     if (set == NULL) {
+         return -1;
+     }
+
+     for (uint16_t j = set->head; j != RTA_NONE; j = set->entries[j].next) {
+         set->entries[j].response = 0;
+     }
+     for (uint16_t j = set->head; j != RTA_NONE; j = set->entries[j].next) {
+         analyze_task(set, j, 0);
+     }
+
+     return 0;
+ }
+
+ /**
+  * Check whether every task meets its deadline
+  */
+ int rta_is_schedulable(const rta_set_t* set) {
+     return (set != NULL && set->unschedulable == 0) ? 1 : 0;
+ }
+
+ /**
+  * Get the worst-case response time of a task
+  */
+ int rta_get_response(const rta_set_t* set, uint16_t id, uint32_t* response) {
+     if (set == NULL || response == NULL || id >= set->capacity || !set->entries[id].used) {
+         return -1;
+     }
+
+     *response = set->entries[id].response;
+     return set->entries[id].schedulable;
+ }
+
+ /**
+  * Get analysis statistics
+  */
+ int rta_get_stats(const rta_set_t* set, rta_stats_t* stats) {
+     if (set == NULL || stats == NULL) {
+         return -1;
+     }
+
+     *stats = set->stats;
+     return 0;
+ }
+
+ /**
+  * Initialize the kernel task set
+  */
+ int rta_system_init(void) {
+     return rta_set_init(&system_set, system_entries, MAX_TASKS);
+ }
+
+ /**
+  * Get the kernel task set
+  */
+ rta_set_t* rta_system_set(void) {
+     return &system_set;
+ }
+
+ /**
+  * Bring a task's entry in the kernel set up to date
+  */
+ int rta_task_update(const task_t* task) {
+     if (task == NULL) {
+         return -1;
+     }
+
+     if (task->period == 0) {
+         return rta_remove_task(&system_set, task->id);
+     }
+
+     rta_params_t params = system_entries[task->id].params;
+     params.period = task->period;
+     params.deadline = task->deadline;
+     params.wcet = task->wcet;
+     params.priority = task->original_priority;
+
+     return rta_set_task(&system_set, task->id, &params);
+ }
+
+ /**
+  * Remove a task from the kernel set
+  */
+ int rta_task_remove(const task_t* task) {
+     if (task == NULL) {
+         return -1;
+     }
+
+     return rta_remove_task(&system_set, task->id);
+ }
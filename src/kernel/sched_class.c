@@ -0,0 +1,389 @@
+/**
+ * @file sched_class.c
+ * @brief Built-in scheduling classes
+ *
+ * Each class keeps its own intrusive run queue threaded through the
+ * rq_next/rq_prev fields of the task control block, so no allocation
+ * happens on the enqueue/dequeue hot path.
+ */
+
+ #include <stddef.h>
+ #include <string.h>
+ #include "../../include/kernel/sched_class.h"
+ #include "../../include/kernel/task.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ #if MAX_PRIORITY_LEVELS > 32
+ #error "Priority bitmap supports at most 32 priority levels"
+ #endif
+
+ /* Fixed-priority run queue: FIFO per level plus a ready bitmap */
+ typedef struct {
+     task_t* head[MAX_PRIORITY_LEVELS];     /* Oldest task at each level */
+     task_t* tail[MAX_PRIORITY_LEVELS];     /* Newest task at each level */
+     uint32_t bitmap;                       /* Bit n set if level n is non-empty */
+ } prio_rq_t;
+
+ static prio_rq_t priority_rq;
+ static prio_rq_t rr_rq;
+
+ /* EDF run queue: binary min-heap keyed by absolute deadline */
+ static task_t* edf_heap[MAX_TASKS];
+ static uint32_t edf_count = 0;
+
+ /* RMS run queue: list sorted by period (shortest first) */
+ static task_t* rms_head = NULL;
+
+ /* Fixed-priority run queue helpers */
+
+ static void prio_rq_reset(prio_rq_t* rq) {
+     memset(rq, 0, sizeof(prio_rq_t));
+ }
+
+ static void prio_rq_push(prio_rq_t* rq, task_t* task) {
+     uint8_t level = task->priority;
+
+     /* Remember the level so a later priority change can still find the task */
+     task->rq_key = level;
+     task->rq_next = NULL;
+     task->rq_prev = rq->tail[level];
+
+     if (rq->tail[level] != NULL) {
+         rq->tail[level]->rq_next = task;
+     } else {
+         rq->head[level] = task;
+     }
+     rq->tail[level] = task;
+
+     rq->bitmap |= (1u << level);
+ }
+
+ static void prio_rq_remove(prio_rq_t* rq, task_t* task) {
+     uint32_t level = task->rq_key;
+
+     if (task->rq_prev != NULL) {
+         task->rq_prev->rq_next = task->rq_next;
+     } else {
+         rq->head[level] = task->rq_next;
+     }
+
+     if (task->rq_next != NULL) {
+         task->rq_next->rq_prev = task->rq_prev;
+     } else {
+         rq->tail[level] = task->rq_prev;
+     }
+
+     task->rq_next = NULL;
+     task->rq_prev = NULL;
+
+     if (rq->head[level] == NULL) {
+         rq->bitmap &= ~(1u << level);
+     }
+ }
+
+ static task_t* prio_rq_first(const prio_rq_t* rq) {
+     if (rq->bitmap == 0) {
+         return NULL;
+     }
+
+     /* Lowest set bit is the highest priority level */
+     return rq->head[__builtin_ctz(rq->bitmap)];
+ }
+
+ /* Priority class */
+
+ static int priority_init(void) {
+     prio_rq_reset(&priority_rq);
+     return 0;
+ }
+
+ static void priority_enqueue(task_t* task) {
+     prio_rq_push(&priority_rq, task);
+ }
+
+ static void priority_dequeue(task_t* task) {
+     prio_rq_remove(&priority_rq, task);
+ }
+
+ static task_t* priority_pick_next(void) {
+     return prio_rq_first(&priority_rq);
+ }
+
+ const sched_class_t sched_class_priority = {
+     .name = "priority",
+     .init = priority_init,
+     .admit = NULL,
+     .enqueue = priority_enqueue,
+     .dequeue = priority_dequeue,
+     .pick_next = priority_pick_next,
+     .tick = NULL,
+     .on_block = NULL,
+     .on_wake = NULL
+ };
+
+ /* Round-robin class */
+
+ static int rr_init(void) {
+     prio_rq_reset(&rr_rq);
+     return 0;
+ }
+
+ static void rr_enqueue(task_t* task) {
+     prio_rq_push(&rr_rq, task);
+ }
+
+ static void rr_dequeue(task_t* task) {
+     prio_rq_remove(&rr_rq, task);
+ }
+
+ static task_t* rr_pick_next(void) {
+     return prio_rq_first(&rr_rq);
+ }
+
+ static int rr_tick(task_t* current) {
+     if (current->time_slice_count > 0) {
+         current->time_slice_count--;
+     }
+
+     if (current->time_slice_count > 0) {
+         return 0;
+     }
+
+     /* Slice expired: refill and rotate only if a peer is waiting at this level */
+     current->time_slice_count = current->time_slice;
+     return (rr_rq.bitmap & (1u << current->priority)) != 0;
+ }
+
+ static void rr_on_wake(task_t* task) {
+     task->time_slice_count = task->time_slice;
+ }
+
+ const sched_class_t sched_class_rr = {
+     .name = "round-robin",
+     .init = rr_init,
+     .admit = NULL,
+     .enqueue = rr_enqueue,
+     .dequeue = rr_dequeue,
+     .pick_next = rr_pick_next,
+     .tick = rr_tick,
+     .on_block = NULL,
+     .on_wake = rr_on_wake
+ };
+
+ /* EDF class */
+
+ static void edf_swap(uint32_t a, uint32_t b) {
+     task_t* tmp = edf_heap[a];
+     edf_heap[a] = edf_heap[b];
+     edf_heap[b] = tmp;
+     edf_heap[a]->rq_key = a;
+     edf_heap[b]->rq_key = b;
+ }
+
+ static void edf_sift_up(uint32_t i) {
+     while (i > 0) {
+         uint32_t parent = (i - 1) / 2;
+         if (edf_heap[parent]->absolute_deadline <= edf_heap[i]->absolute_deadline) {
+             break;
+         }
+         edf_swap(i, parent);
+         i = parent;
+     }
+ }
+
+ static void edf_sift_down(uint32_t i) {
+     for (;;) {
+         uint32_t left = 2 * i + 1;
+         uint32_t right = left + 1;
+         uint32_t smallest = i;
+
+         if (left < edf_count &&
+             edf_heap[left]->absolute_deadline < edf_heap[smallest]->absolute_deadline) {
+             smallest = left;
+         }
+         if (right < edf_count &&
+             edf_heap[right]->absolute_deadline < edf_heap[smallest]->absolute_deadline) {
+             smallest = right;
+         }
+         if (smallest == i) {
+             break;
+         }
+
+         edf_swap(i, smallest);
+         i = smallest;
+     }
+ }
+
+ static int edf_init(void) {
+     edf_count = 0;
+     return 0;
+ }
+
+ static int edf_admit(const task_t* task) {
+     /* Only periodic tasks carry deadlines */
+     return task->period > 0;
+ }
+
+ static void edf_enqueue(task_t* task) {
+     if (edf_count >= MAX_TASKS) {
+         LOG_ERROR("EDF run queue full");
+         return;
+     }
+
+     task->rq_key = edf_count;
+     edf_heap[edf_count++] = task;
+     edf_sift_up(task->rq_key);
+ }
+
+ static void edf_dequeue(task_t* task) {
+     uint32_t i = task->rq_key;
+
+     if (i >= edf_count || edf_heap[i] != task) {
+         LOG_ERROR("Task '%s' not in EDF run queue", task->name);
+         return;
+     }
+
+     edf_count--;
+     if (i != edf_count) {
+         edf_heap[i] = edf_heap[edf_count];
+         edf_heap[i]->rq_key = i;
+         edf_sift_down(i);
+         edf_sift_up(i);
+     }
+ }
+
+ static task_t* edf_pick_next(void) {
+     return (edf_count > 0) ? edf_heap[0] : NULL;
+ }
+
+ const sched_class_t sched_class_edf = {
+     .name = "edf",
+     .init = edf_init,
+     .admit = edf_admit,
+     .enqueue = edf_enqueue,
+     .dequeue = edf_dequeue,
+     .pick_next = edf_pick_next,
+     .tick = NULL,
+     .on_block = NULL,
+     .on_wake = NULL
+ };
+
+ /* RMS class */
+
+ static int rms_init(void) {
+     rms_head = NULL;
+     return 0;
+ }
+
+ static int rms_admit(const task_t* task) {
+     return task->period > 0;
+ }
+
+ static int rms_before(const task_t* a, const task_t* b) {
+     /* Shorter period wins, configured priority breaks ties */
+     if (a->period != b->period) {
+         return a->period < b->period;
+     }
+     return a->priority < b->priority;
+ }
+
+ static void rms_enqueue(task_t* task) {
+     task_t* prev = NULL;
+     task_t* node = rms_head;
+
+     /* Insert after all tasks of equal or higher rate for FIFO among equals */
+     while (node != NULL && !rms_before(task, node)) {
+         prev = node;
+         node = node->rq_next;
+     }
+
+     task->rq_prev = prev;
+     task->rq_next = node;
+
+     if (prev != NULL) {
+         prev->rq_next = task;
+     } else {
+         rms_head = task;
+     }
+
+     if (node != NULL) {
+         node->rq_prev = task;
+     }
+ }
+
+ static void rms_dequeue(task_t* task) {
+     if (task->rq_prev != NULL) {
+         task->rq_prev->rq_next = task->rq_next;
+     } else {
+         rms_head = task->rq_next;
+     }
+
+     if (task->rq_next != NULL) {
+         task->rq_next->rq_prev = task->rq_prev;
+     }
+
+     task->rq_next = NULL;
+     task->rq_prev = NULL;
+ }
+
+ static task_t* rms_pick_next(void) {
+     return rms_head;
+ }
+
+ const sched_class_t sched_class_rms = {
+     .name = "rms",
+     .init = rms_init,
+     .admit = rms_admit,
+     .enqueue = rms_enqueue,
+     .dequeue = rms_dequeue,
+     .pick_next = rms_pick_next,
+     .tick = NULL,
+     .on_block = NULL,
+     .on_wake = NULL
+ };
+
+ /* Policy stacks, highest class first */
+ static const sched_class_t* const priority_stack[] = { &sched_class_priority };
+ static const sched_class_t* const rr_stack[] = { &sched_class_rr };
+ static const sched_class_t* const edf_stack[] = { &sched_class_edf, &sched_class_priority };
+ static const sched_class_t* const rms_stack[] = { &sched_class_rms, &sched_class_priority };
+
+ /**
+  * Get the class stack implementing a scheduling policy
+  */
+ const sched_class_t* const* sched_class_get_stack(uint8_t policy, uint32_t* depth) {
+     const sched_class_t* const* stack = NULL;
+     uint32_t n = 0;
+
+     switch (policy) {
+         case SCHEDULING_POLICY_PRIORITY:
+             stack = priority_stack;
+             n = sizeof(priority_stack) / sizeof(priority_stack[0]);
+             break;
+
+         case SCHEDULING_POLICY_RR:
+             stack = rr_stack;
+             n = sizeof(rr_stack) / sizeof(rr_stack[0]);
+             break;
+
+         case SCHEDULING_POLICY_EDF:
+             stack = edf_stack;
+             n = sizeof(edf_stack) / sizeof(edf_stack[0]);
+             break;
+
+         case SCHEDULING_POLICY_RMS:
+             stack = rms_stack;
+             n = sizeof(rms_stack) / sizeof(rms_stack[0]);
+             break;
+
+         default:
+             break;
+     }
+
+     if (depth != NULL) {
+         *depth = n;
+     }
+
+     return stack;
+ }
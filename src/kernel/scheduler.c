@@ -6,9 +6,13 @@
  #include <stdlib.h>
  #include <string.h>
  #include "../../include/kernel/scheduler.h"
+ #include "../../include/kernel/sched_class.h"
  #include "../../include/kernel/task.h"
  #include "../../include/kernel/context.h"
  #include "../../include/kernel/time.h"
+ #include "../../include/kernel/trace.h"
+ #include "../../include/kernel/let.h"
+ #include "../../include/kernel/overhead.h"
  #include "../../include/utils/logger.h"
  #include "../../include/utils/list.h"
  #include "../../include/config.h"
@@ -16,6 +20,7 @@
  /* External functions from task.c */
  extern void task_set_current(task_t* task);
  extern task_t* task_get_idle(void);
+ extern task_t* task_list[MAX_TASKS];
  
  /* Scheduler state */
  static scheduler_state_t scheduler_state = SCHEDULER_STOPPED;
@@ -23,8 +28,9 @@
  /* Current scheduling policy */
  static uint8_t current_policy = DEFAULT_SCHEDULING_POLICY;
  
- /* Ready lists for each priority level */
- static list_t ready_lists[MAX_PRIORITY_LEVELS];
+ /* Class stack implementing the current policy, highest class first */
+ static const sched_class_t* const* class_stack = NULL;
+ static uint32_t class_stack_depth = 0;
  
  /* Blocked task list */
  static list_t blocked_list;
@@ -38,6 +44,167 @@
  /* Scheduler lock counter (for critical sections) */
  static uint32_t scheduler_lock_count = 0;
  
+ /**
+  * Select the highest class in the current stack that admits a task
+  */
+ static const sched_class_t* scheduler_select_class(const task_t* task) {
+     for (uint32_t i = 0; i < class_stack_depth; i++) {
+         const sched_class_t* cls = class_stack[i];
+         if (cls->admit == NULL || cls->admit(task)) {
+             return cls;
+         }
+     }
+     
+     /* Lowest class is the catch-all */
+     return class_stack[class_stack_depth - 1];
+ }
+ 
+ /**
+  * Insert a task into its class run queue
+  */
+ static void rq_enqueue(task_t* task) {
+     /* Tasks created before scheduler_init() are adopted there */
+     if (task->on_rq || class_stack == NULL) {
+         return;
+     }
+     
+     if (task->sched_class == NULL) {
+         task->sched_class = scheduler_select_class(task);
+     }
+     
+     task->sched_class->enqueue(task);
+     task->on_rq = 1;
+ }
+ 
+ /**
+  * Remove a task from its class run queue
+  */
+ static void rq_dequeue(task_t* task) {
+     if (!task->on_rq) {
+         return;
+     }
+     
+     task->sched_class->dequeue(task);
+     task->on_rq = 0;
+ }
+ 
+ /**
+  * Install a new class stack and migrate all tasks into it
+  */
+ static int scheduler_install_stack(const sched_class_t* const* stack, uint32_t depth) {
+     /* Drain every run queue through the old classes */
+     for (int i = 0; i < MAX_TASKS; i++) {
+         if (task_list[i] != NULL) {
+             rq_dequeue(task_list[i]);
+         }
+     }
+     
+     /* Switch stacks and reset the new class run queues */
+     class_stack = stack;
+     class_stack_depth = depth;
+     for (uint32_t i = 0; i < class_stack_depth; i++) {
+         if (class_stack[i]->init() != 0) {
+             LOG_ERROR("Failed to initialize %s class", class_stack[i]->name);
+             return -1;
+         }
+     }
+     
+     /* Reassign every task and refill the new run queues */
+     for (int i = 0; i < MAX_TASKS; i++) {
+         task_t* task = task_list[i];
+         if (task == NULL) {
+             continue;
+         }
+         
+         task->sched_class = scheduler_select_class(task);
+         if (task->state == TASK_STATE_READY) {
+             rq_enqueue(task);
+         }
+     }
+     
+     return 0;
+ }
+ 
+ /**
+  * Remove a task from a state list
+  */
+ static int list_remove_task(list_t* list, task_t* task) {
+     list_node_t* node = list_find(list, task);
+     if (node == NULL) {
+         return -1;
+     }
+     
+     return list_remove(list, node, 0);
+ }
+ 
+ /**
+  * Run a basic task to completion on the caller's stack
+  * No context is saved: the job is a nested call that returns here
+  */
+ static void scheduler_run_basic(task_t* task) {
+     task_t* preempted = task_get_current();
+     
+     do {
+         task->state = TASK_STATE_RUNNING;
+         task_set_current(task);
+         stats.context_switches++;
+         trace_event(TRACE_SWITCH, task, (preempted != NULL) ? preempted->id : TRACE_NO_TASK, 0);
+         overhead_charge(OVH_CONTEXT_SWITCH);
+         
+         uint32_t start = time_get_ticks();
+         task->stats.last_start_time = start;
+         task->stats.num_activations++;
+         
+         task->task_func(task->task_arg);
+         
+         uint32_t runtime = time_get_ticks() - start;
+         task->stats.total_runtime += runtime;
+         if (runtime > task->stats.max_execution_time) {
+             task->stats.max_execution_time = runtime;
+         }
+         
+         /* Consume one queued activation, if any */
+         uint32_t prev_state = context_enter_critical();
+         int again = (task->pending_activations > 0);
+         if (again) {
+             task->pending_activations--;
+         }
+         context_exit_critical(prev_state);
+         
+         if (!again) {
+             break;
+         }
+     } while (1);
+     
+     /* Job finished: back to suspended until the next activation */
+     trace_event(TRACE_BLOCK, task, BLOCK_REASON_NONE, 0);
+     if (preempted != NULL) {
+         trace_event(TRACE_SWITCH, preempted, task->id, 0);
+     }
+     task->state = TASK_STATE_SUSPENDED;
+     if (list_append(&suspended_list, task) != 0) {
+         LOG_ERROR("Failed to add task to suspended list");
+     }
+     
+     task_set_current(preempted);
+ }
+ 
+ /**
+  * Get the next task, running ready basic tasks inline until an
+  * extended task is selected
+  */
+ static task_t* scheduler_pick_extended(void) {
+     task_t* next = scheduler_get_next_task();
+     
+     while (next != NULL && next->type == TASK_TYPE_BASIC) {
+         rq_dequeue(next);
+         scheduler_run_basic(next);
+         next = scheduler_get_next_task();
+     }
+     
+     return next;
+ }
+ 
  /**
   * Initialize the scheduler
   */
@@ -45,14 +212,20 @@
      LOG_INFO("Initializing scheduler with policy %s", 
               scheduler_policy_to_string(policy));
      
-     /* Initialize task lists */
-     for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
-         if (list_init(&ready_lists[i]) != 0) {
-             LOG_ERROR("Failed to initialize ready list %d", i);
-             return -1;
-         }
+     /* Look up the class stack for this policy */
+     uint32_t depth = 0;
+     const sched_class_t* const* stack = sched_class_get_stack(policy, &depth);
+     if (stack == NULL) {
+         LOG_ERROR("Unknown scheduling policy: %d", policy);
+         return -1;
      }
      
+     /* Initialize class run queues, adopting any tasks created earlier */
+     if (scheduler_install_stack(stack, depth) != 0) {
+         return -1;
+     }
+     
+     /* Initialize task lists */
      if (list_init(&blocked_list) != 0) {
          LOG_ERROR("Failed to initialize blocked list");
          return -1;
@@ -97,8 +270,8 @@
      /* Set state */
      scheduler_state = SCHEDULER_RUNNING;
      
-     /* Get first task to run */
-     task_t* first_task = scheduler_get_next_task();
+     /* Get first task to run, completing any ready basic tasks first */
+     task_t* first_task = scheduler_pick_extended();
      if (first_task == NULL) {
          LOG_ERROR("No tasks ready to run");
          scheduler_state = SCHEDULER_STOPPED;
@@ -155,10 +328,7 @@
      /* Add to appropriate list based on state */
      switch (task->state) {
          case TASK_STATE_READY:
-             if (list_append(&ready_lists[task->priority], task) != 0) {
-                 LOG_ERROR("Failed to add task to ready list");
-                 return -1;
-             }
+             rq_enqueue(task);
              break;
              
          case TASK_STATE_BLOCKED:
@@ -197,21 +367,18 @@
      /* Remove from appropriate list based on state */
      switch (task->state) {
          case TASK_STATE_READY:
-             if (list_remove(&ready_lists[task->priority], (list_node_t*)task, 0) != 0) {
-                 LOG_ERROR("Failed to remove task from ready list");
-                 return -1;
-             }
+             rq_dequeue(task);
              break;
              
          case TASK_STATE_BLOCKED:
-             if (list_remove(&blocked_list, (list_node_t*)task, 0) != 0) {
+             if (list_remove_task(&blocked_list, task) != 0) {
                  LOG_ERROR("Failed to remove task from blocked list");
                  return -1;
              }
              break;
              
          case TASK_STATE_SUSPENDED:
-             if (list_remove(&suspended_list, (list_node_t*)task, 0) != 0) {
+             if (list_remove_task(&suspended_list, task) != 0) {
                  LOG_ERROR("Failed to remove task from suspended list");
                  return -1;
              }
@@ -248,87 +415,9 @@
          }
      }
      
-     /* Select based on scheduling policy */
-     switch (current_policy) {
-         case SCHEDULING_POLICY_PRIORITY:
-             /* Find highest priority task that is ready */
-             for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
-                 if (!list_is_empty(&ready_lists[i])) {
-                     next_task = (task_t*)list_head(&ready_lists[i])->data;
-                     break;
-                 }
-             }
-             break;
-             
-         case SCHEDULING_POLICY_RR:
-             /* Round robin within priority */
-             for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
-                 if (!list_is_empty(&ready_lists[i])) {
-                     /* Get first task */
-                     next_task = (task_t*)list_head(&ready_lists[i])->data;
-                     
-                     /* Move to end of list (round robin) */
-                     list_remove(&ready_lists[i], (list_node_t*)next_task, 0);
-                     list_append(&ready_lists[i], next_task);
-                     
-                     break;
-                 }
-             }
-             break;
-             
-         case SCHEDULING_POLICY_EDF:
-             {
-                 /* Earliest deadline first */
-                 task_t* earliest = NULL;
-                 uint32_t earliest_deadline = UINT32_MAX;
-                 
-                 /* Search all ready lists for earliest deadline */
-                 for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
-                     if (!list_is_empty(&ready_lists[i])) {
-                         list_node_t* node = list_head(&ready_lists[i]);
-                         while (node != NULL) {
-                             task_t* task = (task_t*)node->data;
-                             
-                             /* Only consider periodic tasks with deadlines */
-                             if (task->period > 0 && task->absolute_deadline < earliest_deadline) {
-                                 earliest = task;
-                                 earliest_deadline = task->absolute_deadline;
-                             }
-                             
-                             node = node->next;
-                         }
-                     }
-                 }
-                 
-                 /* If we found a task with deadline, use it */
-                 if (earliest != NULL) {
-                     next_task = earliest;
-                 } else {
-                     /* Fall back to priority scheduling for non-periodic tasks */
-                     for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
-                         if (!list_is_empty(&ready_lists[i])) {
-                             next_task = (task_t*)list_head(&ready_lists[i])->data;
-                             break;
-                         }
-                     }
-                 }
-             }
-             break;
-             
-         case SCHEDULING_POLICY_RMS:
-             /* Rate monotonic - priority based on period (shorter period = higher priority) */
-             /* For this simulation, we just use the configured priorities */
-             for (int i = 0; i < MAX_PRIORITY_LEVELS; i++) {
-                 if (!list_is_empty(&ready_lists[i])) {
-                     next_task = (task_t*)list_head(&ready_lists[i])->data;
-                     break;
-                 }
-             }
-             break;
-             
-         default:
-             LOG_ERROR("Unknown scheduling policy: %d", current_policy);
-             break;
+     /* Ask each class in the stack, highest first */
+     for (uint32_t i = 0; i < class_stack_depth && next_task == NULL; i++) {
+         next_task = class_stack[i]->pick_next();
      }
      
      /* If no task is ready, use idle task */
@@ -354,19 +443,28 @@
          return -1;
      }
      
+     /* Basic tasks run to completion on the caller's stack */
+     if (task->type == TASK_TYPE_BASIC) {
+         LOG_ERROR("Basic task '%s' cannot block", task->name);
+         return -1;
+     }
+     
      /* Set block reason and object */
      task->block_reason = reason;
      task->block_object = block_object;
      
-     /* Update task state */
-     task->state = TASK_STATE_BLOCKED;
+     /* Remove from run queue (a running task is not queued) */
+     rq_dequeue(task);
      
-     /* Remove from ready list */
-     if (list_remove(&ready_lists[task->priority], (list_node_t*)task, 0) != 0) {
-         LOG_ERROR("Failed to remove task from ready list");
-         return -1;
+     /* Notify owning class */
+     if (task->sched_class != NULL && task->sched_class->on_block != NULL) {
+         task->sched_class->on_block(task);
      }
      
+     /* Update task state */
+     task->state = TASK_STATE_BLOCKED;
+     trace_event(TRACE_BLOCK, task, (uint8_t)reason, trace_object_id(block_object));
+     
      /* Add to blocked list */
      if (list_append(&blocked_list, task) != 0) {
          LOG_ERROR("Failed to add task to blocked list");
@@ -397,18 +495,19 @@
      
      /* Update task state */
      task->state = TASK_STATE_READY;
+     trace_event(TRACE_UNBLOCK, task, 0, 0);
      
      /* Remove from blocked list */
-     if (list_remove(&blocked_list, (list_node_t*)task, 0) != 0) {
+     if (list_remove_task(&blocked_list, task) != 0) {
          LOG_ERROR("Failed to remove task from blocked list");
          return -1;
      }
      
-     /* Add to ready list */
-     if (list_append(&ready_lists[task->priority], task) != 0) {
-         LOG_ERROR("Failed to add task to ready list");
-         return -1;
+     /* Notify owning class and requeue */
+     if (task->sched_class != NULL && task->sched_class->on_wake != NULL) {
+         task->sched_class->on_wake(task);
      }
+     rq_enqueue(task);
      
      return 0;
  }
@@ -431,13 +530,39 @@
          return 0;  /* Skip context switch while locked */
      }
      
-     /* Get next task to run */
-     next = scheduler_get_next_task();
+     /* A running basic job is a nested call on this stack and cannot be
+        switched away from. Basic tasks sit above every extended task
+        (enforced in task.c), so only a higher-priority basic task can
+        preempt it, by nesting on top of it */
+     if (current != NULL && current->type == TASK_TYPE_BASIC &&
+         current->state == TASK_STATE_RUNNING) {
+         next = scheduler_get_next_task();
+         while (next != NULL && next->type == TASK_TYPE_BASIC &&
+                next->priority < current->priority) {
+             rq_dequeue(next);
+             scheduler_run_basic(next);
+             next = scheduler_get_next_task();
+         }
+         return 0;
+     }
+     
+     /* Put a still-runnable current task back so it competes for the CPU */
+     if (current != NULL && current->state == TASK_STATE_RUNNING) {
+         current->state = TASK_STATE_READY;
+         rq_enqueue(current);
+     }
+     
+     /* Get next task to run; basic tasks complete inline */
+     next = scheduler_pick_extended();
      if (next == NULL) {
          LOG_ERROR("No tasks ready to run");
          return -1;
      }
      
+     /* Remove from run queue and mark running */
+     rq_dequeue(next);
+     next->state = TASK_STATE_RUNNING;
+     
      /* Don't switch if it's the same task */
      if (current == next) {
          return 0;
@@ -445,28 +570,11 @@
      
      /* Update statistics */
      stats.context_switches++;
+     trace_event(TRACE_SWITCH, next, (current != NULL) ? current->id : TRACE_NO_TASK, 0);
+     overhead_charge(OVH_CONTEXT_SWITCH);
      
-     /* If current task is running, update its state */
-     if (current != NULL && current->state == TASK_STATE_RUNNING) {
-         /* Check if time slice expired (for round robin) */
-         if (current_policy == SCHEDULING_POLICY_RR && 
-             --current->time_slice_count == 0) {
-             
-             /* Reset time slice counter */
-             current->time_slice_count = current->time_slice;
-             
-             /* Mark as ready and put at end of ready list */
-             current->state = TASK_STATE_READY;
-             list_append(&ready_lists[current->priority], current);
-         } else {
-             /* Otherwise just mark as ready and leave in ready list */
-             current->state = TASK_STATE_READY;
-             if (list_append(&ready_lists[current->priority], current) != 0) {
-                 LOG_ERROR("Failed to add current task back to ready list");
-             }
-         }
-         
-         /* Update runtime statistics */
+     /* Update runtime statistics of the task being switched out */
+     if (current != NULL && current->state == TASK_STATE_READY) {
          uint32_t now = time_get_ticks();
          uint32_t runtime = now - current->stats.last_start_time;
          current->stats.total_runtime += runtime;
@@ -477,14 +585,6 @@
          }
      }
      
-     /* Update next task state */
-     next->state = TASK_STATE_RUNNING;
-     
-     /* Remove from ready list */
-     if (list_remove(&ready_lists[next->priority], (list_node_t*)next, 0) != 0) {
-         LOG_ERROR("Failed to remove next task from ready list");
-     }
-     
      /* Update task statistics */
      next->stats.last_start_time = time_get_ticks();
      next->stats.num_activations++;
@@ -520,10 +620,10 @@
      /* Handle based on old state */
      switch (task->state) {
          case TASK_STATE_READY:
-             /* Remove from ready list */
-             if (list_remove(&ready_lists[task->priority], (list_node_t*)task, 0) != 0) {
-                 LOG_ERROR("Failed to remove task from ready list");
-                 return -1;
+             /* Remove from run queue */
+             rq_dequeue(task);
+             if (task->sched_class != NULL && task->sched_class->on_block != NULL) {
+                 task->sched_class->on_block(task);
              }
              break;
              
@@ -534,7 +634,7 @@
              
          case TASK_STATE_BLOCKED:
              /* Remove from blocked list */
-             if (list_remove(&blocked_list, (list_node_t*)task, 0) != 0) {
+             if (list_remove_task(&blocked_list, task) != 0) {
                  LOG_ERROR("Failed to remove task from blocked list");
                  return -1;
              }
@@ -542,7 +642,7 @@
              
          case TASK_STATE_SUSPENDED:
              /* Remove from suspended list */
-             if (list_remove(&suspended_list, (list_node_t*)task, 0) != 0) {
+             if (list_remove_task(&suspended_list, task) != 0) {
                  LOG_ERROR("Failed to remove task from suspended list");
                  return -1;
              }
@@ -556,15 +656,20 @@
      
      /* Update task state */
      task->state = new_state;
+     if (new_state == TASK_STATE_READY) {
+         trace_event(TRACE_UNBLOCK, task, 0, 0);
+     } else if (new_state == TASK_STATE_SUSPENDED) {
+         trace_event(TRACE_BLOCK, task, BLOCK_REASON_NONE, 0);
+     }
      
      /* Handle based on new state */
      switch (new_state) {
          case TASK_STATE_READY:
-             /* Add to ready list */
-             if (list_append(&ready_lists[task->priority], task) != 0) {
-                 LOG_ERROR("Failed to add task to ready list");
-                 return -1;
+             /* Add to run queue */
+             if (task->sched_class != NULL && task->sched_class->on_wake != NULL) {
+                 task->sched_class->on_wake(task);
              }
+             rq_enqueue(task);
              break;
              
          case TASK_STATE_RUNNING:
@@ -610,6 +715,7 @@
      
      /* Update system time */
      stats.system_time++;
+     overhead_charge(OVH_TICK);
      
      /* Update idle time if idle task is running */
      if (current == task_get_idle()) {
@@ -637,6 +743,11 @@
          node = next;
      }
      
+     /* LET outputs due now are published and inputs read before the releases */
+ #if ENABLE_LET
+     let_tick(time_get_ticks());
+ #endif
+     
      /* Check for periodic tasks that need to be released */
      for (int i = 0; i < MAX_TASKS; i++) {
          task_t* task = task_list[i];
@@ -662,16 +773,23 @@
                  /* Calculate next release time and deadline */
                  task->next_release += task->period;
                  task->absolute_deadline = task->next_release + task->deadline;
+                 trace_event(TRACE_RELEASE, task, 0, current_time + task->deadline);
                  
-                 /* If task is blocked or suspended, unblock it */
-                 if (task->state == TASK_STATE_BLOCKED) {
+                 /* Basic tasks are released by activation; extended
+                    tasks that are blocked or suspended are unblocked */
+                 if (task->type == TASK_TYPE_BASIC) {
+                     if (task_activate(task) == 0) {
+                         unblocked_count++;
+                     }
+                 } else if (task->state == TASK_STATE_BLOCKED) {
                      scheduler_unblock_task(task);
                      unblocked_count++;
                  } else if (task->state == TASK_STATE_SUSPENDED) {
-                     task->state = TASK_STATE_READY;
-                     list_remove(&suspended_list, (list_node_t*)task, 0);
-                     list_append(&ready_lists[task->priority], task);
+                     scheduler_update_task_state(task, TASK_STATE_READY);
                      unblocked_count++;
+                 } else if (task->on_rq) {
+                     /* Deadline changed, restore class ordering */
+                     scheduler_requeue_task(task);
                  }
                  
                  LOG_DEBUG("Released periodic task '%s' (next=%u, deadline=%u)",
@@ -688,20 +806,15 @@
          }
      }
      
-     /* If using round-robin policy, check time slice */
-     if (current_policy == SCHEDULING_POLICY_RR && 
-         current != NULL && 
-         current != task_get_idle()) {
+     /* Let the running task's class account the tick (e.g. time slices) */
+     if (current != NULL && 
+         current != task_get_idle() &&
+         current->sched_class != NULL &&
+         current->sched_class->tick != NULL) {
          
-         /* Decrement time slice counter */
-         if (--current->time_slice_count == 0) {
-             /* Time slice expired, reset counter */
-             current->time_slice_count = current->time_slice;
-             
-             /* Trigger context switch if scheduler isn't locked */
-             if (scheduler_lock_count == 0) {
-                 scheduler_context_switch();
-             }
+         /* Trigger context switch if the class asks and scheduler isn't locked */
+         if (current->sched_class->tick(current) && scheduler_lock_count == 0) {
+             scheduler_context_switch();
          }
      }
      
@@ -755,12 +868,11 @@
   * Set scheduling policy
   */
  int scheduler_set_policy(uint8_t policy) {
+     uint32_t depth = 0;
+     
      /* Validate policy */
-     if (policy != SCHEDULING_POLICY_PRIORITY && 
-         policy != SCHEDULING_POLICY_RR && 
-         policy != SCHEDULING_POLICY_EDF && 
-         policy != SCHEDULING_POLICY_RMS) {
-         
+     const sched_class_t* const* stack = sched_class_get_stack(policy, &depth);
+     if (stack == NULL) {
          LOG_ERROR("Invalid scheduling policy: %d", policy);
          return -1;
      }
@@ -769,8 +881,42 @@
               scheduler_policy_to_string(current_policy),
               scheduler_policy_to_string(policy));
      
-     /* Set new policy */
-     current_policy = policy;
+     /* Migrate all tasks into the new class structures */
+     uint32_t prev_state = context_enter_critical();
+     int result = scheduler_install_stack(stack, depth);
+     if (result == 0) {
+         /* Set new policy */
+         current_policy = policy;
+     }
+     context_exit_critical(prev_state);
+     
+     return result;
+ }
+ 
+ /**
+  * Re-evaluate a task's class and run queue position
+  */
+ int scheduler_requeue_task(task_t* task) {
+     if (task == NULL) {
+         LOG_ERROR("NULL task pointer");
+         return -1;
+     }
+     
+     uint32_t prev_state = context_enter_critical();
+     
+     /* Dequeue through the old class, since its key may be stale */
+     int queued = task->on_rq;
+     rq_dequeue(task);
+     
+     if (class_stack != NULL) {
+         task->sched_class = scheduler_select_class(task);
+     }
+     
+     if (queued) {
+         rq_enqueue(task);
+     }
+     
+     context_exit_critical(prev_state);
      
      return 0;
  }
@@ -0,0 +1,629 @@
+/**
+ * @file sdf.c
+ * @brief Implementation of synchronous dataflow graphs
+ *
+ * With an iteration period H, actor u fires every T_u = H / q_u ticks
+ * and each token on an edge u -> v stands for tau = H / (q_u * p) ticks.
+ * Firing n_v of v needs firing n_u of u whenever n_u * p < (n_v + 1) * c - d.
+ * X = n_u * p - n_v * c takes every multiple of g = gcd(p, c), so all of
+ * these precedences hold if
+ *
+ *     s_v >= s_u + T_u + tau * (g * ceil((c - d) / g) - g)
+ *
+ * The start times are longest paths over these constraints. A positive
+ * cycle means the cycle's initial tokens are too few. Since every
+ * constraint scales with H, only the token counts decide this, never the
+ * WCETs. H is rounded to a multiple of every q_u * p, so the weights are
+ * exact in ticks.
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include "../../include/kernel/sdf.h"
+ #include "../../include/kernel/heap.h"
+ #include "../../include/kernel/time.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ /* Graph storage */
+ static sdf_graph_t graphs[MAX_SDF_GRAPHS];
+ static uint8_t graph_used[MAX_SDF_GRAPHS];
+
+ /**
+  * Greatest common divisor
+  */
+ static uint64_t gcd64(uint64_t a, uint64_t b) {
+     while (b != 0) {
+         uint64_t r = a % b;
+         a = b;
+         b = r;
+     }
+
+     return a;
+ }
+
+ /**
+  * Least common multiple, 0 if it exceeds 32 bits
+  */
+ static uint64_t lcm64(uint64_t a, uint64_t b) {
+     uint64_t l = a / gcd64(a, b) * b;
+
+     return (l > UINT32_MAX) ? 0 : l;
+ }
+
+ /**
+  * Ceiling of a / b for b > 0
+  */
+ static int64_t ceil_div(int64_t a, int64_t b) {
+     return (a >= 0) ? (a + b - 1) / b : -((-a) / b);
+ }
+
+ /**
+  * Check that a pointer is an allocated graph
+  */
+ static int graph_valid(const sdf_graph_t* graph) {
+     for (int i = 0; i < MAX_SDF_GRAPHS; i++) {
+         if (&graphs[i] == graph && graph_used[i]) {
+             return 1;
+         }
+     }
+
+     return 0;
+ }
+
+ /**
+  * Solve the balance equations for the repetitions of every actor
+  */
+ static int sdf_repetitions(sdf_graph_t* graph) {
+     uint64_t num[SDF_MAX_ACTORS];
+     uint64_t den[SDF_MAX_ACTORS];
+     uint8_t known[SDF_MAX_ACTORS];
+
+     memset(known, 0, sizeof(known));
+     num[0] = 1;
+     den[0] = 1;
+     known[0] = 1;
+
+     /* Propagate rates along the edges, in either direction */
+     for (int pass = 0; pass < graph->actor_count; pass++) {
+         for (int e = 0; e < graph->edge_count; e++) {
+             const sdf_edge_t* edge = &graph->edges[e];
+             uint8_t from;
+             uint8_t to;
+             uint64_t mul;
+             uint64_t div;
+
+             if (known[edge->src] && !known[edge->dst]) {
+                 from = edge->src;
+                 to = edge->dst;
+                 mul = edge->produce;
+                 div = edge->consume;
+             } else if (known[edge->dst] && !known[edge->src]) {
+                 from = edge->dst;
+                 to = edge->src;
+                 mul = edge->consume;
+                 div = edge->produce;
+             } else {
+                 continue;
+             }
+
+             num[to] = num[from] * mul;
+             den[to] = den[from] * div;
+             uint64_t g = gcd64(num[to], den[to]);
+             num[to] /= g;
+             den[to] /= g;
+             known[to] = 1;
+         }
+     }
+
+     for (int a = 0; a < graph->actor_count; a++) {
+         if (!known[a]) {
+             LOG_ERROR("Graph '%s': actor '%s' is not connected", graph->name, graph->actors[a].name);
+             return -1;
+         }
+     }
+
+     for (int e = 0; e < graph->edge_count; e++) {
+         const sdf_edge_t* edge = &graph->edges[e];
+         if (num[edge->src] * edge->produce * den[edge->dst] != num[edge->dst] * edge->consume * den[edge->src]) {
+             LOG_ERROR("Graph '%s': rates of edge %s -> %s are inconsistent", graph->name,
+                       graph->actors[edge->src].name, graph->actors[edge->dst].name);
+             return -1;
+         }
+     }
+
+     /* Smallest integer solution */
+     uint64_t scale = 1;
+     for (int a = 0; a < graph->actor_count && scale != 0; a++) {
+         scale = lcm64(scale, den[a]);
+     }
+     uint64_t common = 0;
+     for (int a = 0; a < graph->actor_count && scale != 0; a++) {
+         common = gcd64(common, num[a] * (scale / den[a]));
+     }
+     for (int a = 0; a < graph->actor_count; a++) {
+         uint64_t q = (scale != 0) ? num[a] * (scale / den[a]) / common : 0;
+         if (q == 0 || q > UINT16_MAX) {
+             LOG_ERROR("Graph '%s': repetitions of actor '%s' out of range", graph->name, graph->actors[a].name);
+             return -1;
+         }
+         graph->actors[a].repetitions = (uint32_t)q;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Most tokens an edge holds: produced at the producer's releases,
+  * consumed at the consumer's deadlines, over two iterations past both starts
+  */
+ static uint32_t sdf_edge_capacity(const sdf_graph_t* graph, const sdf_edge_t* edge) {
+     const sdf_actor_t* src = &graph->actors[edge->src];
+     const sdf_actor_t* dst = &graph->actors[edge->dst];
+     int64_t end = (int64_t)((src->start > dst->start) ? src->start : dst->start) + 2 * (int64_t)graph->iteration;
+     int64_t most = edge->delay;
+     int64_t produced = edge->delay;
+
+     for (int64_t t = src->start; t <= end; t += src->period) {
+         int64_t consumed = (t >= (int64_t)dst->start) ? (t - dst->start) / dst->period : 0;
+         produced += edge->produce;
+         int64_t tokens = produced - (int64_t)edge->consume * consumed;
+         if (tokens > most) {
+             most = tokens;
+         }
+     }
+
+     return (most > 0) ? (uint32_t)most : 1;
+ }
+
+ /**
+  * Body of an actor task: one firing per scheduled release
+  */
+ static void sdf_actor_task(void* arg) {
+     sdf_actor_t* actor = (sdf_actor_t*)arg;
+     sdf_graph_t* graph = actor->graph;
+     task_t* self = task_get_current();
+     uint8_t index = (uint8_t)(actor - graph->actors);
+     const void* inputs[SDF_MAX_EDGES];
+     void* outputs[SDF_MAX_EDGES];
+     uint8_t* slot = (uint8_t*)actor->scratch;
+     int input_count = 0;
+     int output_count = 0;
+
+     /* Lay the ports out in the scratch buffer, in edge order */
+     for (int e = 0; e < graph->edge_count; e++) {
+         const sdf_edge_t* edge = &graph->edges[e];
+         if (edge->dst == index) {
+             inputs[input_count++] = slot;
+             slot += edge->consume * edge->token_size;
+         }
+     }
+     for (int e = 0; e < graph->edge_count; e++) {
+         const sdf_edge_t* edge = &graph->edges[e];
+         if (edge->src == index) {
+             outputs[output_count++] = slot;
+             slot += edge->produce * edge->token_size;
+         }
+     }
+
+     while (1) {
+         task_delay_until(self->next_release);
+
+         /* Releases before the actor's place in the schedule are skipped */
+         if (self->next_release - self->period < actor->first_release) {
+             continue;
+         }
+
+         /* Tokens are due by now; a retry means a wakeup before they arrived */
+         int port = 0;
+         for (int e = 0; e < graph->edge_count; e++) {
+             const sdf_edge_t* edge = &graph->edges[e];
+             if (edge->dst != index) {
+                 continue;
+             }
+             uint8_t* token = (uint8_t*)inputs[port++];
+             for (uint32_t k = 0; k < edge->consume; k++, token += edge->token_size) {
+                 while (queue_receive(edge->queue, token, MAX_TIMEOUT) != 0) {
+                     actor->stalls++;
+                 }
+             }
+         }
+
+         actor->fire(actor->ctx, inputs, outputs);
+
+         port = 0;
+         for (int e = 0; e < graph->edge_count; e++) {
+             const sdf_edge_t* edge = &graph->edges[e];
+             if (edge->src != index) {
+                 continue;
+             }
+             const uint8_t* token = (const uint8_t*)outputs[port++];
+             for (uint32_t k = 0; k < edge->produce; k++, token += edge->token_size) {
+                 while (queue_send(edge->queue, token, MAX_TIMEOUT) != 0) {
+                     actor->stalls++;
+                 }
+             }
+         }
+
+         actor->firings++;
+     }
+ }
+
+ /**
+  * Create an empty graph
+  */
+ sdf_graph_t* sdf_create(const char* name) {
+     int index = -1;
+
+     if (name == NULL) {
+         LOG_ERROR("Invalid graph parameters");
+         return NULL;
+     }
+
+     /* Find free slot */
+     for (int i = 0; i < MAX_SDF_GRAPHS; i++) {
+         if (!graph_used[i]) {
+             index = i;
+             break;
+         }
+     }
+
+     if (index == -1) {
+         LOG_ERROR("No free dataflow graph slots");
+         return NULL;
+     }
+
+     /* Initialize graph */
+     sdf_graph_t* graph = &graphs[index];
+     memset(graph, 0, sizeof(sdf_graph_t));
+     strncpy(graph->name, name, MAX_TASK_NAME_LEN - 1);
+     graph->name[MAX_TASK_NAME_LEN - 1] = '\0';
+
+     /* Mark as used */
+     graph_used[index] = 1;
+
+     LOG_INFO("Created dataflow graph '%s'", graph->name);
+
+     return graph;
+ }
+
+ /**
+  * Delete the actor tasks, port buffers and queues created so far
+  */
+ static void sdf_teardown(sdf_graph_t* graph) {
+     /* Stop the actors before their queues go away */
+     for (int a = 0; a < graph->actor_count; a++) {
+         sdf_actor_t* actor = &graph->actors[a];
+         if (actor->task != NULL) {
+             task_delete(actor->task);
+             actor->task = NULL;
+         }
+         if (actor->scratch != NULL) {
+             heap_free(actor->scratch);
+             actor->scratch = NULL;
+         }
+     }
+     for (int e = 0; e < graph->edge_count; e++) {
+         if (graph->edges[e].queue != NULL) {
+             queue_delete(graph->edges[e].queue);
+             graph->edges[e].queue = NULL;
+         }
+     }
+
+     graph->started = 0;
+ }
+
+ /**
+  * Delete a graph with its tasks and queues
+  */
+ int sdf_delete(sdf_graph_t* graph) {
+     if (graph == NULL || !graph_valid(graph)) {
+         LOG_ERROR("Invalid graph pointer");
+         return -1;
+     }
+
+     task_t* current = task_get_current();
+     for (int a = 0; a < graph->actor_count; a++) {
+         if (graph->actors[a].task != NULL && graph->actors[a].task == current) {
+             LOG_ERROR("Graph '%s' cannot be deleted by its own actor", graph->name);
+             return -1;
+         }
+     }
+
+     sdf_teardown(graph);
+
+     graph_used[graph - graphs] = 0;
+
+     LOG_INFO("Deleted dataflow graph '%s'", graph->name);
+     return 0;
+ }
+
+ /**
+  * Add an actor
+  */
+ int sdf_add_actor(sdf_graph_t* graph, const char* name, sdf_fire_t fire, void* ctx,
+                   uint8_t priority, uint32_t wcet) {
+     if (graph == NULL || name == NULL || fire == NULL || !graph_valid(graph) ||
+         priority >= MAX_PRIORITY_LEVELS) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     if (graph->compiled) {
+         LOG_ERROR("Graph '%s' is already compiled", graph->name);
+         return -1;
+     }
+
+     if (graph->actor_count >= SDF_MAX_ACTORS) {
+         LOG_ERROR("Graph '%s' has more than %d actors", graph->name, SDF_MAX_ACTORS);
+         return -1;
+     }
+
+     sdf_actor_t* actor = &graph->actors[graph->actor_count];
+     memset(actor, 0, sizeof(sdf_actor_t));
+     strncpy(actor->name, name, MAX_TASK_NAME_LEN - 1);
+     actor->name[MAX_TASK_NAME_LEN - 1] = '\0';
+     actor->fire = fire;
+     actor->ctx = ctx;
+     actor->priority = priority;
+     actor->wcet = wcet;
+     actor->graph = graph;
+
+     return graph->actor_count++;
+ }
+
+ /**
+  * Add an edge
+  */
+ int sdf_add_edge(sdf_graph_t* graph, uint8_t src, uint8_t dst, uint32_t produce, uint32_t consume,
+                  size_t token_size, uint32_t delay) {
+     if (graph == NULL || !graph_valid(graph) || src >= graph->actor_count || dst >= graph->actor_count ||
+         produce == 0 || consume == 0 || token_size == 0) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     if (graph->compiled) {
+         LOG_ERROR("Graph '%s' is already compiled", graph->name);
+         return -1;
+     }
+
+     if (graph->edge_count >= SDF_MAX_EDGES) {
+         LOG_ERROR("Graph '%s' has more than %d edges", graph->name, SDF_MAX_EDGES);
+         return -1;
+     }
+
+     sdf_edge_t* edge = &graph->edges[graph->edge_count];
+     memset(edge, 0, sizeof(sdf_edge_t));
+     edge->src = src;
+     edge->dst = dst;
+     edge->produce = produce;
+     edge->consume = consume;
+     edge->token_size = token_size;
+     edge->delay = delay;
+
+     return graph->edge_count++;
+ }
+
+ /**
+  * Compute repetitions, periods, start times and buffer capacities
+  */
+ int sdf_compile(sdf_graph_t* graph, uint32_t iteration) {
+     int64_t start[SDF_MAX_ACTORS];
+     int64_t weight[SDF_MAX_EDGES];
+
+     if (graph == NULL || !graph_valid(graph) || graph->actor_count == 0) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     if (graph->started) {
+         LOG_ERROR("Graph '%s' is already running", graph->name);
+         return -1;
+     }
+
+     if (sdf_repetitions(graph) != 0) {
+         return -1;
+     }
+
+     /* Work per iteration, and the granularity that keeps all intervals whole */
+     uint64_t demand = 0;
+     uint64_t grain = 1;
+     for (int a = 0; a < graph->actor_count; a++) {
+         const sdf_actor_t* actor = &graph->actors[a];
+         if (iteration == 0 && actor->wcet == 0) {
+             LOG_ERROR("Graph '%s': actor '%s' needs a WCET to derive the period", graph->name, actor->name);
+             return -1;
+         }
+         demand += (uint64_t)actor->repetitions * actor->wcet;
+         grain = lcm64(grain, actor->repetitions);
+     }
+     for (int e = 0; e < graph->edge_count && grain != 0; e++) {
+         const sdf_edge_t* edge = &graph->edges[e];
+         grain = lcm64(grain, (uint64_t)graph->actors[edge->src].repetitions * edge->produce);
+     }
+     if (grain == 0) {
+         LOG_ERROR("Graph '%s': rates too large for a tick schedule", graph->name);
+         return -1;
+     }
+
+     uint64_t period = (iteration > 0) ? iteration : demand;
+     period = (period == 0) ? grain : (period + grain - 1) / grain * grain;
+     if (period > UINT32_MAX / 4) {
+         LOG_ERROR("Graph '%s': iteration period out of range", graph->name);
+         return -1;
+     }
+     if (iteration > 0 && period != iteration) {
+         LOG_WARNING("Graph '%s': iteration period rounded up from %u to %u ticks",
+                     graph->name, iteration, (uint32_t)period);
+     }
+     if (demand > period) {
+         LOG_ERROR("Graph '%s' needs %u ticks of work per iteration, more than its period %u",
+                   graph->name, (uint32_t)demand, (uint32_t)period);
+         return -1;
+     }
+
+     graph->iteration = (uint32_t)period;
+     for (int a = 0; a < graph->actor_count; a++) {
+         graph->actors[a].period = graph->iteration / graph->actors[a].repetitions;
+     }
+
+     /* Precedence constraints s_dst - s_src >= weight */
+     for (int e = 0; e < graph->edge_count; e++) {
+         const sdf_edge_t* edge = &graph->edges[e];
+         const sdf_actor_t* src = &graph->actors[edge->src];
+         int64_t g = (int64_t)gcd64(edge->produce, edge->consume);
+         int64_t tau = graph->iteration / ((int64_t)src->repetitions * edge->produce);
+         int64_t span = g * ceil_div((int64_t)edge->consume - (int64_t)edge->delay, g) - g;
+         weight[e] = (int64_t)src->period + tau * span;
+     }
+
+     /* Longest paths; still relaxing after actor_count passes means a positive cycle */
+     for (int a = 0; a < graph->actor_count; a++) {
+         start[a] = 0;
+     }
+     for (int pass = 0; pass <= graph->actor_count; pass++) {
+         int changed = -1;
+         for (int e = 0; e < graph->edge_count; e++) {
+             const sdf_edge_t* edge = &graph->edges[e];
+             if (start[edge->src] + weight[e] > start[edge->dst]) {
+                 start[edge->dst] = start[edge->src] + weight[e];
+                 changed = edge->dst;
+             }
+         }
+         if (changed < 0) {
+             break;
+         }
+         if (pass == graph->actor_count) {
+             LOG_ERROR("Graph '%s': a cycle through '%s' holds too few initial tokens",
+                       graph->name, graph->actors[changed].name);
+             return -1;
+         }
+     }
+
+     int64_t earliest = start[0];
+     for (int a = 1; a < graph->actor_count; a++) {
+         if (start[a] < earliest) {
+             earliest = start[a];
+         }
+     }
+     for (int a = 0; a < graph->actor_count; a++) {
+         if (start[a] - earliest > UINT32_MAX / 4) {
+             LOG_ERROR("Graph '%s': start of actor '%s' out of range", graph->name, graph->actors[a].name);
+             return -1;
+         }
+         graph->actors[a].start = (uint32_t)(start[a] - earliest);
+     }
+
+     for (int e = 0; e < graph->edge_count; e++) {
+         graph->edges[e].capacity = sdf_edge_capacity(graph, &graph->edges[e]);
+     }
+
+     graph->compiled = 1;
+
+     LOG_INFO("Compiled dataflow graph '%s' (iteration=%u ticks, load=%u/%u)",
+              graph->name, graph->iteration, (uint32_t)demand, graph->iteration);
+     for (int a = 0; a < graph->actor_count; a++) {
+         const sdf_actor_t* actor = &graph->actors[a];
+         LOG_DEBUG("  actor '%s': %u firings, period=%u, start=%u",
+                   actor->name, actor->repetitions, actor->period, actor->start);
+     }
+     for (int e = 0; e < graph->edge_count; e++) {
+         const sdf_edge_t* edge = &graph->edges[e];
+         LOG_DEBUG("  edge %s -> %s: capacity=%u tokens",
+                   graph->actors[edge->src].name, graph->actors[edge->dst].name, edge->capacity);
+     }
+
+     return 0;
+ }
+
+ /**
+  * Create the actor tasks and edge queues of a compiled graph
+  */
+ int sdf_start(sdf_graph_t* graph) {
+     char name[MAX_TASK_NAME_LEN + 4];    /* Queue names are cut to MAX_TASK_NAME_LEN */
+
+     if (graph == NULL || !graph_valid(graph)) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     if (!graph->compiled || graph->started) {
+         LOG_ERROR("Graph '%s' is not compiled or already running", graph->name);
+         return -1;
+     }
+
+     /* Queues, holding their initial tokens */
+     for (int e = 0; e < graph->edge_count; e++) {
+         sdf_edge_t* edge = &graph->edges[e];
+
+         snprintf(name, sizeof(name), "%s.%d", graph->name, e);
+         edge->queue = queue_create(name, edge->token_size, edge->capacity);
+         if (edge->queue == NULL) {
+             LOG_ERROR("Failed to create queue for edge %d of graph '%s'", e, graph->name);
+             sdf_teardown(graph);
+             return -1;
+         }
+
+         if (edge->delay > 0) {
+             uint8_t* zero = (uint8_t*)heap_alloc_for(NULL, edge->token_size);
+             if (zero == NULL) {
+                 LOG_ERROR("Failed to allocate initial token of graph '%s'", graph->name);
+                 sdf_teardown(graph);
+                 return -1;
+             }
+             memset(zero, 0, edge->token_size);
+             for (uint32_t k = 0; k < edge->delay; k++) {
+                 queue_send(edge->queue, zero, 0);
+             }
+             heap_free(zero);
+         }
+     }
+
+     /* The first iteration starts on the next multiple of the iteration period */
+     uint32_t now = time_get_ticks();
+     uint32_t origin = (now / graph->iteration + 1) * graph->iteration;
+
+     for (int a = 0; a < graph->actor_count; a++) {
+         sdf_actor_t* actor = &graph->actors[a];
+         size_t scratch = 0;
+
+         for (int e = 0; e < graph->edge_count; e++) {
+             const sdf_edge_t* edge = &graph->edges[e];
+             if (edge->dst == a) {
+                 scratch += edge->consume * edge->token_size;
+             }
+             if (edge->src == a) {
+                 scratch += edge->produce * edge->token_size;
+             }
+         }
+
+         actor->scratch = heap_alloc_for(NULL, (scratch > 0) ? scratch : 1);
+         if (actor->scratch == NULL) {
+             LOG_ERROR("Failed to allocate ports of actor '%s'", actor->name);
+             sdf_teardown(graph);
+             return -1;
+         }
+         actor->first_release = origin + actor->start;
+
+         actor->task = task_create(actor->name, actor->priority, sdf_actor_task, actor, DEFAULT_STACK_SIZE);
+         if (actor->task == NULL) {
+             LOG_ERROR("Failed to create task of actor '%s'", actor->name);
+             sdf_teardown(graph);
+             return -1;
+         }
+
+         if ((actor->wcet > 0 && task_set_wcet(actor->task, actor->wcet) != 0) ||
+             task_set_offset(actor->task, actor->start % actor->period) != 0 ||
+             task_set_periodic(actor->task, actor->period, actor->period) != 0) {
+             LOG_ERROR("Failed to configure task of actor '%s'", actor->name);
+             sdf_teardown(graph);
+             return -1;
+         }
+     }
+
+     graph->started = 1;
+
+     LOG_INFO("Started dataflow graph '%s' at tick %u", graph->name, origin);
+     return 0;
+ }
@@ -0,0 +1,183 @@
+/**
+ * @file sysconf.c
+ * @brief Instantiation of static system configuration tables
+ */
+
+ #include "../../include/kernel/sysconf.h"
+ #include "../../include/kernel/task.h"
+ #include "../../include/kernel/ipc.h"
+ #include "../../include/kernel/chain.h"
+ #include "../../include/kernel/let.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+ 
+ /**
+  * Create the IPC objects of a configuration
+  */
+ static int sysconf_apply_ipc(const sysconf_t* cfg) {
+     for (uint32_t i = 0; i < cfg->semaphore_count; i++) {
+         const sysconf_semaphore_t* s = &cfg->semaphores[i];
+         *s->handle = semaphore_create(s->name, s->initial_count, s->max_count);
+         if (*s->handle == NULL) {
+             LOG_ERROR("Failed to create configured semaphore '%s'", s->name);
+             return -1;
+         }
+     }
+     
+     for (uint32_t i = 0; i < cfg->mutex_count; i++) {
+         const sysconf_mutex_t* m = &cfg->mutexes[i];
+         *m->handle = mutex_create(m->name);
+         if (*m->handle == NULL) {
+             LOG_ERROR("Failed to create configured mutex '%s'", m->name);
+             return -1;
+         }
+     }
+     
+     for (uint32_t i = 0; i < cfg->queue_count; i++) {
+         const sysconf_queue_t* q = &cfg->queues[i];
+         *q->handle = queue_create_static(q->name, q->msg_size, q->capacity, q->buffer);
+         if (*q->handle == NULL) {
+             LOG_ERROR("Failed to create configured queue '%s'", q->name);
+             return -1;
+         }
+     }
+     
+     for (uint32_t i = 0; i < cfg->event_group_count; i++) {
+         const sysconf_event_group_t* e = &cfg->event_groups[i];
+         *e->handle = event_group_create(e->name);
+         if (*e->handle == NULL) {
+             LOG_ERROR("Failed to create configured event group '%s'", e->name);
+             return -1;
+         }
+     }
+     
+     return 0;
+ }
+ 
+ /**
+  * Create the tasks of a configuration
+  */
+ static int sysconf_apply_tasks(const sysconf_t* cfg) {
+     for (uint32_t i = 0; i < cfg->task_count; i++) {
+         const sysconf_task_t* t = &cfg->tasks[i];
+         task_t* task;
+         
+         if (t->type == TASK_TYPE_BASIC) {
+             task = task_create_basic(t->name, t->priority, t->entry, t->arg);
+         } else {
+             task = task_create_static(t->name, t->priority, t->entry, t->arg,
+                                       t->tcb, t->stack, t->stack_size);
+         }
+         
+         if (task == NULL) {
+             LOG_ERROR("Failed to create configured task '%s'", t->name);
+             return -1;
+         }
+         
+         if (t->wcet > 0 && task_set_wcet(task, t->wcet) != 0) {
+             LOG_ERROR("Failed to set WCET of configured task '%s'", t->name);
+             return -1;
+         }
+         
+         if (t->offset > 0 && task_set_offset(task, t->offset) != 0) {
+             LOG_ERROR("Failed to set release offset of configured task '%s'", t->name);
+             return -1;
+         }
+         
+         if (t->period > 0 && task_set_periodic(task, t->period, t->deadline) != 0) {
+             LOG_ERROR("Failed to configure periodic task '%s'", t->name);
+             return -1;
+         }
+         
+         *t->handle = task;
+     }
+     
+     return 0;
+ }
+ 
+ /**
+  * Create the cause-effect chains of a configuration
+  */
+ static int sysconf_apply_chains(const sysconf_t* cfg) {
+     for (uint32_t i = 0; i < cfg->chain_count; i++) {
+         const sysconf_chain_t* c = &cfg->chains[i];
+         chain_t* chain = chain_create(c->name, c->deadline_us);
+         
+         if (chain == NULL) {
+             LOG_ERROR("Failed to create configured chain '%s'", c->name);
+             return -1;
+         }
+         
+         for (uint32_t s = 0; s < c->stage_count; s++) {
+             queue_t* input = (s > 0) ? *c->links[s - 1] : NULL;
+             if (chain_add_stage(chain, *c->tasks[s], input) != 0) {
+                 LOG_ERROR("Failed to add stage %u of configured chain '%s'", s, c->name);
+                 return -1;
+             }
+         }
+         
+         *c->handle = chain;
+     }
+     
+     return 0;
+ }
+ 
+ /**
+  * Create the LET variables of a configuration and bind their tasks
+  */
+ static int sysconf_apply_lets(const sysconf_t* cfg) {
+     for (uint32_t i = 0; i < cfg->let_count; i++) {
+         const sysconf_let_t* l = &cfg->lets[i];
+         let_var_t* var = let_var_create(l->name, l->size, NULL);
+         
+         if (var == NULL) {
+             LOG_ERROR("Failed to create configured LET variable '%s'", l->name);
+             return -1;
+         }
+         
+         if (l->writer != NULL && let_bind_output(*l->writer, var) != 0) {
+             LOG_ERROR("Failed to bind the writer of configured LET variable '%s'", l->name);
+             return -1;
+         }
+         
+         for (uint32_t r = 0; r < l->reader_count; r++) {
+             if (let_bind_input(*l->readers[r], var) != 0) {
+                 LOG_ERROR("Failed to bind reader %u of configured LET variable '%s'", r, l->name);
+                 return -1;
+             }
+         }
+         
+         *l->handle = var;
+     }
+     
+     return 0;
+ }
+ 
+ /**
+  * Instantiate all objects of a system configuration
+  */
+ int sysconf_apply(const sysconf_t* cfg) {
+     if (cfg == NULL) {
+         LOG_ERROR("NULL configuration pointer");
+         return -1;
+     }
+     
+     LOG_INFO("Applying system configuration (%u tasks, %u IPC objects)",
+              cfg->task_count,
+              cfg->semaphore_count + cfg->mutex_count +
+              cfg->queue_count + cfg->event_group_count);
+     
+     if (sysconf_apply_ipc(cfg) != 0) {
+         return -1;
+     }
+     
+     if (sysconf_apply_tasks(cfg) != 0) {
+         return -1;
+     }
+     
+     if (sysconf_apply_lets(cfg) != 0) {
+         return -1;
+     }
+     
+     return sysconf_apply_chains(cfg);
+ }
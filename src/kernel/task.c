@@ -8,12 +8,16 @@
  #include "../../include/kernel/task.h"
  #include "../../include/kernel/scheduler.h"
  #include "../../include/kernel/context.h"
+ #include "../../include/kernel/heap.h"
+ #include "../../include/kernel/arena.h"
  #include "../../include/kernel/time.h"
+ #include "../../include/kernel/rta.h"
+ #include "../../include/kernel/let.h"
  #include "../../include/utils/logger.h"
  #include "../../include/config.h"
  
- /* Array of all tasks in the system */
- static task_t* task_list[MAX_TASKS];
+ /* Array of all tasks in the system (shared with scheduler.c) */
+ task_t* task_list[MAX_TASKS];
  static uint32_t task_count = 0;
  
  /* Current running task */
@@ -22,6 +26,28 @@
  /* Idle task */
  static task_t* idle_task = NULL;
  
+ /**
+  * Allocate a kernel-owned TCB
+  */
+ static task_t* tcb_alloc(void) {
+ #if ENABLE_KERNEL_ARENA
+     return arena_tcb_alloc();
+ #else
+     return (task_t*) heap_alloc_for(NULL, sizeof(task_t));
+ #endif
+ }
+ 
+ /**
+  * Release a kernel-owned TCB
+  */
+ static void tcb_free(task_t* task) {
+ #if ENABLE_KERNEL_ARENA
+     arena_tcb_free(task);
+ #else
+     heap_free(task);
+ #endif
+ }
+ 
  /**
   * Idle task function - runs when no other tasks are ready
   */
@@ -33,6 +59,74 @@
      }
  }
  
+ /**
+  * Check that a priority keeps every basic task above every extended task
+  * A running basic job is a nested call on the current stack, so only a
+  * higher-priority basic task can preempt it; an extended task above it
+  * would have to wait for the job to return.
+  */
+ static int task_check_priority_band(const task_t* task, task_type_t type, uint8_t priority) {
+     for (int i = 0; i < MAX_TASKS; i++) {
+         const task_t* other = task_list[i];
+         if (other == NULL || other == task || other->type == type) {
+             continue;
+         }
+         
+         if (type == TASK_TYPE_BASIC && priority >= other->original_priority) {
+             LOG_ERROR("Basic task priority %u is not above extended task '%s' (priority %u)",
+                       priority, other->name, other->original_priority);
+             return -1;
+         }
+         if (type == TASK_TYPE_EXTENDED && priority <= other->original_priority) {
+             LOG_ERROR("Extended task priority %u is not below basic task '%s' (priority %u)",
+                       priority, other->name, other->original_priority);
+             return -1;
+         }
+     }
+     
+     return 0;
+ }
+ 
+ /**
+  * Bring the response-time analysis up to date after a timing change
+  */
+ static void task_analyze(task_t* task) {
+ #if ENABLE_RTA
+     rta_set_t* set = rta_system_set();
+     int was_schedulable = rta_is_schedulable(set);
+     
+     if (rta_task_update(task) != 0) {
+         LOG_ERROR("Failed to analyze task '%s'", task->name);
+         return;
+     }
+     
+     if (was_schedulable && !rta_is_schedulable(set)) {
+         LOG_WARNING("Periodic tasks no longer schedulable after change to '%s'", task->name);
+     }
+ #else
+     (void)task;
+ #endif
+ }
+ 
+ /**
+  * Set the next release to the first grid point (offset + k * period) after now
+  */
+ static void task_schedule_release(task_t* task) {
+     uint32_t now = time_get_ticks();
+     uint32_t next = task->offset;
+     
+     if (now >= task->offset) {
+         next += ((now - task->offset) / task->period + 1) * task->period;
+     }
+     
+     task->next_release = next;
+     task->absolute_deadline = next + task->deadline;
+     
+ #if ENABLE_LET
+     let_task_update(task);
+ #endif
+ }
+ 
  /**
   * Initialize the task management subsystem
   */
@@ -47,6 +141,14 @@
      task_count = 0;
      current_task = NULL;
      
+ #if ENABLE_RTA
+     rta_system_init();
+ #endif
+     
+ #if ENABLE_LET
+     let_init();
+ #endif
+     
      /* Create idle task */
      idle_task = task_create("idle", MAX_PRIORITY_LEVELS - 1, idle_task_func, NULL, DEFAULT_STACK_SIZE / 2);
      if (idle_task == NULL) {
@@ -58,6 +160,89 @@
      return 0;
  }
  
+ /**
+  * Initialize a task in the given storage and register it
+  */
+ static int task_setup(task_t* task, const char* name, uint8_t priority,
+                       void (*task_func)(void*), void* task_arg,
+                       uint32_t* stack, uint32_t stack_size, uint8_t static_alloc) {
+     /* Initialize task structure */
+     strncpy(task->name, name, MAX_TASK_NAME_LEN - 1);
+     task->name[MAX_TASK_NAME_LEN - 1] = '\0';
+     task->state = TASK_STATE_READY;
+     task->type = TASK_TYPE_EXTENDED;
+     task->pending_activations = 0;
+     task->priority = priority;
+     task->original_priority = priority;
+     task->time_slice = DEFAULT_TIME_SLICE;
+     task->time_slice_count = DEFAULT_TIME_SLICE;
+     task->task_func = task_func;
+     task->task_arg = task_arg;
+     task->delay_until = 0;
+     task->block_reason = BLOCK_REASON_NONE;
+     task->block_object = NULL;
+     task->period = 0;
+     task->deadline = 0;
+     task->wcet = 0;
+     task->offset = 0;
+     task->next_release = 0;
+     task->absolute_deadline = 0;
+     task->chain_stamp = 0;
+     task->next = NULL;
+     task->prev = NULL;
+     task->sched_class = NULL;
+     task->rq_next = NULL;
+     task->rq_prev = NULL;
+     task->rq_key = 0;
+     task->on_rq = 0;
+     task->heap_used = 0;
+     task->heap_peak = 0;
+     task->heap_quota = 0;
+     task->static_alloc = static_alloc;
+     
+     /* Initialize task context */
+     if (context_init_task(task, stack, stack_size, task_func, task_arg) != 0) {
+         LOG_ERROR("Failed to initialize task context");
+         return -1;
+     }
+     
+     /* Initialize task statistics */
+     task->stats.total_runtime = 0;
+     task->stats.last_start_time = 0;
+     task->stats.num_activations = 0;
+     task->stats.deadline_misses = 0;
+     task->stats.max_execution_time = 0;
+     
+     /* Add task to array */
+     int slot = -1;
+     for (int i = 0; i < MAX_TASKS; i++) {
+         if (task_list[i] == NULL) {
+             task_list[i] = task;
+             task_count++;
+             task->id = (uint8_t)i;
+             slot = i;
+             break;
+         }
+     }
+     if (slot < 0) {
+         LOG_ERROR("No free task slots");
+         return -1;
+     }
+     
+     /* Add task to scheduler */
+     if (scheduler_add_task(task) != 0) {
+         LOG_ERROR("Failed to add task to scheduler");
+         task_list[slot] = NULL;
+         task_count--;
+         return -1;
+     }
+     
+     LOG_INFO("Created task '%s', priority=%u, stack=%u bytes", 
+              task->name, task->priority, stack_size);
+     
+     return 0;
+ }
+ 
  /**
   * Create a new task
   */
@@ -75,79 +260,176 @@
          return NULL;
      }
      
-     /* Allocate task structure */
-     task = (task_t*) malloc(sizeof(task_t));
+     /* Extended tasks stay below every basic task */
+     if (task_check_priority_band(NULL, TASK_TYPE_EXTENDED, priority) != 0) {
+         return NULL;
+     }
+     
+     /* Allocate task structure (kernel-owned) */
+     task = tcb_alloc();
      if (task == NULL) {
          LOG_ERROR("Failed to allocate task structure");
          return NULL;
      }
      
-     /* Allocate stack */
-     stack = (uint32_t*) malloc(stack_size);
+     /* Allocate stack (kernel-owned) */
+     stack = (uint32_t*) heap_alloc_for(NULL, stack_size);
      if (stack == NULL) {
          LOG_ERROR("Failed to allocate task stack");
-         free(task);
+         tcb_free(task);
          return NULL;
      }
      
-     /* Initialize task structure */
+     if (task_setup(task, name, priority, task_func, task_arg, stack, stack_size, 0) != 0) {
+         heap_free(stack);
+         tcb_free(task);
+         return NULL;
+     }
+     
+     return task;
+ }
+ 
+ /**
+  * Create a task in caller-provided storage
+  */
+ task_t* task_create_static(const char* name, uint8_t priority,
+                           void (*task_func)(void*), void* task_arg,
+                           task_t* tcb, uint32_t* stack, uint32_t stack_size) {
+     /* Check parameters */
+     if (name == NULL || task_func == NULL || tcb == NULL || stack == NULL ||
+         priority >= MAX_PRIORITY_LEVELS || 
+         task_count >= MAX_TASKS) {
+         LOG_ERROR("Invalid task parameters");
+         return NULL;
+     }
+     
+     /* Extended tasks stay below every basic task */
+     if (task_check_priority_band(NULL, TASK_TYPE_EXTENDED, priority) != 0) {
+         return NULL;
+     }
+     
+     if (task_setup(tcb, name, priority, task_func, task_arg, stack, stack_size, 1) != 0) {
+         return NULL;
+     }
+     
+     return tcb;
+ }
+ 
+ /**
+  * Create a basic (run-to-completion) task
+  */
+ task_t* task_create_basic(const char* name, uint8_t priority,
+                           void (*task_func)(void*), void* task_arg) {
+     task_t* task = NULL;
+     
+     /* Check parameters */
+     if (name == NULL || task_func == NULL || 
+         priority >= MAX_PRIORITY_LEVELS || 
+         task_count >= MAX_TASKS) {
+         LOG_ERROR("Invalid task parameters");
+         return NULL;
+     }
+     
+     /* Basic tasks stay above every extended task */
+     if (task_check_priority_band(NULL, TASK_TYPE_BASIC, priority) != 0) {
+         return NULL;
+     }
+     
+     /* Allocate task structure (kernel-owned) */
+     task = tcb_alloc();
+     if (task == NULL) {
+         LOG_ERROR("Failed to allocate task structure");
+         return NULL;
+     }
+     
+     /* Initialize task structure; basic tasks start suspended */
+     memset(task, 0, sizeof(task_t));
      strncpy(task->name, name, MAX_TASK_NAME_LEN - 1);
      task->name[MAX_TASK_NAME_LEN - 1] = '\0';
-     task->state = TASK_STATE_READY;
+     task->state = TASK_STATE_SUSPENDED;
+     task->type = TASK_TYPE_BASIC;
      task->priority = priority;
      task->original_priority = priority;
      task->time_slice = DEFAULT_TIME_SLICE;
      task->time_slice_count = DEFAULT_TIME_SLICE;
      task->task_func = task_func;
      task->task_arg = task_arg;
-     task->delay_until = 0;
      task->block_reason = BLOCK_REASON_NONE;
-     task->block_object = NULL;
-     task->period = 0;
-     task->deadline = 0;
-     task->next_release = 0;
-     task->absolute_deadline = 0;
-     task->next = NULL;
-     task->prev = NULL;
      
-     /* Initialize task context */
-     if (context_init_task(task, stack, stack_size, task_func, task_arg) != 0) {
-         LOG_ERROR("Failed to initialize task context");
-         free(stack);
-         free(task);
-         return NULL;
-     }
-     
-     /* Initialize task statistics */
-     task->stats.total_runtime = 0;
-     task->stats.last_start_time = 0;
-     task->stats.num_activations = 0;
-     task->stats.deadline_misses = 0;
-     task->stats.max_execution_time = 0;
+     /* No context or stack: each job is a nested call on the stack of
+        whichever task or tick dispatched it */
+     task->context.stack_ptr = NULL;
+     task->context.stack_base = 0;
+     task->context.stack_size = 0;
      
      /* Add task to array */
+     int slot = -1;
      for (int i = 0; i < MAX_TASKS; i++) {
          if (task_list[i] == NULL) {
              task_list[i] = task;
              task_count++;
+             task->id = (uint8_t)i;
+             slot = i;
              break;
          }
      }
+     if (slot < 0) {
+         LOG_ERROR("No free task slots");
+         tcb_free(task);
+         return NULL;
+     }
      
      /* Add task to scheduler */
      if (scheduler_add_task(task) != 0) {
          LOG_ERROR("Failed to add task to scheduler");
-         free(stack);
-         free(task);
+         task_list[slot] = NULL;
+         task_count--;
+         tcb_free(task);
          return NULL;
      }
      
-     LOG_INFO("Created task '%s', priority=%u, stack=%u bytes", 
-              task->name, task->priority, stack_size);
+     LOG_INFO("Created basic task '%s', priority=%u", task->name, task->priority);
      
      return task;
  }
  
+ /**
+  * Activate a basic task
+  */
+ int task_activate(task_t* task) {
+     int result = 0;
+     
+     if (task == NULL) {
+         LOG_ERROR("NULL task pointer");
+         return -1;
+     }
+     
+     if (task->type != TASK_TYPE_BASIC) {
+         LOG_ERROR("Task '%s' is not a basic task", task->name);
+         return -1;
+     }
+     
+     uint32_t prev_state = context_enter_critical();
+     
+     if (task->state == TASK_STATE_SUSPENDED) {
+         /* Idle basic task: make it ready */
+         result = scheduler_update_task_state(task, TASK_STATE_READY);
+     } else if (task->pending_activations < BASIC_TASK_MAX_ACTIVATIONS) {
+         /* Already ready or running: run again after completion */
+         task->pending_activations++;
+     } else {
+         result = -1;
+     }
+     
+     context_exit_critical(prev_state);
+     
+     if (result != 0) {
+         LOG_WARNING("Failed to activate task '%s'", task->name);
+     }
+     
+     return result;
+ }
+ 
  /**
   * Delete a task
   */
@@ -175,6 +457,16 @@
          return -1;
      }
      
+     /* Lower-priority periodic tasks lose its interference */
+ #if ENABLE_RTA
+     rta_task_remove(task);
+ #endif
+     
+     /* Its LET copies go with it */
+ #if ENABLE_LET
+     let_task_remove(task);
+ #endif
+     
      /* Remove from task list */
      for (int i = 0; i < MAX_TASKS; i++) {
          if (task_list[i] == task) {
@@ -186,13 +478,18 @@
      
      LOG_INFO("Deleted task '%s'", task->name);
      
-     /* Free stack */
-     if (task->context.stack_ptr != NULL) {
-         free((void*)task->context.stack_base);
+     /* Hand any buffers the task still owns to the kernel */
+     heap_release_task(task);
+     
+     /* Free stack (basic tasks have none) */
+     if (task->context.stack_ptr != NULL && !task->static_alloc) {
+         heap_free(task->context.stack_ptr);
      }
      
-     /* Free task structure */
-     free(task);
+     /* Free task structure (static tasks keep their storage) */
+     if (!task->static_alloc) {
+         tcb_free(task);
+     }
      
      return 0;
  }
@@ -206,20 +503,43 @@
          return -1;
      }
      
+     /* Basic tasks must stay above every extended task */
+     if (task_check_priority_band(task, task->type, priority) != 0) {
+         return -1;
+     }
+     
      /* Update priority */
      task->priority = priority;
      task->original_priority = priority;
      
      /* Notify scheduler of priority change */
-     if (scheduler_update_task_state(task, task->state) != 0) {
+     if (scheduler_requeue_task(task) != 0) {
          LOG_ERROR("Failed to update scheduler for priority change");
          return -1;
      }
      
+     task_analyze(task);
+     
      LOG_INFO("Set task '%s' priority to %u", task->name, priority);
      return 0;
  }
  
+ /**
+  * Temporarily change the running priority (priority inheritance)
+  * Called with interrupts masked: no analysis, no logging, and the
+  * configured priority stays as it is. Only extended tasks block, so an
+  * owner is never boosted above the extended band.
+  */
+ int task_boost_priority(task_t* task, uint8_t priority) {
+     if (task == NULL || priority >= MAX_PRIORITY_LEVELS) {
+         return -1;
+     }
+     
+     task->priority = priority;
+     
+     return scheduler_requeue_task(task);
+ }
+ 
  /**
   * Get task priority
   */
@@ -247,9 +567,6 @@
          return -1;
      }
      
-     /* Update task state */
-     task->state = TASK_STATE_SUSPENDED;
-     
      /* Notify scheduler of state change */
      if (scheduler_update_task_state(task, TASK_STATE_SUSPENDED) != 0) {
          LOG_ERROR("Failed to update scheduler for suspend");
@@ -280,9 +597,6 @@
          return 0;
      }
      
-     /* Update task state */
-     task->state = TASK_STATE_READY;
-     
      /* Notify scheduler of state change */
      if (scheduler_update_task_state(task, TASK_STATE_READY) != 0) {
          LOG_ERROR("Failed to update scheduler for resume");
@@ -392,19 +706,64 @@
          return -1;
      }
      
+     if (task->offset >= period) {
+         LOG_ERROR("Offset %u of task '%s' is not below period %u", task->offset, task->name, period);
+         return -1;
+     }
+     
      /* Set periodic parameters */
      task->period = period;
      task->deadline = (deadline > 0) ? deadline : period;
+     task_schedule_release(task);
+     
+     /* Periodic tasks may belong to a different scheduling class */
+     if (scheduler_requeue_task(task) != 0) {
+         LOG_ERROR("Failed to update scheduler for periodic task");
+         return -1;
+     }
      
-     /* Initialize next release time */
-     task->next_release = time_get_ticks() + period;
-     task->absolute_deadline = task->next_release + task->deadline;
+     task_analyze(task);
      
      LOG_INFO("Set task '%s' as periodic (period=%u, deadline=%u)",
               task->name, period, task->deadline);
      return 0;
  }
  
+ /**
+  * Set task release offset
+  */
+ int task_set_offset(task_t* task, uint32_t offset) {
+     if (task == NULL || (task->period > 0 && offset >= task->period)) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+     
+     task->offset = offset;
+     if (task->period > 0) {
+         task_schedule_release(task);
+         if (task->on_rq) {
+             scheduler_requeue_task(task);
+         }
+     }
+     
+     return 0;
+ }
+ 
+ /**
+  * Set task worst-case execution time
+  */
+ int task_set_wcet(task_t* task, uint32_t wcet) {
+     if (task == NULL) {
+         LOG_ERROR("NULL task pointer");
+         return -1;
+     }
+     
+     task->wcet = wcet;
+     task_analyze(task);
+     
+     return 0;
+ }
+ 
  /**
   * Get task state as string
   */
@@ -0,0 +1,448 @@
+/**
+ * @file timetag.c
+ * @brief Implementation of time-tagged command tables
+ *
+ * Messages live in fixed slots; the heap orders slot indices by release
+ * tick and each slot records its heap position, so cancellation is a
+ * direct O(log n) removal. Entry IDs combine the slot with a per-slot
+ * generation, so a stale ID never cancels a later entry in that slot.
+ * Ticks are compared by signed difference to survive counter wrap.
+ */
+
+ #include <string.h>
+ #include "../../include/kernel/timetag.h"
+ #include "../../include/kernel/context.h"
+ #include "../../include/kernel/heap.h"
+ #include "../../include/kernel/time.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ /* Time-tag table storage */
+ static timetag_table_t tables[MAX_TIMETAG_TABLES];
+ static uint8_t table_used[MAX_TIMETAG_TABLES];
+
+ /* Tick a is earlier than tick b */
+ #define TICK_BEFORE(a, b)  ((int32_t)((a) - (b)) < 0)
+
+ /**
+  * Swap two heap nodes and keep slot positions in step
+  */
+ static void heap_swap(timetag_table_t* t, uint16_t i, uint16_t j) {
+     timetag_node_t tmp = t->heap[i];
+     t->heap[i] = t->heap[j];
+     t->heap[j] = tmp;
+     t->heap_pos[t->heap[i].slot] = i;
+     t->heap_pos[t->heap[j].slot] = j;
+ }
+
+ /**
+  * Move a node towards the root until its parent is earlier
+  */
+ static void sift_up(timetag_table_t* t, uint16_t i) {
+     while (i > 0) {
+         uint16_t parent = (uint16_t)((i - 1) / 2);
+         if (!TICK_BEFORE(t->heap[i].tick, t->heap[parent].tick)) {
+             break;
+         }
+         heap_swap(t, i, parent);
+         i = parent;
+     }
+ }
+
+ /**
+  * Move a node towards the leaves until its children are later
+  */
+ static void sift_down(timetag_table_t* t, uint16_t i) {
+     for (;;) {
+         uint32_t left = 2u * i + 1;
+         uint32_t right = left + 1;
+         uint16_t earliest = i;
+
+         if (left < t->count && TICK_BEFORE(t->heap[left].tick, t->heap[earliest].tick)) {
+             earliest = (uint16_t)left;
+         }
+         if (right < t->count && TICK_BEFORE(t->heap[right].tick, t->heap[earliest].tick)) {
+             earliest = (uint16_t)right;
+         }
+         if (earliest == i) {
+             break;
+         }
+         heap_swap(t, i, earliest);
+         i = earliest;
+     }
+ }
+
+ /**
+  * Remove the node at a heap index and free its slot
+  */
+ static void heap_remove(timetag_table_t* t, uint16_t i) {
+     uint16_t slot = t->heap[i].slot;
+     uint16_t last = (uint16_t)(t->count - 1);
+
+     if (i != last) {
+         heap_swap(t, i, last);
+     }
+     t->count--;
+
+     if (i < t->count) {
+         sift_down(t, i);
+         sift_up(t, i);
+     }
+
+     /* Retire the slot's current ID */
+     t->generation[slot] = (uint16_t)(t->generation[slot] + 1);
+     if (t->generation[slot] == 0) {
+         t->generation[slot] = 1;
+     }
+     t->free_slots[t->free_count++] = slot;
+ }
+
+ /**
+  * Take a free slot and copy a message into it
+  */
+ static uint16_t slot_fill(timetag_table_t* t, const void* msg) {
+     uint16_t slot = t->free_slots[--t->free_count];
+     memcpy(t->messages + (size_t)slot * t->msg_size, msg, t->msg_size);
+     return slot;
+ }
+
+ /**
+  * Entry ID of a slot
+  */
+ static uint32_t slot_id(const timetag_table_t* t, uint16_t slot) {
+     return ((uint32_t)t->generation[slot] << 16) | slot;
+ }
+
+ /**
+  * Arm the timer for the earliest entry (called in a critical section)
+  */
+ static void timetag_rearm(timetag_table_t* t) {
+     if (t->count == 0) {
+         if (t->armed) {
+             timer_stop(t->timer);
+             t->armed = 0;
+         }
+         return;
+     }
+
+     uint32_t due = t->heap[0].tick;
+     if (t->armed && t->armed_tick == due) {
+         return;
+     }
+
+     /* Overdue entries go out on the next tick */
+     uint32_t now = time_get_ticks();
+     uint32_t delay = TICK_BEFORE(now, due) ? due - now : 1;
+
+     t->armed_tick = due;
+     t->armed = 1;
+     if (timer_set_period(t->timer, time_ticks_to_ms(delay)) != 0 ||
+         timer_start(t->timer) != 0) {
+         LOG_ERROR("Failed to arm time-tag timer for '%s'", t->name);
+         t->armed = 0;
+     }
+ }
+
+ /**
+  * Timer callback: release every entry that is due
+  */
+ static void timetag_timer_fn(void* arg) {
+     timetag_table_t* t = (timetag_table_t*)arg;
+     uint32_t prev_state = context_enter_critical();
+     uint32_t now = time_get_ticks();
+
+     t->armed = 0;
+
+     while (t->count > 0 && !TICK_BEFORE(now, t->heap[0].tick)) {
+         uint16_t slot = t->heap[0].slot;
+         uint32_t lateness = now - t->heap[0].tick;
+
+         /* Target full: keep the entry at the head and retry next tick */
+         if (queue_send(t->target, t->messages + (size_t)slot * t->msg_size, 0) != 0) {
+             t->stats.deferred++;
+             t->armed_tick = now + 1;
+             t->armed = 1;
+             timer_set_period(t->timer, time_ticks_to_ms(1));
+             timer_start(t->timer);
+             context_exit_critical(prev_state);
+             return;
+         }
+
+         if (lateness > t->stats.max_lateness) {
+             t->stats.max_lateness = lateness;
+         }
+         t->stats.released++;
+         heap_remove(t, 0);
+     }
+
+     timetag_rearm(t);
+
+     context_exit_critical(prev_state);
+ }
+
+ /**
+  * Create a time-tag table releasing into a queue
+  */
+ timetag_table_t* timetag_create(const char* name, queue_t* target, uint16_t capacity) {
+     timetag_table_t* t = NULL;
+     int index = -1;
+
+     /* Validate parameters */
+     if (name == NULL || target == NULL || capacity == 0 || capacity == UINT16_MAX) {
+         LOG_ERROR("Invalid time-tag table parameters");
+         return NULL;
+     }
+
+     /* Find free slot */
+     for (int i = 0; i < MAX_TIMETAG_TABLES; i++) {
+         if (!table_used[i]) {
+             index = i;
+             break;
+         }
+     }
+
+     if (index == -1) {
+         LOG_ERROR("No free time-tag table slots");
+         return NULL;
+     }
+
+     /* Initialize table */
+     t = &tables[index];
+     memset(t, 0, sizeof(timetag_table_t));
+     t->target = target;
+     t->msg_size = target->msg_size;
+     t->capacity = capacity;
+     strncpy(t->name, name, MAX_TASK_NAME_LEN - 1);
+     t->name[MAX_TASK_NAME_LEN - 1] = '\0';
+
+     /* Kernel-owned storage, allocated once */
+     t->heap = (timetag_node_t*)heap_alloc_for(NULL, capacity * sizeof(timetag_node_t));
+     t->heap_pos = (uint16_t*)heap_alloc_for(NULL, capacity * sizeof(uint16_t));
+     t->generation = (uint16_t*)heap_alloc_for(NULL, capacity * sizeof(uint16_t));
+     t->free_slots = (uint16_t*)heap_alloc_for(NULL, capacity * sizeof(uint16_t));
+     t->messages = (uint8_t*)heap_alloc_for(NULL, capacity * t->msg_size);
+     t->timer = timer_create(name, 1, 0, timetag_timer_fn, t);
+
+     if (t->heap == NULL || t->heap_pos == NULL || t->generation == NULL ||
+         t->free_slots == NULL || t->messages == NULL || t->timer == NULL) {
+         LOG_ERROR("Failed to allocate time-tag table '%s'", name);
+         heap_free(t->heap);
+         heap_free(t->heap_pos);
+         heap_free(t->generation);
+         heap_free(t->free_slots);
+         heap_free(t->messages);
+         if (t->timer != NULL) {
+             timer_delete(t->timer);
+         }
+         return NULL;
+     }
+
+     for (uint16_t i = 0; i < capacity; i++) {
+         t->generation[i] = 1;
+         t->free_slots[i] = (uint16_t)(capacity - 1 - i);
+     }
+     t->free_count = capacity;
+
+     /* Mark as used */
+     table_used[index] = 1;
+
+     LOG_INFO("Created time-tag table '%s' (capacity=%u, target='%s')",
+              t->name, capacity, target->name);
+
+     return t;
+ }
+
+ /**
+  * Delete a time-tag table, discarding pending entries
+  */
+ int timetag_delete(timetag_table_t* table) {
+     int index = -1;
+
+     if (table == NULL) {
+         LOG_ERROR("NULL time-tag table pointer");
+         return -1;
+     }
+
+     for (int i = 0; i < MAX_TIMETAG_TABLES; i++) {
+         if (&tables[i] == table && table_used[i]) {
+             index = i;
+             break;
+         }
+     }
+
+     if (index == -1) {
+         LOG_ERROR("Invalid time-tag table pointer");
+         return -1;
+     }
+
+     timer_stop(table->timer);
+     timer_delete(table->timer);
+
+     if (table->count > 0) {
+         LOG_WARNING("Deleting time-tag table '%s' with %u pending entries",
+                     table->name, table->count);
+     }
+
+     heap_free(table->heap);
+     heap_free(table->heap_pos);
+     heap_free(table->generation);
+     heap_free(table->free_slots);
+     heap_free(table->messages);
+
+     /* Mark as unused */
+     table_used[index] = 0;
+
+     LOG_INFO("Deleted time-tag table '%s'", table->name);
+     return 0;
+ }
+
+ /**
+  * Insert one message to be released at a tick
+  */
+ int timetag_insert(timetag_table_t* table, uint32_t tick, const void* msg, uint32_t* id) {
+     if (table == NULL || msg == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     if (table->free_count == 0) {
+         context_exit_critical(prev_state);
+         LOG_WARNING("Time-tag table '%s' full", table->name);
+         return -1;
+     }
+
+     uint16_t slot = slot_fill(table, msg);
+     uint16_t i = table->count++;
+     table->heap[i].tick = tick;
+     table->heap[i].slot = slot;
+     table->heap_pos[slot] = i;
+     sift_up(table, i);
+
+     table->stats.inserted++;
+     if (id != NULL) {
+         *id = slot_id(table, slot);
+     }
+
+     /* Only a new earliest entry moves the timer */
+     timetag_rearm(table);
+
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
+
+ /**
+  * Insert many messages at once
+  */
+ int timetag_load(timetag_table_t* table, const timetag_entry_t* entries, uint32_t count,
+                  uint32_t* ids) {
+     if (table == NULL || (entries == NULL && count > 0)) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     for (uint32_t i = 0; i < count; i++) {
+         if (entries[i].msg == NULL) {
+             LOG_ERROR("NULL message in time-tag load");
+             return -1;
+         }
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     if (count > table->free_count) {
+         context_exit_critical(prev_state);
+         LOG_WARNING("Time-tag table '%s' cannot take %u entries (%u free)",
+                     table->name, count, table->free_count);
+         return -1;
+     }
+
+     /* Append unordered, then restore the heap bottom-up in O(n) */
+     for (uint32_t i = 0; i < count; i++) {
+         uint16_t slot = slot_fill(table, entries[i].msg);
+         uint16_t pos = table->count++;
+         table->heap[pos].tick = entries[i].tick;
+         table->heap[pos].slot = slot;
+         table->heap_pos[slot] = pos;
+         if (ids != NULL) {
+             ids[i] = slot_id(table, slot);
+         }
+     }
+
+     if (table->count > 1) {
+         for (int32_t i = (int32_t)(table->count / 2) - 1; i >= 0; i--) {
+             sift_down(table, (uint16_t)i);
+         }
+     }
+
+     table->stats.inserted += count;
+     timetag_rearm(table);
+
+     context_exit_critical(prev_state);
+
+     LOG_INFO("Loaded %u entries into time-tag table '%s'", count, table->name);
+
+     return 0;
+ }
+
+ /**
+  * Cancel a pending entry
+  */
+ int timetag_cancel(timetag_table_t* table, uint32_t id) {
+     if (table == NULL) {
+         LOG_ERROR("NULL time-tag table pointer");
+         return -1;
+     }
+
+     uint16_t slot = (uint16_t)(id & 0xFFFF);
+     uint16_t generation = (uint16_t)(id >> 16);
+
+     uint32_t prev_state = context_enter_critical();
+
+     /* A free slot or a newer generation means the entry already left */
+     uint16_t pos = (slot < table->capacity) ? table->heap_pos[slot] : 0;
+     if (slot >= table->capacity || table->generation[slot] != generation ||
+         pos >= table->count || table->heap[pos].slot != slot) {
+         context_exit_critical(prev_state);
+         return -1;
+     }
+
+     heap_remove(table, pos);
+     table->stats.cancelled++;
+
+     timetag_rearm(table);
+
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
+
+ /**
+  * Get the number of pending entries
+  */
+ uint32_t timetag_get_count(timetag_table_t* table) {
+     if (table == NULL) {
+         LOG_ERROR("NULL time-tag table pointer");
+         return 0;
+     }
+
+     return table->count;
+ }
+
+ /**
+  * Get time-tag table statistics
+  */
+ int timetag_get_stats(timetag_table_t* table, timetag_stats_t* stats) {
+     if (table == NULL || stats == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+     memcpy(stats, &table->stats, sizeof(timetag_stats_t));
+     context_exit_critical(prev_state);
+
+     return 0;
+ }
@@ -0,0 +1,153 @@
+/**
+ * @file trace.c
+ * @brief Implementation of the kernel event trace
+ *
+ * Events go into one of two buffers. When the active buffer fills, the
+ * buffers swap and the full one is written, so recording never waits
+ * for a partially written batch.
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include "../../include/kernel/trace.h"
+ #include "../../include/kernel/context.h"
+ #include "../../include/drivers/time.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+ 
+ /* External task table from task.c */
+ extern task_t* task_list[MAX_TASKS];
+ 
+ volatile uint8_t trace_enabled = 0;
+ 
+ /* Double buffer */
+ static trace_event_t buffers[2][TRACE_BUFFER_EVENTS];
+ static uint32_t active = 0;
+ static uint32_t fill = 0;
+ 
+ static FILE* output = NULL;
+ static uint32_t dropped = 0;
+ 
+ /**
+  * Write one full buffer to the file
+  */
+ static void trace_write(const trace_event_t* events, uint32_t count) {
+     if (fwrite(events, sizeof(trace_event_t), count, output) != count) {
+         dropped += count;
+     }
+ }
+ 
+ /**
+  * Start tracing to a file
+  */
+ int trace_start(const char* path) {
+     trace_header_t header;
+     trace_task_info_t info;
+     
+     if (path == NULL) {
+         LOG_ERROR("NULL trace path");
+         return -1;
+     }
+     
+     if (trace_enabled) {
+         LOG_ERROR("Trace already running");
+         return -1;
+     }
+     
+     output = fopen(path, "wb");
+     if (output == NULL) {
+         LOG_ERROR("Failed to open trace file '%s'", path);
+         return -1;
+     }
+     
+     /* Header and task table */
+     memset(&header, 0, sizeof(header));
+     header.magic = TRACE_MAGIC;
+     header.version = TRACE_VERSION;
+     header.tick_us = MILLISECONDS_PER_TICK * 1000;
+     for (int i = 0; i < MAX_TASKS; i++) {
+         if (task_list[i] != NULL) {
+             header.task_count++;
+         }
+     }
+     fwrite(&header, sizeof(header), 1, output);
+     
+     for (int i = 0; i < MAX_TASKS; i++) {
+         task_t* task = task_list[i];
+         if (task == NULL) {
+             continue;
+         }
+         memset(&info, 0, sizeof(info));
+         info.id = task->id;
+         info.priority = task->original_priority;
+         info.period = task->period;
+         info.deadline = task->deadline;
+         memcpy(info.name, task->name, MAX_TASK_NAME_LEN);
+         fwrite(&info, sizeof(info), 1, output);
+     }
+     
+     active = 0;
+     fill = 0;
+     dropped = 0;
+     trace_enabled = 1;
+     
+     LOG_INFO("Tracing to '%s'", path);
+     return 0;
+ }
+ 
+ /**
+  * Stop tracing, write buffered events and close the file
+  */
+ int trace_stop(void) {
+     if (!trace_enabled) {
+         LOG_WARNING("Trace not running");
+         return 0;
+     }
+     
+     uint32_t prev_state = context_enter_critical();
+     trace_enabled = 0;
+     uint32_t count = fill;
+     fill = 0;
+     context_exit_critical(prev_state);
+     
+     trace_write(buffers[active], count);
+     
+     int result = (fclose(output) == 0) ? 0 : -1;
+     output = NULL;
+     
+     if (dropped > 0) {
+         LOG_WARNING("Trace lost %u events", dropped);
+     }
+     
+     return result;
+ }
+ 
+ /**
+  * Record an event
+  */
+ void trace_record(uint8_t type, const task_t* task, uint8_t arg, uint32_t object) {
+     const trace_event_t* full = NULL;
+     
+     uint32_t prev_state = context_enter_critical();
+     
+     trace_event_t* ev = &buffers[active][fill];
+     ev->timestamp_us = timer_get_us();
+     ev->type = type;
+     ev->task = (task != NULL) ? task->id : TRACE_NO_TASK;
+     ev->arg = arg;
+     ev->reserved = 0;
+     ev->object = object;
+     
+     /* Swap buffers when full; write outside the critical section */
+     if (++fill == TRACE_BUFFER_EVENTS) {
+         full = buffers[active];
+         active ^= 1;
+         fill = 0;
+     }
+     
+     context_exit_critical(prev_state);
+     
+     if (full != NULL) {
+         trace_write(full, TRACE_BUFFER_EVENTS);
+     }
+ }
@@ -0,0 +1,264 @@
+/**
+ * @file workqueue.c
+ * @brief Implementation of kernel work queues
+ *
+ * Submitters push onto a Treiber stack with a single CAS. The worker
+ * detaches the whole stack with one exchange, restores submission order
+ * and runs the batch, so one wakeup amortizes any number of submissions.
+ */
+
+ #include <string.h>
+ #include "../../include/kernel/workqueue.h"
+ #include "../../include/kernel/atomic.h"
+ #include "../../include/kernel/task.h"
+ #include "../../include/kernel/ipc.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ /* Work queue storage */
+ static workqueue_t workqueues[MAX_WORKQUEUES];
+ static uint8_t workqueue_used[MAX_WORKQUEUES];
+
+ /**
+  * Worker task: sleep until work arrives, then run everything pending
+  */
+ static void workqueue_worker(void* arg) {
+     workqueue_t* wq = (workqueue_t*)arg;
+
+     while (1) {
+         semaphore_take(wq->wakeup, MAX_TIMEOUT);
+
+         /* Detach the whole batch at once */
+         work_item_t* list = (work_item_t*)atomic_xchg_ptr(&wq->pending_head, 0);
+
+         /* Reverse LIFO submission list into FIFO execution order */
+         work_item_t* batch = NULL;
+         while (list != NULL) {
+             work_item_t* next = list->next;
+             list->next = batch;
+             batch = list;
+             list = next;
+         }
+
+         uint32_t count = 0;
+         while (batch != NULL) {
+             work_item_t* work = batch;
+             batch = work->next;
+             work->next = NULL;
+
+             /* Clear pending first so the item may resubmit itself */
+             atomic_store_u32(&work->pending, 0);
+             work->func(work->arg);
+             count++;
+         }
+
+         if (count > 0) {
+             wq->stats.executed += count;
+             wq->stats.batches++;
+             if (count > wq->stats.max_batch) {
+                 wq->stats.max_batch = count;
+             }
+         }
+     }
+ }
+
+ /**
+  * Timer callback for delayed work
+  */
+ static void delayed_work_timer_fn(void* arg) {
+     delayed_work_t* dwork = (delayed_work_t*)arg;
+
+     if (dwork->wq != NULL) {
+         workqueue_submit(dwork->wq, &dwork->work);
+     }
+ }
+
+ /**
+  * Initialize the work queue subsystem
+  */
+ int workqueue_init(void) {
+     LOG_INFO("Initializing work queues");
+
+     memset(workqueue_used, 0, sizeof(workqueue_used));
+
+     return 0;
+ }
+
+ /**
+  * Create a work queue and its worker task
+  */
+ workqueue_t* workqueue_create(const char* name, uint8_t priority, uint32_t stack_size) {
+     workqueue_t* wq = NULL;
+     int index = -1;
+
+     /* Validate parameters */
+     if (name == NULL || priority >= MAX_PRIORITY_LEVELS) {
+         LOG_ERROR("Invalid work queue parameters");
+         return NULL;
+     }
+
+     /* Find free slot */
+     for (int i = 0; i < MAX_WORKQUEUES; i++) {
+         if (!workqueue_used[i]) {
+             index = i;
+             break;
+         }
+     }
+
+     if (index == -1) {
+         LOG_ERROR("No free work queue slots");
+         return NULL;
+     }
+
+     /* Initialize work queue */
+     wq = &workqueues[index];
+     memset(wq, 0, sizeof(workqueue_t));
+     strncpy(wq->name, name, MAX_TASK_NAME_LEN - 1);
+     wq->name[MAX_TASK_NAME_LEN - 1] = '\0';
+
+     /* Binary wakeup: given only on the empty -> non-empty transition */
+     wq->wakeup = semaphore_create(name, 0, 1);
+     if (wq->wakeup == NULL) {
+         LOG_ERROR("Failed to create work queue semaphore");
+         return NULL;
+     }
+
+     wq->worker = task_create(name, priority, workqueue_worker, wq, stack_size);
+     if (wq->worker == NULL) {
+         LOG_ERROR("Failed to create work queue worker");
+         semaphore_delete(wq->wakeup);
+         return NULL;
+     }
+
+     /* Mark as used */
+     workqueue_used[index] = 1;
+
+     LOG_INFO("Created work queue '%s' (priority=%u)", wq->name, priority);
+
+     return wq;
+ }
+
+ /**
+  * Initialize a work item
+  */
+ int work_init(work_item_t* work, work_func_t func, void* arg) {
+     if (work == NULL || func == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     work->func = func;
+     work->arg = arg;
+     work->pending = 0;
+     work->next = NULL;
+
+     return 0;
+ }
+
+ /**
+  * Submit a work item without blocking or locking
+  */
+ int workqueue_submit(workqueue_t* wq, work_item_t* work) {
+     if (wq == NULL || work == NULL || work->func == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     /* Claim the item; a pending item is already going to run */
+     if (!atomic_cas_u32(&work->pending, 0, 1)) {
+         atomic_add_u32(&wq->stats.coalesced, 1);
+         return 1;
+     }
+
+     /* Push onto the submission stack */
+     uintptr_t head;
+     do {
+         head = atomic_load_ptr(&wq->pending_head);
+         work->next = (work_item_t*)head;
+     } while (!atomic_cas_ptr(&wq->pending_head, head, (uintptr_t)work));
+
+     atomic_add_u32(&wq->stats.submitted, 1);
+
+     /* Only the first item of a batch needs to wake the worker */
+     if (head == 0) {
+         semaphore_give(wq->wakeup);
+     }
+
+     return 0;
+ }
+
+ /**
+  * Initialize a delayed work item
+  */
+ int delayed_work_init(delayed_work_t* dwork, const char* name, work_func_t func, void* arg) {
+     if (dwork == NULL || name == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     if (work_init(&dwork->work, func, arg) != 0) {
+         return -1;
+     }
+
+     dwork->wq = NULL;
+
+     /* Create the timer once so arming it later does not allocate */
+     dwork->timer = timer_create(name, 1, 0, delayed_work_timer_fn, dwork);
+     if (dwork->timer == NULL) {
+         LOG_ERROR("Failed to create timer for delayed work '%s'", name);
+         return -1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Submit a work item after a delay
+  */
+ int workqueue_submit_delayed(workqueue_t* wq, delayed_work_t* dwork, uint32_t delay_ms) {
+     if (wq == NULL || dwork == NULL || dwork->timer == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     if (delay_ms == 0) {
+         return (workqueue_submit(wq, &dwork->work) < 0) ? -1 : 0;
+     }
+
+     dwork->wq = wq;
+
+     /* Re-arming restarts the delay */
+     if (timer_set_period(dwork->timer, delay_ms) != 0 ||
+         timer_start(dwork->timer) != 0) {
+         LOG_ERROR("Failed to arm delayed work timer");
+         return -1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Cancel a pending delay
+  */
+ int delayed_work_cancel(delayed_work_t* dwork) {
+     if (dwork == NULL || dwork->timer == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     return timer_stop(dwork->timer);
+ }
+
+ /**
+  * Get work queue statistics
+  */
+ int workqueue_get_stats(workqueue_t* wq, workqueue_stats_t* stats) {
+     if (wq == NULL || stats == NULL) {
+         LOG_ERROR("Invalid parameters");
+         return -1;
+     }
+
+     memcpy(stats, &wq->stats, sizeof(workqueue_stats_t));
+
+     return 0;
+ }
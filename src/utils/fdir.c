@@ -0,0 +1,301 @@
+/**
+ * @file fdir.c
+ * @brief Implementation of FDIR limit checking
+ *
+ * Each check field is its own array, padded to a whole number of vector
+ * lanes. Unused lanes carry open limits and never trip. A persistence
+ * counter counts consecutive violated cycles and saturates at the check's
+ * persistence, so "tripped" is counter == persistence and a new trip is
+ * a lane that reaches it this cycle.
+ */
+
+ #include <string.h>
+ #include "../../include/utils/fdir.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ #ifdef __GNUC__
+ #define FDIR_LANES      (FDIR_VECTOR_BYTES / (int)sizeof(float))
+ #define FDIR_ALIGNED    __attribute__((aligned(FDIR_VECTOR_BYTES)))
+ typedef float fdir_vf __attribute__((vector_size(FDIR_VECTOR_BYTES)));
+ typedef int32_t fdir_vi __attribute__((vector_size(FDIR_VECTOR_BYTES)));
+ #else
+ #define FDIR_LANES      1
+ #define FDIR_ALIGNED
+ #endif
+
+ /* Check table, one array per field */
+ static float value[FDIR_MAX_CHECKS] FDIR_ALIGNED;
+ static float previous[FDIR_MAX_CHECKS] FDIR_ALIGNED;
+ static float low[FDIR_MAX_CHECKS] FDIR_ALIGNED;
+ static float high[FDIR_MAX_CHECKS] FDIR_ALIGNED;
+ static float max_delta[FDIR_MAX_CHECKS] FDIR_ALIGNED;
+ static int32_t count[FDIR_MAX_CHECKS] FDIR_ALIGNED;
+ static int32_t persistence[FDIR_MAX_CHECKS] FDIR_ALIGNED;
+ static int32_t flags[FDIR_MAX_CHECKS] FDIR_ALIGNED;
+ static uint8_t action[FDIR_MAX_CHECKS];
+ static uint8_t sampled[FDIR_MAX_CHECKS];
+ static const char* names[FDIR_MAX_CHECKS];
+ static uint32_t check_count = 0;
+
+ /* Recovery actions */
+ static fdir_action_fn action_fn[FDIR_MAX_ACTIONS];
+ static void* action_ctx[FDIR_MAX_ACTIONS];
+
+ static event_group_t* event_group = NULL;
+ static uint32_t owned_flags = 0;     /* Union of all check flags */
+ static fdir_stats_t stats;
+ static uint8_t initialized = 0;
+
+ /**
+  * Run the recovery action of a check that just tripped
+  */
+ static void trip(uint32_t id) {
+     uint8_t slot = action[id];
+
+     stats.trips++;
+     LOG_WARNING("FDIR check '%s' tripped (value %.3f)",
+                 names[id] ? names[id] : "?", (double)value[id]);
+
+     if (slot < FDIR_MAX_ACTIONS && action_fn[slot] != NULL) {
+         stats.actions++;
+         action_fn[slot]((uint16_t)id, value[id], action_ctx[slot]);
+     }
+ }
+
+ /**
+  * Initialize the FDIR table
+  */
+ int fdir_init(event_group_t* events) {
+     /* Open limits everywhere so padding lanes never violate */
+     for (uint32_t i = 0; i < FDIR_MAX_CHECKS; i++) {
+         value[i] = 0.0f;
+         previous[i] = 0.0f;
+         low[i] = -INFINITY;
+         high[i] = INFINITY;
+         max_delta[i] = INFINITY;
+         count[i] = 0;
+         persistence[i] = 1;
+         flags[i] = 0;
+         action[i] = FDIR_NO_ACTION;
+         sampled[i] = 0;
+         names[i] = NULL;
+     }
+
+     memset(action_fn, 0, sizeof(action_fn));
+     memset(action_ctx, 0, sizeof(action_ctx));
+     memset(&stats, 0, sizeof(stats));
+     event_group = events;
+     owned_flags = 0;
+     check_count = 0;
+     initialized = 1;
+
+     LOG_INFO("FDIR initialized (%d-lane evaluation)", FDIR_LANES);
+     return 0;
+ }
+
+ /**
+  * Add a check
+  */
+ int fdir_add_check(const fdir_check_t* check, uint16_t* id) {
+     if (!initialized || check == NULL) {
+         LOG_ERROR("FDIR not initialized or NULL check");
+         return -1;
+     }
+
+     if (check->persistence == 0 || !(check->low <= check->high) || !(check->max_delta >= 0.0f)) {
+         LOG_ERROR("Invalid FDIR check '%s'", check->name ? check->name : "?");
+         return -1;
+     }
+
+     if (check_count >= FDIR_MAX_CHECKS) {
+         LOG_ERROR("Too many FDIR checks");
+         return -1;
+     }
+
+     uint32_t i = check_count++;
+     low[i] = check->low;
+     high[i] = check->high;
+     max_delta[i] = check->max_delta;
+     persistence[i] = check->persistence;
+     flags[i] = (int32_t)check->flags;
+     action[i] = check->action;
+     names[i] = check->name;
+     owned_flags |= check->flags;
+
+     if (id != NULL) {
+         *id = (uint16_t)i;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Register a recovery action
+  */
+ int fdir_register_action(uint8_t slot, fdir_action_fn fn, void* ctx) {
+     if (slot >= FDIR_MAX_ACTIONS || fn == NULL) {
+         LOG_ERROR("Invalid FDIR action %u", slot);
+         return -1;
+     }
+
+     action_fn[slot] = fn;
+     action_ctx[slot] = ctx;
+
+     return 0;
+ }
+
+ /**
+  * Sample the value of a check
+  */
+ int fdir_set_value(uint16_t id, float sample) {
+     if (id >= check_count) {
+         LOG_ERROR("Invalid FDIR check %u", id);
+         return -1;
+     }
+
+     value[id] = sample;
+     if (!sampled[id]) {
+         previous[id] = sample;
+         sampled[id] = 1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Evaluate every check once
+  */
+ int fdir_evaluate(fdir_result_t* result) {
+     uint32_t raised = 0;
+     uint32_t tripped = 0;
+     uint32_t new_trips = 0;
+
+     if (!initialized) {
+         LOG_ERROR("FDIR not initialized");
+         return -1;
+     }
+
+     /* Padding lanes up to the next vector boundary are inert */
+     uint32_t end = (check_count + FDIR_LANES - 1) / FDIR_LANES * FDIR_LANES;
+
+ #ifdef __GNUC__
+     fdir_vi raised_v = { 0 };
+     fdir_vi tripped_v = { 0 };
+
+     for (uint32_t i = 0; i < end; i += FDIR_LANES) {
+         fdir_vf v, p, lo, hi, md;
+         fdir_vi c, lim, fl;
+
+         memcpy(&v, &value[i], sizeof(v));
+         memcpy(&p, &previous[i], sizeof(p));
+         memcpy(&lo, &low[i], sizeof(lo));
+         memcpy(&hi, &high[i], sizeof(hi));
+         memcpy(&md, &max_delta[i], sizeof(md));
+         memcpy(&c, &count[i], sizeof(c));
+         memcpy(&lim, &persistence[i], sizeof(lim));
+         memcpy(&fl, &flags[i], sizeof(fl));
+
+         /* Lanes are all-ones where violated; NaN samples always violate */
+         fdir_vf d = v - p;
+         fdir_vi violated = (v < lo) | (v > hi) | (d > md) | (d < -md) | (v != v);
+
+         /* Count violated cycles, saturating at the persistence */
+         fdir_vi was = (c >= lim);
+         c = (c - (c < lim)) & violated;
+         fdir_vi now = (c >= lim);
+
+         raised_v |= fl & now;
+         tripped_v -= now;
+
+         memcpy(&count[i], &c, sizeof(c));
+         memcpy(&previous[i], &v, sizeof(v));
+
+         /* New trips are rare: only then look at single lanes */
+         union { fdir_vi v; int32_t lane[FDIR_LANES]; } edge = { now & ~was };
+         int32_t any = 0;
+         for (int l = 0; l < FDIR_LANES; l++) {
+             any |= edge.lane[l];
+         }
+         if (any) {
+             for (int l = 0; l < FDIR_LANES; l++) {
+                 if (edge.lane[l]) {
+                     new_trips++;
+                     trip(i + (uint32_t)l);
+                 }
+             }
+         }
+     }
+
+     union { fdir_vi v; int32_t lane[FDIR_LANES]; } r = { raised_v }, t = { tripped_v };
+     for (int l = 0; l < FDIR_LANES; l++) {
+         raised |= (uint32_t)r.lane[l];
+         tripped += (uint32_t)t.lane[l];
+     }
+ #else
+     for (uint32_t i = 0; i < end; i++) {
+         float d = value[i] - previous[i];
+         int violated = value[i] < low[i] || value[i] > high[i] ||
+                        d > max_delta[i] || d < -max_delta[i] || value[i] != value[i];
+         int was = count[i] >= persistence[i];
+
+         count[i] = violated ? count[i] + (count[i] < persistence[i]) : 0;
+         previous[i] = value[i];
+
+         if (count[i] >= persistence[i]) {
+             raised |= (uint32_t)flags[i];
+             tripped++;
+             if (!was) {
+                 new_trips++;
+                 trip(i);
+             }
+         }
+     }
+ #endif
+
+     stats.evaluations++;
+
+     if (event_group != NULL) {
+         if (raised != 0) {
+             event_group_set_flags(event_group, raised);
+         }
+         if ((owned_flags & ~raised) != 0) {
+             event_group_clear_flags(event_group, owned_flags & ~raised);
+         }
+     }
+
+     if (result != NULL) {
+         result->raised = raised;
+         result->tripped = tripped;
+         result->new_trips = new_trips;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Check whether a check is tripped
+  */
+ int fdir_is_tripped(uint16_t id) {
+     if (id >= check_count) {
+         LOG_ERROR("Invalid FDIR check %u", id);
+         return -1;
+     }
+
+     return count[id] >= persistence[id];
+ }
+
+ /**
+  * Get FDIR statistics
+  */
+ int fdir_get_stats(fdir_stats_t* out) {
+     if (out == NULL) {
+         LOG_ERROR("NULL stats pointer");
+         return -1;
+     }
+
+     *out = stats;
+     out->checks = check_count;
+
+     return 0;
+ }
@@ -0,0 +1,321 @@
+/**
+ * @file paramdb.c
+ * @brief Implementation of the telemetry parameter database
+ *
+ * Entry layout: sequence counter, value, timestamp and a meta word
+ * (type and validity), 16 bytes each. Writers bump the counter to odd,
+ * store the entry and bump it to even again inside a short critical
+ * section, so on one CPU a reader only ever retries when a writer ran
+ * between its two counter loads. The compare-and-swap that makes the
+ * counter odd also keeps writers on other cores apart.
+ */
+
+ #include <string.h>
+ #include "../../include/utils/paramdb.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/kernel/atomic.h"
+ #include "../../include/kernel/context.h"
+ #include "../../include/kernel/time.h"
+ #include "../../include/config.h"
+
+ #define META_VALID       0x100    /* Meta word: type in bits 0-7, valid flag */
+
+ /* Packed parameter entry */
+ typedef struct {
+     volatile uint32_t seq;       /* Odd while a write is in progress */
+     volatile uint32_t value;     /* Raw value bits */
+     volatile uint32_t timestamp; /* Tick of the last write */
+     volatile uint32_t meta;      /* Type and validity */
+ } param_entry_t;
+
+ static param_entry_t table[PARAMDB_MAX_PARAMS] __attribute__((aligned(CACHE_LINE_SIZE)));
+ static const char* names[PARAMDB_MAX_PARAMS];
+ static paramdb_stats_t stats;
+
+ /**
+  * Start writing an entry
+  */
+ static uint32_t write_begin(param_entry_t* entry) {
+     uint32_t seq;
+
+     do {
+         seq = atomic_load_relaxed_u32(&entry->seq) & ~1u;
+     } while (!atomic_cas_u32(&entry->seq, seq, seq + 1));
+     atomic_fence_release();
+
+     return seq;
+ }
+
+ /**
+  * Publish a written entry
+  */
+ static void write_end(param_entry_t* entry, uint32_t seq) {
+     atomic_store_u32(&entry->seq, seq + 2);
+ }
+
+ /**
+  * Read a consistent copy of an entry
+  */
+ static void read_entry(uint16_t id, param_sample_t* sample) {
+     param_entry_t* entry = &table[id];
+     uint32_t seq, value, timestamp, meta;
+
+     for (;;) {
+         seq = atomic_load_u32(&entry->seq);
+         if ((seq & 1) == 0) {
+             value = atomic_load_relaxed_u32(&entry->value);
+             timestamp = atomic_load_relaxed_u32(&entry->timestamp);
+             meta = atomic_load_relaxed_u32(&entry->meta);
+             atomic_fence_acquire();
+             if (atomic_load_relaxed_u32(&entry->seq) == seq) {
+                 break;
+             }
+         }
+         atomic_add_u32(&stats.read_retries, 1);
+     }
+
+     sample->value.raw = value;
+     sample->timestamp = timestamp;
+     sample->id = id;
+     sample->type = (uint8_t)(meta & 0xFF);
+     sample->valid = (meta & META_VALID) ? 1 : 0;
+ }
+
+ /**
+  * Store a value and meta word under the entry's sequence counter
+  */
+ static void write_entry(uint16_t id, uint32_t value, uint32_t meta) {
+     param_entry_t* entry = &table[id];
+
+     uint32_t prev_state = context_enter_critical();
+     uint32_t seq = write_begin(entry);
+
+     atomic_store_relaxed_u32(&entry->value, value);
+     atomic_store_relaxed_u32(&entry->timestamp, time_get_ticks());
+     atomic_store_relaxed_u32(&entry->meta, meta);
+
+     write_end(entry, seq);
+     stats.writes++;
+     context_exit_critical(prev_state);
+ }
+
+ /**
+  * Type of a defined parameter, PARAM_TYPE_NONE if undefined
+  */
+ static param_type_t entry_type(uint16_t id) {
+     if (id >= PARAMDB_MAX_PARAMS) {
+         return PARAM_TYPE_NONE;
+     }
+
+     /* The type never changes after definition, so no seqlock is needed */
+     return (param_type_t)(atomic_load_relaxed_u32(&table[id].meta) & 0xFF);
+ }
+
+ /**
+  * Initialize the parameter database
+  */
+ int paramdb_init(void) {
+     memset((void*)table, 0, sizeof(table));
+     memset(names, 0, sizeof(names));
+     memset(&stats, 0, sizeof(stats));
+
+     LOG_INFO("Parameter database initialized (%u parameters)", PARAMDB_MAX_PARAMS);
+     return 0;
+ }
+
+ /**
+  * Define a parameter
+  */
+ int paramdb_define(uint16_t id, const char* name, param_type_t type) {
+     if (id >= PARAMDB_MAX_PARAMS || type == PARAM_TYPE_NONE || type > PARAM_TYPE_BOOL) {
+         LOG_ERROR("Invalid parameter %u (type %d)", id, type);
+         return -1;
+     }
+
+     if (entry_type(id) != PARAM_TYPE_NONE) {
+         LOG_ERROR("Parameter %u already defined as '%s'", id, names[id] ? names[id] : "?");
+         return -1;
+     }
+
+     names[id] = name;
+     write_entry(id, 0, (uint32_t)type);
+     stats.defined++;
+
+     return 0;
+ }
+
+ /**
+  * Write a parameter
+  */
+ int paramdb_set(uint16_t id, param_type_t type, param_value_t value) {
+     param_type_t defined = entry_type(id);
+
+     if (defined == PARAM_TYPE_NONE || defined != type) {
+         LOG_ERROR("Parameter %u written with wrong type %d", id, type);
+         return -1;
+     }
+
+     write_entry(id, value.raw, (uint32_t)type | META_VALID);
+     return 0;
+ }
+
+ /**
+  * Write an unsigned parameter
+  */
+ int paramdb_set_u32(uint16_t id, uint32_t value) {
+     param_value_t v;
+     v.u32 = value;
+     return paramdb_set(id, PARAM_TYPE_U32, v);
+ }
+
+ /**
+  * Write a signed parameter
+  */
+ int paramdb_set_i32(uint16_t id, int32_t value) {
+     param_value_t v;
+     v.i32 = value;
+     return paramdb_set(id, PARAM_TYPE_I32, v);
+ }
+
+ /**
+  * Write a floating-point parameter
+  */
+ int paramdb_set_f32(uint16_t id, float value) {
+     param_value_t v;
+     v.f32 = value;
+     return paramdb_set(id, PARAM_TYPE_F32, v);
+ }
+
+ /**
+  * Write a boolean parameter
+  */
+ int paramdb_set_bool(uint16_t id, uint32_t value) {
+     param_value_t v;
+     v.u32 = value ? 1 : 0;
+     return paramdb_set(id, PARAM_TYPE_BOOL, v);
+ }
+
+ /**
+  * Mark a parameter invalid
+  */
+ int paramdb_invalidate(uint16_t id) {
+     param_type_t type = entry_type(id);
+
+     if (type == PARAM_TYPE_NONE) {
+         LOG_ERROR("Invalid parameter %u", id);
+         return -1;
+     }
+
+     param_sample_t sample;
+     read_entry(id, &sample);
+     write_entry(id, sample.value.raw, (uint32_t)type);
+
+     return 0;
+ }
+
+ /**
+  * Read a parameter
+  */
+ int paramdb_get(uint16_t id, param_sample_t* sample) {
+     if (sample == NULL || entry_type(id) == PARAM_TYPE_NONE) {
+         LOG_ERROR("Invalid parameter %u or NULL sample", id);
+         return -1;
+     }
+
+     read_entry(id, sample);
+     return 0;
+ }
+
+ /**
+  * Read a numeric parameter as float
+  */
+ int paramdb_get_f32(uint16_t id, float* value) {
+     param_sample_t sample;
+
+     if (value == NULL || paramdb_get(id, &sample) != 0 || !sample.valid) {
+         return -1;
+     }
+
+     switch (sample.type) {
+         case PARAM_TYPE_F32:  *value = sample.value.f32; break;
+         case PARAM_TYPE_I32:  *value = (float)sample.value.i32; break;
+         default:              *value = (float)sample.value.u32; break;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Read a numeric parameter as unsigned integer
+  */
+ int paramdb_get_u32(uint16_t id, uint32_t* value) {
+     param_sample_t sample;
+
+     if (value == NULL || paramdb_get(id, &sample) != 0 || !sample.valid) {
+         return -1;
+     }
+
+     switch (sample.type) {
+         case PARAM_TYPE_F32:  *value = (uint32_t)sample.value.f32; break;
+         case PARAM_TYPE_I32:  *value = (uint32_t)sample.value.i32; break;
+         default:              *value = sample.value.u32; break;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Read a list of parameters
+  */
+ int paramdb_snapshot(const uint16_t* ids, uint32_t count, param_sample_t* samples) {
+     if (ids == NULL || samples == NULL) {
+         LOG_ERROR("NULL snapshot arguments");
+         return -1;
+     }
+
+     for (uint32_t i = 0; i < count; i++) {
+         if (entry_type(ids[i]) == PARAM_TYPE_NONE) {
+             LOG_ERROR("Invalid parameter %u in snapshot", ids[i]);
+             return -1;
+         }
+         read_entry(ids[i], &samples[i]);
+     }
+
+     return 0;
+ }
+
+ /**
+  * Read a contiguous block of parameters
+  */
+ int paramdb_snapshot_range(uint16_t first, uint32_t count, param_sample_t* samples) {
+     if (samples == NULL || (uint32_t)first + count > PARAMDB_MAX_PARAMS) {
+         LOG_ERROR("Invalid snapshot range %u+%u", first, count);
+         return -1;
+     }
+
+     for (uint32_t i = 0; i < count; i++) {
+         read_entry((uint16_t)(first + i), &samples[i]);
+     }
+
+     return 0;
+ }
+
+ /**
+  * Get the name of a parameter
+  */
+ const char* paramdb_get_name(uint16_t id) {
+     return (entry_type(id) != PARAM_TYPE_NONE) ? names[id] : NULL;
+ }
+
+ /**
+  * Get database statistics
+  */
+ int paramdb_get_stats(paramdb_stats_t* out) {
+     if (out == NULL) {
+         LOG_ERROR("NULL stats pointer");
+         return -1;
+     }
+
+     *out = stats;
+     return 0;
+ }
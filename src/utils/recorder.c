@@ -0,0 +1,453 @@
+/**
+ * @file recorder.c
+ * @brief Implementation of the time-series statistics recorder
+ *
+ * The sampler runs from a periodic timer and only copies counters into
+ * a ring of raw rows. The writer task drains the ring, folds rows into
+ * the downsampling levels, and encodes and writes full blocks, so the
+ * timer callback never does I/O.
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include "../../include/utils/recorder.h"
+ #include "../../include/utils/varint.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/kernel/scheduler.h"
+ #include "../../include/kernel/heap.h"
+ #include "../../include/kernel/time.h"
+ #include "../../include/drivers/time.h"
+ #include "../../include/config.h"
+
+ /* Column sources */
+ typedef enum {
+     SRC_TIME,
+     SRC_CONTEXT_SWITCHES,
+     SRC_INVOCATIONS,
+     SRC_IDLE_TIME,
+     SRC_DEADLINE_MISSES,
+     SRC_HEAP_USED,
+     SRC_TASK_RUNTIME,
+     SRC_TASK_ACTIVATIONS,
+     SRC_TASK_MISSES,
+     SRC_TASK_MAX_EXEC,
+     SRC_QUEUE_DEPTH
+ } column_source_t;
+
+ /* Column descriptor */
+ typedef struct {
+     char name[2 * MAX_TASK_NAME_LEN];
+     uint8_t kind;
+     column_source_t source;
+     void* object;                /* Task or queue, if any */
+ } column_t;
+
+ /* Per-level state */
+ typedef struct {
+     uint32_t block[RECORDER_MAX_BLOCK_ROWS][RECORDER_MAX_COLUMNS];
+     uint32_t rows;               /* Rows in the current block */
+     uint32_t agg[RECORDER_MAX_COLUMNS];
+     uint32_t agg_rows;           /* Rows folded into agg */
+     uint32_t written_rows;       /* Rows written at this level */
+ } level_t;
+
+ /* Recorder state */
+ static recorder_config_t config;
+ static column_t columns[RECORDER_MAX_COLUMNS];
+ static uint32_t column_count = 0;
+ static level_t levels[RECORDER_MAX_LEVELS];
+ static recorder_stats_t stats;
+ static uint8_t started = 0;
+
+ /* Sample ring: timer produces, writer task consumes */
+ static uint32_t ring[RECORDER_RING_ROWS][RECORDER_MAX_COLUMNS];
+ static volatile uint32_t ring_head = 0;
+ static volatile uint32_t ring_tail = 0;
+
+ static FILE* output = NULL;
+ static timer_t* sample_timer = NULL;
+ static semaphore_t* wakeup = NULL;
+ static task_t* writer = NULL;
+ static uint32_t blocks_since_flush = 0;
+
+ /* Encoding scratch: worst case 5 bytes per value plus block header */
+ static uint8_t encode_buf[16 + RECORDER_MAX_BLOCK_ROWS * RECORDER_MAX_COLUMNS * 5];
+
+ /**
+  * Add a column descriptor
+  */
+ static int add_column(const char* prefix, const char* suffix, uint8_t kind,
+                       column_source_t source, void* object) {
+     if (started) {
+         LOG_ERROR("Cannot add recorder columns while recording");
+         return -1;
+     }
+
+     if (column_count >= RECORDER_MAX_COLUMNS) {
+         LOG_ERROR("Too many recorder columns");
+         return -1;
+     }
+
+     column_t* col = &columns[column_count++];
+     snprintf(col->name, sizeof(col->name), "%s%s", prefix, suffix);
+     col->kind = kind;
+     col->source = source;
+     col->object = object;
+
+     return 0;
+ }
+
+ /**
+  * Read the current value of a column
+  */
+ static uint32_t read_column(const column_t* col, const scheduler_stats_t* sched,
+                             const heap_stats_t* heap) {
+     const task_t* task = (const task_t*)col->object;
+
+     switch (col->source) {
+         case SRC_TIME:              return time_get_ticks();
+         case SRC_CONTEXT_SWITCHES:  return sched->context_switches;
+         case SRC_INVOCATIONS:       return sched->scheduler_invocations;
+         case SRC_IDLE_TIME:         return sched->idle_time;
+         case SRC_DEADLINE_MISSES:   return sched->deadline_misses;
+         case SRC_HEAP_USED:         return heap->used_bytes;
+         case SRC_TASK_RUNTIME:      return task->stats.total_runtime;
+         case SRC_TASK_ACTIVATIONS:  return task->stats.num_activations;
+         case SRC_TASK_MISSES:       return task->stats.deadline_misses;
+         case SRC_TASK_MAX_EXEC:     return task->stats.max_execution_time;
+         case SRC_QUEUE_DEPTH:       return ((const queue_t*)col->object)->count;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Timer callback: copy one sample row into the ring
+  */
+ static void recorder_sample(void* arg) {
+     scheduler_stats_t sched;
+     heap_stats_t heap;
+
+     (void)arg;
+
+     if (ring_head - ring_tail >= RECORDER_RING_ROWS) {
+         stats.dropped++;
+         return;
+     }
+
+     scheduler_get_stats(&sched);
+     heap_get_stats(&heap);
+
+     uint32_t* row = ring[ring_head % RECORDER_RING_ROWS];
+     for (uint32_t c = 0; c < column_count; c++) {
+         row[c] = read_column(&columns[c], &sched, &heap);
+     }
+
+     ring_head++;
+     stats.samples++;
+
+     /* Wake the writer once a block's worth of rows is waiting */
+     if (ring_head - ring_tail == config.block_rows) {
+         semaphore_give(wakeup);
+     }
+ }
+
+ /**
+  * Encode and write the current block of a level
+  */
+ static int write_block(uint32_t level_index) {
+     level_t* level = &levels[level_index];
+     size_t n = 0;
+
+     if (level->rows == 0) {
+         return 0;
+     }
+
+     encode_buf[n++] = 'B';
+     n += varint_put(&encode_buf[n], level_index);
+     n += varint_put(&encode_buf[n], level->rows);
+
+     /* Columnar layout: each column's values are contiguous */
+     for (uint32_t c = 0; c < column_count; c++) {
+         n += varint_put(&encode_buf[n], level->block[0][c]);
+         for (uint32_t r = 1; r < level->rows; r++) {
+             int32_t delta = (int32_t)(level->block[r][c] - level->block[r - 1][c]);
+             n += varint_put(&encode_buf[n], varint_zigzag(delta));
+         }
+     }
+
+     level->rows = 0;
+
+     if (fwrite(encode_buf, 1, n, output) != n) {
+         LOG_ERROR("Failed to write recorder block");
+         return -1;
+     }
+
+     stats.blocks_written++;
+     stats.bytes_written += (uint32_t)n;
+
+     if (++blocks_since_flush >= RECORDER_FLUSH_BLOCKS) {
+         fflush(output);
+         blocks_since_flush = 0;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Feed a row into a level, cascading aggregates into coarser levels
+  */
+ static void level_push(uint32_t level_index, const uint32_t* row) {
+     level_t* level = &levels[level_index];
+
+     /* Level 0 may be capped to bound file growth on long runs */
+     int keep = (level_index > 0 || config.full_rate_rows == 0 ||
+                 level->written_rows < config.full_rate_rows);
+     if (keep) {
+         memcpy(level->block[level->rows], row, column_count * sizeof(uint32_t));
+         level->written_rows++;
+         if (++level->rows == config.block_rows) {
+             write_block(level_index);
+         }
+     }
+
+     if (level_index + 1 >= config.levels) {
+         return;
+     }
+
+     /* Fold into the next level: counters keep last, gauges keep max */
+     for (uint32_t c = 0; c < column_count; c++) {
+         if (level->agg_rows == 0 || columns[c].kind == RECORDER_COLUMN_COUNTER ||
+             row[c] > level->agg[c]) {
+             level->agg[c] = row[c];
+         }
+     }
+
+     if (++level->agg_rows == config.downsample_factor) {
+         level->agg_rows = 0;
+         level_push(level_index + 1, level->agg);
+     }
+ }
+
+ /**
+  * Move all buffered samples into the levels
+  */
+ static void recorder_drain(void) {
+     while (ring_tail != ring_head) {
+         level_push(0, ring[ring_tail % RECORDER_RING_ROWS]);
+         ring_tail++;
+     }
+ }
+
+ /**
+  * Writer task: encode and write samples in batches
+  */
+ static void recorder_writer(void* arg) {
+     (void)arg;
+
+     /* Bound latency even if the ring never reaches a full block */
+     uint32_t timeout = time_ms_to_ticks(config.sample_period_ms * config.block_rows);
+
+     while (1) {
+         semaphore_take(wakeup, timeout);
+         if (started) {
+             recorder_drain();
+         }
+     }
+ }
+
+ /**
+  * Write the file header
+  */
+ static int write_header(void) {
+     uint8_t buf[32];
+     size_t n = 0;
+
+     memcpy(buf, "ORTS", 4);
+     n = 4;
+     buf[n++] = 1;  /* Format version */
+     n += varint_put(&buf[n], config.sample_period_ms);
+     n += varint_put(&buf[n], config.downsample_factor);
+     n += varint_put(&buf[n], column_count);
+     if (fwrite(buf, 1, n, output) != n) {
+         return -1;
+     }
+
+     for (uint32_t c = 0; c < column_count; c++) {
+         uint8_t len = (uint8_t)strlen(columns[c].name);
+         if (fputc(columns[c].kind, output) == EOF ||
+             fputc(len, output) == EOF ||
+             fwrite(columns[c].name, 1, len, output) != len) {
+             return -1;
+         }
+     }
+
+     return 0;
+ }
+
+ /**
+  * Initialize the recorder
+  */
+ int recorder_init(const recorder_config_t* cfg) {
+     if (cfg == NULL || cfg->path == NULL || cfg->sample_period_ms == 0 ||
+         cfg->block_rows == 0 || cfg->block_rows > RECORDER_MAX_BLOCK_ROWS ||
+         cfg->block_rows > RECORDER_RING_ROWS ||
+         cfg->levels == 0 || cfg->levels > RECORDER_MAX_LEVELS ||
+         (cfg->levels > 1 && cfg->downsample_factor < 2)) {
+         LOG_ERROR("Invalid recorder configuration");
+         return -1;
+     }
+
+     if (started) {
+         LOG_ERROR("Recorder already running");
+         return -1;
+     }
+
+     memcpy(&config, cfg, sizeof(recorder_config_t));
+     memset(levels, 0, sizeof(levels));
+     memset(&stats, 0, sizeof(stats));
+     column_count = 0;
+     ring_head = 0;
+     ring_tail = 0;
+
+     /* System-wide columns */
+     add_column("time", "", RECORDER_COLUMN_COUNTER, SRC_TIME, NULL);
+     add_column("sched.", "switches", RECORDER_COLUMN_COUNTER, SRC_CONTEXT_SWITCHES, NULL);
+     add_column("sched.", "invocations", RECORDER_COLUMN_COUNTER, SRC_INVOCATIONS, NULL);
+     add_column("sched.", "idle", RECORDER_COLUMN_COUNTER, SRC_IDLE_TIME, NULL);
+     add_column("sched.", "misses", RECORDER_COLUMN_COUNTER, SRC_DEADLINE_MISSES, NULL);
+     add_column("heap.", "used", RECORDER_COLUMN_GAUGE, SRC_HEAP_USED, NULL);
+
+     LOG_INFO("Recorder initialized (%u ms, %u levels)", config.sample_period_ms, config.levels);
+     return 0;
+ }
+
+ /**
+  * Add per-task columns
+  */
+ int recorder_add_task(task_t* task) {
+     if (task == NULL) {
+         LOG_ERROR("NULL task pointer");
+         return -1;
+     }
+
+     if (column_count + 4 > RECORDER_MAX_COLUMNS) {
+         LOG_ERROR("Too many recorder columns");
+         return -1;
+     }
+
+     add_column(task->name, ".runtime", RECORDER_COLUMN_COUNTER, SRC_TASK_RUNTIME, task);
+     add_column(task->name, ".activations", RECORDER_COLUMN_COUNTER, SRC_TASK_ACTIVATIONS, task);
+     add_column(task->name, ".misses", RECORDER_COLUMN_COUNTER, SRC_TASK_MISSES, task);
+     return add_column(task->name, ".max_exec", RECORDER_COLUMN_GAUGE, SRC_TASK_MAX_EXEC, task);
+ }
+
+ /**
+  * Add a queue depth column
+  */
+ int recorder_add_queue(queue_t* queue) {
+     if (queue == NULL) {
+         LOG_ERROR("NULL queue pointer");
+         return -1;
+     }
+
+     return add_column(queue->name, ".depth", RECORDER_COLUMN_GAUGE, SRC_QUEUE_DEPTH, queue);
+ }
+
+ /**
+  * Open the output file and start sampling
+  */
+ int recorder_start(void) {
+     if (started || column_count == 0) {
+         LOG_ERROR("Recorder not initialized or already running");
+         return -1;
+     }
+
+     output = fopen(config.path, "wb");
+     if (output == NULL) {
+         LOG_ERROR("Failed to open recorder file '%s'", config.path);
+         return -1;
+     }
+     setvbuf(output, NULL, _IOFBF, RECORDER_IO_BUFFER);
+
+     if (write_header() != 0) {
+         LOG_ERROR("Failed to write recorder header");
+         fclose(output);
+         output = NULL;
+         return -1;
+     }
+
+     /* Writer task and its wakeup are created once and reused */
+     if (wakeup == NULL) {
+         wakeup = semaphore_create("recorder", 0, 1);
+         writer = (wakeup != NULL) ?
+                  task_create("recorder", config.priority, recorder_writer, NULL, DEFAULT_STACK_SIZE) : NULL;
+         if (writer == NULL) {
+             LOG_ERROR("Failed to create recorder writer");
+             fclose(output);
+             output = NULL;
+             return -1;
+         }
+     }
+
+     if (sample_timer == NULL) {
+         sample_timer = timer_create("recorder", config.sample_period_ms, 1, recorder_sample, NULL);
+     } else {
+         timer_set_period(sample_timer, config.sample_period_ms);
+     }
+
+     started = 1;
+     if (sample_timer == NULL || timer_start(sample_timer) != 0) {
+         LOG_ERROR("Failed to start recorder timer");
+         started = 0;
+         fclose(output);
+         output = NULL;
+         return -1;
+     }
+
+     LOG_INFO("Recording %u columns to '%s'", column_count, config.path);
+     return 0;
+ }
+
+ /**
+  * Stop sampling, flush partial blocks and close the file
+  */
+ int recorder_stop(void) {
+     if (!started) {
+         LOG_WARNING("Recorder not running");
+         return 0;
+     }
+
+     timer_stop(sample_timer);
+     started = 0;
+
+     /* Write everything still buffered, coarse partial rows included */
+     recorder_drain();
+     for (uint32_t i = 0; i < config.levels; i++) {
+         if (i + 1 < config.levels && levels[i].agg_rows > 0) {
+             levels[i].agg_rows = 0;
+             level_push(i + 1, levels[i].agg);
+         }
+         write_block(i);
+     }
+
+     int result = (fclose(output) == 0) ? 0 : -1;
+     output = NULL;
+
+     LOG_INFO("Recorder stopped (%u samples, %u dropped, %u bytes)",
+              stats.samples, stats.dropped, stats.bytes_written);
+     return result;
+ }
+
+ /**
+  * Get recorder statistics
+  */
+ int recorder_get_stats(recorder_stats_t* out_stats) {
+     if (out_stats == NULL) {
+         LOG_ERROR("NULL stats pointer");
+         return -1;
+     }
+
+     memcpy(out_stats, &stats, sizeof(recorder_stats_t));
+     return 0;
+ }
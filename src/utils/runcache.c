@@ -0,0 +1,294 @@
+/**
+ * @file runcache.c
+ * @brief Implementation of the simulation result cache
+ *
+ * Only the index lives in memory: an open-addressing table from key to
+ * file offset, sized for RUNCACHE_MAX_ENTRIES at half load. Lookups read
+ * the one record they need, and stores append a record and flush it, so
+ * a sweep killed mid-run keeps every result it has finished.
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include "../../include/utils/runcache.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/config.h"
+
+ #define RUNCACHE_MAGIC       "ORRC"
+ #define RUNCACHE_VERSION     1
+ #define INDEX_SLOTS          (2 * RUNCACHE_MAX_ENTRIES)
+
+ #define FNV64_OFFSET         0xcbf29ce484222325ULL
+ #define FNV64_PRIME          0x100000001b3ULL
+
+ /* File header */
+ typedef struct {
+     char magic[4];
+     uint32_t version;
+     uint32_t record_size;        /* Rejects files written with another result layout */
+ } file_header_t;
+
+ /* One stored result */
+ typedef struct {
+     runcache_key_t key;
+     uint32_t check;              /* FNV-1a of key and result */
+     uint32_t reserved;
+     runcache_result_t result;
+ } record_t;
+
+ /* Index slot; offset 0 marks an empty slot (records follow the header) */
+ typedef struct {
+     runcache_key_t key;
+     long offset;
+ } index_slot_t;
+
+ static FILE* file = NULL;
+ static long append_offset;
+ static index_slot_t index_table[INDEX_SLOTS];
+ static runcache_stats_t stats;
+
+ /**
+  * Start a scenario key
+  */
+ void runcache_key_init(runcache_key_t* key) {
+     *key = FNV64_OFFSET;
+ }
+
+ /**
+  * Mix bytes into a scenario key
+  */
+ void runcache_key_add(runcache_key_t* key, const void* data, size_t length) {
+     const uint8_t* p = (const uint8_t*)data;
+     runcache_key_t h = *key;
+
+     for (size_t i = 0; i < length; i++) {
+         h ^= p[i];
+         h *= FNV64_PRIME;
+     }
+
+     *key = h;
+ }
+
+ /**
+  * Mix a 32-bit value into a scenario key, least significant byte first
+  */
+ void runcache_key_add_u32(runcache_key_t* key, uint32_t value) {
+     uint8_t bytes[4];
+
+     bytes[0] = (uint8_t)value;
+     bytes[1] = (uint8_t)(value >> 8);
+     bytes[2] = (uint8_t)(value >> 16);
+     bytes[3] = (uint8_t)(value >> 24);
+     runcache_key_add(key, bytes, sizeof(bytes));
+ }
+
+ /**
+  * Checksum of a record
+  */
+ static uint32_t record_check(const record_t* record) {
+     runcache_key_t h;
+
+     runcache_key_init(&h);
+     runcache_key_add(&h, &record->key, sizeof(record->key));
+     runcache_key_add(&h, &record->result, sizeof(record->result));
+
+     return (uint32_t)(h ^ (h >> 32));
+ }
+
+ /**
+  * Find the index slot of a key, or the empty slot where it belongs
+  */
+ static index_slot_t* index_find(runcache_key_t key) {
+     uint32_t slot = (uint32_t)(key ^ (key >> 32)) & (INDEX_SLOTS - 1);
+
+     while (index_table[slot].offset != 0 && index_table[slot].key != key) {
+         slot = (slot + 1) & (INDEX_SLOTS - 1);
+     }
+
+     return &index_table[slot];
+ }
+
+ /**
+  * Point a key at a record, replacing any earlier record for it
+  */
+ static int index_insert(runcache_key_t key, long offset) {
+     index_slot_t* slot = index_find(key);
+
+     if (slot->offset == 0) {
+         if (stats.entries >= RUNCACHE_MAX_ENTRIES) {
+             return -1;
+         }
+         slot->key = key;
+         stats.entries++;
+     }
+
+     slot->offset = offset;
+     return 0;
+ }
+
+ /**
+  * Index every record in the file and find where the next one goes
+  */
+ static int load_index(void) {
+     record_t record;
+     long offset = (long)sizeof(file_header_t);
+
+     if (fseek(file, offset, SEEK_SET) != 0) {
+         return -1;
+     }
+
+     /* A short read is a torn final record; the next store overwrites it */
+     while (fread(&record, sizeof(record), 1, file) == 1) {
+         if (record.check != record_check(&record)) {
+             stats.dropped++;
+         } else if (index_insert(record.key, offset) != 0) {
+             LOG_WARNING("Result cache index full, ignoring later records");
+             break;
+         }
+         offset += (long)sizeof(record);
+     }
+
+     append_offset = offset;
+     return 0;
+ }
+
+ /**
+  * Open a cache file and index its records
+  */
+ int runcache_open(const char* path) {
+     file_header_t header;
+
+     if (path == NULL || file != NULL) {
+         LOG_ERROR("Invalid cache path or cache already open");
+         return -1;
+     }
+
+     memset(index_table, 0, sizeof(index_table));
+     memset(&stats, 0, sizeof(stats));
+
+     file = fopen(path, "r+b");
+     if (file == NULL) {
+         /* New cache: write the header */
+         file = fopen(path, "w+b");
+         if (file == NULL) {
+             LOG_ERROR("Cannot create result cache %s", path);
+             return -1;
+         }
+
+         memcpy(header.magic, RUNCACHE_MAGIC, sizeof(header.magic));
+         header.version = RUNCACHE_VERSION;
+         header.record_size = (uint32_t)sizeof(record_t);
+         if (fwrite(&header, sizeof(header), 1, file) != 1 || fflush(file) != 0) {
+             LOG_ERROR("Cannot write result cache header to %s", path);
+             runcache_close();
+             return -1;
+         }
+     } else if (fread(&header, sizeof(header), 1, file) != 1 ||
+                memcmp(header.magic, RUNCACHE_MAGIC, sizeof(header.magic)) != 0 ||
+                header.version != RUNCACHE_VERSION ||
+                header.record_size != (uint32_t)sizeof(record_t)) {
+         LOG_ERROR("%s is not a compatible result cache", path);
+         runcache_close();
+         return -1;
+     }
+
+     if (load_index() != 0) {
+         LOG_ERROR("Cannot read result cache %s", path);
+         runcache_close();
+         return -1;
+     }
+
+     LOG_INFO("Result cache %s: %u results (%u corrupt records skipped)",
+              path, stats.entries, stats.dropped);
+     return 0;
+ }
+
+ /**
+  * Look up a stored result
+  */
+ int runcache_lookup(runcache_key_t key, runcache_result_t* result) {
+     record_t record;
+
+     if (file == NULL || result == NULL) {
+         LOG_ERROR("Result cache not open or NULL result");
+         return -1;
+     }
+
+     index_slot_t* slot = index_find(key);
+     if (slot->offset == 0) {
+         stats.misses++;
+         return -1;
+     }
+
+     if (fseek(file, slot->offset, SEEK_SET) != 0 ||
+         fread(&record, sizeof(record), 1, file) != 1 ||
+         record.key != key || record.check != record_check(&record)) {
+         LOG_ERROR("Result cache record at offset %ld is unreadable", slot->offset);
+         stats.misses++;
+         return -1;
+     }
+
+     *result = record.result;
+     stats.hits++;
+     return 0;
+ }
+
+ /**
+  * Store the result of a run
+  */
+ int runcache_store(runcache_key_t key, const runcache_result_t* result) {
+     record_t record;
+
+     if (file == NULL || result == NULL) {
+         LOG_ERROR("Result cache not open or NULL result");
+         return -1;
+     }
+
+     memset(&record, 0, sizeof(record));
+     record.key = key;
+     record.result = *result;
+     record.check = record_check(&record);
+
+     if (fseek(file, append_offset, SEEK_SET) != 0 ||
+         fwrite(&record, sizeof(record), 1, file) != 1 ||
+         fflush(file) != 0) {
+         LOG_ERROR("Cannot append to result cache");
+         return -1;
+     }
+
+     if (index_insert(key, append_offset) != 0) {
+         LOG_ERROR("Result cache index full (%u entries)", RUNCACHE_MAX_ENTRIES);
+         return -1;
+     }
+
+     append_offset += (long)sizeof(record);
+     stats.stores++;
+     return 0;
+ }
+
+ /**
+  * Close the cache file
+  */
+ int runcache_close(void) {
+     if (file == NULL) {
+         return 0;
+     }
+
+     int result = fclose(file);
+     file = NULL;
+
+     return (result == 0) ? 0 : -1;
+ }
+
+ /**
+  * Get cache statistics
+  */
+ int runcache_get_stats(runcache_stats_t* out) {
+     if (out == NULL) {
+         LOG_ERROR("NULL stats pointer");
+         return -1;
+     }
+
+     *out = stats;
+     return 0;
+ }
@@ -0,0 +1,595 @@
+/**
+ * @file sequence.c
+ * @brief Implementation of the stored-sequence engine
+ *
+ * Every sequence is a slot holding its program counter, operand stack,
+ * locals and wake tick. The engine task runs each due slot until it
+ * waits, ends or spends its instruction budget, then sleeps on its
+ * wakeup semaphore until the earliest wake tick. Loading a sequence
+ * gives the semaphore so new work starts without waiting out a sleep.
+ */
+
+ #include <string.h>
+ #include "../../include/utils/sequence.h"
+ #include "../../include/utils/logger.h"
+ #include "../../include/kernel/context.h"
+ #include "../../include/kernel/ipc.h"
+ #include "../../include/kernel/task.h"
+ #include "../../include/kernel/time.h"
+ #include "../../include/config.h"
+
+ /* Threaded dispatch needs GCC's labels-as-values */
+ #ifdef __GNUC__
+ #define SEQ_THREADED 1
+ #else
+ #define SEQ_THREADED 0
+ #endif
+
+ /* Sequence slot */
+ typedef struct {
+     const uint8_t* code;         /* Verified program */
+     uint32_t length;             /* Program length */
+     uint32_t pc;                 /* Next instruction */
+     uint32_t wake_tick;          /* Tick the sequence next runs at */
+     int32_t stack[SEQ_STACK_DEPTH];
+     int32_t locals[SEQ_LOCALS];
+     uint32_t commands;           /* Commands issued */
+     uint32_t instructions;       /* Instructions executed */
+     uint16_t generation;         /* Upper half of the handle */
+     uint8_t sp;                  /* Operand stack depth */
+     volatile uint8_t state;      /* seq_state_t */
+ } seq_slot_t;
+
+ /* Operand bytes and stack effect of each opcode */
+ typedef struct {
+     uint8_t size;                /* Instruction length including opcode */
+     uint8_t pops;                /* Stack entries consumed */
+     uint8_t pushes;              /* Stack entries produced */
+ } seq_opinfo_t;
+
+ static const seq_opinfo_t opinfo[SEQ_OPCODE_COUNT] = {
+     [SEQ_END]    = { 1, 0, 0 },
+     [SEQ_PUSH8]  = { 2, 0, 1 },
+     [SEQ_PUSH32] = { 5, 0, 1 },
+     [SEQ_POP]    = { 1, 1, 0 },
+     [SEQ_DUP]    = { 1, 1, 2 },
+     [SEQ_LOAD]   = { 2, 0, 1 },
+     [SEQ_STORE]  = { 2, 1, 0 },
+     [SEQ_TLM]    = { 3, 0, 1 },
+     [SEQ_ADD]    = { 1, 2, 1 },
+     [SEQ_SUB]    = { 1, 2, 1 },
+     [SEQ_LT]     = { 1, 2, 1 },
+     [SEQ_GT]     = { 1, 2, 1 },
+     [SEQ_EQ]     = { 1, 2, 1 },
+     [SEQ_NOT]    = { 1, 1, 1 },
+     [SEQ_AND]    = { 1, 2, 1 },
+     [SEQ_OR]     = { 1, 2, 1 },
+     [SEQ_JMP]    = { 3, 0, 0 },
+     [SEQ_JZ]     = { 3, 1, 0 },
+     [SEQ_JNZ]    = { 3, 1, 0 },
+     [SEQ_LOOP]   = { 4, 0, 0 },
+     [SEQ_WAIT]   = { 5, 0, 0 },
+     [SEQ_WAITS]  = { 1, 1, 0 },
+     [SEQ_CMD]    = { 2, 1, 0 },
+ };
+
+ /* Engine state */
+ static seq_engine_config_t config;
+ static seq_slot_t slots[SEQ_MAX_SEQUENCES];
+ static volatile uint32_t slot_limit = 0;   /* One past the highest slot ever used */
+ static volatile int32_t running_slot = -1;  /* Slot the engine is executing */
+ static seq_engine_stats_t stats;
+ static uint8_t initialized = 0;
+
+ static semaphore_t* wakeup = NULL;
+ static task_t* engine = NULL;
+
+ /* Verifier scratch, guarded by load_lock */
+ static mutex_t* load_lock = NULL;
+ static int8_t depth_at[SEQ_MAX_CODE];
+ static uint16_t worklist[SEQ_MAX_CODE];
+
+ #define DEPTH_NOT_START  (-2)     /* Byte is inside an instruction */
+ #define DEPTH_UNSEEN     (-1)     /* Instruction not reached yet */
+
+ /**
+  * Read a little-endian 16-bit operand
+  */
+ static inline uint16_t rd16(const uint8_t* p) {
+     return (uint16_t)(p[0] | (p[1] << 8));
+ }
+
+ /**
+  * Read a little-endian 32-bit operand
+  */
+ static inline uint32_t rd32(const uint8_t* p) {
+     return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+ }
+
+ /**
+  * Record the stack depth at a branch target or fall-through
+  */
+ static int verify_edge(uint32_t target, uint32_t length, int8_t depth, uint32_t* pending) {
+     if (target >= length || depth_at[target] == DEPTH_NOT_START) {
+         LOG_ERROR("Sequence jumps to %u, not an instruction", target);
+         return -1;
+     }
+
+     if (depth_at[target] == DEPTH_UNSEEN) {
+         depth_at[target] = depth;
+         worklist[(*pending)++] = (uint16_t)target;
+     } else if (depth_at[target] != depth) {
+         LOG_ERROR("Sequence stack depth differs at %u (%d vs %d)", target, depth_at[target], depth);
+         return -1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Check a program so it can run without runtime checks
+  * Every reachable instruction must be well formed, every jump must land
+  * on an instruction, and the stack depth at each instruction must be the
+  * same on every path and stay within SEQ_STACK_DEPTH.
+  */
+ static int verify(const uint8_t* code, uint32_t length) {
+     uint32_t pc;
+     uint32_t pending = 0;
+
+     /* Mark instruction starts and check opcodes and operands */
+     memset(depth_at, DEPTH_NOT_START, length);
+     for (pc = 0; pc < length; pc += opinfo[code[pc]].size) {
+         uint8_t op = code[pc];
+
+         if (op >= SEQ_OPCODE_COUNT) {
+             LOG_ERROR("Invalid sequence opcode %u at %u", op, pc);
+             return -1;
+         }
+         if (pc + opinfo[op].size > length) {
+             LOG_ERROR("Truncated sequence instruction at %u", pc);
+             return -1;
+         }
+         if ((op == SEQ_LOAD || op == SEQ_STORE || op == SEQ_LOOP) && code[pc + 1] >= SEQ_LOCALS) {
+             LOG_ERROR("Sequence local %u out of range at %u", code[pc + 1], pc);
+             return -1;
+         }
+         depth_at[pc] = DEPTH_UNSEEN;
+     }
+
+     /* Propagate stack depth along every path from the entry */
+     depth_at[0] = 0;
+     worklist[pending++] = 0;
+     while (pending > 0) {
+         pc = worklist[--pending];
+
+         uint8_t op = code[pc];
+         const seq_opinfo_t* info = &opinfo[op];
+         int8_t depth = depth_at[pc];
+         uint32_t next = pc + info->size;
+
+         if (depth < info->pops) {
+             LOG_ERROR("Sequence stack underflow at %u", pc);
+             return -1;
+         }
+         depth = (int8_t)(depth - info->pops + info->pushes);
+         if (depth > SEQ_STACK_DEPTH) {
+             LOG_ERROR("Sequence stack overflow at %u", pc);
+             return -1;
+         }
+
+         if (op == SEQ_JMP || op == SEQ_JZ || op == SEQ_JNZ || op == SEQ_LOOP) {
+             int16_t offset = (int16_t)rd16(&code[next - 2]);
+             if (verify_edge((uint32_t)((int32_t)next + offset), length, depth, &pending) != 0) {
+                 return -1;
+             }
+         }
+         if (op != SEQ_END && op != SEQ_JMP) {
+             if (next >= length) {
+                 LOG_ERROR("Sequence runs past its end at %u", pc);
+                 return -1;
+             }
+             if (verify_edge(next, length, depth, &pending) != 0) {
+                 return -1;
+             }
+         }
+     }
+
+     return 0;
+ }
+
+ /**
+  * Run one sequence until it waits, ends, faults or spends its budget
+  * The program has been verified, so no opcode, operand, jump or stack
+  * check is needed here.
+  */
+ static void run_slot(seq_slot_t* slot, uint32_t now) {
+     const uint8_t* code = slot->code;
+     uint32_t pc = slot->pc;
+     int32_t* stack = slot->stack;
+     int32_t* locals = slot->locals;
+     uint32_t sp = slot->sp;
+     uint32_t budget = SEQ_BUDGET;
+     uint8_t state = SEQ_STATE_READY;
+     uint32_t wake = now + 1;
+     int32_t a;
+
+ #if SEQ_THREADED
+     static const void* const labels[SEQ_OPCODE_COUNT] = {
+         [SEQ_END] = &&op_END, [SEQ_PUSH8] = &&op_PUSH8, [SEQ_PUSH32] = &&op_PUSH32,
+         [SEQ_POP] = &&op_POP, [SEQ_DUP] = &&op_DUP, [SEQ_LOAD] = &&op_LOAD,
+         [SEQ_STORE] = &&op_STORE, [SEQ_TLM] = &&op_TLM, [SEQ_ADD] = &&op_ADD,
+         [SEQ_SUB] = &&op_SUB, [SEQ_LT] = &&op_LT, [SEQ_GT] = &&op_GT, [SEQ_EQ] = &&op_EQ,
+         [SEQ_NOT] = &&op_NOT, [SEQ_AND] = &&op_AND, [SEQ_OR] = &&op_OR,
+         [SEQ_JMP] = &&op_JMP, [SEQ_JZ] = &&op_JZ, [SEQ_JNZ] = &&op_JNZ,
+         [SEQ_LOOP] = &&op_LOOP, [SEQ_WAIT] = &&op_WAIT, [SEQ_WAITS] = &&op_WAITS,
+         [SEQ_CMD] = &&op_CMD,
+     };
+     #define OP(name)    op_##name:
+     #define NEXT(n)     do { pc += (n); if (--budget == 0) goto yield; goto *labels[code[pc]]; } while (0)
+     #define DISPATCH()  goto *labels[code[pc]];
+ #else
+     #define OP(name)    case SEQ_##name:
+     #define NEXT(n)     do { pc += (n); if (--budget == 0) goto yield; goto dispatch; } while (0)
+     #define DISPATCH()  dispatch: switch (code[pc])
+ #endif
+     #define JUMP(n, taken) NEXT((taken) ? (n) + (int16_t)rd16(&code[pc + (n) - 2]) : (n))
+
+     DISPATCH() {
+     OP(END)
+         state = SEQ_STATE_DONE;
+         goto out_counted;
+     OP(PUSH8)
+         stack[sp++] = (int8_t)code[pc + 1];
+         NEXT(2);
+     OP(PUSH32)
+         stack[sp++] = (int32_t)rd32(&code[pc + 1]);
+         NEXT(5);
+     OP(POP)
+         sp--;
+         NEXT(1);
+     OP(DUP)
+         stack[sp] = stack[sp - 1];
+         sp++;
+         NEXT(1);
+     OP(LOAD)
+         stack[sp++] = locals[code[pc + 1]];
+         NEXT(2);
+     OP(STORE)
+         locals[code[pc + 1]] = stack[--sp];
+         NEXT(2);
+     OP(TLM)
+         stack[sp++] = config.telemetry(rd16(&code[pc + 1]), config.ctx);
+         NEXT(3);
+     OP(ADD)
+         sp--;
+         stack[sp - 1] = (int32_t)((uint32_t)stack[sp - 1] + (uint32_t)stack[sp]);
+         NEXT(1);
+     OP(SUB)
+         sp--;
+         stack[sp - 1] = (int32_t)((uint32_t)stack[sp - 1] - (uint32_t)stack[sp]);
+         NEXT(1);
+     OP(LT)
+         sp--;
+         stack[sp - 1] = stack[sp - 1] < stack[sp];
+         NEXT(1);
+     OP(GT)
+         sp--;
+         stack[sp - 1] = stack[sp - 1] > stack[sp];
+         NEXT(1);
+     OP(EQ)
+         sp--;
+         stack[sp - 1] = stack[sp - 1] == stack[sp];
+         NEXT(1);
+     OP(NOT)
+         stack[sp - 1] = !stack[sp - 1];
+         NEXT(1);
+     OP(AND)
+         sp--;
+         stack[sp - 1] = stack[sp - 1] && stack[sp];
+         NEXT(1);
+     OP(OR)
+         sp--;
+         stack[sp - 1] = stack[sp - 1] || stack[sp];
+         NEXT(1);
+     OP(JMP)
+         JUMP(3, 1);
+     OP(JZ)
+         a = stack[--sp];
+         JUMP(3, a == 0);
+     OP(JNZ)
+         a = stack[--sp];
+         JUMP(3, a != 0);
+     OP(LOOP)
+         a = --locals[code[pc + 1]];
+         JUMP(4, a > 0);
+     OP(WAIT)
+         a = (int32_t)rd32(&code[pc + 1]);
+         pc += 5;
+         wake = now + (a > 0 ? (uint32_t)a : 1);
+         goto out_counted;
+     OP(WAITS)
+         a = stack[--sp];
+         pc += 1;
+         wake = now + (a > 0 ? (uint32_t)a : 1);
+         goto out_counted;
+     OP(CMD)
+         a = stack[--sp];
+         if (config.command(code[pc + 1], a, config.ctx) != 0) {
+             LOG_WARNING("Sequence command %u rejected at %u", code[pc + 1], pc);
+             state = SEQ_STATE_FAULT;
+             goto out_counted;
+         }
+         slot->commands++;
+         NEXT(2);
+     }
+
+     #undef OP
+     #undef NEXT
+     #undef DISPATCH
+     #undef JUMP
+
+ yield:
+     /* Budget spent: resume on the next tick */
+     goto out;
+ out_counted:
+     budget--;
+ out:
+     slot->instructions += SEQ_BUDGET - budget;
+     stats.instructions += SEQ_BUDGET - budget;
+     slot->pc = pc;
+     slot->sp = (uint8_t)sp;
+     slot->wake_tick = wake;
+
+     /* A concurrent seq_stop() wins over the result of this turn */
+     uint32_t prev_state = context_enter_critical();
+     if (slot->state == SEQ_STATE_READY) {
+         slot->state = state;
+         if (state == SEQ_STATE_DONE) {
+             stats.completed++;
+         } else if (state == SEQ_STATE_FAULT) {
+             stats.faults++;
+         }
+     }
+     context_exit_critical(prev_state);
+ }
+
+ /**
+  * Sequence engine task
+  */
+ static void seq_engine_task(void* arg) {
+     (void)arg;
+
+     while (1) {
+         uint32_t delay = seq_engine_run(time_get_ticks());
+         semaphore_take(wakeup, delay);
+     }
+ }
+
+ /**
+  * Initialize the sequence engine
+  */
+ int seq_engine_init(const seq_engine_config_t* cfg) {
+     if (cfg == NULL || cfg->telemetry == NULL || cfg->command == NULL) {
+         LOG_ERROR("Invalid sequence engine configuration");
+         return -1;
+     }
+
+     if (initialized) {
+         LOG_ERROR("Sequence engine already initialized");
+         return -1;
+     }
+
+     load_lock = mutex_create("seq_load");
+     if (load_lock == NULL) {
+         LOG_ERROR("Failed to create sequence load lock");
+         return -1;
+     }
+
+     config = *cfg;
+     memset(slots, 0, sizeof(slots));
+     memset(&stats, 0, sizeof(stats));
+     slot_limit = 0;
+     initialized = 1;
+
+     LOG_INFO("Sequence engine initialized (%u slots)", SEQ_MAX_SEQUENCES);
+     return 0;
+ }
+
+ /**
+  * Create the engine task and wakeup semaphore
+  */
+ int seq_engine_start(void) {
+     if (!initialized || engine != NULL) {
+         LOG_ERROR("Sequence engine not initialized or already running");
+         return -1;
+     }
+
+     wakeup = semaphore_create("sequencer", 0, 1);
+     engine = (wakeup != NULL) ?
+              task_create("sequencer", config.priority, seq_engine_task, NULL, DEFAULT_STACK_SIZE) : NULL;
+     if (engine == NULL) {
+         LOG_ERROR("Failed to create sequence engine task");
+         return -1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Verify and start a sequence
+  */
+ int seq_load(const uint8_t* code, uint32_t length, uint32_t* handle) {
+     if (!initialized || code == NULL || length == 0 || length > SEQ_MAX_CODE) {
+         LOG_ERROR("Invalid sequence (engine initialized: %u, length %u)", initialized, length);
+         return -1;
+     }
+
+     mutex_lock(load_lock, MAX_TIMEOUT);
+     int result = verify(code, length);
+     mutex_unlock(load_lock);
+     if (result != 0) {
+         return -1;
+     }
+
+     /* Prefer never-used slots so finished sequences stay readable longest */
+     uint32_t prev_state = context_enter_critical();
+     int index = -1;
+     for (int i = 0; i < SEQ_MAX_SEQUENCES; i++) {
+         if (i == running_slot) {
+             continue;
+         }
+         if (slots[i].state == SEQ_STATE_FREE) {
+             index = i;
+             break;
+         }
+         if (index < 0 && slots[i].state != SEQ_STATE_READY) {
+             index = i;
+         }
+     }
+     if (index < 0) {
+         context_exit_critical(prev_state);
+         LOG_ERROR("No free sequence slots");
+         return -1;
+     }
+
+     seq_slot_t* slot = &slots[index];
+     uint16_t generation = (uint16_t)(slot->generation + 1);
+     memset(slot, 0, sizeof(seq_slot_t));
+     slot->code = code;
+     slot->length = length;
+     slot->wake_tick = time_get_ticks();
+     slot->generation = generation ? generation : 1;
+     slot->state = SEQ_STATE_READY;
+     if ((uint32_t)index >= slot_limit) {
+         slot_limit = (uint32_t)index + 1;
+     }
+     stats.loaded++;
+     context_exit_critical(prev_state);
+
+     if (handle != NULL) {
+         *handle = ((uint32_t)slot->generation << 16) | (uint32_t)index;
+     }
+
+     if (wakeup != NULL) {
+         semaphore_give(wakeup);
+     }
+
+     LOG_DEBUG("Loaded sequence %d (%u bytes)", index, length);
+     return 0;
+ }
+
+ /**
+  * Find the slot named by a handle
+  */
+ static seq_slot_t* find_slot(uint32_t handle) {
+     uint32_t index = handle & 0xFFFF;
+
+     if (!initialized || index >= SEQ_MAX_SEQUENCES ||
+         slots[index].generation != (uint16_t)(handle >> 16) ||
+         slots[index].state == SEQ_STATE_FREE) {
+         return NULL;
+     }
+
+     return &slots[index];
+ }
+
+ /**
+  * Stop a running sequence
+  */
+ int seq_stop(uint32_t handle) {
+     uint32_t prev_state = context_enter_critical();
+
+     seq_slot_t* slot = find_slot(handle);
+     if (slot == NULL || slot->state != SEQ_STATE_READY) {
+         context_exit_critical(prev_state);
+         LOG_ERROR("Sequence %08x is not running", handle);
+         return -1;
+     }
+     slot->state = SEQ_STATE_STOPPED;
+
+     context_exit_critical(prev_state);
+     return 0;
+ }
+
+ /**
+  * Get the status of a sequence
+  */
+ int seq_get_status(uint32_t handle, seq_status_t* status) {
+     if (status == NULL) {
+         LOG_ERROR("NULL status pointer");
+         return -1;
+     }
+
+     uint32_t prev_state = context_enter_critical();
+
+     seq_slot_t* slot = find_slot(handle);
+     if (slot == NULL) {
+         context_exit_critical(prev_state);
+         return -1;
+     }
+     status->state = (seq_state_t)slot->state;
+     status->pc = slot->pc;
+     status->wake_tick = slot->wake_tick;
+     status->commands = slot->commands;
+     status->instructions = slot->instructions;
+
+     context_exit_critical(prev_state);
+     return 0;
+ }
+
+ /**
+  * Run every due sequence once
+  */
+ uint32_t seq_engine_run(uint32_t now) {
+     uint32_t next = MAX_TIMEOUT;
+     uint32_t limit = slot_limit;
+
+     stats.turns++;
+
+     for (uint32_t i = 0; i < limit; i++) {
+         seq_slot_t* slot = &slots[i];
+
+         if (slot->state != SEQ_STATE_READY) {
+             continue;
+         }
+         if ((int32_t)(now - slot->wake_tick) >= 0) {
+             /* Keep seq_load() from recycling the slot while it runs */
+             running_slot = (int32_t)i;
+             run_slot(slot, now);
+             running_slot = -1;
+             if (slot->state != SEQ_STATE_READY) {
+                 continue;
+             }
+         }
+
+         uint32_t remaining = slot->wake_tick - now;
+         if ((int32_t)remaining <= 0) {
+             remaining = 1;
+         }
+         if (remaining < next) {
+             next = remaining;
+         }
+     }
+
+     return next;
+ }
+
+ /**
+  * Get engine statistics
+  */
+ int seq_engine_get_stats(seq_engine_stats_t* out) {
+     if (out == NULL) {
+         LOG_ERROR("NULL stats pointer");
+         return -1;
+     }
+
+     *out = stats;
+     out->active = 0;
+     for (uint32_t i = 0; i < slot_limit; i++) {
+         if (slots[i].state == SEQ_STATE_READY) {
+             out->active++;
+         }
+     }
+
+     return 0;
+ }
@@ -0,0 +1,440 @@
+/**
+ * @file tmcodec.c
+ * @brief Implementation of the housekeeping telemetry codec
+ *
+ * Block: [flags][varint raw length][payload]. The payload is either the
+ * delta-coded frames as they are or, with TMCODEC_FLAG_LZ set in flags,
+ * their LZ77 encoding. A block is stored without LZ whenever LZ would
+ * not make it smaller.
+ *
+ * Frame: varint zigzag tick delta, varint valid mask XOR the previous
+ * mask, then one varint per valid field: zigzag delta for integers, and
+ * for floats the XOR with the previous bits shifted right by its whole
+ * trailing zero bytes, with that byte count in the low two bits.
+ *
+ * LZ sequence: token (literal count << 4 | match length - 4, 15 meaning
+ * more in 255-continued bytes), literals, then a 16-bit little-endian
+ * offset and the match. The last sequence is literals only.
+ */
+
+ #include <string.h>
+ #include "../../include/utils/tmcodec.h"
+ #include "../../include/utils/varint.h"
+
+ /* Largest frame: tick and mask, then every field at 5 bytes */
+ #define FRAME_MAX_BYTES  (10 + 5 * TMCODEC_MAX_FIELDS)
+ #define LZ_MIN_MATCH     4
+
+ /**
+  * Restart prediction (at every block boundary)
+  */
+ static void model_reset(tmcodec_model_t* model) {
+     memset(model->prev, 0, sizeof(model->prev));
+     model->prev_tick = 0;
+     model->prev_valid = 0;
+ }
+
+ /**
+  * Set up the field predictors
+  */
+ static int model_init(tmcodec_model_t* model, const uint8_t* types, uint8_t count) {
+     if (types == NULL || count == 0 || count > TMCODEC_MAX_FIELDS) {
+         return -1;
+     }
+
+     for (uint8_t i = 0; i < count; i++) {
+         if (types[i] != TMCODEC_FIELD_INT && types[i] != TMCODEC_FIELD_FLOAT) {
+             return -1;
+         }
+         model->types[i] = types[i];
+     }
+     model->count = count;
+     model_reset(model);
+
+     return 0;
+ }
+
+ /**
+  * Append a sequence length continuation (the token held 15 of it)
+  */
+ static uint32_t lz_put_length(uint8_t* out, uint32_t length) {
+     uint32_t n = 0;
+
+     while (length >= 255) {
+         out[n++] = 255;
+         length -= 255;
+     }
+     out[n++] = (uint8_t)length;
+
+     return n;
+ }
+
+ /**
+  * Append one LZ sequence, failing if it would reach the capacity
+  */
+ static int lz_put_sequence(uint8_t* out, uint32_t* op, uint32_t capacity,
+                            const uint8_t* literals, uint32_t literal_count,
+                            uint32_t offset, uint32_t match_length) {
+     uint32_t match_code = match_length ? match_length - LZ_MIN_MATCH : 0;
+     uint32_t worst = 1 + literal_count + literal_count / 255 + 1 + 2 + match_code / 255 + 1;
+
+     if (*op + worst >= capacity) {
+         return -1;
+     }
+
+     uint8_t* token = &out[(*op)++];
+     *token = (uint8_t)((literal_count < 15 ? literal_count : 15) << 4);
+     if (literal_count >= 15) {
+         *op += lz_put_length(&out[*op], literal_count - 15);
+     }
+     memcpy(&out[*op], literals, literal_count);
+     *op += literal_count;
+
+     if (match_length > 0) {
+         out[(*op)++] = (uint8_t)(offset & 0xFF);
+         out[(*op)++] = (uint8_t)(offset >> 8);
+         *token |= (uint8_t)(match_code < 15 ? match_code : 15);
+         if (match_code >= 15) {
+             *op += lz_put_length(&out[*op], match_code - 15);
+         }
+     }
+
+     return 0;
+ }
+
+ /**
+  * Read 4 bytes for match finding
+  */
+ static uint32_t read32(const uint8_t* p) {
+     uint32_t v;
+     memcpy(&v, p, sizeof(v));
+     return v;
+ }
+
+ /**
+  * LZ-compress a block
+  * Returns the compressed size, or 0 if it would not be smaller than
+  * the input.
+  */
+ static uint32_t lz_compress(tmcodec_encoder_t* enc, const uint8_t* in, uint32_t length,
+                             uint8_t* out, uint32_t capacity) {
+     uint32_t ip = 0;
+     uint32_t anchor = 0;
+     uint32_t op = 0;
+
+     /* Table holds position + 1 so zero means empty */
+     memset(enc->hash, 0, sizeof(enc->hash));
+
+     while (ip + LZ_MIN_MATCH <= length) {
+         uint32_t sequence = read32(&in[ip]);
+         uint32_t h = (sequence * 2654435761u) >> (32 - TMCODEC_LZ_HASH_BITS);
+         uint32_t candidate = enc->hash[h];
+         enc->hash[h] = (uint16_t)(ip + 1);
+
+         if (candidate == 0 || read32(&in[candidate - 1]) != sequence) {
+             ip++;
+             continue;
+         }
+
+         uint32_t ref = candidate - 1;
+         uint32_t match = LZ_MIN_MATCH;
+         while (ip + match < length && in[ref + match] == in[ip + match]) {
+             match++;
+         }
+
+         if (lz_put_sequence(out, &op, capacity, &in[anchor], ip - anchor, ip - ref, match) != 0) {
+             return 0;
+         }
+         ip += match;
+         anchor = ip;
+     }
+
+     if (anchor < length &&
+         lz_put_sequence(out, &op, capacity, &in[anchor], length - anchor, 0, 0) != 0) {
+         return 0;
+     }
+
+     return op;
+ }
+
+ /**
+  * Read a sequence length continuation
+  */
+ static int lz_get_length(const uint8_t* in, uint32_t length, uint32_t* ip, uint32_t* value) {
+     uint8_t byte;
+
+     do {
+         if (*ip >= length) {
+             return -1;
+         }
+         byte = in[(*ip)++];
+         *value += byte;
+     } while (byte == 255);
+
+     return 0;
+ }
+
+ /**
+  * LZ-decompress a block, checking every bound
+  */
+ static int lz_decompress(const uint8_t* in, uint32_t length, uint8_t* out, uint32_t out_length) {
+     uint32_t ip = 0;
+     uint32_t op = 0;
+
+     while (op < out_length) {
+         if (ip >= length) {
+             return -1;
+         }
+         uint8_t token = in[ip++];
+
+         uint32_t literals = token >> 4;
+         if (literals == 15 && lz_get_length(in, length, &ip, &literals) != 0) {
+             return -1;
+         }
+         if (literals > length - ip || literals > out_length - op) {
+             return -1;
+         }
+         memcpy(&out[op], &in[ip], literals);
+         ip += literals;
+         op += literals;
+
+         if (op == out_length) {
+             break;
+         }
+
+         if (ip + 2 > length) {
+             return -1;
+         }
+         uint32_t offset = (uint32_t)in[ip] | ((uint32_t)in[ip + 1] << 8);
+         ip += 2;
+
+         uint32_t match = token & 0x0F;
+         if (match == 15 && lz_get_length(in, length, &ip, &match) != 0) {
+             return -1;
+         }
+         match += LZ_MIN_MATCH;
+         if (offset == 0 || offset > op || match > out_length - op) {
+             return -1;
+         }
+
+         /* Byte copy: the match may overlap its own output */
+         for (uint32_t i = 0; i < match; i++, op++) {
+             out[op] = out[op - offset];
+         }
+     }
+
+     return (ip == length) ? 0 : -1;
+ }
+
+ /**
+  * Initialize an encoder
+  */
+ int tmcodec_encoder_init(tmcodec_encoder_t* enc, const uint8_t* types, uint8_t count,
+                          uint8_t flags, tmcodec_sink_fn sink, void* ctx) {
+     if (enc == NULL || sink == NULL) {
+         return -1;
+     }
+
+     memset(enc, 0, sizeof(tmcodec_encoder_t));
+     if (model_init(&enc->model, types, count) != 0) {
+         return -1;
+     }
+     enc->flags = flags;
+     enc->sink = sink;
+     enc->ctx = ctx;
+
+     return 0;
+ }
+
+ /**
+  * Emit the current block
+  */
+ int tmcodec_flush(tmcodec_encoder_t* enc) {
+     if (enc == NULL) {
+         return -1;
+     }
+
+     if (enc->length == 0) {
+         return 0;
+     }
+
+     uint32_t header = 1 + varint_put(&enc->out[1], enc->length);
+     uint32_t payload = 0;
+     enc->out[0] = 0;
+
+     if (enc->flags & TMCODEC_FLAG_LZ) {
+         payload = lz_compress(enc, enc->block, enc->length, &enc->out[header],
+                               enc->length);
+         if (payload > 0) {
+             enc->out[0] = TMCODEC_FLAG_LZ;
+             enc->stats.lz_blocks++;
+         }
+     }
+     if (payload == 0) {
+         memcpy(&enc->out[header], enc->block, enc->length);
+         payload = enc->length;
+     }
+
+     enc->stats.blocks++;
+     enc->stats.output_bytes += header + payload;
+
+     /* The next block decodes on its own */
+     enc->length = 0;
+     model_reset(&enc->model);
+
+     return enc->sink(enc->out, header + payload, enc->ctx);
+ }
+
+ /**
+  * Encode one frame
+  */
+ int tmcodec_encode(tmcodec_encoder_t* enc, uint32_t tick, const uint32_t* values, uint32_t valid) {
+     if (enc == NULL || values == NULL) {
+         return -1;
+     }
+
+     if (enc->length + FRAME_MAX_BYTES > TMCODEC_BLOCK_SIZE && tmcodec_flush(enc) != 0) {
+         return -1;
+     }
+
+     tmcodec_model_t* model = &enc->model;
+     uint8_t* out = &enc->block[enc->length];
+     uint32_t n = 0;
+     uint32_t fields = 0;
+
+     if (model->count < 32) {
+         valid &= (1u << model->count) - 1;
+     }
+
+     n += varint_put(&out[n], varint_zigzag((int32_t)(tick - model->prev_tick)));
+     n += varint_put(&out[n], valid ^ model->prev_valid);
+
+     for (uint32_t i = 0; i < model->count; i++) {
+         if ((valid & (1u << i)) == 0) {
+             continue;
+         }
+
+         if (model->types[i] == TMCODEC_FIELD_FLOAT) {
+             uint32_t x = values[i] ^ model->prev[i];
+             uint32_t shift = 0;
+             while (shift < 3 && x != 0 && (x & 0xFF) == 0) {
+                 x >>= 8;
+                 shift++;
+             }
+             n += varint_put(&out[n], ((uint64_t)x << 2) | shift);
+         } else {
+             n += varint_put(&out[n], varint_zigzag((int32_t)(values[i] - model->prev[i])));
+         }
+
+         model->prev[i] = values[i];
+         fields++;
+     }
+
+     model->prev_tick = tick;
+     model->prev_valid = valid;
+     enc->length += n;
+
+     enc->stats.frames++;
+     enc->stats.input_bytes += 4 * (1 + fields);
+     enc->stats.coded_bytes += n;
+
+     return 0;
+ }
+
+ /**
+  * Get encoder statistics
+  */
+ int tmcodec_get_stats(tmcodec_encoder_t* enc, tmcodec_stats_t* stats) {
+     if (enc == NULL || stats == NULL) {
+         return -1;
+     }
+
+     *stats = enc->stats;
+     return 0;
+ }
+
+ /**
+  * Initialize a decoder
+  */
+ int tmcodec_decoder_init(tmcodec_decoder_t* dec, const uint8_t* types, uint8_t count) {
+     if (dec == NULL) {
+         return -1;
+     }
+
+     memset(dec, 0, sizeof(tmcodec_decoder_t));
+     return model_init(&dec->model, types, count);
+ }
+
+ /**
+  * Decode one block
+  */
+ int tmcodec_decode(tmcodec_decoder_t* dec, const uint8_t* block, uint32_t length,
+                    tmcodec_frame_fn frame, void* ctx) {
+     uint32_t pos = 1;
+     uint64_t raw_length;
+     const uint8_t* raw;
+
+     if (dec == NULL || block == NULL || length < 2 || frame == NULL) {
+         return -1;
+     }
+
+     if ((block[0] & ~TMCODEC_FLAG_LZ) != 0 ||
+         varint_get(block, length, &pos, &raw_length) != 0 ||
+         raw_length == 0 || raw_length > TMCODEC_BLOCK_SIZE) {
+         return -1;
+     }
+
+     if (block[0] & TMCODEC_FLAG_LZ) {
+         if (lz_decompress(&block[pos], length - pos, dec->block, (uint32_t)raw_length) != 0) {
+             return -1;
+         }
+         raw = dec->block;
+     } else {
+         if (length - pos != raw_length) {
+             return -1;
+         }
+         raw = &block[pos];
+     }
+
+     tmcodec_model_t* model = &dec->model;
+     uint32_t values[TMCODEC_MAX_FIELDS];
+     uint32_t count = 0;
+     uint32_t rp = 0;
+
+     model_reset(model);
+
+     while (rp < raw_length) {
+         uint64_t v;
+
+         if (varint_get(raw, (uint32_t)raw_length, &rp, &v) != 0) {
+             return -1;
+         }
+         uint32_t tick = model->prev_tick + (uint32_t)varint_unzigzag((uint32_t)v);
+
+         if (varint_get(raw, (uint32_t)raw_length, &rp, &v) != 0) {
+             return -1;
+         }
+         uint32_t valid = model->prev_valid ^ (uint32_t)v;
+
+         for (uint32_t i = 0; i < model->count; i++) {
+             if (valid & (1u << i)) {
+                 if (varint_get(raw, (uint32_t)raw_length, &rp, &v) != 0) {
+                     return -1;
+                 }
+                 if (model->types[i] == TMCODEC_FIELD_FLOAT) {
+                     model->prev[i] ^= (uint32_t)((v >> 2) << (8 * (v & 3)));
+                 } else {
+                     model->prev[i] += (uint32_t)varint_unzigzag((uint32_t)v);
+                 }
+             }
+             values[i] = model->prev[i];
+         }
+
+         model->prev_tick = tick;
+         model->prev_valid = valid;
+         frame(tick, values, valid, ctx);
+         count++;
+     }
+
+     return (int)count;
+ }
@@ -0,0 +1,326 @@
+/**
+ * @file ovh_calibrate.c
+ * @brief Calibrate the kernel overhead model (kernel/overhead.h)
+ *
+ * Times the host mechanisms behind each charged kernel operation
+ * (setjmp/longjmp for a context switch, a critical section and a scan of
+ * the task table for a tick, a ring-buffer copy for a queue operation, a
+ * compare-and-swap for a semaphore, an owner update for a mutex) and
+ * reads the target's costs from measurements taken on hardware: a CSV
+ * file of "op,value" samples, in nanoseconds or, with -f, in CPU cycles
+ * at the given clock. Each target cost is a quantile of its samples (the
+ * maximum by default, for worst-case runs).
+ *
+ * The result is a model file for the simulator's -o option. Operations
+ * without target samples keep their host cost and are not charged.
+ *
+ * Usage: ovh_calibrate [-i target.csv] [-f mhz] [-q quantile] [-n iterations] [-o model-file]
+ */
+
+ #define _POSIX_C_SOURCE 200809L
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <unistd.h>
+ #include <time.h>
+ #include <setjmp.h>
+ #include "config.h"
+ #include "kernel/overhead.h"
+
+ #define DEFAULT_ITERATIONS   1000000
+ #define ROUNDS               7
+ #define QUEUE_MSG_SIZE       16
+ #define QUEUE_LENGTH         32
+ #define MAX_LINE             256
+
+ /* Target samples of one operation */
+ typedef struct {
+     double* values;              /* Nanoseconds */
+     uint32_t count;
+     uint32_t capacity;
+ } samples_t;
+
+ /* Stand-in for the kernel state the host paths touch */
+ typedef struct {
+     uint32_t release;
+     uint8_t state;
+ } bench_task_t;
+
+ static const char* const op_names[OVH_OP_COUNT] = OVERHEAD_OP_NAMES;
+
+ static volatile uint32_t critical_count;
+ static volatile uint32_t sink;
+ static bench_task_t task_table[MAX_TASKS];
+ static uint8_t ring[QUEUE_LENGTH * QUEUE_MSG_SIZE];
+ static uint32_t ring_head;
+ static uint32_t ring_tail;
+ static uint32_t sem_count;
+ static volatile uint32_t mutex_owner;
+ static jmp_buf switch_env;
+
+ /**
+  * Monotonic time in nanoseconds
+  */
+ static double now_ns(void) {
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+ }
+
+ /**
+  * Simulated critical section, as in context_enter_critical()
+  */
+ static void critical_enter(void) {
+     critical_count++;
+ }
+
+ static void critical_exit(void) {
+     critical_count--;
+ }
+
+ /**
+  * Host path of each operation
+  */
+ static void host_op(int op, uint32_t i) {
+     uint8_t msg[QUEUE_MSG_SIZE];
+
+     switch (op) {
+         case OVH_CONTEXT_SWITCH:
+             /* Save one context and restore another */
+             if (setjmp(switch_env) == 0) {
+                 longjmp(switch_env, 1);
+             }
+             break;
+         case OVH_TICK:
+             critical_enter();
+             for (int t = 0; t < MAX_TASKS; t++) {
+                 if (task_table[t].state != 0 && task_table[t].release <= i) {
+                     task_table[t].release = i + (uint32_t)t + 1;
+                 }
+             }
+             critical_exit();
+             break;
+         case OVH_QUEUE_SEND:
+             memset(msg, (int)i, sizeof(msg));
+             critical_enter();
+             memcpy(&ring[ring_head * QUEUE_MSG_SIZE], msg, QUEUE_MSG_SIZE);
+             ring_head = (ring_head + 1) % QUEUE_LENGTH;
+             critical_exit();
+             break;
+         case OVH_QUEUE_RECEIVE:
+             critical_enter();
+             memcpy(msg, &ring[ring_tail * QUEUE_MSG_SIZE], QUEUE_MSG_SIZE);
+             ring_tail = (ring_tail + 1) % QUEUE_LENGTH;
+             critical_exit();
+             sink += msg[0];
+             break;
+         case OVH_SEM_TAKE: {
+             uint32_t count = __atomic_load_n(&sem_count, __ATOMIC_ACQUIRE);
+             if (count > 0) {
+                 __atomic_compare_exchange_n(&sem_count, &count, count - 1, 0,
+                                             __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+             }
+             break;
+         }
+         case OVH_SEM_GIVE: {
+             uint32_t count = __atomic_load_n(&sem_count, __ATOMIC_ACQUIRE);
+             __atomic_compare_exchange_n(&sem_count, &count, count + 1, 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+             break;
+         }
+         case OVH_MUTEX_LOCK:
+             critical_enter();
+             if (mutex_owner == 0) {
+                 mutex_owner = i | 1;
+             }
+             critical_exit();
+             break;
+         case OVH_MUTEX_UNLOCK:
+             critical_enter();
+             mutex_owner = 0;
+             critical_exit();
+             break;
+         default:
+             break;
+     }
+ }
+
+ /**
+  * Compare doubles for qsort
+  */
+ static int compare_double(const void* a, const void* b) {
+     double x = *(const double*)a;
+     double y = *(const double*)b;
+     return (x > y) - (x < y);
+ }
+
+ /**
+  * Host cost of an operation in ns: median over rounds of the mean per call
+  */
+ static double measure_host(int op, uint32_t iterations) {
+     double rounds[ROUNDS];
+
+     for (int r = 0; r < ROUNDS; r++) {
+         double start = now_ns();
+         for (uint32_t i = 0; i < iterations; i++) {
+             host_op(op, i);
+         }
+         rounds[r] = (now_ns() - start) / iterations;
+     }
+     qsort(rounds, ROUNDS, sizeof(double), compare_double);
+
+     return rounds[ROUNDS / 2];
+ }
+
+ /**
+  * Read target samples; values are cycles at mhz, or ns if mhz is 0
+  */
+ static int read_target(const char* path, double mhz, samples_t* samples) {
+     char line[MAX_LINE];
+     int line_no = 0;
+
+     FILE* file = fopen(path, "r");
+     if (file == NULL) {
+         fprintf(stderr, "Cannot open %s\n", path);
+         return -1;
+     }
+
+     while (fgets(line, sizeof(line), file) != NULL) {
+         char name[32];
+         double value;
+         int op;
+
+         line_no++;
+         char* hash = strchr(line, '#');
+         if (hash != NULL) {
+             *hash = '\0';
+         }
+         if (sscanf(line, " %31[^, \t\r\n]", name) != 1) {
+             continue;
+         }
+         if (sscanf(line, " %31[^, \t\r\n] , %lf", name, &value) != 2 || value < 0) {
+             /* Tolerate a header row */
+             if (line_no == 1) {
+                 continue;
+             }
+             fprintf(stderr, "%s:%d: expected '<op>,<value>'\n", path, line_no);
+             fclose(file);
+             return -1;
+         }
+
+         op = 0;
+         while (op < OVH_OP_COUNT && strcmp(op_names[op], name) != 0) {
+             op++;
+         }
+         if (op == OVH_OP_COUNT) {
+             fprintf(stderr, "%s:%d: unknown operation '%s'\n", path, line_no, name);
+             fclose(file);
+             return -1;
+         }
+
+         samples_t* s = &samples[op];
+         if (s->count == s->capacity) {
+             s->capacity = s->capacity ? s->capacity * 2 : 64;
+             s->values = realloc(s->values, s->capacity * sizeof(double));
+             if (s->values == NULL) {
+                 fprintf(stderr, "Out of memory\n");
+                 fclose(file);
+                 return -1;
+             }
+         }
+         s->values[s->count++] = (mhz > 0) ? value * 1000.0 / mhz : value;
+     }
+     fclose(file);
+
+     return 0;
+ }
+
+ /**
+  * Quantile q of the samples (nearest rank)
+  */
+ static double quantile(samples_t* s, double q) {
+     qsort(s->values, s->count, sizeof(double), compare_double);
+
+     uint32_t rank = (uint32_t)(q * s->count + 0.999999);
+     if (rank < 1) {
+         rank = 1;
+     }
+     if (rank > s->count) {
+         rank = s->count;
+     }
+
+     return s->values[rank - 1];
+ }
+
+ int main(int argc, char* argv[]) {
+     const char* target_path = NULL;
+     const char* model_path = NULL;
+     uint32_t iterations = DEFAULT_ITERATIONS;
+     double mhz = 0;
+     double q = 1.0;
+     samples_t samples[OVH_OP_COUNT];
+     int opt;
+
+     while ((opt = getopt(argc, argv, "i:f:q:n:o:")) != -1) {
+         switch (opt) {
+             case 'i': target_path = optarg; break;
+             case 'f': mhz = atof(optarg); break;
+             case 'q': q = atof(optarg); break;
+             case 'n': iterations = (uint32_t)atoi(optarg); break;
+             case 'o': model_path = optarg; break;
+             default:
+                 fprintf(stderr, "Usage: %s [-i target.csv] [-f mhz] [-q quantile] [-n iterations] [-o model-file]\n",
+                         argv[0]);
+                 return 1;
+         }
+     }
+     if (iterations == 0 || q <= 0 || q > 1 || mhz < 0) {
+         fprintf(stderr, "Need 1+ iterations, a quantile in (0, 1] and a positive clock\n");
+         return 1;
+     }
+
+     memset(samples, 0, sizeof(samples));
+     if (target_path != NULL && read_target(target_path, mhz, samples) != 0) {
+         return 1;
+     }
+
+     for (int t = 0; t < MAX_TASKS; t++) {
+         task_table[t].state = (uint8_t)(t & 1);
+     }
+     sem_count = 1;
+
+     FILE* out = stdout;
+     if (model_path != NULL) {
+         out = fopen(model_path, "w");
+         if (out == NULL) {
+             fprintf(stderr, "Cannot create %s\n", model_path);
+             return 1;
+         }
+     }
+
+     fprintf(out, "# Kernel overhead model written by ovh_calibrate\n");
+     if (target_path != NULL) {
+         fprintf(out, "# Target: %s, %s, quantile %.3f\n", target_path, (mhz > 0) ? "cycles" : "ns", q);
+     } else {
+         fprintf(out, "# No target measurements: nothing is charged\n");
+     }
+     fprintf(out, "# %-15s %10s %10s   samples\n", "op", "target_ns", "host_ns");
+
+     for (int op = 0; op < OVH_OP_COUNT; op++) {
+         double host = measure_host(op, iterations);
+         double target = (samples[op].count > 0) ? quantile(&samples[op], q) : host;
+         uint32_t host_ns = (uint32_t)(host + 0.5);
+         uint32_t target_ns = (uint32_t)(target + 0.5);
+
+         fprintf(out, "  %-15s %10u %10u   # %u\n", op_names[op], target_ns, host_ns, samples[op].count);
+         if (target_path != NULL && samples[op].count == 0) {
+             fprintf(stderr, "No target samples for %s, not charged\n", op_names[op]);
+         }
+         free(samples[op].values);
+     }
+
+     if (out != stdout) {
+         fclose(out);
+     }
+     return 0;
+ }
@@ -0,0 +1,169 @@
+/**
+ * @file rta_chain.c
+ * @brief End-to-end latency bounds of cause-effect chains
+ *
+ * Bounds the latency of every [chain] of a system configuration (a
+ * sequence of periodic tasks linked by queues, see kernel/chain.h) under
+ * fixed priorities, from the worst-case response times R_i of the
+ * response-time analysis:
+ *
+ *     data age   age of a sample when the last stage acts on it, from
+ *                the sample taken by the first stage's job (what the
+ *                kernel's chain histograms measure)
+ *     reaction   delay from an external event to the first output that
+ *                reflects it: one more period of the first stage, for
+ *                an event just missing its sample
+ *
+ * Both are built stage by stage from the latest release of the job that
+ * forwards the data, relative to the release of the sampling job (A_1 =
+ * 0). In general a consumer reads what its producer wrote by A_p + R_p
+ * at its next release, at most one period later:
+ *
+ *     A_c = A_p + R_p + T_c
+ *
+ * When producer and consumer run at the same rate, the release offsets
+ * fix the distance d = (O_c - O_p) mod T between their jobs. The
+ * consumer job released d later reads the new data if it is released
+ * after the producer's worst-case completion (d >= R_p) or if the
+ * producer has the higher priority (it cannot start before the producer
+ * finishes); otherwise the next one does:
+ *
+ *     A_c = A_p + d (+ T if neither holds)
+ *
+ * and data age = A_n + R_n, reaction = T_1 + data age. The bounds assume
+ * each job of a consumer reads out its queue (the producer does not
+ * outpace it), and leave out the queue copies.
+ *
+ * Usage: rta_chain <config.sysconf>
+ */
+
+ #define _POSIX_C_SOURCE 200809L
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "taskset.h"
+ #include "config.h"
+
+ /**
+  * Bound one chain; returns 1 if within its deadline, 0 if not, -1 if unbounded
+  */
+ static int analyze_chain(const taskset_t* ts, const rta_set_t* set, const taskset_chain_t* chain) {
+     uint64_t release = 0;        /* A of the current stage */
+     uint32_t response[TASKSET_MAX_STAGES];
+
+     printf("\nChain %s:", chain->name);
+     for (int k = 0; k < chain->stage_count; k++) {
+         if (k > 0) {
+             printf(" -> %s ->", chain->links[k]);
+         }
+         printf(" %s", chain->stages[k]);
+     }
+     printf("\n");
+
+     for (int k = 0; k < chain->stage_count; k++) {
+         if (chain->tasks[k] < 0) {
+             printf("  stage %s is not a periodic task: no bound\n", chain->stages[k]);
+             return -1;
+         }
+         if (rta_get_response(set, (uint16_t)chain->tasks[k], &response[k]) != 1) {
+             printf("  stage %s misses its deadline: no bound\n", chain->stages[k]);
+             return -1;
+         }
+     }
+
+     printf("  %-20s %8s %8s %5s %8s %8s %8s\n", "Stage", "Period", "Offset", "Prio", "R", "Wait", "Release");
+     for (int k = 0; k < chain->stage_count; k++) {
+         const taskset_task_t* task = &ts->tasks[chain->tasks[k]];
+         uint64_t wait = 0;
+         const char* how = "";
+
+         if (k > 0) {
+             const taskset_task_t* producer = &ts->tasks[chain->tasks[k - 1]];
+             if (producer->period == task->period) {
+                 uint32_t d = (task->offset + task->period - producer->offset) % task->period;
+                 int fresh = (d >= response[k - 1] || producer->priority < task->priority);
+                 wait = d + (fresh ? 0 : task->period);
+                 how = fresh ? "  same rate, reads this job's data" : "  same rate, reads next job's data";
+             } else {
+                 wait = (uint64_t)response[k - 1] + task->period;
+                 if (task->period > producer->period) {
+                     how = "  slower than its producer: must drain the queue";
+                 }
+             }
+             release += wait;
+         }
+
+         printf("  %-20.20s %8u %8u %5d %8u %8llu %8llu%s\n", chain->stages[k], task->period, task->offset,
+                task->priority, response[k], (unsigned long long)wait, (unsigned long long)release, how);
+     }
+
+     const taskset_task_t* first = &ts->tasks[chain->tasks[0]];
+     uint64_t age = release + response[chain->stage_count - 1];
+     uint64_t reaction = age + first->period;
+
+     printf("  Data age <= %llu ticks (%llu ms), reaction <= %llu ticks (%llu ms)",
+            (unsigned long long)age, (unsigned long long)age * MILLISECONDS_PER_TICK,
+            (unsigned long long)reaction, (unsigned long long)reaction * MILLISECONDS_PER_TICK);
+     if (chain->deadline == 0) {
+         printf("\n");
+         return 1;
+     }
+     printf(", deadline %u ticks: %s\n", chain->deadline, (age <= chain->deadline) ? "met" : "MISSED");
+
+     return (age <= chain->deadline) ? 1 : 0;
+ }
+
+ int main(int argc, char* argv[]) {
+     taskset_t ts;
+
+     if (argc != 2) {
+         fprintf(stderr, "Usage: %s <config.sysconf>\n", argv[0]);
+         return 1;
+     }
+
+     if (taskset_load(argv[1], &ts) != 0) {
+         return 1;
+     }
+     if (ts.chain_count == 0) {
+         fprintf(stderr, "rta_chain: %s defines no [chain] sections\n", argv[1]);
+         taskset_free(&ts);
+         return 1;
+     }
+     if (ts.count >= RTA_NONE) {
+         fprintf(stderr, "rta_chain: at most %d tasks\n", RTA_NONE - 1);
+         taskset_free(&ts);
+         return 1;
+     }
+
+     rta_entry_t* entries = malloc((size_t)(ts.count > 0 ? ts.count : 1) * sizeof(rta_entry_t));
+     rta_set_t set;
+     if (entries == NULL) {
+         fprintf(stderr, "rta_chain: out of memory\n");
+         taskset_free(&ts);
+         return 1;
+     }
+     if (taskset_build(&ts, &set, entries) != 0) {
+         fprintf(stderr, "rta_chain: cannot build the analysis set\n");
+         free(entries);
+         taskset_free(&ts);
+         return 1;
+     }
+
+     printf("Task set: %s (%d periodic tasks, %d chains), %s\n", argv[1], ts.count, ts.chain_count,
+            rta_is_schedulable(&set) ? "schedulable" : "NOT schedulable");
+
+     int failed = 0;
+     for (int c = 0; c < ts.chain_count; c++) {
+         if (analyze_chain(&ts, &set, &ts.chains[c]) != 1) {
+             failed++;
+         }
+     }
+
+     if (failed > 0) {
+         printf("\n%d of %d chains unbounded or over their deadline\n", failed, ts.chain_count);
+     }
+
+     free(entries);
+     taskset_free(&ts);
+     return (failed > 0) ? 2 : 0;
+ }
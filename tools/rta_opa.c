@@ -0,0 +1,429 @@
+/**
+ * @file rta_opa.c
+ * @brief Optimal priority assignment for a periodic task set
+ *
+ * Runs Audsley's algorithm with the response-time test: starting from
+ * the lowest priority, it gives each level to some unassigned task that
+ * meets its deadline there, with every other unassigned task above it.
+ * A task's test only depends on which tasks are above and below it, not
+ * on their order, so the algorithm finds a schedulable assignment
+ * whenever one exists, including with constrained deadlines and mutex
+ * blocking, where deadline-monotonic order is not optimal.
+ *
+ * Blocking follows priority inheritance (tools/taskset.h): at each level
+ * the lower-priority tasks are exactly the ones already assigned, so one
+ * blocking term holds for every candidate and is kept incrementally as
+ * tasks are assigned. Blocking breaks the optimality argument, though:
+ * the task placed at a level adds its critical sections to the blocking
+ * of every task above, so the choice among passing candidates matters.
+ * Candidates are therefore tried in order of the blocking they would add
+ * above them, then longest deadline first (the deadline-monotonic
+ * choice, which usually passes at once). Without mutexes the first level
+ * no task can take proves the set infeasible; with them, the search
+ * backtracks to the next passing candidate of the level above, which
+ * stays exact until SEARCH_BUDGET tests have run.
+ *
+ * Each test is a single response-time fixed point (rta_response()) that
+ * stops as soon as it passes the deadline. The final assignment is
+ * checked with the full analysis.
+ *
+ * With -o, the new priorities are written into a copy of the input
+ * (which may be the input itself). A .sysconf gets kernel priorities
+ * from -b base (default: the highest priority any periodic task has now,
+ * so aperiodic tasks above it keep their place); when there are more
+ * tasks than free levels, adjacent levels are merged as long as the set
+ * stays schedulable.
+ *
+ * Usage: rta_opa [-b base] [-o output] <config.sysconf|table>
+ */
+
+ #define _POSIX_C_SOURCE 200809L
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <unistd.h>
+ #include "taskset.h"
+
+ #define SEARCH_BUDGET    10000000    /* Response-time tests before backtracking gives up */
+
+ /* Choice made at one level, kept for backtracking */
+ typedef struct {
+     int position;                /* Position of the task among the unassigned */
+     int tried;                   /* Index of the choice in the level's try order */
+     uint32_t longest[TASKSET_MAX_LOCKS];  /* Longest sections before the task was placed */
+ } frame_t;
+
+ static taskset_t ts;
+ static int64_t* added;           /* Blocking each candidate would add above it */
+ static int* position;            /* Candidate order of each task */
+
+ /**
+  * Candidate order: longest deadline, then longest period, then file order
+  */
+ static int compare_candidate(const void* a, const void* b) {
+     const taskset_task_t* x = &ts.tasks[*(const int*)a];
+     const taskset_task_t* y = &ts.tasks[*(const int*)b];
+
+     if (x->deadline != y->deadline) {
+         return (x->deadline > y->deadline) ? -1 : 1;
+     }
+     if (x->period != y->period) {
+         return (x->period > y->period) ? -1 : 1;
+     }
+     return *(const int*)a - *(const int*)b;
+ }
+
+ /**
+  * Try order within a level: least added blocking, then candidate order
+  */
+ static int compare_try(const void* a, const void* b) {
+     int x = *(const int*)a;
+     int y = *(const int*)b;
+
+     if (added[x] != added[y]) {
+         return (added[x] < added[y]) ? -1 : 1;
+     }
+     return position[x] - position[y];
+ }
+
+ /**
+  * Change in the level's blocking term if task i were assigned to it
+  */
+ static int64_t added_blocking(int i, const int* users, const uint32_t* longest) {
+     int64_t delta = 0;
+
+     for (int k = 0; k < ts.tasks[i].lock_count; k++) {
+         int r = ts.tasks[i].locks[k].mutex;
+         uint32_t length = ts.tasks[i].locks[k].length;
+         int64_t before = (users[r] > 0) ? longest[r] : 0;
+         int64_t after = (users[r] > 1) ? ((length > longest[r]) ? length : longest[r]) : 0;
+         delta += after - before;
+     }
+
+     return delta;
+ }
+
+ /**
+  * Order in which to try the unassigned positions at the current level
+  */
+ static void try_order(int* tries, int m, const int* order, const int* users, const uint32_t* longest) {
+     for (int p = 0; p < m; p++) {
+         tries[p] = p;
+         position[p] = p;
+         added[p] = added_blocking(order[p], users, longest);
+     }
+     if (ts.mutex_count > 0) {
+         qsort(tries, (size_t)m, sizeof(int), compare_try);
+     }
+ }
+
+ /**
+  * Audsley's algorithm; fills rank (task at each level, highest first)
+  * Returns the number of levels left unassigned (0 on success)
+  */
+ static int audsley(int* rank, uint64_t* tests, int* exhausted) {
+     int n = ts.count;
+     int* order = malloc((size_t)n * sizeof(int));
+     rta_params_t* hp = malloc((size_t)n * sizeof(rta_params_t));
+     int* tries = malloc((size_t)n * sizeof(int));
+     frame_t* frames = malloc((size_t)n * sizeof(frame_t));
+     int* users = calloc((size_t)ts.mutex_count + 1, sizeof(int));
+     uint32_t* longest = calloc((size_t)ts.mutex_count + 1, sizeof(uint32_t));
+
+     added = calloc((size_t)n, sizeof(int64_t));
+     position = malloc((size_t)n * sizeof(int));
+     if (order == NULL || hp == NULL || tries == NULL || frames == NULL || users == NULL ||
+         longest == NULL || added == NULL || position == NULL) {
+         fprintf(stderr, "rta_opa: out of memory\n");
+         exit(1);
+     }
+
+     for (int i = 0; i < n; i++) {
+         order[i] = i;
+         for (int k = 0; k < ts.tasks[i].lock_count; k++) {
+             users[ts.tasks[i].locks[k].mutex]++;
+         }
+     }
+     qsort(order, (size_t)n, sizeof(int), compare_candidate);
+     for (int i = 0; i < n; i++) {
+         taskset_params(&ts.tasks[order[i]], &hp[i]);
+     }
+
+     /* Unassigned tasks are order[0..m-1], with their parameters in hp */
+     int m = n;
+     int level = n - 1;
+     int first = 0;
+     *exhausted = 0;
+     while (level >= 0) {
+         uint64_t lock_blocking = 0;
+         int chosen = -1;
+         int t;
+
+         /* A mutex still used at or above this level can be held below it */
+         for (int r = 0; r < ts.mutex_count; r++) {
+             if (users[r] > 0) {
+                 lock_blocking += longest[r];
+             }
+         }
+
+         try_order(tries, m, order, users, longest);
+         for (t = first; t < m && chosen < 0; t++) {
+             int p = tries[t];
+             rta_params_t task = hp[p];
+             uint64_t blocking = (uint64_t)ts.tasks[order[p]].blocking + lock_blocking;
+             uint32_t response;
+
+             task.blocking = (blocking > UINT32_MAX) ? UINT32_MAX : (uint32_t)blocking;
+
+             /* Test against everyone else still unassigned: the last one takes its slot */
+             hp[p] = hp[m - 1];
+             (*tests)++;
+             if (rta_response(&task, hp, (uint32_t)(m - 1), &response) == 1) {
+                 chosen = p;
+             }
+             hp[p] = task;
+         }
+
+         if (chosen < 0) {
+             /* Without mutexes a failed level proves infeasibility; with them, undo the last choice */
+             if (ts.mutex_count == 0 || level == n - 1 || *tests >= SEARCH_BUDGET) {
+                 *exhausted = (ts.mutex_count > 0 && level < n - 1);
+                 break;
+             }
+
+             level++;
+             frame_t* f = &frames[level];
+             const taskset_task_t* task = &ts.tasks[rank[level]];
+             /* Reverse order, so a mutex listed twice gets its oldest value back */
+             for (int k = task->lock_count - 1; k >= 0; k--) {
+                 users[task->locks[k].mutex]++;
+                 longest[task->locks[k].mutex] = f->longest[k];
+             }
+             memmove(&order[f->position + 1], &order[f->position], (size_t)(m - f->position) * sizeof(int));
+             memmove(&hp[f->position + 1], &hp[f->position], (size_t)(m - f->position) * sizeof(rta_params_t));
+             order[f->position] = rank[level];
+             taskset_params(task, &hp[f->position]);
+             m++;
+             first = f->tried + 1;
+             continue;
+         }
+
+         const taskset_task_t* task = &ts.tasks[order[chosen]];
+         frame_t* f = &frames[level];
+         f->position = chosen;
+         f->tried = t - 1;
+         rank[level] = order[chosen];
+         for (int k = 0; k < task->lock_count; k++) {
+             f->longest[k] = longest[task->locks[k].mutex];
+             users[task->locks[k].mutex]--;
+             if (task->locks[k].length > longest[task->locks[k].mutex]) {
+                 longest[task->locks[k].mutex] = task->locks[k].length;
+             }
+         }
+
+         memmove(&order[chosen], &order[chosen + 1], (size_t)(m - chosen - 1) * sizeof(int));
+         memmove(&hp[chosen], &hp[chosen + 1], (size_t)(m - chosen - 1) * sizeof(rta_params_t));
+         m--;
+         level--;
+         first = 0;
+     }
+
+     free(order);
+     free(hp);
+     free(tries);
+     free(frames);
+     free(users);
+     free(longest);
+     free(added);
+     free(position);
+     return m;
+ }
+
+ /**
+  * Apply priorities and check the whole set with the response-time analysis
+  */
+ static int check(const int* priorities, rta_set_t* set, rta_entry_t* entries) {
+     for (int i = 0; i < ts.count; i++) {
+         ts.tasks[i].priority = priorities[i];
+     }
+     taskset_update_blocking(&ts);
+
+     return taskset_build(&ts, set, entries) == 0 && rta_is_schedulable(set);
+ }
+
+ /**
+  * Merge adjacent levels (in rank order) until at most max_levels remain
+  * Returns the number of levels used, or 0 if the set does not fit
+  */
+ static int merge_levels(const int* rank, int* level_of, int max_levels,
+                         rta_set_t* set, rta_entry_t* entries) {
+     int n = ts.count;
+     int levels = n;
+
+     for (int k = 0; k < n; k++) {
+         level_of[rank[k]] = k;
+     }
+
+     for (int k = 1; k < n && levels > max_levels; k++) {
+         /* Try joining task k to the level of task k - 1, shifting the rest up */
+         for (int j = k; j < n; j++) {
+             level_of[rank[j]]--;
+         }
+         if (check(level_of, set, entries)) {
+             levels--;
+         } else {
+             for (int j = k; j < n; j++) {
+                 level_of[rank[j]]++;
+             }
+         }
+     }
+
+     return (levels <= max_levels) ? levels : 0;
+ }
+
+ /**
+  * Print the assignment, highest priority first
+  */
+ static void report(const int* rank, const int* old_priority, const rta_set_t* set) {
+     printf("\n%-20s %5s %5s %8s %8s %8s %8s %8s\n",
+            "Task", "Old", "New", "Period", "Deadline", "WCET", "Blocking", "Response");
+
+     for (int k = 0; k < ts.count; k++) {
+         int i = rank[k];
+         const taskset_task_t* task = &ts.tasks[i];
+         uint32_t response = 0;
+
+         rta_get_response(set, (uint16_t)i, &response);
+         printf("%-20.20s %5d %5d %8u %8u %8u %8u %8u\n", task->name, old_priority[i], task->priority,
+                task->period, task->deadline, task->wcet, task->blocking + task->lock_blocking, response);
+     }
+ }
+
+ /**
+  * Main entry point
+  */
+ int main(int argc, char* argv[]) {
+     const char* output = NULL;
+     int base = -1;
+     int opt;
+
+     while ((opt = getopt(argc, argv, "b:o:")) != -1) {
+         switch (opt) {
+             case 'b': base = atoi(optarg); break;
+             case 'o': output = optarg; break;
+             default:
+                 fprintf(stderr, "Usage: %s [-b base] [-o output] <config.sysconf|table>\n", argv[0]);
+                 return 1;
+         }
+     }
+
+     if (optind != argc - 1) {
+         fprintf(stderr, "Usage: %s [-b base] [-o output] <config.sysconf|table>\n", argv[0]);
+         return 1;
+     }
+
+     if (taskset_load(argv[optind], &ts) != 0) {
+         return 1;
+     }
+     if (ts.count >= RTA_NONE) {
+         fprintf(stderr, "rta_opa: at most %d tasks\n", RTA_NONE - 1);
+         taskset_free(&ts);
+         return 1;
+     }
+
+     int n = ts.count;
+     int* old_priority = malloc((size_t)n * sizeof(int));
+     int* rank = malloc((size_t)n * sizeof(int));
+     int* level_of = malloc((size_t)n * sizeof(int));
+     rta_entry_t* entries = malloc((size_t)n * sizeof(rta_entry_t));
+     rta_set_t set;
+     if (old_priority == NULL || rank == NULL || level_of == NULL || entries == NULL) {
+         fprintf(stderr, "rta_opa: out of memory\n");
+         return 1;
+     }
+
+     int highest = ts.tasks[0].priority;
+     for (int i = 0; i < n; i++) {
+         old_priority[i] = ts.tasks[i].priority;
+         if (old_priority[i] < highest) {
+             highest = old_priority[i];
+         }
+     }
+     if (base < 0) {
+         base = ts.sysconf ? highest : 0;
+     }
+
+     printf("Task set: %s (%d periodic tasks", argv[optind], n);
+     if (ts.skipped > 0) {
+         printf(", %d aperiodic skipped", ts.skipped);
+     }
+     printf(", %d mutexes)\n", ts.mutex_count);
+     printf("Current priorities: %s\n", check(old_priority, &set, entries) ? "schedulable" : "NOT schedulable");
+
+     uint64_t tests = 0;
+     int exhausted;
+     double start = taskset_now_s();
+     int left = audsley(rank, &tests, &exhausted);
+     double elapsed = taskset_now_s() - start;
+
+     if (left > 0 && exhausted) {
+         printf("Optimal assignment: none found within %d tests\n", SEARCH_BUDGET);
+         printf("%llu response-time tests in %.3f s\n", (unsigned long long)tests, elapsed);
+         taskset_free(&ts);
+         return 2;
+     }
+     if (left > 0) {
+         printf("Optimal assignment: none exists (no task can take level %d of the %d left)\n", left - 1, left);
+         printf("%llu response-time tests in %.3f s\n", (unsigned long long)tests, elapsed);
+         for (int i = 0; i < n; i++) {
+             ts.tasks[i].priority = old_priority[i];
+         }
+         taskset_free(&ts);
+         return 2;
+     }
+
+     for (int k = 0; k < n; k++) {
+         level_of[rank[k]] = k;
+     }
+     if (!check(level_of, &set, entries)) {
+         fprintf(stderr, "rta_opa: assignment fails the full analysis\n");
+         return 1;
+     }
+
+     /* Fit the levels into the kernel's range for a system configuration */
+     int levels = n;
+     if (ts.sysconf && base + n > MAX_PRIORITY_LEVELS) {
+         levels = merge_levels(rank, level_of, MAX_PRIORITY_LEVELS - base, &set, entries);
+         if (levels == 0) {
+             fprintf(stderr, "rta_opa: no schedulable assignment fits priorities %d..%d\n",
+                     base, MAX_PRIORITY_LEVELS - 1);
+             return 2;
+         }
+     }
+
+     for (int i = 0; i < n; i++) {
+         level_of[i] += base;
+     }
+     check(level_of, &set, entries);
+
+     printf("Optimal assignment: schedulable, %d levels from priority %d\n", levels, base);
+     printf("%llu response-time tests in %.3f s\n", (unsigned long long)tests, elapsed);
+     report(rank, old_priority, &set);
+
+     int result = 0;
+     if (output != NULL) {
+         if (taskset_save(&ts, argv[optind], output) == 0) {
+             printf("\nPriorities written to %s\n", output);
+         } else {
+             result = 1;
+         }
+     }
+
+     free(old_priority);
+     free(rank);
+     free(level_of);
+     free(entries);
+     taskset_free(&ts);
+
+     return result;
+ }
@@ -0,0 +1,558 @@
+/**
+ * @file rta_sensitivity.c
+ * @brief Sensitivity analysis of a periodic task set
+ *
+ * Answers "how much margin is left" for a task set that passes the
+ * schedulability test:
+ *
+ * - the critical scaling factor: the largest factor every WCET can be
+ *   multiplied by with the set still schedulable;
+ * - per task, the largest WCET it can have with the others unchanged,
+ *   and the slack that leaves over its current WCET;
+ * - per task, the shortest period it can run at (an implicit deadline
+ *   follows the period, a constrained one is kept when it still fits).
+ *
+ * Each quantity is a binary search over the schedulability test, which
+ * is monotone in WCETs and periods. Fixed-priority sets use the
+ * incremental response-time analysis (kernel/rta.h), so a probe that
+ * changes one task only re-analyzes the tasks below it; EDF sets use a
+ * processor-demand test (QPA). Tasks are independent searches and run
+ * in parallel, each worker probing its own copy of the analyzed set.
+ *
+ * Times are in kernel ticks; a scaled WCET rounds up to a whole tick.
+ * Under rm, priorities are assigned once from the nominal periods and
+ * stay fixed while periods are probed.
+ *
+ * Usage: rta_sensitivity [-j threads] [-p fp|rm|edf] <config.sysconf|table>
+ */
+
+ #define _POSIX_C_SOURCE 200809L
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <math.h>
+ #include <unistd.h>
+ #include <pthread.h>
+ #include "taskset.h"
+
+ #define MAX_THREADS      32      /* Worker threads */
+ #define SCALE_STEPS      40      /* Bisection steps for the scaling factor */
+ #define PERIOD_GROWTH    64      /* Longest period probed, as a multiple of the current one */
+
+ #define POLICY_FP        0       /* Fixed priorities as configured */
+ #define POLICY_RM        1       /* Rate-monotonic priorities */
+ #define POLICY_EDF       2       /* Earliest deadline first */
+
+ #define NONE             UINT32_MAX
+
+ /* Per-task results */
+ typedef struct {
+     uint32_t response;           /* Worst-case response time (fixed priority only) */
+     uint32_t wcet_max;           /* Largest feasible WCET, NONE if none is */
+     uint32_t period_min;         /* Shortest feasible period, NONE if none is */
+ } result_t;
+
+ /* Worker context */
+ typedef struct {
+     pthread_t thread;
+     taskset_task_t* tasks;       /* Private copy of the task set */
+     rta_entry_t* entries;        /* Private copy of the analyzed set */
+     rta_set_t set;
+     uint64_t probes;
+ } worker_t;
+
+ static int policy = POLICY_FP;
+ static int num_workers = 0;
+
+ static taskset_t ts;
+ static rta_entry_t* base_entries = NULL;
+ static rta_set_t base_set;
+ static result_t* results = NULL;
+ static double scale_factor = -1.0;   /* < 0: infeasible even with no execution */
+ static int scale_unbounded = 0;
+
+ /* Job dispenser: job 0 is the scaling factor, job i + 1 is task i */
+ static int next_job = 0;
+ static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+ /* ------------------------------------------------------------------ */
+ /* EDF processor-demand test                                           */
+ /* ------------------------------------------------------------------ */
+
+ /**
+  * Execution demand of the jobs released and due within [0, t]
+  */
+ static uint64_t demand(const taskset_task_t* tasks, int n, uint64_t t) {
+     uint64_t h = 0;
+
+     for (int i = 0; i < n; i++) {
+         if (t >= tasks[i].deadline) {
+             h += ((t - tasks[i].deadline) / tasks[i].period + 1) * tasks[i].wcet;
+         }
+     }
+
+     return h;
+ }
+
+ /**
+  * Latest absolute deadline strictly before t (0 if there is none)
+  */
+ static uint64_t deadline_before(const taskset_task_t* tasks, int n, uint64_t t) {
+     uint64_t latest = 0;
+
+     for (int i = 0; i < n; i++) {
+         if (t > tasks[i].deadline) {
+             uint64_t d = ((t - tasks[i].deadline - 1) / tasks[i].period) * tasks[i].period +
+                          tasks[i].deadline;
+             if (d > latest) {
+                 latest = d;
+             }
+         }
+     }
+
+     return latest;
+ }
+
+ /**
+  * Quick processor-demand analysis (Zhang and Burns) over the synchronous busy period
+  */
+ static int edf_schedulable(const taskset_task_t* tasks, int n) {
+     double u = 0.0;
+     uint64_t w = 0;
+     uint64_t d_min = UINT64_MAX;
+
+     for (int i = 0; i < n; i++) {
+         uint32_t deadline = (tasks[i].deadline < tasks[i].period) ? tasks[i].deadline : tasks[i].period;
+         if (tasks[i].wcet > deadline) {
+             return 0;
+         }
+         u += (double)tasks[i].wcet / tasks[i].period;
+         w += tasks[i].wcet;
+         if (tasks[i].deadline < d_min) {
+             d_min = tasks[i].deadline;
+         }
+     }
+     if (u > 1.0) {
+         return 0;
+     }
+
+     /* Length of the synchronous busy period */
+     for (;;) {
+         uint64_t next = 0;
+         for (int i = 0; i < n; i++) {
+             next += ((w + tasks[i].period - 1) / tasks[i].period) * tasks[i].wcet;
+         }
+         if (next == w) {
+             break;
+         }
+         w = next;
+     }
+
+     uint64_t t = deadline_before(tasks, n, w);
+     uint64_t h = demand(tasks, n, t);
+     while (h <= t && h > d_min) {
+         t = (h < t) ? h : deadline_before(tasks, n, t);
+         h = demand(tasks, n, t);
+     }
+
+     return h <= d_min;
+ }
+
+ /* ------------------------------------------------------------------ */
+ /* Probes                                                              */
+ /* ------------------------------------------------------------------ */
+
+ /**
+  * Put a worker's analyzed set back to the nominal task set
+  */
+ static void worker_reset(worker_t* w) {
+     memcpy(w->tasks, ts.tasks, (size_t)ts.count * sizeof(taskset_task_t));
+     memcpy(w->entries, base_entries, (size_t)ts.count * sizeof(rta_entry_t));
+     w->set = base_set;
+     w->set.entries = w->entries;
+ }
+
+ /**
+  * Test the set with task i replaced (left in place for the next probe of task i)
+  */
+ static int probe_task(worker_t* w, int i, const taskset_task_t* changed) {
+     w->probes++;
+     w->tasks[i] = *changed;
+
+     if (policy == POLICY_EDF) {
+         return edf_schedulable(w->tasks, ts.count);
+     }
+
+     /* Successive probes of one task are single-task changes, analyzed incrementally */
+     rta_params_t params;
+     taskset_params(changed, &params);
+     rta_set_task(&w->set, (uint16_t)i, &params);
+     return rta_is_schedulable(&w->set);
+ }
+
+ /**
+  * Put task i back to its nominal parameters
+  */
+ static void restore_task(worker_t* w, int i) {
+     probe_task(w, i, &ts.tasks[i]);
+     w->probes--;
+ }
+
+ /**
+  * Test the set with every WCET scaled by alpha (rounded up to a tick)
+  */
+ static int probe_scaled(worker_t* w, double alpha) {
+     w->probes++;
+
+     for (int i = 0; i < ts.count; i++) {
+         double wcet = ceil((double)ts.tasks[i].wcet * alpha);
+         w->tasks[i].wcet = (wcet < (double)UINT32_MAX) ? (uint32_t)wcet : UINT32_MAX;
+     }
+
+     if (policy == POLICY_EDF) {
+         return edf_schedulable(w->tasks, ts.count);
+     }
+
+     /* Priorities are unchanged, so the priority list stays valid */
+     for (int i = 0; i < ts.count; i++) {
+         w->entries[i].params.wcet = w->tasks[i].wcet;
+     }
+     rta_analyze(&w->set);
+     return rta_is_schedulable(&w->set);
+ }
+
+ /**
+  * Largest factor all WCETs can be scaled by
+  */
+ static void find_scale(worker_t* w) {
+     double u = taskset_utilization(&ts);
+
+     if (u == 0.0) {
+         scale_unbounded = probe_scaled(w, 1.0);
+         scale_factor = scale_unbounded ? 0.0 : -1.0;
+         worker_reset(w);
+         return;
+     }
+
+     /* Beyond 1/U the processor is overloaded whatever the policy */
+     double lo = 0.0;
+     double hi = 1.0 / u * (1.0 + 1e-9);
+     if (!probe_scaled(w, lo)) {
+         scale_factor = -1.0;
+         worker_reset(w);
+         return;
+     }
+     if (probe_scaled(w, hi)) {
+         lo = hi;
+     }
+
+     for (int step = 0; step < SCALE_STEPS && lo < hi; step++) {
+         double mid = (lo + hi) / 2.0;
+         if (probe_scaled(w, mid)) {
+             lo = mid;
+         } else {
+             hi = mid;
+         }
+     }
+
+     scale_factor = lo;
+     worker_reset(w);
+ }
+
+ /**
+  * Largest feasible WCET of task i (NONE if even zero fails)
+  */
+ static uint32_t find_wcet_max(worker_t* w, int i) {
+     taskset_task_t task = ts.tasks[i];
+     uint32_t deadline = (task.deadline < task.period) ? task.deadline : task.period;
+
+     /* The response time is at least the WCET, so the deadline bounds the search */
+     task.wcet = 0;
+     if (!probe_task(w, i, &task)) {
+         return NONE;
+     }
+
+     uint32_t lo = 0;
+     uint32_t hi = deadline + 1;
+     while (hi - lo > 1) {
+         uint32_t mid = lo + (hi - lo) / 2;
+         task.wcet = mid;
+         if (probe_task(w, i, &task)) {
+             lo = mid;
+         } else {
+             hi = mid;
+         }
+     }
+
+     return lo;
+ }
+
+ /**
+  * Task i with a new period; an implicit deadline follows it
+  */
+ static void set_period(taskset_task_t* task, const taskset_task_t* nominal, uint32_t period) {
+     task->period = period;
+     if (nominal->deadline >= nominal->period || nominal->deadline > period) {
+         task->deadline = period;
+     } else {
+         task->deadline = nominal->deadline;
+     }
+ }
+
+ /**
+  * Shortest feasible period of task i (NONE if none up to PERIOD_GROWTH times the current one)
+  */
+ static uint32_t find_period_min(worker_t* w, int i) {
+     const taskset_task_t* nominal = &ts.tasks[i];
+     taskset_task_t task = *nominal;
+     uint64_t limit = (uint64_t)nominal->period * PERIOD_GROWTH;
+     uint64_t hi = nominal->period;
+
+     /* Longer periods only lighten the load: grow until one fits */
+     for (;;) {
+         set_period(&task, nominal, (uint32_t)hi);
+         if (probe_task(w, i, &task)) {
+             break;
+         }
+         if (hi >= limit || hi >= UINT32_MAX / 2) {
+             return NONE;
+         }
+         hi *= 2;
+     }
+
+     /* A period below the WCET cannot fit; lo is known infeasible or zero */
+     uint64_t lo = (nominal->wcet > 1) ? nominal->wcet - 1 : 0;
+     while (hi - lo > 1) {
+         uint64_t mid = lo + (hi - lo) / 2;
+         set_period(&task, nominal, (uint32_t)mid);
+         if (probe_task(w, i, &task)) {
+             hi = mid;
+         } else {
+             lo = mid;
+         }
+     }
+
+     return (uint32_t)hi;
+ }
+
+ /**
+  * Worker thread: take jobs until none are left
+  */
+ static void* worker_main(void* arg) {
+     worker_t* w = (worker_t*)arg;
+
+     worker_reset(w);
+
+     for (;;) {
+         pthread_mutex_lock(&lock);
+         int job = next_job++;
+         pthread_mutex_unlock(&lock);
+
+         if (job > ts.count) {
+             break;
+         }
+         if (job == 0) {
+             find_scale(w);
+         } else {
+             results[job - 1].wcet_max = find_wcet_max(w, job - 1);
+             results[job - 1].period_min = find_period_min(w, job - 1);
+             restore_task(w, job - 1);
+         }
+     }
+
+     return NULL;
+ }
+
+ /* ------------------------------------------------------------------ */
+ /* Report                                                              */
+ /* ------------------------------------------------------------------ */
+
+ /**
+  * Print a value or "-" when there is none
+  */
+ static void print_value(uint32_t value, int width) {
+     if (value == NONE) {
+         printf(" %*s", width, "-");
+     } else {
+         printf(" %*u", width, value);
+     }
+ }
+
+ /**
+  * Print the analysis results
+  */
+ static void report(const char* path, int schedulable, double elapsed, uint64_t probes) {
+     static const char* policy_names[] = { "fixed priority", "rate monotonic", "EDF" };
+
+     printf("Task set: %s (%d periodic tasks", path, ts.count);
+     if (ts.skipped > 0) {
+         printf(", %d aperiodic skipped", ts.skipped);
+     }
+     printf(")\n");
+     printf("Policy: %s\n", policy_names[policy]);
+     printf("Utilization: %.4f\n", taskset_utilization(&ts));
+     printf("Schedulable: %s\n", schedulable ? "yes" : "NO");
+
+     if (scale_unbounded) {
+         printf("Critical scaling factor: unbounded (no task has a WCET)\n");
+     } else if (scale_factor < 0.0) {
+         printf("Critical scaling factor: - (unschedulable even without execution)\n");
+     } else {
+         printf("Critical scaling factor: %.4f\n", scale_factor);
+     }
+
+     printf("\nTimes in ticks (%d ms)\n", MILLISECONDS_PER_TICK);
+     printf("%-20s %5s %8s %8s %8s %8s %8s %8s %10s\n",
+            "Task", "Prio", "Period", "Deadline", "WCET", "Response", "WCET max", "Slack", "Min period");
+
+     for (int i = 0; i < ts.count; i++) {
+         const taskset_task_t* task = &ts.tasks[i];
+         const result_t* r = &results[i];
+
+         printf("%-20.20s", task->name);
+         if (policy == POLICY_EDF) {
+             printf(" %5s", "-");
+         } else {
+             printf(" %5d", task->priority);
+         }
+         printf(" %8u %8u %8u", task->period, task->deadline, task->wcet);
+         print_value(r->response, 8);
+         print_value(r->wcet_max, 8);
+         if (r->wcet_max == NONE) {
+             printf(" %8s", "-");
+         } else {
+             printf(" %8lld", (long long)r->wcet_max - (long long)task->wcet);
+         }
+         print_value(r->period_min, 10);
+         printf("\n");
+     }
+
+     printf("\n%llu schedulability tests in %.3f s on %d threads\n",
+            (unsigned long long)probes, elapsed, num_workers);
+ }
+
+ /**
+  * Print usage
+  */
+ static void usage(const char* prog) {
+     fprintf(stderr, "Usage: %s [-j threads] [-p fp|rm|edf] <config.sysconf|table>\n", prog);
+ }
+
+ /**
+  * Main entry point
+  */
+ int main(int argc, char* argv[]) {
+     worker_t workers[MAX_THREADS];
+     int opt;
+
+ #if DEFAULT_SCHEDULING_POLICY == SCHEDULING_POLICY_EDF
+     policy = POLICY_EDF;
+ #elif DEFAULT_SCHEDULING_POLICY == SCHEDULING_POLICY_RMS
+     policy = POLICY_RM;
+ #endif
+
+     while ((opt = getopt(argc, argv, "j:p:")) != -1) {
+         switch (opt) {
+             case 'j': num_workers = atoi(optarg); break;
+             case 'p':
+                 if (strcmp(optarg, "fp") == 0) {
+                     policy = POLICY_FP;
+                 } else if (strcmp(optarg, "rm") == 0) {
+                     policy = POLICY_RM;
+                 } else if (strcmp(optarg, "edf") == 0) {
+                     policy = POLICY_EDF;
+                 } else {
+                     usage(argv[0]);
+                     return 1;
+                 }
+                 break;
+             default:
+                 usage(argv[0]);
+                 return 1;
+         }
+     }
+
+     if (optind != argc - 1) {
+         usage(argv[0]);
+         return 1;
+     }
+
+     if (num_workers <= 0) {
+         long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+         num_workers = (cpus > 0) ? (int)cpus : 1;
+     }
+     if (num_workers > MAX_THREADS) {
+         num_workers = MAX_THREADS;
+     }
+
+     if (taskset_load(argv[optind], &ts) != 0) {
+         return 1;
+     }
+     if (ts.count >= RTA_NONE) {
+         fprintf(stderr, "rta_sensitivity: at most %d tasks\n", RTA_NONE - 1);
+         taskset_free(&ts);
+         return 1;
+     }
+     if (policy == POLICY_RM) {
+         taskset_assign_rm(&ts);
+     }
+
+     base_entries = malloc((size_t)ts.count * sizeof(rta_entry_t));
+     results = calloc((size_t)ts.count, sizeof(result_t));
+     if (base_entries == NULL || results == NULL) {
+         fprintf(stderr, "rta_sensitivity: out of memory\n");
+         return 1;
+     }
+
+     /* Nominal analysis, shared read-only by the workers */
+     int schedulable;
+     if (policy == POLICY_EDF) {
+         memset(base_entries, 0, (size_t)ts.count * sizeof(rta_entry_t));
+         memset(&base_set, 0, sizeof(base_set));
+         schedulable = edf_schedulable(ts.tasks, ts.count);
+         for (int i = 0; i < ts.count; i++) {
+             results[i].response = NONE;
+         }
+     } else {
+         if (taskset_build(&ts, &base_set, base_entries) != 0) {
+             fprintf(stderr, "rta_sensitivity: task priorities must be below %d\n", RTA_NONE);
+             return 1;
+         }
+         schedulable = rta_is_schedulable(&base_set);
+         for (int i = 0; i < ts.count; i++) {
+             rta_get_response(&base_set, (uint16_t)i, &results[i].response);
+         }
+     }
+
+     if (num_workers > ts.count + 1) {
+         num_workers = ts.count + 1;
+     }
+
+     double start = taskset_now_s();
+     for (int i = 0; i < num_workers; i++) {
+         workers[i].tasks = malloc((size_t)ts.count * sizeof(taskset_task_t));
+         workers[i].entries = malloc((size_t)ts.count * sizeof(rta_entry_t));
+         workers[i].probes = 0;
+         if (workers[i].tasks == NULL || workers[i].entries == NULL) {
+             fprintf(stderr, "rta_sensitivity: out of memory\n");
+             return 1;
+         }
+         pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+     }
+
+     uint64_t probes = 0;
+     for (int i = 0; i < num_workers; i++) {
+         pthread_join(workers[i].thread, NULL);
+         probes += workers[i].probes;
+         free(workers[i].tasks);
+         free(workers[i].entries);
+     }
+
+     report(argv[optind], schedulable, taskset_now_s() - start, probes);
+
+     free(base_entries);
+     free(results);
+     taskset_free(&ts);
+
+     return schedulable ? 0 : 2;
+ }
@@ -0,0 +1,1129 @@
+/**
+ * @file sysgen.c
+ * @brief System configuration compiler
+ *
+ * Reads a declarative system description (tasks and IPC objects) and
+ * emits static C tables for sysconf_apply(), storage for every TCB,
+ * stack and queue buffer, and a limits header that sizes the kernel
+ * object pools exactly.
+ *
+ * Usage: sysgen <config.sysconf> <output-base>
+ * Produces <output-base>.c, <output-base>.h and <output-base>_limits.h.
+ *
+ * Input format:
+ *
+ *     # comment
+ *     [system]
+ *     include = satellite.h      (repeatable, emitted into the .c file)
+ *     extra_tasks = 1            (tasks created at run time)
+ *     extra_semaphores = 1       (semaphores created at run time)
+ *     extra_queues = 0           (queues created at run time)
+ *     extra_chains = 0           (chains created at run time)
+ *     extra_lets = 0             (LET variables created at run time)
+ *
+ *     [task <handle>]            (type = extended | basic)
+ *     name, entry, arg, priority, stack, period_ms, deadline_ms, wcet_ms, offset_ms, type,
+ *     locks = <mutex handle>:<cs_ms>, ...   (critical sections, for the analysis tools)
+ *
+ *     [semaphore <handle>]       name, initial, max
+ *     [mutex <handle>]           name
+ *     [queue <handle>]           name, msg_type | msg_size, depth
+ *     [event_group <handle>]     name
+ *     [chain <handle>]           name, deadline_ms,
+ *     path = <task> -> <queue> -> <task> ...   (cause-effect chain, see kernel/chain.h)
+ *     [let <handle>]             name, msg_type | msg_size, writer = <task>,
+ *     readers = <task>, ...      (LET variable of periodic tasks, see kernel/let.h)
+ *
+ * <handle> is the C variable through which the application reaches the
+ * object; name defaults to the handle.
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ctype.h>
+ #include <stdarg.h>
+
+ #define SYSGEN_MAX_OBJECTS   64      /* Objects of each kind */
+ #define SYSGEN_MAX_INCLUDES  8       /* [system] include lines */
+ #define SYSGEN_MAX_LINE      256     /* Longest input line */
+ #define SYSGEN_MAX_VALUE     96      /* Longest value or identifier */
+ #define SYSGEN_MAX_STAGES    8       /* Tasks per chain (CHAIN_MAX_STAGES) */
+ #define SYSGEN_MAX_READERS   16      /* Readers per LET variable */
+
+ #define FNV64_OFFSET         0xcbf29ce484222325ULL
+ #define FNV64_PRIME          0x100000001b3ULL
+
+ /* Object kinds */
+ typedef enum {
+     KIND_NONE,
+     KIND_SYSTEM,
+     KIND_TASK,
+     KIND_SEMAPHORE,
+     KIND_MUTEX,
+     KIND_QUEUE,
+     KIND_EVENT_GROUP,
+     KIND_CHAIN,
+     KIND_LET
+ } kind_t;
+
+ /* One configured object; which fields are used depends on the kind */
+ typedef struct {
+     char handle[SYSGEN_MAX_VALUE];
+     char name[SYSGEN_MAX_VALUE];
+     int line;
+     /* Tasks */
+     char entry[SYSGEN_MAX_VALUE];
+     char arg[SYSGEN_MAX_VALUE];
+     char stack[SYSGEN_MAX_VALUE];
+     long priority;
+     long period_ms;
+     long deadline_ms;
+     long wcet_ms;
+     long offset_ms;
+     char locks[SYSGEN_MAX_VALUE];
+     int basic;
+     /* Semaphores */
+     long initial;
+     long max;
+     /* Queues and LET variables */
+     char msg_type[SYSGEN_MAX_VALUE];
+     long msg_size;
+     long depth;
+     /* Chains (deadline in deadline_ms) */
+     char path[SYSGEN_MAX_VALUE];
+     /* LET variables */
+     char writer[SYSGEN_MAX_VALUE];
+     char readers[SYSGEN_MAX_VALUE];
+ } object_t;
+
+ /* Parsed configuration */
+ static struct {
+     object_t tasks[SYSGEN_MAX_OBJECTS];
+     int task_count;
+     object_t semaphores[SYSGEN_MAX_OBJECTS];
+     int semaphore_count;
+     object_t mutexes[SYSGEN_MAX_OBJECTS];
+     int mutex_count;
+     object_t queues[SYSGEN_MAX_OBJECTS];
+     int queue_count;
+     object_t event_groups[SYSGEN_MAX_OBJECTS];
+     int event_group_count;
+     object_t chains[SYSGEN_MAX_OBJECTS];
+     int chain_count;
+     object_t lets[SYSGEN_MAX_OBJECTS];
+     int let_count;
+     char includes[SYSGEN_MAX_INCLUDES][SYSGEN_MAX_VALUE];
+     int include_count;
+     long extra_tasks;
+     long extra_semaphores;
+     long extra_queues;
+     long extra_chains;
+     long extra_lets;
+     unsigned long long hash;     /* FNV-1a of sections and key/value pairs */
+ } cfg;
+
+ static const char* input_path;
+
+ /**
+  * Report an input error and exit
+  */
+ static void fail(int line, const char* fmt, ...) {
+     va_list args;
+
+     fprintf(stderr, "%s:%d: error: ", input_path, line);
+     va_start(args, fmt);
+     vfprintf(stderr, fmt, args);
+     va_end(args);
+     fputc('\n', stderr);
+
+     exit(1);
+ }
+
+ /**
+  * Strip leading and trailing whitespace in place
+  */
+ static char* trim(char* s) {
+     while (isspace((unsigned char)*s)) {
+         s++;
+     }
+
+     char* end = s + strlen(s);
+     while (end > s && isspace((unsigned char)end[-1])) {
+         *--end = '\0';
+     }
+
+     return s;
+ }
+
+ /**
+  * Check that a string is a valid C identifier
+  */
+ static int is_identifier(const char* s) {
+     if (!isalpha((unsigned char)*s) && *s != '_') {
+         return 0;
+     }
+
+     for (s++; *s != '\0'; s++) {
+         if (!isalnum((unsigned char)*s) && *s != '_') {
+             return 0;
+         }
+     }
+
+     return 1;
+ }
+
+ /**
+  * Parse a non-negative integer value
+  */
+ static long parse_number(const char* value, int line, const char* key) {
+     char* end = NULL;
+     long n = strtol(value, &end, 0);
+
+     if (*value == '\0' || *end != '\0' || n < 0) {
+         fail(line, "'%s' expects a non-negative integer, got '%s'", key, value);
+     }
+
+     return n;
+ }
+
+ /**
+  * Copy a value into a fixed-size field
+  */
+ static void set_string(char* dst, const char* value, int line) {
+     if (strlen(value) >= SYSGEN_MAX_VALUE) {
+         fail(line, "value too long: '%s'", value);
+     }
+
+     strcpy(dst, value);
+ }
+
+ /**
+  * Check that a handle is unique across all object kinds
+  */
+ static void check_unique(const char* handle, int line) {
+     const object_t* lists[] = { cfg.tasks, cfg.semaphores, cfg.mutexes,
+                                 cfg.queues, cfg.event_groups, cfg.chains, cfg.lets };
+     const int counts[] = { cfg.task_count, cfg.semaphore_count, cfg.mutex_count,
+                            cfg.queue_count, cfg.event_group_count, cfg.chain_count, cfg.let_count };
+
+     for (int k = 0; k < 7; k++) {
+         for (int i = 0; i < counts[k]; i++) {
+             if (strcmp(lists[k][i].handle, handle) == 0) {
+                 fail(line, "duplicate handle '%s' (first defined on line %d)",
+                      handle, lists[k][i].line);
+             }
+         }
+     }
+ }
+
+ /**
+  * Start a new object section
+  */
+ static object_t* begin_object(kind_t kind, const char* handle, int line) {
+     object_t* list = NULL;
+     int* count = NULL;
+
+     switch (kind) {
+         case KIND_TASK:        list = cfg.tasks;        count = &cfg.task_count;        break;
+         case KIND_SEMAPHORE:   list = cfg.semaphores;   count = &cfg.semaphore_count;   break;
+         case KIND_MUTEX:       list = cfg.mutexes;      count = &cfg.mutex_count;       break;
+         case KIND_QUEUE:       list = cfg.queues;       count = &cfg.queue_count;       break;
+         case KIND_EVENT_GROUP: list = cfg.event_groups; count = &cfg.event_group_count; break;
+         case KIND_CHAIN:       list = cfg.chains;       count = &cfg.chain_count;       break;
+         case KIND_LET:         list = cfg.lets;         count = &cfg.let_count;         break;
+         default:
+             return NULL;
+     }
+
+     if (!is_identifier(handle)) {
+         fail(line, "handle '%s' is not a C identifier", handle);
+     }
+     check_unique(handle, line);
+
+     if (*count >= SYSGEN_MAX_OBJECTS) {
+         fail(line, "too many objects of this kind (limit %d)", SYSGEN_MAX_OBJECTS);
+     }
+
+     object_t* obj = &list[(*count)++];
+     memset(obj, 0, sizeof(object_t));
+     set_string(obj->handle, handle, line);
+     set_string(obj->name, handle, line);
+     obj->line = line;
+     obj->priority = -1;
+     obj->max = 1;
+     strcpy(obj->arg, "NULL");
+     strcpy(obj->stack, "DEFAULT_STACK_SIZE");
+
+     return obj;
+ }
+
+ /**
+  * Parse a section header: [kind] or [kind handle]
+  */
+ static object_t* parse_section(char* text, int line, kind_t* kind) {
+     char* close = strchr(text, ']');
+     if (close == NULL || trim(close + 1)[0] != '\0') {
+         fail(line, "malformed section header");
+     }
+     *close = '\0';
+
+     char* word = trim(text + 1);
+     char* handle = word;
+     while (*handle != '\0' && !isspace((unsigned char)*handle)) {
+         handle++;
+     }
+     if (*handle != '\0') {
+         *handle++ = '\0';
+     }
+     handle = trim(handle);
+
+     if (strcmp(word, "system") == 0) {
+         if (*handle != '\0') {
+             fail(line, "[system] takes no handle");
+         }
+         *kind = KIND_SYSTEM;
+         return NULL;
+     }
+
+     if (strcmp(word, "task") == 0) {
+         *kind = KIND_TASK;
+     } else if (strcmp(word, "semaphore") == 0) {
+         *kind = KIND_SEMAPHORE;
+     } else if (strcmp(word, "mutex") == 0) {
+         *kind = KIND_MUTEX;
+     } else if (strcmp(word, "queue") == 0) {
+         *kind = KIND_QUEUE;
+     } else if (strcmp(word, "event_group") == 0) {
+         *kind = KIND_EVENT_GROUP;
+     } else if (strcmp(word, "chain") == 0) {
+         *kind = KIND_CHAIN;
+     } else if (strcmp(word, "let") == 0) {
+         *kind = KIND_LET;
+     } else {
+         fail(line, "unknown section kind '%s'", word);
+     }
+
+     if (*handle == '\0') {
+         fail(line, "[%s] needs a handle name", word);
+     }
+
+     return begin_object(*kind, handle, line);
+ }
+
+ /**
+  * Apply one key = value line to the current section
+  */
+ static void parse_key(kind_t kind, object_t* obj, const char* key, const char* value, int line) {
+     if (kind == KIND_NONE) {
+         fail(line, "'%s' outside of any section", key);
+     }
+
+     if (kind == KIND_SYSTEM) {
+         if (strcmp(key, "include") == 0) {
+             if (cfg.include_count >= SYSGEN_MAX_INCLUDES) {
+                 fail(line, "too many include lines");
+             }
+             set_string(cfg.includes[cfg.include_count++], value, line);
+         } else if (strcmp(key, "extra_tasks") == 0) {
+             cfg.extra_tasks = parse_number(value, line, key);
+         } else if (strcmp(key, "extra_semaphores") == 0) {
+             cfg.extra_semaphores = parse_number(value, line, key);
+         } else if (strcmp(key, "extra_queues") == 0) {
+             cfg.extra_queues = parse_number(value, line, key);
+         } else if (strcmp(key, "extra_chains") == 0) {
+             cfg.extra_chains = parse_number(value, line, key);
+         } else if (strcmp(key, "extra_lets") == 0) {
+             cfg.extra_lets = parse_number(value, line, key);
+         } else {
+             fail(line, "unknown [system] key '%s'", key);
+         }
+         return;
+     }
+
+     if (strcmp(key, "name") == 0) {
+         set_string(obj->name, value, line);
+         return;
+     }
+
+     switch (kind) {
+         case KIND_TASK:
+             if (strcmp(key, "entry") == 0) {
+                 if (!is_identifier(value)) {
+                     fail(line, "entry '%s' is not a C identifier", value);
+                 }
+                 set_string(obj->entry, value, line);
+             } else if (strcmp(key, "arg") == 0) {
+                 set_string(obj->arg, value, line);
+             } else if (strcmp(key, "priority") == 0) {
+                 obj->priority = parse_number(value, line, key);
+             } else if (strcmp(key, "stack") == 0) {
+                 set_string(obj->stack, value, line);
+             } else if (strcmp(key, "period_ms") == 0) {
+                 obj->period_ms = parse_number(value, line, key);
+             } else if (strcmp(key, "deadline_ms") == 0) {
+                 obj->deadline_ms = parse_number(value, line, key);
+             } else if (strcmp(key, "wcet_ms") == 0) {
+                 obj->wcet_ms = parse_number(value, line, key);
+             } else if (strcmp(key, "offset_ms") == 0) {
+                 obj->offset_ms = parse_number(value, line, key);
+             } else if (strcmp(key, "locks") == 0) {
+                 set_string(obj->locks, value, line);
+             } else if (strcmp(key, "type") == 0) {
+                 if (strcmp(value, "basic") == 0) {
+                     obj->basic = 1;
+                 } else if (strcmp(value, "extended") == 0) {
+                     obj->basic = 0;
+                 } else {
+                     fail(line, "task type must be 'extended' or 'basic'");
+                 }
+             } else {
+                 fail(line, "unknown task key '%s'", key);
+             }
+             break;
+
+         case KIND_SEMAPHORE:
+             if (strcmp(key, "initial") == 0) {
+                 obj->initial = parse_number(value, line, key);
+             } else if (strcmp(key, "max") == 0) {
+                 obj->max = parse_number(value, line, key);
+             } else {
+                 fail(line, "unknown semaphore key '%s'", key);
+             }
+             break;
+
+         case KIND_QUEUE:
+             if (strcmp(key, "msg_type") == 0) {
+                 set_string(obj->msg_type, value, line);
+             } else if (strcmp(key, "msg_size") == 0) {
+                 obj->msg_size = parse_number(value, line, key);
+             } else if (strcmp(key, "depth") == 0) {
+                 obj->depth = parse_number(value, line, key);
+             } else {
+                 fail(line, "unknown queue key '%s'", key);
+             }
+             break;
+
+         case KIND_CHAIN:
+             if (strcmp(key, "path") == 0) {
+                 set_string(obj->path, value, line);
+             } else if (strcmp(key, "deadline_ms") == 0) {
+                 obj->deadline_ms = parse_number(value, line, key);
+             } else {
+                 fail(line, "unknown chain key '%s'", key);
+             }
+             break;
+
+         case KIND_LET:
+             if (strcmp(key, "msg_type") == 0) {
+                 set_string(obj->msg_type, value, line);
+             } else if (strcmp(key, "msg_size") == 0) {
+                 obj->msg_size = parse_number(value, line, key);
+             } else if (strcmp(key, "writer") == 0) {
+                 set_string(obj->writer, value, line);
+             } else if (strcmp(key, "readers") == 0) {
+                 set_string(obj->readers, value, line);
+             } else {
+                 fail(line, "unknown let key '%s'", key);
+             }
+             break;
+
+         default:
+             fail(line, "unknown key '%s'", key);
+     }
+ }
+
+ /**
+  * Check a task's locks list: mutex handles with critical section lengths
+  */
+ static void validate_locks(const object_t* t) {
+     char list[SYSGEN_MAX_VALUE];
+
+     memcpy(list, t->locks, sizeof(list));
+     for (char* item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+         char* colon = strchr(item, ':');
+         int found = 0;
+
+         if (colon == NULL) {
+             fail(t->line, "task '%s': locks entries are <mutex>:<cs_ms>", t->handle);
+         }
+         *colon = '\0';
+         char* handle = trim(item);
+         for (int i = 0; i < cfg.mutex_count && !found; i++) {
+             found = (strcmp(cfg.mutexes[i].handle, handle) == 0);
+         }
+         if (!found) {
+             fail(t->line, "task '%s' locks '%s', which is not a mutex", t->handle, handle);
+         }
+         parse_number(trim(colon + 1), t->line, "locks");
+     }
+ }
+
+ /**
+  * Find an object by handle, NULL if there is none
+  */
+ static const object_t* find_object(const object_t* list, int count, const char* handle) {
+     for (int i = 0; i < count; i++) {
+         if (strcmp(list[i].handle, handle) == 0) {
+             return &list[i];
+         }
+     }
+
+     return NULL;
+ }
+
+ /**
+  * Split a chain path into its handles; tasks at even positions, queues between them
+  */
+ static int split_path(const object_t* c, char handles[][SYSGEN_MAX_VALUE]) {
+     char list[SYSGEN_MAX_VALUE];
+     int count = 0;
+
+     memcpy(list, c->path, sizeof(list));
+     for (char* item = list; item != NULL;) {
+         char* arrow = strstr(item, "->");
+         if (arrow != NULL) {
+             *arrow = '\0';
+         }
+         if (count == 2 * SYSGEN_MAX_STAGES - 1) {
+             fail(c->line, "chain '%s' has more than %d tasks", c->handle, SYSGEN_MAX_STAGES);
+         }
+         strcpy(handles[count], trim(item));
+         if (handles[count][0] == '\0') {
+             fail(c->line, "chain '%s': empty element in path", c->handle);
+         }
+         count++;
+         item = (arrow != NULL) ? arrow + 2 : NULL;
+     }
+
+     return count;
+ }
+
+ /**
+  * Check a chain's path: task -> queue -> task ..., starting and ending with a task
+  */
+ static void validate_chain(const object_t* c) {
+     char handles[2 * SYSGEN_MAX_STAGES - 1][SYSGEN_MAX_VALUE];
+
+     if (c->path[0] == '\0') {
+         fail(c->line, "chain '%s' has no path", c->handle);
+     }
+
+     int count = split_path(c, handles);
+     if (count % 2 == 0) {
+         fail(c->line, "chain '%s' must end with a task", c->handle);
+     }
+     for (int i = 0; i < count; i++) {
+         if (i % 2 == 0 && find_object(cfg.tasks, cfg.task_count, handles[i]) == NULL) {
+             fail(c->line, "chain '%s': '%s' is not a task", c->handle, handles[i]);
+         }
+         if (i % 2 == 1 && find_object(cfg.queues, cfg.queue_count, handles[i]) == NULL) {
+             fail(c->line, "chain '%s': '%s' is not a queue", c->handle, handles[i]);
+         }
+     }
+ }
+
+ /**
+  * Split a LET variable's readers list into task handles
+  */
+ static int split_readers(const object_t* l, char handles[][SYSGEN_MAX_VALUE]) {
+     char list[SYSGEN_MAX_VALUE];
+     int count = 0;
+
+     memcpy(list, l->readers, sizeof(list));
+     for (char* item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+         if (count == SYSGEN_MAX_READERS) {
+             fail(l->line, "let '%s' has more than %d readers", l->handle, SYSGEN_MAX_READERS);
+         }
+         strcpy(handles[count++], trim(item));
+     }
+
+     return count;
+ }
+
+ /**
+  * Check that a LET task is periodic with a deadline no longer than its period
+  */
+ static void validate_let_task(const object_t* l, const char* handle) {
+     const object_t* t = find_object(cfg.tasks, cfg.task_count, handle);
+
+     if (t == NULL) {
+         fail(l->line, "let '%s': '%s' is not a task", l->handle, handle);
+     }
+     if (t->period_ms == 0 || t->deadline_ms > t->period_ms) {
+         fail(l->line, "let '%s': task '%s' needs a period and a deadline no longer than it",
+              l->handle, handle);
+     }
+ }
+
+ /**
+  * Check a LET variable's size, writer and readers
+  */
+ static void validate_let(const object_t* l) {
+     char handles[SYSGEN_MAX_READERS][SYSGEN_MAX_VALUE];
+
+     if ((l->msg_type[0] == '\0') == (l->msg_size == 0)) {
+         fail(l->line, "let '%s' needs exactly one of msg_type or msg_size", l->handle);
+     }
+     if (l->writer[0] != '\0') {
+         validate_let_task(l, l->writer);
+     }
+
+     int count = split_readers(l, handles);
+     for (int i = 0; i < count; i++) {
+         validate_let_task(l, handles[i]);
+         for (int j = 0; j < i; j++) {
+             if (strcmp(handles[i], handles[j]) == 0) {
+                 fail(l->line, "let '%s' lists reader '%s' twice", l->handle, handles[i]);
+             }
+         }
+     }
+     if (l->writer[0] == '\0' && count == 0) {
+         fail(l->line, "let '%s' has neither a writer nor readers", l->handle);
+     }
+ }
+
+ /**
+  * Check required fields once the whole file is read
+  */
+ static void validate(void) {
+     for (int i = 0; i < cfg.task_count; i++) {
+         object_t* t = &cfg.tasks[i];
+         if (t->entry[0] == '\0') {
+             fail(t->line, "task '%s' has no entry function", t->handle);
+         }
+         if (t->priority < 0) {
+             fail(t->line, "task '%s' has no priority", t->handle);
+         }
+         if (t->deadline_ms > 0 && t->period_ms == 0) {
+             fail(t->line, "task '%s' has a deadline but no period", t->handle);
+         }
+         if (t->wcet_ms > 0 && t->period_ms == 0) {
+             fail(t->line, "task '%s' has a WCET but no period", t->handle);
+         }
+         if (t->offset_ms > 0 && t->offset_ms >= t->period_ms) {
+             fail(t->line, "task '%s' needs an offset below its period", t->handle);
+         }
+         validate_locks(t);
+     }
+
+     /* Basic jobs nest on the dispatching task's stack, so they must outrank it */
+     for (int i = 0; i < cfg.task_count; i++) {
+         object_t* b = &cfg.tasks[i];
+         if (!b->basic) {
+             continue;
+         }
+         for (int j = 0; j < cfg.task_count; j++) {
+             object_t* e = &cfg.tasks[j];
+             if (!e->basic && b->priority >= e->priority) {
+                 fail(b->line, "basic task '%s' needs a higher priority than extended task '%s'",
+                      b->handle, e->handle);
+             }
+         }
+     }
+
+     for (int i = 0; i < cfg.semaphore_count; i++) {
+         object_t* s = &cfg.semaphores[i];
+         if (s->max == 0 || s->initial > s->max) {
+             fail(s->line, "semaphore '%s' needs 0 <= initial <= max, max > 0", s->handle);
+         }
+     }
+
+     for (int i = 0; i < cfg.queue_count; i++) {
+         object_t* q = &cfg.queues[i];
+         if ((q->msg_type[0] == '\0') == (q->msg_size == 0)) {
+             fail(q->line, "queue '%s' needs exactly one of msg_type or msg_size", q->handle);
+         }
+         if (q->depth == 0) {
+             fail(q->line, "queue '%s' needs a non-zero depth", q->handle);
+         }
+     }
+
+     for (int i = 0; i < cfg.chain_count; i++) {
+         validate_chain(&cfg.chains[i]);
+     }
+
+     for (int i = 0; i < cfg.let_count; i++) {
+         validate_let(&cfg.lets[i]);
+     }
+ }
+
+ /**
+  * Mix a string and a separator into the configuration hash
+  */
+ static void hash_text(const char* s, char separator) {
+     for (; *s != '\0'; s++) {
+         cfg.hash = (cfg.hash ^ (unsigned char)*s) * FNV64_PRIME;
+     }
+     cfg.hash = (cfg.hash ^ (unsigned char)separator) * FNV64_PRIME;
+ }
+
+ /**
+  * Read and parse the configuration file
+  * Comments and spacing do not change the hash, so only edits that can
+  * change a run invalidate cached results (see utils/runcache.h)
+  */
+ static void parse_file(FILE* in) {
+     char buf[SYSGEN_MAX_LINE];
+     kind_t kind = KIND_NONE;
+     object_t* obj = NULL;
+     int line = 0;
+
+     cfg.hash = FNV64_OFFSET;
+     while (fgets(buf, sizeof(buf), in) != NULL) {
+         line++;
+
+         if (strchr(buf, '\n') == NULL && !feof(in)) {
+             fail(line, "line too long");
+         }
+
+         /* Drop comments */
+         char* hash = strchr(buf, '#');
+         if (hash != NULL) {
+             *hash = '\0';
+         }
+
+         char* text = trim(buf);
+         if (*text == '\0') {
+             continue;
+         }
+
+         if (*text == '[') {
+             hash_text(text, '\n');
+             obj = parse_section(text, line, &kind);
+             continue;
+         }
+
+         char* eq = strchr(text, '=');
+         if (eq == NULL) {
+             fail(line, "expected 'key = value'");
+         }
+         *eq = '\0';
+
+         char* key = trim(text);
+         char* value = trim(eq + 1);
+         if (*key == '\0' || *value == '\0') {
+             fail(line, "expected 'key = value'");
+         }
+
+         hash_text(key, '=');
+         hash_text(value, '\n');
+         parse_key(kind, obj, key, value, line);
+     }
+
+     validate();
+ }
+
+ /**
+  * Sort tasks by priority, keeping file order within a level
+  */
+ static void sort_tasks(void) {
+     for (int i = 1; i < cfg.task_count; i++) {
+         object_t tmp = cfg.tasks[i];
+         int j = i - 1;
+         while (j >= 0 && cfg.tasks[j].priority > tmp.priority) {
+             cfg.tasks[j + 1] = cfg.tasks[j];
+             j--;
+         }
+         cfg.tasks[j + 1] = tmp;
+     }
+ }
+
+ /**
+  * Open an output file named <base><suffix>
+  */
+ static FILE* open_output(const char* base, const char* suffix, char* path, size_t path_size) {
+     snprintf(path, path_size, "%s%s", base, suffix);
+
+     FILE* out = fopen(path, "w");
+     if (out == NULL) {
+         fprintf(stderr, "sysgen: cannot write %s\n", path);
+         exit(1);
+     }
+
+     return out;
+ }
+
+ /**
+  * Upper-case copy of an identifier, for macro names
+  */
+ static const char* upper(const char* s) {
+     static char buf[SYSGEN_MAX_VALUE];
+     size_t i;
+
+     for (i = 0; s[i] != '\0' && i < sizeof(buf) - 1; i++) {
+         buf[i] = (char)toupper((unsigned char)s[i]);
+     }
+     buf[i] = '\0';
+
+     return buf;
+ }
+
+ /**
+  * Larger of two counts
+  */
+ static long max_long(long a, long b) {
+     return (a > b) ? a : b;
+ }
+
+ /**
+  * Emit the limits header (pure macros, safe to include from config.h)
+  */
+ static void emit_limits(FILE* out, const char* guard) {
+     /* Mutexes and event groups share the semaphore pool limit */
+     long sems = max_long(cfg.semaphore_count, max_long(cfg.mutex_count, cfg.event_group_count));
+     long let_bindings = 0;
+
+     for (int i = 0; i < cfg.let_count; i++) {
+         char handles[SYSGEN_MAX_READERS][SYSGEN_MAX_VALUE];
+         let_bindings += split_readers(&cfg.lets[i], handles) + (cfg.lets[i].writer[0] != '\0');
+     }
+
+     fprintf(out, "/* Generated by sysgen from %s - do not edit */\n\n", input_path);
+     fprintf(out, "#ifndef %s_LIMITS_H\n#define %s_LIMITS_H\n\n", guard, guard);
+     fprintf(out, "#define SYSCONF_TASK_COUNT        %d\n", cfg.task_count);
+     fprintf(out, "#define SYSCONF_SEMAPHORE_COUNT   %d\n", cfg.semaphore_count);
+     fprintf(out, "#define SYSCONF_MUTEX_COUNT       %d\n", cfg.mutex_count);
+     fprintf(out, "#define SYSCONF_QUEUE_COUNT       %d\n", cfg.queue_count);
+     fprintf(out, "#define SYSCONF_EVENT_GROUP_COUNT %d\n", cfg.event_group_count);
+     fprintf(out, "#define SYSCONF_CHAIN_COUNT       %d\n", cfg.chain_count);
+     fprintf(out, "#define SYSCONF_LET_COUNT         %d\n\n", cfg.let_count);
+     fprintf(out, "/* Kernel pools sized from the configuration (+1 task for idle) */\n");
+     fprintf(out, "#define MAX_TASKS                 %ld\n", cfg.task_count + 1 + cfg.extra_tasks);
+     fprintf(out, "#define MAX_SEMAPHORES            %ld\n", max_long(1, sems + cfg.extra_semaphores));
+     fprintf(out, "#define MAX_QUEUES                %ld\n", max_long(1, cfg.queue_count + cfg.extra_queues));
+     fprintf(out, "#define MAX_CHAINS                %ld\n", max_long(1, cfg.chain_count + cfg.extra_chains));
+     fprintf(out, "#define MAX_LET_VARS              %ld\n", max_long(1, cfg.let_count + cfg.extra_lets));
+     fprintf(out, "/* LET bindings: configured ones, plus a writer and a reader per extra variable */\n");
+     fprintf(out, "#define MAX_LET_BINDINGS          %ld\n\n", max_long(1, let_bindings + 2 * cfg.extra_lets));
+     fprintf(out, "#endif /* %s_LIMITS_H */\n", guard);
+ }
+
+ /**
+  * Emit the handle header
+  */
+ static void emit_header(FILE* out, const char* guard) {
+     fprintf(out, "/* Generated by sysgen from %s - do not edit */\n\n", input_path);
+     fprintf(out, "#ifndef %s_H\n#define %s_H\n\n", guard, guard);
+     fprintf(out, "#include \"kernel/sysconf.h\"\n\n");
+
+     fprintf(out, "/* Task table indices (tasks are sorted by priority) */\n");
+     for (int i = 0; i < cfg.task_count; i++) {
+         fprintf(out, "#define SYSCONF_TASK_%s %d\n", upper(cfg.tasks[i].handle), i);
+     }
+
+     fprintf(out, "\n/* Object handles, valid after sysconf_apply() */\n");
+     for (int i = 0; i < cfg.task_count; i++) {
+         fprintf(out, "extern task_t* %s;\n", cfg.tasks[i].handle);
+     }
+     for (int i = 0; i < cfg.semaphore_count; i++) {
+         fprintf(out, "extern semaphore_t* %s;\n", cfg.semaphores[i].handle);
+     }
+     for (int i = 0; i < cfg.mutex_count; i++) {
+         fprintf(out, "extern mutex_t* %s;\n", cfg.mutexes[i].handle);
+     }
+     for (int i = 0; i < cfg.queue_count; i++) {
+         fprintf(out, "extern queue_t* %s;\n", cfg.queues[i].handle);
+     }
+     for (int i = 0; i < cfg.event_group_count; i++) {
+         fprintf(out, "extern event_group_t* %s;\n", cfg.event_groups[i].handle);
+     }
+     for (int i = 0; i < cfg.chain_count; i++) {
+         fprintf(out, "extern chain_t* %s;\n", cfg.chains[i].handle);
+     }
+     for (int i = 0; i < cfg.let_count; i++) {
+         fprintf(out, "extern let_var_t* %s;\n", cfg.lets[i].handle);
+     }
+
+     fprintf(out, "\n/* Configuration hash, keys cached simulation results */\n");
+     fprintf(out, "#define SYSCONF_HASH 0x%016llxULL\n", cfg.hash);
+
+     fprintf(out, "\n/* Complete system configuration */\n");
+     fprintf(out, "extern const sysconf_t sysconf_system;\n\n");
+     fprintf(out, "#endif /* %s_H */\n", guard);
+ }
+
+ /**
+  * Emit the tables and storage
+  */
+ static void emit_source(FILE* out, const char* header_name) {
+     fprintf(out, "/* Generated by sysgen from %s - do not edit */\n\n", input_path);
+     fprintf(out, "#include \"%s\"\n", header_name);
+     for (int i = 0; i < cfg.include_count; i++) {
+         fprintf(out, "#include \"%s\"\n", cfg.includes[i]);
+     }
+
+     /* Entry points */
+     fprintf(out, "\n/* Task entry points */\n");
+     for (int i = 0; i < cfg.task_count; i++) {
+         int seen = 0;
+         for (int j = 0; j < i; j++) {
+             seen |= (strcmp(cfg.tasks[j].entry, cfg.tasks[i].entry) == 0);
+         }
+         if (!seen) {
+             fprintf(out, "extern void %s(void* arg);\n", cfg.tasks[i].entry);
+         }
+     }
+
+     /* Handles */
+     fprintf(out, "\n/* Object handles */\n");
+     for (int i = 0; i < cfg.task_count; i++) {
+         fprintf(out, "task_t* %s;\n", cfg.tasks[i].handle);
+     }
+     for (int i = 0; i < cfg.semaphore_count; i++) {
+         fprintf(out, "semaphore_t* %s;\n", cfg.semaphores[i].handle);
+     }
+     for (int i = 0; i < cfg.mutex_count; i++) {
+         fprintf(out, "mutex_t* %s;\n", cfg.mutexes[i].handle);
+     }
+     for (int i = 0; i < cfg.queue_count; i++) {
+         fprintf(out, "queue_t* %s;\n", cfg.queues[i].handle);
+     }
+     for (int i = 0; i < cfg.event_group_count; i++) {
+         fprintf(out, "event_group_t* %s;\n", cfg.event_groups[i].handle);
+     }
+     for (int i = 0; i < cfg.chain_count; i++) {
+         fprintf(out, "chain_t* %s;\n", cfg.chains[i].handle);
+     }
+     for (int i = 0; i < cfg.let_count; i++) {
+         fprintf(out, "let_var_t* %s;\n", cfg.lets[i].handle);
+     }
+
+     /* Storage */
+     fprintf(out, "\n/* Task storage */\n");
+     for (int i = 0; i < cfg.task_count; i++) {
+         const object_t* t = &cfg.tasks[i];
+         if (t->basic) {
+             continue;  /* Basic tasks run on the dispatching task's stack */
+         }
+         fprintf(out, "static task_t sysconf_tcb_%s;\n", t->handle);
+         fprintf(out, "static uint32_t sysconf_stack_%s[((%s) + 3) / 4];\n", t->handle, t->stack);
+     }
+
+     if (cfg.queue_count > 0) {
+         fprintf(out, "\n/* Queue storage */\n");
+     }
+     for (int i = 0; i < cfg.queue_count; i++) {
+         const object_t* q = &cfg.queues[i];
+         if (q->msg_type[0] != '\0') {
+             fprintf(out, "static %s sysconf_qbuf_%s[%ld];\n", q->msg_type, q->handle, q->depth);
+         } else {
+             fprintf(out, "static uint32_t sysconf_qbuf_%s[(%ld * %ld + 3) / 4];\n",
+                     q->handle, q->msg_size, q->depth);
+         }
+     }
+
+     /* Tables */
+     if (cfg.task_count > 0) {
+         fprintf(out, "\nstatic const sysconf_task_t sysconf_tasks[] = {\n");
+         for (int i = 0; i < cfg.task_count; i++) {
+             const object_t* t = &cfg.tasks[i];
+             fprintf(out, "    { \"%s\", %ld, %s, %s, %s, ",
+                     t->name, t->priority,
+                     t->basic ? "TASK_TYPE_BASIC" : "TASK_TYPE_EXTENDED",
+                     t->entry, t->arg);
+             if (t->basic) {
+                 fprintf(out, "NULL, NULL, 0, ");
+             } else {
+                 fprintf(out, "&sysconf_tcb_%s, sysconf_stack_%s, sizeof(sysconf_stack_%s), ",
+                         t->handle, t->handle, t->handle);
+             }
+             fprintf(out, "%ld / MILLISECONDS_PER_TICK, %ld / MILLISECONDS_PER_TICK, "
+                     "(%ld + MILLISECONDS_PER_TICK - 1) / MILLISECONDS_PER_TICK, "
+                     "%ld / MILLISECONDS_PER_TICK, &%s },\n",
+                     t->period_ms, t->deadline_ms, t->wcet_ms, t->offset_ms, t->handle);
+         }
+         fprintf(out, "};\n");
+     }
+
+     if (cfg.semaphore_count > 0) {
+         fprintf(out, "\nstatic const sysconf_semaphore_t sysconf_semaphores[] = {\n");
+         for (int i = 0; i < cfg.semaphore_count; i++) {
+             const object_t* s = &cfg.semaphores[i];
+             fprintf(out, "    { \"%s\", %ld, %ld, &%s },\n", s->name, s->initial, s->max, s->handle);
+         }
+         fprintf(out, "};\n");
+     }
+
+     if (cfg.mutex_count > 0) {
+         fprintf(out, "\nstatic const sysconf_mutex_t sysconf_mutexes[] = {\n");
+         for (int i = 0; i < cfg.mutex_count; i++) {
+             fprintf(out, "    { \"%s\", &%s },\n", cfg.mutexes[i].name, cfg.mutexes[i].handle);
+         }
+         fprintf(out, "};\n");
+     }
+
+     if (cfg.queue_count > 0) {
+         fprintf(out, "\nstatic const sysconf_queue_t sysconf_queues[] = {\n");
+         for (int i = 0; i < cfg.queue_count; i++) {
+             const object_t* q = &cfg.queues[i];
+             if (q->msg_type[0] != '\0') {
+                 fprintf(out, "    { \"%s\", sizeof(%s), %ld, sysconf_qbuf_%s, &%s },\n",
+                         q->name, q->msg_type, q->depth, q->handle, q->handle);
+             } else {
+                 fprintf(out, "    { \"%s\", %ld, %ld, sysconf_qbuf_%s, &%s },\n",
+                         q->name, q->msg_size, q->depth, q->handle, q->handle);
+             }
+         }
+         fprintf(out, "};\n");
+     }
+
+     if (cfg.event_group_count > 0) {
+         fprintf(out, "\nstatic const sysconf_event_group_t sysconf_event_groups[] = {\n");
+         for (int i = 0; i < cfg.event_group_count; i++) {
+             fprintf(out, "    { \"%s\", &%s },\n", cfg.event_groups[i].name, cfg.event_groups[i].handle);
+         }
+         fprintf(out, "};\n");
+     }
+
+     if (cfg.chain_count > 0) {
+         fprintf(out, "\n/* Chain stages */\n");
+     }
+     for (int i = 0; i < cfg.chain_count; i++) {
+         const object_t* c = &cfg.chains[i];
+         char handles[2 * SYSGEN_MAX_STAGES - 1][SYSGEN_MAX_VALUE];
+         int count = split_path(c, handles);
+
+         fprintf(out, "static task_t** const sysconf_chain_tasks_%s[] = {", c->handle);
+         for (int k = 0; k < count; k += 2) {
+             fprintf(out, "%s &%s", (k > 0) ? "," : "", handles[k]);
+         }
+         fprintf(out, " };\n");
+         if (count > 1) {
+             fprintf(out, "static queue_t** const sysconf_chain_links_%s[] = {", c->handle);
+             for (int k = 1; k < count; k += 2) {
+                 fprintf(out, "%s &%s", (k > 1) ? "," : "", handles[k]);
+             }
+             fprintf(out, " };\n");
+         }
+     }
+
+     if (cfg.chain_count > 0) {
+         fprintf(out, "\nstatic const sysconf_chain_t sysconf_chains[] = {\n");
+         for (int i = 0; i < cfg.chain_count; i++) {
+             const object_t* c = &cfg.chains[i];
+             char handles[2 * SYSGEN_MAX_STAGES - 1][SYSGEN_MAX_VALUE];
+             int count = split_path(c, handles);
+
+             fprintf(out, "    { \"%s\", sysconf_chain_tasks_%s, ", c->name, c->handle);
+             if (count > 1) {
+                 fprintf(out, "sysconf_chain_links_%s, ", c->handle);
+             } else {
+                 fprintf(out, "NULL, ");
+             }
+             fprintf(out, "%d, %ldu * 1000u, &%s },\n", (count + 1) / 2, c->deadline_ms, c->handle);
+         }
+         fprintf(out, "};\n");
+     }
+
+     if (cfg.let_count > 0) {
+         fprintf(out, "\n/* LET readers */\n");
+     }
+     for (int i = 0; i < cfg.let_count; i++) {
+         const object_t* l = &cfg.lets[i];
+         char handles[SYSGEN_MAX_READERS][SYSGEN_MAX_VALUE];
+         int count = split_readers(l, handles);
+
+         if (count > 0) {
+             fprintf(out, "static task_t** const sysconf_let_readers_%s[] = {", l->handle);
+             for (int k = 0; k < count; k++) {
+                 fprintf(out, "%s &%s", (k > 0) ? "," : "", handles[k]);
+             }
+             fprintf(out, " };\n");
+         }
+     }
+
+     if (cfg.let_count > 0) {
+         fprintf(out, "\nstatic const sysconf_let_t sysconf_lets[] = {\n");
+         for (int i = 0; i < cfg.let_count; i++) {
+             const object_t* l = &cfg.lets[i];
+             char handles[SYSGEN_MAX_READERS][SYSGEN_MAX_VALUE];
+             int count = split_readers(l, handles);
+
+             if (l->msg_type[0] != '\0') {
+                 fprintf(out, "    { \"%s\", sizeof(%s), ", l->name, l->msg_type);
+             } else {
+                 fprintf(out, "    { \"%s\", %ld, ", l->name, l->msg_size);
+             }
+             if (l->writer[0] != '\0') {
+                 fprintf(out, "&%s, ", l->writer);
+             } else {
+                 fprintf(out, "NULL, ");
+             }
+             if (count > 0) {
+                 fprintf(out, "sysconf_let_readers_%s, ", l->handle);
+             } else {
+                 fprintf(out, "NULL, ");
+             }
+             fprintf(out, "%d, &%s },\n", count, l->handle);
+         }
+         fprintf(out, "};\n");
+     }
+
+     /* Top-level table; empty kinds get NULL so no zero-length arrays are emitted */
+     fprintf(out, "\nconst sysconf_t sysconf_system = {\n");
+     fprintf(out, "    %s, %d,\n", cfg.task_count ? "sysconf_tasks" : "NULL", cfg.task_count);
+     fprintf(out, "    %s, %d,\n", cfg.semaphore_count ? "sysconf_semaphores" : "NULL", cfg.semaphore_count);
+     fprintf(out, "    %s, %d,\n", cfg.mutex_count ? "sysconf_mutexes" : "NULL", cfg.mutex_count);
+     fprintf(out, "    %s, %d,\n", cfg.queue_count ? "sysconf_queues" : "NULL", cfg.queue_count);
+     fprintf(out, "    %s, %d,\n", cfg.event_group_count ? "sysconf_event_groups" : "NULL", cfg.event_group_count);
+     fprintf(out, "    %s, %d,\n", cfg.chain_count ? "sysconf_chains" : "NULL", cfg.chain_count);
+     fprintf(out, "    %s, %d\n", cfg.let_count ? "sysconf_lets" : "NULL", cfg.let_count);
+     fprintf(out, "};\n");
+ }
+
+ /**
+  * Main entry point
+  */
+ int main(int argc, char* argv[]) {
+     char path[512];
+     char guard[SYSGEN_MAX_VALUE];
+
+     if (argc != 3) {
+         fprintf(stderr, "Usage: %s <config.sysconf> <output-base>\n", argv[0]);
+         return 1;
+     }
+
+     input_path = argv[1];
+     FILE* in = fopen(input_path, "r");
+     if (in == NULL) {
+         fprintf(stderr, "sysgen: cannot open %s\n", input_path);
+         return 1;
+     }
+
+     parse_file(in);
+     fclose(in);
+     sort_tasks();
+
+     /* Header names and guards derive from the output base name */
+     const char* base = argv[2];
+     const char* base_name = strrchr(base, '/');
+     base_name = (base_name != NULL) ? base_name + 1 : base;
+     snprintf(guard, sizeof(guard), "%s", upper(base_name));
+     for (char* p = guard; *p != '\0'; p++) {
+         if (!isalnum((unsigned char)*p)) {
+             *p = '_';
+         }
+     }
+
+     FILE* out = open_output(base, "_limits.h", path, sizeof(path));
+     emit_limits(out, guard);
+     fclose(out);
+
+     out = open_output(base, ".h", path, sizeof(path));
+     emit_header(out, guard);
+     fclose(out);
+
+     char header_name[SYSGEN_MAX_VALUE + 2];
+     snprintf(header_name, sizeof(header_name), "%s.h", base_name);
+     out = open_output(base, ".c", path, sizeof(path));
+     emit_source(out, header_name);
+     fclose(out);
+
+     printf("sysgen: %d tasks, %d semaphores, %d mutexes, %d queues, %d event groups, %d chains, "
+            "%d LET variables\n",
+            cfg.task_count, cfg.semaphore_count, cfg.mutex_count,
+            cfg.queue_count, cfg.event_group_count, cfg.chain_count, cfg.let_count);
+
+     return 0;
+ }
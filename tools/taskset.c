@@ -0,0 +1,735 @@
+/**
+ * @file taskset.c
+ * @brief Periodic task set loading for the offline analysis tools
+ */
+
+ #define _POSIX_C_SOURCE 200809L
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <ctype.h>
+ #include <limits.h>
+ #include <time.h>
+ #include "taskset.h"
+ #include "config.h"
+
+ #define LINE_MAX_LEN     256
+
+ /* What taskset_save() does with a source line */
+ #define LINE_COPY        0
+ #define LINE_ROW         1       /* Table row: rewrite */
+ #define LINE_PRIORITY    2       /* .sysconf priority key */
+ #define LINE_OFFSET      3       /* .sysconf offset_ms key */
+ #define LINE_PERIOD      4       /* .sysconf period_ms key, offset key to add after it */
+
+ /**
+  * Strip leading and trailing whitespace in place
+  */
+ static char* trim(char* s) {
+     while (isspace((unsigned char)*s)) {
+         s++;
+     }
+
+     char* end = s + strlen(s);
+     while (end > s && isspace((unsigned char)end[-1])) {
+         *--end = '\0';
+     }
+
+     return s;
+ }
+
+ /**
+  * Append a task, growing the array as needed
+  */
+ static taskset_task_t* add_task(taskset_t* ts, int* capacity) {
+     if (ts->count == *capacity) {
+         int grown = (*capacity > 0) ? *capacity * 2 : 64;
+         taskset_task_t* tasks = realloc(ts->tasks, (size_t)grown * sizeof(taskset_task_t));
+         if (tasks == NULL) {
+             return NULL;
+         }
+         ts->tasks = tasks;
+         *capacity = grown;
+     }
+
+     taskset_task_t* task = &ts->tasks[ts->count++];
+     memset(task, 0, sizeof(*task));
+     return task;
+ }
+
+ /**
+  * Index of a mutex by name, adding it on first use
+  */
+ static int mutex_index(taskset_t* ts, const char* name) {
+     for (int i = 0; i < ts->mutex_count; i++) {
+         if (strcmp(ts->mutexes[i], name) == 0) {
+             return i;
+         }
+     }
+
+     char (*mutexes)[TASKSET_NAME_LEN] = realloc(ts->mutexes,
+                                                 (size_t)(ts->mutex_count + 1) * TASKSET_NAME_LEN);
+     if (mutexes == NULL) {
+         return -1;
+     }
+     ts->mutexes = mutexes;
+     snprintf(ts->mutexes[ts->mutex_count], TASKSET_NAME_LEN, "%s", name);
+
+     return ts->mutex_count++;
+ }
+
+ /**
+  * Parse one "mutex:length" critical section; ms_per_unit converts a .sysconf length to ticks
+  */
+ static int parse_lock(taskset_t* ts, taskset_task_t* task, char* text, int ms_per_unit) {
+     char* colon = strchr(text, ':');
+     char* end;
+
+     if (colon == NULL || task->lock_count == TASKSET_MAX_LOCKS) {
+         return -1;
+     }
+     *colon = '\0';
+
+     char* name = trim(text);
+     unsigned long length = strtoul(trim(colon + 1), &end, 10);
+     if (*name == '\0' || *end != '\0') {
+         return -1;
+     }
+
+     int mutex = mutex_index(ts, name);
+     if (mutex < 0) {
+         return -1;
+     }
+
+     /* Critical sections round up to a tick, like WCETs */
+     if (ms_per_unit > 0) {
+         length = (length + MILLISECONDS_PER_TICK - 1) / MILLISECONDS_PER_TICK;
+     }
+     task->locks[task->lock_count].mutex = mutex;
+     task->locks[task->lock_count].length = (uint32_t)length;
+     task->lock_count++;
+
+     return 0;
+ }
+
+ /**
+  * Parse a chain path: task handles with the queues between them
+  */
+ static int parse_path(taskset_chain_t* chain, char* text) {
+     int position = 0;
+
+     for (char* item = text; item != NULL; position++) {
+         char* arrow = strstr(item, "->");
+         if (arrow != NULL) {
+             *arrow = '\0';
+         }
+         item = trim(item);
+         if (*item == '\0' || position == 2 * TASKSET_MAX_STAGES - 1) {
+             return -1;
+         }
+         if (position % 2 == 0) {
+             snprintf(chain->stages[chain->stage_count++], TASKSET_NAME_LEN, "%s", item);
+         } else {
+             snprintf(chain->links[chain->stage_count], TASKSET_NAME_LEN, "%s", item);
+         }
+         item = (arrow != NULL) ? arrow + 2 : NULL;
+     }
+
+     return (position % 2 == 1) ? 0 : -1;
+ }
+
+ /**
+  * Find each chain stage among the loaded (periodic) tasks
+  */
+ static void resolve_chains(taskset_t* ts) {
+     for (int c = 0; c < ts->chain_count; c++) {
+         taskset_chain_t* chain = &ts->chains[c];
+         for (int k = 0; k < chain->stage_count; k++) {
+             chain->tasks[k] = -1;
+             for (int i = 0; i < ts->count; i++) {
+                 if (strcmp(ts->tasks[i].handle, chain->stages[k]) == 0) {
+                     chain->tasks[k] = i;
+                     break;
+                 }
+             }
+         }
+     }
+ }
+
+ /**
+  * Finish a task read from a .sysconf section
+  */
+ static void end_sysconf_task(taskset_t* ts, long period_ms, long deadline_ms, long wcet_ms,
+                              long offset_ms) {
+     taskset_task_t* task = &ts->tasks[ts->count - 1];
+
+     if (period_ms <= 0) {
+         ts->count--;
+         ts->skipped++;
+         return;
+     }
+
+     /* Same conversion as the tables sysgen generates */
+     task->period = (uint32_t)(period_ms / MILLISECONDS_PER_TICK);
+     task->deadline = (uint32_t)(deadline_ms / MILLISECONDS_PER_TICK);
+     task->wcet = (uint32_t)((wcet_ms + MILLISECONDS_PER_TICK - 1) / MILLISECONDS_PER_TICK);
+     task->offset = (uint32_t)(offset_ms / MILLISECONDS_PER_TICK);
+     if (task->deadline == 0) {
+         task->deadline = task->period;
+     }
+ }
+
+ /**
+  * Read the [task] and [chain] sections of a system configuration
+  */
+ static int load_sysconf(FILE* in, const char* path, taskset_t* ts) {
+     char buf[LINE_MAX_LEN];
+     int capacity = 0;
+     int in_task = 0;
+     int in_chain = 0;
+     long period_ms = 0, deadline_ms = 0, wcet_ms = 0, offset_ms = 0;
+     int line = 0;
+
+     while (fgets(buf, sizeof(buf), in) != NULL) {
+         line++;
+
+         char* hash = strchr(buf, '#');
+         if (hash != NULL) {
+             *hash = '\0';
+         }
+         char* text = trim(buf);
+         if (*text == '\0') {
+             continue;
+         }
+
+         if (*text == '[') {
+             if (in_task) {
+                 end_sysconf_task(ts, period_ms, deadline_ms, wcet_ms, offset_ms);
+             }
+             char* close = strchr(text, ']');
+             if (close != NULL) {
+                 *close = '\0';
+             }
+             in_task = (strncmp(text, "[task", 5) == 0 && isspace((unsigned char)text[5]));
+             in_chain = (strncmp(text, "[chain", 6) == 0 && isspace((unsigned char)text[6]));
+             if (in_chain) {
+                 taskset_chain_t* chains = realloc(ts->chains,
+                                                   (size_t)(ts->chain_count + 1) * sizeof(taskset_chain_t));
+                 if (chains == NULL) {
+                     fprintf(stderr, "%s: out of memory\n", path);
+                     return -1;
+                 }
+                 ts->chains = chains;
+                 taskset_chain_t* chain = &ts->chains[ts->chain_count++];
+                 memset(chain, 0, sizeof(*chain));
+                 snprintf(chain->name, sizeof(chain->name), "%s", trim(text + 6));
+                 chain->line = line;
+             }
+             if (in_task) {
+                 taskset_task_t* task = add_task(ts, &capacity);
+                 if (task == NULL) {
+                     fprintf(stderr, "%s: out of memory\n", path);
+                     return -1;
+                 }
+                 snprintf(task->name, sizeof(task->name), "%s", trim(text + 5));
+                 snprintf(task->handle, sizeof(task->handle), "%s", task->name);
+                 task->priority = -1;
+                 task->line = line;
+                 period_ms = deadline_ms = wcet_ms = offset_ms = 0;
+             }
+             continue;
+         }
+
+         char* eq = strchr(text, '=');
+         if ((!in_task && !in_chain) || eq == NULL) {
+             continue;
+         }
+         *eq = '\0';
+         char* key = trim(text);
+         char* value = trim(eq + 1);
+
+         if (in_chain) {
+             taskset_chain_t* chain = &ts->chains[ts->chain_count - 1];
+             if (strcmp(key, "name") == 0) {
+                 snprintf(chain->name, sizeof(chain->name), "%s", value);
+             } else if (strcmp(key, "deadline_ms") == 0) {
+                 chain->deadline = (uint32_t)(atol(value) / MILLISECONDS_PER_TICK);
+             } else if (strcmp(key, "path") == 0 && parse_path(chain, value) != 0) {
+                 fprintf(stderr, "%s:%d: expected 'path = task -> queue -> task ...' (at most %d tasks)\n",
+                         path, line, TASKSET_MAX_STAGES);
+                 return -1;
+             }
+             continue;
+         }
+
+         taskset_task_t* task = &ts->tasks[ts->count - 1];
+
+         if (strcmp(key, "name") == 0) {
+             snprintf(task->name, sizeof(task->name), "%s", value);
+         } else if (strcmp(key, "priority") == 0) {
+             task->priority = atoi(value);
+             task->priority_line = line;
+         } else if (strcmp(key, "locks") == 0) {
+             for (char* item = strtok(value, ","); item != NULL; item = strtok(NULL, ",")) {
+                 if (parse_lock(ts, task, item, 1) != 0) {
+                     fprintf(stderr, "%s:%d: expected 'locks = mutex:cs_ms, ...' (at most %d)\n",
+                             path, line, TASKSET_MAX_LOCKS);
+                     return -1;
+                 }
+             }
+         } else if (strcmp(key, "period_ms") == 0) {
+             period_ms = atol(value);
+             task->period_line = line;
+         } else if (strcmp(key, "offset_ms") == 0) {
+             offset_ms = atol(value);
+             task->offset_line = line;
+         } else if (strcmp(key, "deadline_ms") == 0) {
+             deadline_ms = atol(value);
+         } else if (strcmp(key, "wcet_ms") == 0) {
+             wcet_ms = atol(value);
+         }
+     }
+
+     if (in_task) {
+         end_sysconf_task(ts, period_ms, deadline_ms, wcet_ms, offset_ms);
+     }
+
+     for (int i = 0; i < ts->count; i++) {
+         if (ts->tasks[i].priority < 0 || ts->tasks[i].period == 0 ||
+             ts->tasks[i].offset >= ts->tasks[i].period) {
+             fprintf(stderr, "%s:%d: task '%s' needs a priority, a period of at least one tick "
+                     "and an offset below it\n", path, ts->tasks[i].line, ts->tasks[i].name);
+             return -1;
+         }
+     }
+
+     resolve_chains(ts);
+
+     return 0;
+ }
+
+ /**
+  * Read a table of tasks
+  */
+ static int load_table(FILE* in, const char* path, taskset_t* ts) {
+     char buf[LINE_MAX_LEN];
+     int capacity = 0;
+     int line = 0;
+
+     while (fgets(buf, sizeof(buf), in) != NULL) {
+         line++;
+
+         char* hash = strchr(buf, '#');
+         if (hash != NULL) {
+             *hash = '\0';
+         }
+         char* text = trim(buf);
+         if (*text == '\0') {
+             continue;
+         }
+
+         taskset_task_t* task = add_task(ts, &capacity);
+         if (task == NULL) {
+             fprintf(stderr, "%s: out of memory\n", path);
+             return -1;
+         }
+
+         /* Fixed columns, then an optional blocking column and mutex:cs columns */
+         char* fields[6];
+         int count = 0;
+         char* token = strtok(text, " \t");
+         for (; token != NULL && count < 6 && strchr(token, ':') == NULL; token = strtok(NULL, " \t")) {
+             fields[count++] = token;
+         }
+
+         unsigned long period = 0, deadline = 0, wcet = 0, blocking = 0;
+         if (count >= 5) {
+             task->priority = atoi(fields[1]);
+             period = strtoul(fields[2], NULL, 10);
+             deadline = strtoul(fields[3], NULL, 10);
+             wcet = strtoul(fields[4], NULL, 10);
+             blocking = (count == 6) ? strtoul(fields[5], NULL, 10) : 0;
+         }
+         int bad = (count < 5 || task->priority < 0 || period == 0);
+         for (; token != NULL && !bad; token = strtok(NULL, " \t")) {
+             if (strncmp(token, "offset=", 7) == 0) {
+                 task->offset = (uint32_t)strtoul(token + 7, NULL, 10);
+             } else {
+                 bad = (parse_lock(ts, task, token, 0) != 0);
+             }
+         }
+         if (bad || task->offset >= period) {
+             fprintf(stderr, "%s:%d: expected 'name priority period deadline wcet [blocking] "
+                     "[mutex:cs ...] [offset=N]' with offset below period\n", path, line);
+             return -1;
+         }
+
+         snprintf(task->name, sizeof(task->name), "%s", fields[0]);
+         task->period = (uint32_t)period;
+         task->deadline = (deadline > 0) ? (uint32_t)deadline : (uint32_t)period;
+         task->wcet = (uint32_t)wcet;
+         task->blocking = (uint32_t)blocking;
+         task->line = line;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Load a task set from a .sysconf file or a table
+  */
+ int taskset_load(const char* path, taskset_t* ts) {
+     memset(ts, 0, sizeof(*ts));
+
+     FILE* in = fopen(path, "r");
+     if (in == NULL) {
+         fprintf(stderr, "cannot open %s\n", path);
+         return -1;
+     }
+
+     size_t length = strlen(path);
+     ts->sysconf = (length > 8 && strcmp(path + length - 8, ".sysconf") == 0);
+     int result = ts->sysconf ? load_sysconf(in, path, ts) : load_table(in, path, ts);
+     fclose(in);
+
+     if (result == 0 && ts->count == 0) {
+         fprintf(stderr, "%s: no periodic tasks\n", path);
+         result = -1;
+     }
+     if (result != 0) {
+         taskset_free(ts);
+         return result;
+     }
+
+     taskset_update_blocking(ts);
+     return 0;
+ }
+
+ /**
+  * Free a loaded task set
+  */
+ void taskset_free(taskset_t* ts) {
+     free(ts->tasks);
+     free(ts->mutexes);
+     free(ts->chains);
+     ts->tasks = NULL;
+     ts->mutexes = NULL;
+     ts->chains = NULL;
+     ts->count = 0;
+     ts->mutex_count = 0;
+     ts->chain_count = 0;
+ }
+
+ /**
+  * Total utilization
+  */
+ double taskset_utilization(const taskset_t* ts) {
+     double u = 0.0;
+
+     for (int i = 0; i < ts->count; i++) {
+         u += (double)ts->tasks[i].wcet / ts->tasks[i].period;
+     }
+
+     return u;
+ }
+
+ /**
+  * Compare task indices by period, then deadline, then file order
+  */
+ static const taskset_t* sort_set;
+ static int compare_rate(const void* a, const void* b) {
+     const taskset_task_t* x = &sort_set->tasks[*(const int*)a];
+     const taskset_task_t* y = &sort_set->tasks[*(const int*)b];
+
+     if (x->period != y->period) {
+         return (x->period < y->period) ? -1 : 1;
+     }
+     if (x->deadline != y->deadline) {
+         return (x->deadline < y->deadline) ? -1 : 1;
+     }
+     return *(const int*)a - *(const int*)b;
+ }
+
+ /**
+  * Compare task indices by priority, then file order
+  */
+ static int compare_priority(const void* a, const void* b) {
+     const taskset_task_t* x = &sort_set->tasks[*(const int*)a];
+     const taskset_task_t* y = &sort_set->tasks[*(const int*)b];
+
+     if (x->priority != y->priority) {
+         return (x->priority < y->priority) ? -1 : 1;
+     }
+     return *(const int*)a - *(const int*)b;
+ }
+
+ /**
+  * Task indices sorted with a comparator (caller frees)
+  */
+ static int* sorted_order(const taskset_t* ts, int (*compare)(const void*, const void*)) {
+     int* order = malloc((size_t)ts->count * sizeof(int));
+     if (order == NULL) {
+         return NULL;
+     }
+
+     for (int i = 0; i < ts->count; i++) {
+         order[i] = i;
+     }
+     sort_set = ts;
+     qsort(order, (size_t)ts->count, sizeof(int), compare);
+
+     return order;
+ }
+
+ /**
+  * Give every task a rate-monotonic priority
+  */
+ void taskset_assign_rm(taskset_t* ts) {
+     int* order = sorted_order(ts, compare_rate);
+     if (order == NULL) {
+         return;
+     }
+
+     for (int i = 0; i < ts->count; i++) {
+         ts->tasks[order[i]].priority = i;
+     }
+     free(order);
+
+     taskset_update_blocking(ts);
+ }
+
+ /**
+  * Recompute the mutex blocking terms (priority inheritance)
+  */
+ void taskset_update_blocking(taskset_t* ts) {
+     if (ts->mutex_count == 0) {
+         for (int i = 0; i < ts->count; i++) {
+             ts->tasks[i].lock_blocking = 0;
+         }
+         return;
+     }
+
+     /* Highest-priority user of each mutex, and longest section below each task */
+     int* top = malloc((size_t)ts->mutex_count * sizeof(int));
+     uint32_t* longest = malloc((size_t)ts->mutex_count * sizeof(uint32_t));
+     if (top == NULL || longest == NULL) {
+         free(top);
+         free(longest);
+         return;
+     }
+
+     for (int r = 0; r < ts->mutex_count; r++) {
+         top[r] = INT_MAX;
+     }
+     for (int j = 0; j < ts->count; j++) {
+         for (int k = 0; k < ts->tasks[j].lock_count; k++) {
+             int r = ts->tasks[j].locks[k].mutex;
+             if (ts->tasks[j].priority < top[r]) {
+                 top[r] = ts->tasks[j].priority;
+             }
+         }
+     }
+
+     for (int i = 0; i < ts->count; i++) {
+         taskset_task_t* task = &ts->tasks[i];
+         uint64_t blocking = 0;
+
+         memset(longest, 0, (size_t)ts->mutex_count * sizeof(uint32_t));
+         for (int j = 0; j < ts->count; j++) {
+             if (ts->tasks[j].priority <= task->priority) {
+                 continue;
+             }
+             for (int k = 0; k < ts->tasks[j].lock_count; k++) {
+                 const taskset_lock_t* lock = &ts->tasks[j].locks[k];
+                 if (lock->length > longest[lock->mutex]) {
+                     longest[lock->mutex] = lock->length;
+                 }
+             }
+         }
+
+         /* Under inheritance each such mutex can block once per job */
+         for (int r = 0; r < ts->mutex_count; r++) {
+             if (top[r] <= task->priority) {
+                 blocking += longest[r];
+             }
+         }
+         task->lock_blocking = (blocking > UINT32_MAX) ? UINT32_MAX : (uint32_t)blocking;
+     }
+
+     free(top);
+     free(longest);
+ }
+
+ /**
+  * Analysis parameters of a task
+  */
+ void taskset_params(const taskset_task_t* task, rta_params_t* params) {
+     params->period = task->period;
+     params->deadline = task->deadline;
+     params->wcet = task->wcet;
+     uint64_t blocking = (uint64_t)task->blocking + task->lock_blocking;
+     params->blocking = (blocking > UINT32_MAX) ? UINT32_MAX : (uint32_t)blocking;
+     params->priority = (uint16_t)task->priority;
+ }
+
+ /**
+  * Build an analyzed RTA set
+  */
+ int taskset_build(const taskset_t* ts, rta_set_t* set, rta_entry_t* entries) {
+     if (ts->count >= RTA_NONE || rta_set_init(set, entries, (uint16_t)ts->count) != 0) {
+         return -1;
+     }
+
+     /* Highest priority first, so each task added only analyzes its own level */
+     int* order = sorted_order(ts, compare_priority);
+     if (order == NULL) {
+         return -1;
+     }
+
+     int result = 0;
+     for (int k = 0; k < ts->count && result == 0; k++) {
+         const taskset_task_t* task = &ts->tasks[order[k]];
+         rta_params_t params;
+
+         taskset_params(task, &params);
+         if (task->priority >= RTA_NONE || rta_set_task(set, (uint16_t)order[k], &params) != 0) {
+             result = -1;
+         }
+     }
+
+     free(order);
+     return result;
+ }
+
+ /**
+  * Copy the trailing comment of a line, with the spacing before it
+  */
+ static void write_comment(FILE* out, const char* start, size_t span) {
+     const char* comment = memchr(start, '#', span);
+
+     if (comment != NULL) {
+         while (comment > start && isspace((unsigned char)comment[-1])) {
+             comment--;
+         }
+         fwrite(comment, 1, span - (size_t)(comment - start), out);
+     }
+ }
+
+ /**
+  * Write the current priorities and offsets into a copy of the source file
+  */
+ int taskset_save(const taskset_t* ts, const char* source, const char* path) {
+     FILE* in = fopen(source, "rb");
+     if (in == NULL) {
+         fprintf(stderr, "cannot open %s\n", source);
+         return -1;
+     }
+
+     /* Read the whole source first, so path may name the same file */
+     size_t length = 0;
+     size_t capacity = 4096;
+     char* text = malloc(capacity + 1);
+     while (text != NULL) {
+         length += fread(text + length, 1, capacity - length, in);
+         if (length < capacity) {
+             break;
+         }
+         capacity *= 2;
+         char* grown = realloc(text, capacity + 1);
+         if (grown == NULL) {
+             free(text);
+         }
+         text = grown;
+     }
+     fclose(in);
+     if (text == NULL) {
+         fprintf(stderr, "%s: out of memory\n", source);
+         return -1;
+     }
+     text[length] = '\0';
+
+     FILE* out = fopen(path, "w");
+     if (out == NULL) {
+         fprintf(stderr, "cannot write %s\n", path);
+         free(text);
+         return -1;
+     }
+
+     int line = 0;
+     for (char* start = text; *start != '\0';) {
+         char* end = strchr(start, '\n');
+         size_t span = (end != NULL) ? (size_t)(end - start) : strlen(start);
+         const taskset_task_t* task = NULL;
+         int kind = LINE_COPY;
+
+         line++;
+         for (int i = 0; i < ts->count && task == NULL; i++) {
+             const taskset_task_t* t = &ts->tasks[i];
+             if (!ts->sysconf) {
+                 kind = (t->line == line) ? LINE_ROW : LINE_COPY;
+             } else if (t->priority_line == line) {
+                 kind = LINE_PRIORITY;
+             } else if (t->offset_line == line) {
+                 kind = LINE_OFFSET;
+             } else if (t->period_line == line && t->offset_line == 0 && t->offset > 0) {
+                 kind = LINE_PERIOD;
+             }
+             if (kind != LINE_COPY) {
+                 task = t;
+             }
+         }
+
+         switch (kind) {
+             case LINE_ROW:
+                 fprintf(out, "%s %d %u %u %u %u", task->name, task->priority, task->period,
+                         task->deadline, task->wcet, task->blocking);
+                 for (int k = 0; k < task->lock_count; k++) {
+                     fprintf(out, " %s:%u", ts->mutexes[task->locks[k].mutex], task->locks[k].length);
+                 }
+                 if (task->offset > 0) {
+                     fprintf(out, " offset=%u", task->offset);
+                 }
+                 write_comment(out, start, span);
+                 break;
+             case LINE_PRIORITY:
+                 fprintf(out, "priority = %d", task->priority);
+                 write_comment(out, start, span);
+                 break;
+             case LINE_OFFSET:
+                 fprintf(out, "offset_ms = %lu", (unsigned long)task->offset * MILLISECONDS_PER_TICK);
+                 write_comment(out, start, span);
+                 break;
+             case LINE_PERIOD:
+                 /* No offset key yet: add one after the period */
+                 fwrite(start, 1, span, out);
+                 fprintf(out, "\noffset_ms = %lu", (unsigned long)task->offset * MILLISECONDS_PER_TICK);
+                 break;
+             default:
+                 fwrite(start, 1, span, out);
+                 break;
+         }
+
+         if (end == NULL) {
+             break;
+         }
+         fputc('\n', out);
+         start = end + 1;
+     }
+
+     free(text);
+     if (fclose(out) != 0) {
+         fprintf(stderr, "cannot write %s\n", path);
+         return -1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Monotonic time in seconds
+  */
+ double taskset_now_s(void) {
+     struct timespec t;
+     clock_gettime(CLOCK_MONOTONIC, &t);
+     return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+ }
@@ -0,0 +1,166 @@
+/**
+ * @file taskset.h
+ * @brief Periodic task sets for the offline analysis tools
+ *
+ * Loads the periodic tasks of a system configuration (.sysconf, the
+ * sysgen input) or of a plain table, and builds response-time analysis
+ * sets (kernel/rta.h) from them. Times are kept in kernel ticks, with
+ * the same conversion sysgen applies: periods and deadlines round down,
+ * WCETs round up.
+ *
+ * Table format, one task per line, times in ticks:
+ *
+ *     # name  priority  period  deadline  wcet  [blocking]  [mutex:cs ...]  [offset=N]
+ *     sensor  0         10      10        2     0           bus:1          offset=3
+ *
+ * Release offsets come from the offset_ms key of a .sysconf task or an
+ * offset=N column of a table; releases fall on offset + k * period.
+ *
+ * Critical sections come from the "locks = mutex:cs_ms, ..." key of a
+ * .sysconf task, or from mutex:cs columns of a table. The blocking term
+ * of each task adds the worst case under priority inheritance (the
+ * kernel's mutex protocol) to any explicit blocking: for every mutex
+ * used by the task or a task of equal or higher priority, the longest
+ * critical section a lower-priority task holds on it.
+ *
+ * Aperiodic tasks of a .sysconf file are skipped; they are outside the
+ * periodic analysis.
+ *
+ * Cause-effect chains come from the [chain] sections of a .sysconf file
+ * ("path = task -> queue -> task ..."); tables have none.
+ */
+
+ #ifndef TASKSET_H
+ #define TASKSET_H
+
+ #include <stdint.h>
+ #include "kernel/rta.h"
+
+ #define TASKSET_NAME_LEN     64
+ #define TASKSET_MAX_LOCKS    8       /* Mutexes one task can use */
+ #define TASKSET_MAX_STAGES   8       /* Tasks per chain */
+
+ /* Critical section of a task on one mutex */
+ typedef struct {
+     int mutex;                   /* Index into taskset_t.mutexes */
+     uint32_t length;             /* Longest critical section, ticks */
+ } taskset_lock_t;
+
+ /* One periodic task */
+ typedef struct {
+     char name[TASKSET_NAME_LEN];
+     char handle[TASKSET_NAME_LEN];  /* Section handle (.sysconf only) */
+     int priority;                /* 0 = highest */
+     uint32_t period;             /* Ticks */
+     uint32_t deadline;           /* Ticks (never 0 after loading) */
+     uint32_t wcet;               /* Ticks */
+     uint32_t offset;             /* Release offset, ticks */
+     uint32_t blocking;           /* Explicit blocking, ticks */
+     uint32_t lock_blocking;      /* Mutex blocking at the current priorities, ticks */
+     taskset_lock_t locks[TASKSET_MAX_LOCKS];
+     int lock_count;
+     int line;                    /* Line of the task's section or table row */
+     int priority_line;           /* Line of the priority key (.sysconf only) */
+     int period_line;             /* Line of the period_ms key (.sysconf only) */
+     int offset_line;             /* Line of the offset_ms key, 0 if none (.sysconf only) */
+ } taskset_task_t;
+
+ /* Cause-effect chain */
+ typedef struct {
+     char name[TASKSET_NAME_LEN];
+     char stages[TASKSET_MAX_STAGES][TASKSET_NAME_LEN];  /* Task handles, in data-flow order */
+     char links[TASKSET_MAX_STAGES][TASKSET_NAME_LEN];   /* Queue feeding each stage (links[0] empty) */
+     int tasks[TASKSET_MAX_STAGES];  /* Index of each stage's task, -1 if it is not periodic */
+     int stage_count;
+     uint32_t deadline;           /* End-to-end deadline, ticks (0 = none) */
+     int line;                    /* Line of the chain's section */
+ } taskset_chain_t;
+
+ /* Loaded task set */
+ typedef struct {
+     taskset_task_t* tasks;
+     int count;
+     int skipped;                 /* Aperiodic tasks left out */
+     char (*mutexes)[TASKSET_NAME_LEN];
+     int mutex_count;
+     taskset_chain_t* chains;
+     int chain_count;
+     int sysconf;                 /* 1 if loaded from a .sysconf file */
+ } taskset_t;
+
+ /**
+  * @brief Load a task set from a .sysconf file or a table
+  *
+  * @param path File to read (".sysconf" suffix selects the configuration format)
+  * @param ts Receives the task set (free with taskset_free)
+  * @return int 0 on success, negative on error (reported on stderr)
+  */
+ int taskset_load(const char* path, taskset_t* ts);
+
+ /**
+  * @brief Free a loaded task set
+  *
+  * @param ts Task set
+  */
+ void taskset_free(taskset_t* ts);
+
+ /**
+  * @brief Total utilization (sum of wcet / period)
+  *
+  * @param ts Task set
+  * @return double Utilization
+  */
+ double taskset_utilization(const taskset_t* ts);
+
+ /**
+  * @brief Give every task a rate-monotonic priority (shorter period first)
+  * Also recomputes the mutex blocking terms.
+  *
+  * @param ts Task set
+  */
+ void taskset_assign_rm(taskset_t* ts);
+
+ /**
+  * @brief Recompute every task's mutex blocking term from the current priorities
+  *
+  * @param ts Task set
+  */
+ void taskset_update_blocking(taskset_t* ts);
+
+ /**
+  * @brief Write the task set's current priorities and offsets into a copy of its source file
+  * Other lines are copied unchanged.
+  *
+  * @param ts Task set
+  * @param source File the task set was loaded from
+  * @param path File to write (may be source)
+  * @return int 0 on success, negative on error (reported on stderr)
+  */
+ int taskset_save(const taskset_t* ts, const char* source, const char* path);
+
+ /**
+  * @brief Analysis parameters of a task (blocking includes the mutex term)
+  *
+  * @param task Task
+  * @param params Receives the parameters
+  */
+ void taskset_params(const taskset_task_t* task, rta_params_t* params);
+
+ /**
+  * @brief Build an analyzed RTA set, task i under ID i
+  *
+  * @param ts Task set
+  * @param set Set to initialize
+  * @param entries Storage for ts->count entries
+  * @return int 0 on success, negative on error
+  */
+ int taskset_build(const taskset_t* ts, rta_set_t* set, rta_entry_t* entries);
+ 
+ /**
+  * @brief Monotonic time in seconds, for reporting analysis run times
+  *
+  * @return double Seconds since an arbitrary start
+  */
+ double taskset_now_s(void);
+
+ #endif /* TASKSET_H */
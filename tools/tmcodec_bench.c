@@ -0,0 +1,237 @@
+/**
+ * @file tmcodec_bench.c
+ * @brief Throughput and ratio benchmark for the telemetry codec
+ *
+ * Generates a synthetic housekeeping stream (temperatures and voltages
+ * drifting slowly, counters, modes, orbit position and status flags),
+ * encodes it with and without the LZ stage, decodes every block and
+ * checks the round trip. Reports compression ratio and encode/decode
+ * throughput in MB/s of uncompressed telemetry.
+ *
+ * Usage: tmcodec_bench [-f frames] [-n fields] [-s seed]
+ */
+
+ #define _POSIX_C_SOURCE 200809L
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <unistd.h>
+ #include <time.h>
+ #include "utils/tmcodec.h"
+
+ #define DEFAULT_FRAMES   200000
+ #define DEFAULT_FIELDS   24
+
+ /* Encoded stream kept in memory so decoding is timed separately */
+ typedef struct {
+     uint8_t* data;
+     uint32_t length;
+     uint32_t capacity;
+     uint32_t blocks;
+ } stream_t;
+
+ /* Round-trip check state */
+ typedef struct {
+     const uint32_t* frames;      /* Original values, fields per frame */
+     const uint32_t* valid;       /* Original valid masks */
+     uint32_t fields;
+     uint32_t next;               /* Next expected frame */
+     uint32_t mismatches;
+ } check_t;
+
+ static uint32_t rng_state;
+
+ /**
+  * xorshift32
+  */
+ static uint32_t rng(void) {
+     rng_state ^= rng_state << 13;
+     rng_state ^= rng_state >> 17;
+     rng_state ^= rng_state << 5;
+     return rng_state;
+ }
+
+ /**
+  * Monotonic time in seconds
+  */
+ static double now_s(void) {
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+ }
+
+ /**
+  * Sink: append each block, length-prefixed, to the stream
+  */
+ static int stream_sink(const uint8_t* block, uint32_t length, void* ctx) {
+     stream_t* s = (stream_t*)ctx;
+
+     if (s->length + 2 + length > s->capacity) {
+         s->capacity = (s->capacity + 2 + length) * 2;
+         s->data = realloc(s->data, s->capacity);
+         if (s->data == NULL) {
+             return -1;
+         }
+     }
+
+     s->data[s->length++] = (uint8_t)(length & 0xFF);
+     s->data[s->length++] = (uint8_t)(length >> 8);
+     memcpy(&s->data[s->length], block, length);
+     s->length += length;
+     s->blocks++;
+
+     return 0;
+ }
+
+ /**
+  * Compare a decoded frame with the original
+  */
+ static void check_frame(uint32_t tick, const uint32_t* values, uint32_t valid, void* ctx) {
+     check_t* c = (check_t*)ctx;
+     const uint32_t* expect = &c->frames[(size_t)c->next * c->fields];
+
+     if (tick != c->next * 100 || valid != c->valid[c->next]) {
+         c->mismatches++;
+     } else {
+         for (uint32_t i = 0; i < c->fields; i++) {
+             if ((valid & (1u << i)) && values[i] != expect[i]) {
+                 c->mismatches++;
+                 break;
+             }
+         }
+     }
+     c->next++;
+ }
+
+ /**
+  * Fill frames with a synthetic housekeeping stream
+  */
+ static void generate(uint32_t* frames, uint32_t* valid, uint32_t count, uint32_t fields,
+                      uint8_t* types) {
+     float level[TMCODEC_MAX_FIELDS];
+     uint32_t counter[TMCODEC_MAX_FIELDS];
+
+     for (uint32_t i = 0; i < fields; i++) {
+         types[i] = (i % 3 == 2) ? TMCODEC_FIELD_INT : TMCODEC_FIELD_FLOAT;
+         level[i] = 20.0f + (float)(rng() % 100) / 10.0f;
+         counter[i] = rng() % 1000;
+     }
+
+     for (uint32_t f = 0; f < count; f++) {
+         uint32_t* row = &frames[(size_t)f * fields];
+         valid[f] = (fields < 32) ? (1u << fields) - 1 : 0xFFFFFFFFu;
+
+         for (uint32_t i = 0; i < fields; i++) {
+             if (types[i] == TMCODEC_FIELD_FLOAT) {
+                 if (i % 2 == 0) {
+                     /* Thermistor: 0.25 degree steps, drifting */
+                     int step = (int)(rng() % 5) - 2;
+                     level[i] += (step == 2 ? 0.25f : step == -2 ? -0.25f : 0.0f);
+                 } else {
+                     /* Bus voltage: small noise around a level */
+                     level[i] = 28.0f + (float)((int)(rng() % 21) - 10) * 0.01f;
+                 }
+                 memcpy(&row[i], &level[i], sizeof(float));
+             } else {
+                 switch (i % 4) {
+                     case 0:  counter[i] += 1; break;                     /* Packet counter */
+                     case 1:  counter[i] += (rng() % 64 == 0); break;     /* Event counter */
+                     case 2:  counter[i] = (f / 54) % 360; break;         /* Orbit position */
+                     default: counter[i] = (f / 5000) % 5; break;         /* Mode */
+                 }
+                 row[i] = counter[i];
+             }
+         }
+
+         /* Occasionally a sensor drops out */
+         if (rng() % 500 == 0) {
+             valid[f] &= ~(1u << (rng() % fields));
+         }
+     }
+ }
+
+ /**
+  * Encode and decode the stream once and print the results
+  */
+ static int run(const char* label, uint8_t flags, const uint32_t* frames, const uint32_t* valid,
+                uint32_t count, uint32_t fields, const uint8_t* types) {
+     static tmcodec_encoder_t enc;
+     static tmcodec_decoder_t dec;
+     stream_t stream = { NULL, 0, 0, 0 };
+     check_t check = { frames, valid, fields, 0, 0 };
+     tmcodec_stats_t stats;
+
+     tmcodec_encoder_init(&enc, types, (uint8_t)fields, flags, stream_sink, &stream);
+
+     double t0 = now_s();
+     for (uint32_t f = 0; f < count; f++) {
+         if (tmcodec_encode(&enc, f * 100, &frames[(size_t)f * fields], valid[f]) != 0) {
+             fprintf(stderr, "encode failed\n");
+             return -1;
+         }
+     }
+     tmcodec_flush(&enc);
+     double t1 = now_s();
+
+     tmcodec_decoder_init(&dec, types, (uint8_t)fields);
+     for (uint32_t pos = 0; pos < stream.length; ) {
+         uint32_t length = (uint32_t)stream.data[pos] | ((uint32_t)stream.data[pos + 1] << 8);
+         if (tmcodec_decode(&dec, &stream.data[pos + 2], length, check_frame, &check) < 0) {
+             fprintf(stderr, "decode failed at offset %u\n", pos);
+             return -1;
+         }
+         pos += 2 + length;
+     }
+     double t2 = now_s();
+
+     tmcodec_get_stats(&enc, &stats);
+     double mb = (double)stats.input_bytes / 1e6;
+     printf("%-12s ratio %5.2f (delta %5.2f)  encode %7.1f MB/s  decode %7.1f MB/s  "
+            "blocks %u (lz %u)  %s\n",
+            label, (double)stats.input_bytes / stats.output_bytes,
+            (double)stats.input_bytes / stats.coded_bytes,
+            mb / (t1 - t0), mb / (t2 - t1), stats.blocks, stats.lz_blocks,
+            (check.mismatches == 0 && check.next == count) ? "round trip ok" : "ROUND TRIP FAILED");
+
+     free(stream.data);
+     return (check.mismatches == 0 && check.next == count) ? 0 : -1;
+ }
+
+ int main(int argc, char* argv[]) {
+     uint32_t count = DEFAULT_FRAMES;
+     uint32_t fields = DEFAULT_FIELDS;
+     uint8_t types[TMCODEC_MAX_FIELDS];
+     int opt;
+
+     rng_state = 1;
+     while ((opt = getopt(argc, argv, "f:n:s:")) != -1) {
+         switch (opt) {
+             case 'f': count = (uint32_t)atoi(optarg); break;
+             case 'n': fields = (uint32_t)atoi(optarg); break;
+             case 's': rng_state = (uint32_t)atoi(optarg) | 1; break;
+             default:
+                 fprintf(stderr, "Usage: %s [-f frames] [-n fields] [-s seed]\n", argv[0]);
+                 return 1;
+         }
+     }
+     if (count == 0 || fields == 0 || fields > TMCODEC_MAX_FIELDS) {
+         fprintf(stderr, "Need 1+ frames and 1..%d fields\n", TMCODEC_MAX_FIELDS);
+         return 1;
+     }
+
+     uint32_t* frames = malloc((size_t)count * fields * sizeof(uint32_t));
+     uint32_t* valid = malloc((size_t)count * sizeof(uint32_t));
+     if (frames == NULL || valid == NULL) {
+         fprintf(stderr, "Out of memory\n");
+         return 1;
+     }
+     generate(frames, valid, count, fields, types);
+
+     printf("%u frames x %u fields, %u-byte blocks\n", count, fields, TMCODEC_BLOCK_SIZE);
+     int result = run("delta", 0, frames, valid, count, fields, types);
+     result |= run("delta+lz", TMCODEC_FLAG_LZ, frames, valid, count, fields, types);
+
+     free(frames);
+     free(valid);
+     return result ? 1 : 0;
+ }
@@ -0,0 +1,852 @@
+/**
+ * @file trace_analyze.c
+ * @brief Offline analysis of kernel event traces
+ *
+ * Reconstructs per-job response times from a trace written by the
+ * kernel trace facility (kernel/trace.h). It attributes every
+ * microsecond a job spends off the CPU to a cause: preempted by a
+ * task, blocked on a mutex (split by which task ran meanwhile), or
+ * blocked on a queue, semaphore or event. It also detects
+ * priority-inversion intervals and prints ranked reports, including
+ * the critical path of each task's worst job.
+ *
+ * The trace is streamed in fixed-size chunks. The main thread reads a
+ * chunk and annotates it with state that needs a global view (mutex
+ * owners, inversions). Worker threads then process the chunk in
+ * parallel, each owning a subset of the tasks. Memory stays bounded by
+ * the chunk pool, whatever the trace length.
+ *
+ * Usage: trace_analyze [-j threads] [-n top] [-c chunk_events] <trace>
+ */
+
+ #define _POSIX_C_SOURCE 200809L
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <unistd.h>
+ #include <pthread.h>
+ #include "kernel/trace.h"
+
+ #define MAX_IDS          256     /* Task ids are one byte */
+ #define MAX_THREADS      32      /* Worker threads */
+ #define CHUNK_SLOTS      8       /* Chunks in flight */
+ #define DEFAULT_CHUNK    65536   /* Events per chunk */
+ #define DEFAULT_TOP      10      /* Entries per ranked report */
+ #define HIST_BINS        256     /* Response-time histogram bins */
+ #define NUM_REASONS      8       /* block_reason_t values */
+ #define OWNER_SLOTS      1024    /* Mutex owner hash table */
+
+ /* Chunk of events shared by all workers */
+ typedef struct {
+     trace_event_t* events;
+     uint8_t* owners;             /* Mutex owner at each BLOCK event */
+     uint32_t count;
+     int refs;                    /* Workers still processing */
+ } chunk_t;
+
+ /* Where a job's time went */
+ typedef struct {
+     uint64_t exec;                       /* Running */
+     uint64_t ready_by[MAX_IDS];          /* Ready, while this task ran */
+     uint64_t mutex_by[MAX_IDS];          /* Blocked on mutex, while this task ran */
+     uint64_t blocked[NUM_REASONS];       /* Blocked, by reason */
+     uint8_t mutex_owner;                 /* Owner at the last mutex block */
+ } breakdown_t;
+
+ /* Per-task analysis state (owned by exactly one worker) */
+ typedef struct {
+     int in_job;
+     uint64_t release;            /* Job start */
+     uint64_t deadline;           /* Absolute deadline (0 = none) */
+     uint64_t mark;               /* Start of the current phase */
+     int phase;                   /* PHASE_* */
+     uint8_t reason;              /* Block reason in PHASE_BLOCKED */
+     uint8_t owner;               /* Mutex owner in PHASE_BLOCKED */
+     breakdown_t job;             /* Current job */
+     breakdown_t worst;           /* Worst job so far */
+     uint64_t worst_response;
+     uint64_t worst_release;
+     uint64_t jobs;
+     uint64_t misses;
+     uint64_t total_response;
+     uint64_t hist[HIST_BINS];
+     breakdown_t total;           /* All jobs */
+ } job_state_t;
+
+ #define PHASE_IDLE     0         /* Not ready (between jobs) */
+ #define PHASE_READY    1
+ #define PHASE_RUNNING  2
+ #define PHASE_BLOCKED  3
+
+ /* Priority-inversion interval */
+ typedef struct {
+     uint8_t high;                /* Blocked task */
+     uint8_t owner;               /* Lower-priority mutex owner */
+     uint64_t start;
+     uint64_t duration;
+     uint64_t unbounded;          /* Time other lower-priority tasks ran */
+     uint8_t worst_intruder;      /* Task contributing most unbounded time */
+ } inversion_t;
+
+ /* Worker context */
+ typedef struct {
+     int index;
+     pthread_t thread;
+     uint8_t running;             /* Running task as seen in the event stream */
+     uint64_t last_time;
+ } worker_t;
+
+ static trace_header_t header;
+ static trace_task_info_t infos[MAX_IDS];
+ static uint8_t known[MAX_IDS];
+ static job_state_t tasks[MAX_IDS];
+
+ static int num_workers = 0;
+ static int top_n = DEFAULT_TOP;
+ static uint32_t chunk_events = DEFAULT_CHUNK;
+
+ /* Chunk pipeline */
+ static chunk_t slots[CHUNK_SLOTS];
+ static uint64_t published = 0;
+ static int finished = 0;
+ static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+ static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+ /* Producer-side global state */
+ static struct {
+     uint32_t object;
+     uint8_t owner;
+     uint8_t used;
+ } owners[OWNER_SLOTS];
+ static inversion_t open_inv[MAX_IDS];
+ static uint8_t inv_open[MAX_IDS];
+ static uint64_t inv_intruder[MAX_IDS][MAX_IDS];
+ static inversion_t* inversions = NULL;
+ static size_t inversion_count = 0;
+ static size_t inversion_cap = 0;
+ static uint8_t prod_running = TRACE_NO_TASK;
+ static uint64_t prod_last = 0;
+
+ static const char* reason_names[NUM_REASONS] = {
+     "none", "delay", "semaphore", "queue full", "queue empty", "event", "mutex", "?"
+ };
+
+ /**
+  * Task name for reports
+  */
+ static const char* task_name(uint8_t id) {
+     static char buf[4][24];
+     static int next = 0;
+
+     if (id == TRACE_NO_TASK) {
+         return "(none)";
+     }
+     if (known[id]) {
+         return infos[id].name;
+     }
+
+     char* b = buf[next++ & 3];
+     snprintf(b, sizeof(buf[0]), "task#%u", id);
+     return b;
+ }
+
+ /**
+  * Base priority of a task (unknown tasks rank lowest)
+  */
+ static int task_priority(uint8_t id) {
+     return (id != TRACE_NO_TASK && known[id]) ? infos[id].priority : 255;
+ }
+
+ /* ------------------------------------------------------------------ */
+ /* Producer: global annotation                                         */
+ /* ------------------------------------------------------------------ */
+
+ /**
+  * Find or create the owner slot of a mutex
+  */
+ static uint8_t* owner_slot(uint32_t object) {
+     uint32_t h = (object * 2654435761U) % OWNER_SLOTS;
+
+     for (uint32_t i = 0; i < OWNER_SLOTS; i++) {
+         uint32_t s = (h + i) % OWNER_SLOTS;
+         if (!owners[s].used) {
+             owners[s].used = 1;
+             owners[s].object = object;
+             owners[s].owner = TRACE_NO_TASK;
+             return &owners[s].owner;
+         }
+         if (owners[s].object == object) {
+             return &owners[s].owner;
+         }
+     }
+
+     fprintf(stderr, "trace_analyze: too many mutexes\n");
+     exit(1);
+ }
+
+ /**
+  * Account elapsed time to open inversion intervals
+  */
+ static void inversion_advance(uint64_t now) {
+     uint64_t dt = now - prod_last;
+
+     if (prod_last == 0 || dt == 0) {
+         prod_last = now;
+         return;
+     }
+
+     for (int h = 0; h < MAX_IDS; h++) {
+         if (!inv_open[h]) {
+             continue;
+         }
+         inversion_t* inv = &open_inv[h];
+         uint8_t r = prod_running;
+         if (r != TRACE_NO_TASK && r != inv->owner && r != h &&
+             task_priority(r) > task_priority((uint8_t)h)) {
+             inv->unbounded += dt;
+             inv_intruder[h][r] += dt;
+         }
+     }
+
+     prod_last = now;
+ }
+
+ /**
+  * Close an inversion interval and keep it for the report
+  */
+ static void inversion_close(uint8_t h, uint64_t now) {
+     inversion_t* inv = &open_inv[h];
+
+     inv->duration = now - inv->start;
+     uint64_t best = 0;
+     inv->worst_intruder = TRACE_NO_TASK;
+     for (int r = 0; r < MAX_IDS; r++) {
+         if (inv_intruder[h][r] > best) {
+             best = inv_intruder[h][r];
+             inv->worst_intruder = (uint8_t)r;
+         }
+     }
+     memset(inv_intruder[h], 0, sizeof(inv_intruder[h]));
+
+     if (inversion_count == inversion_cap) {
+         inversion_cap = inversion_cap ? inversion_cap * 2 : 256;
+         inversions = realloc(inversions, inversion_cap * sizeof(inversion_t));
+         if (inversions == NULL) {
+             fprintf(stderr, "trace_analyze: out of memory\n");
+             exit(1);
+         }
+     }
+     inversions[inversion_count++] = *inv;
+     inv_open[h] = 0;
+ }
+
+ /**
+  * Annotate a chunk with mutex owners and track inversions
+  */
+ static void annotate(chunk_t* chunk) {
+     for (uint32_t i = 0; i < chunk->count; i++) {
+         const trace_event_t* ev = &chunk->events[i];
+
+         inversion_advance(ev->timestamp_us);
+         chunk->owners[i] = TRACE_NO_TASK;
+
+         switch (ev->type) {
+             case TRACE_SWITCH:
+                 prod_running = ev->task;
+                 break;
+
+             case TRACE_MUTEX_LOCK:
+                 *owner_slot(ev->object) = ev->task;
+                 break;
+
+             case TRACE_MUTEX_UNLOCK:
+                 *owner_slot(ev->object) = TRACE_NO_TASK;
+                 break;
+
+             case TRACE_BLOCK:
+                 if (ev->arg == BLOCK_REASON_MUTEX && ev->task != TRACE_NO_TASK) {
+                     uint8_t owner = *owner_slot(ev->object);
+                     chunk->owners[i] = owner;
+                     if (owner != TRACE_NO_TASK &&
+                         task_priority(owner) > task_priority(ev->task)) {
+                         inversion_t* inv = &open_inv[ev->task];
+                         memset(inv, 0, sizeof(*inv));
+                         inv->high = ev->task;
+                         inv->owner = owner;
+                         inv->start = ev->timestamp_us;
+                         inv_open[ev->task] = 1;
+                     }
+                 }
+                 break;
+
+             case TRACE_UNBLOCK:
+                 if (ev->task != TRACE_NO_TASK && inv_open[ev->task]) {
+                     inversion_close(ev->task, ev->timestamp_us);
+                 }
+                 break;
+
+             default:
+                 break;
+         }
+     }
+ }
+
+ /* ------------------------------------------------------------------ */
+ /* Workers: per-task job reconstruction                                */
+ /* ------------------------------------------------------------------ */
+
+ /**
+  * Histogram bin of a response time (eight bins per power of two)
+  */
+ static int hist_bin(uint64_t us) {
+     if (us < 8) {
+         return (int)us;
+     }
+
+     int log2 = 63 - __builtin_clzll(us);
+     int sub = (int)((us >> (log2 - 3)) & 7);
+     int bin = (log2 - 2) * 8 + sub;
+
+     return (bin < HIST_BINS) ? bin : HIST_BINS - 1;
+ }
+
+ /**
+  * Lower bound of a histogram bin
+  */
+ static uint64_t hist_value(int bin) {
+     if (bin < 8) {
+         return (uint64_t)bin;
+     }
+
+     int log2 = bin / 8 + 2;
+     return ((uint64_t)(8 + bin % 8)) << (log2 - 3);
+ }
+
+ /**
+  * Charge the time since the last mark to the current phase
+  */
+ static void charge(job_state_t* t, uint8_t id, uint8_t running, uint64_t now) {
+     uint64_t dt = now - t->mark;
+     t->mark = now;
+
+     /* Waiting while still marked as running is the switch itself */
+     if (running == id) {
+         running = TRACE_NO_TASK;
+     }
+
+     if (!t->in_job || dt == 0) {
+         return;
+     }
+
+     switch (t->phase) {
+         case PHASE_RUNNING:
+             t->job.exec += dt;
+             break;
+         case PHASE_READY:
+             t->job.ready_by[running] += dt;
+             break;
+         case PHASE_BLOCKED:
+             if (t->reason == BLOCK_REASON_MUTEX) {
+                 t->job.mutex_by[running] += dt;
+             }
+             t->job.blocked[t->reason < NUM_REASONS ? t->reason : NUM_REASONS - 1] += dt;
+             break;
+         default:
+             break;
+     }
+ }
+
+ /**
+  * Add one breakdown to another
+  */
+ static void breakdown_add(breakdown_t* dst, const breakdown_t* src) {
+     dst->exec += src->exec;
+     for (int i = 0; i < MAX_IDS; i++) {
+         dst->ready_by[i] += src->ready_by[i];
+         dst->mutex_by[i] += src->mutex_by[i];
+     }
+     for (int i = 0; i < NUM_REASONS; i++) {
+         dst->blocked[i] += src->blocked[i];
+     }
+ }
+
+ /**
+  * Start a job
+  */
+ static void job_start(uint8_t id, uint64_t now) {
+     job_state_t* t = &tasks[id];
+
+     memset(&t->job, 0, sizeof(t->job));
+     t->in_job = 1;
+     t->release = now;
+     t->mark = now;
+     t->deadline = 0;
+     if (known[id] && infos[id].deadline > 0) {
+         t->deadline = now + (uint64_t)infos[id].deadline * header.tick_us;
+     }
+ }
+
+ /**
+  * Finish a job and fold it into the task statistics
+  */
+ static void job_end(uint8_t id, uint64_t now) {
+     job_state_t* t = &tasks[id];
+     uint64_t response = now - t->release;
+
+     t->jobs++;
+     t->total_response += response;
+     t->hist[hist_bin(response)]++;
+     if (t->deadline != 0 && now > t->deadline) {
+         t->misses++;
+     }
+     if (response >= t->worst_response) {
+         t->worst_response = response;
+         t->worst_release = t->release;
+         t->worst = t->job;
+     }
+     breakdown_add(&t->total, &t->job);
+     t->in_job = 0;
+ }
+
+ /**
+  * Does a block end the current job?
+  * Periodic jobs end when they wait for the next period; aperiodic jobs
+  * end at any wait other than a mutex, which is part of the job's work.
+  */
+ static int block_ends_job(uint8_t id, uint8_t reason) {
+     if (known[id] && infos[id].period > 0) {
+         return reason == BLOCK_REASON_DELAY || reason == BLOCK_REASON_NONE;
+     }
+     return reason != BLOCK_REASON_MUTEX;
+ }
+
+ /**
+  * Process one chunk for the tasks owned by a worker
+  */
+ static void worker_process(worker_t* w, const chunk_t* chunk) {
+     for (uint32_t i = 0; i < chunk->count; i++) {
+         const trace_event_t* ev = &chunk->events[i];
+         uint64_t now = ev->timestamp_us;
+         uint8_t id = ev->task;
+
+         if (ev->type == TRACE_SWITCH) {
+             /* Close the interval for every owned task that is waiting,
+                since the task charged for it changes now */
+             for (int t = w->index; t < MAX_IDS; t += num_workers) {
+                 if (tasks[t].in_job) {
+                     charge(&tasks[t], (uint8_t)t, w->running, now);
+                 }
+             }
+             uint8_t prev = ev->arg;
+             if (prev != TRACE_NO_TASK && prev % num_workers == w->index &&
+                 tasks[prev].phase == PHASE_RUNNING) {
+                 tasks[prev].phase = PHASE_READY;
+             }
+             if (id != TRACE_NO_TASK && id % num_workers == w->index) {
+                 tasks[id].phase = PHASE_RUNNING;
+                 if (!tasks[id].in_job && !(known[id] && infos[id].period > 0)) {
+                     job_start(id, now);
+                 }
+             }
+             w->running = id;
+             continue;
+         }
+
+         if (id == TRACE_NO_TASK || id % num_workers != w->index) {
+             continue;
+         }
+
+         job_state_t* t = &tasks[id];
+         charge(t, id, w->running, now);
+
+         switch (ev->type) {
+             case TRACE_RELEASE:
+                 if (t->in_job) {
+                     job_end(id, now);  /* Overran into the next period */
+                 }
+                 job_start(id, now);
+                 break;
+
+             case TRACE_BLOCK:
+                 t->phase = PHASE_BLOCKED;
+                 t->reason = ev->arg;
+                 t->owner = chunk->owners[i];
+                 if (ev->arg == BLOCK_REASON_MUTEX) {
+                     t->job.mutex_owner = t->owner;
+                 }
+                 if (t->in_job && block_ends_job(id, ev->arg)) {
+                     job_end(id, now);
+                     t->phase = PHASE_IDLE;
+                 }
+                 break;
+
+             case TRACE_UNBLOCK:
+                 t->phase = PHASE_READY;
+                 if (!t->in_job && !(known[id] && infos[id].period > 0)) {
+                     job_start(id, now);
+                 }
+                 break;
+
+             default:
+                 break;
+         }
+     }
+ }
+
+ /**
+  * Worker thread: consume chunks in order until the producer finishes
+  */
+ static void* worker_main(void* arg) {
+     worker_t* w = (worker_t*)arg;
+     uint64_t next = 0;
+
+     w->running = TRACE_NO_TASK;
+
+     for (;;) {
+         pthread_mutex_lock(&lock);
+         while (next >= published && !finished) {
+             pthread_cond_wait(&cond, &lock);
+         }
+         if (next >= published) {
+             pthread_mutex_unlock(&lock);
+             break;
+         }
+         chunk_t* chunk = &slots[next % CHUNK_SLOTS];
+         pthread_mutex_unlock(&lock);
+
+         worker_process(w, chunk);
+
+         pthread_mutex_lock(&lock);
+         if (--chunk->refs == 0) {
+             pthread_cond_broadcast(&cond);
+         }
+         pthread_mutex_unlock(&lock);
+         next++;
+     }
+
+     return NULL;
+ }
+
+ /* ------------------------------------------------------------------ */
+ /* Reports                                                             */
+ /* ------------------------------------------------------------------ */
+
+ /* Ranked cause of lost time */
+ typedef struct {
+     uint8_t victim;
+     uint8_t by;                  /* Task charged, TRACE_NO_TASK for the switch itself */
+     uint8_t blocked;             /* kind is a block reason, not a task relation */
+     const char* kind;
+     uint64_t time;
+ } cause_t;
+
+ /**
+  * Descending order by time
+  */
+ static int cause_cmp(const void* a, const void* b) {
+     uint64_t ta = ((const cause_t*)a)->time;
+     uint64_t tb = ((const cause_t*)b)->time;
+     return (ta < tb) - (ta > tb);
+ }
+
+ /**
+  * Descending order by unbounded time, then duration
+  */
+ static int inversion_cmp(const void* a, const void* b) {
+     const inversion_t* x = (const inversion_t*)a;
+     const inversion_t* y = (const inversion_t*)b;
+     if (x->unbounded != y->unbounded) {
+         return (x->unbounded < y->unbounded) - (x->unbounded > y->unbounded);
+     }
+     return (x->duration < y->duration) - (x->duration > y->duration);
+ }
+
+ /**
+  * Percentile estimate from a task's histogram
+  */
+ static uint64_t percentile(const job_state_t* t, double p) {
+     uint64_t target = (uint64_t)(p * (double)t->jobs);
+     uint64_t seen = 0;
+
+     for (int b = 0; b < HIST_BINS; b++) {
+         seen += t->hist[b];
+         if (seen > target) {
+             return hist_value(b);
+         }
+     }
+     return t->worst_response;
+ }
+
+ /**
+  * Descending order of task ids by worst response relative to deadline
+  */
+ static int task_rank_cmp(const void* a, const void* b) {
+     const job_state_t* x = &tasks[*(const uint8_t*)a];
+     const job_state_t* y = &tasks[*(const uint8_t*)b];
+     if (x->misses != y->misses) {
+         return (x->misses < y->misses) - (x->misses > y->misses);
+     }
+     return (x->worst_response < y->worst_response) - (x->worst_response > y->worst_response);
+ }
+
+ /**
+  * Print the critical path of a task's worst job
+  */
+ static void print_critical_path(uint8_t id) {
+     const job_state_t* t = &tasks[id];
+     cause_t parts[2 * MAX_IDS + NUM_REASONS];
+     int n = 0;
+
+     printf("  %s: worst job released at %.3f ms, response %.3f ms\n",
+            task_name(id), t->worst_release / 1000.0, t->worst_response / 1000.0);
+     printf("    %-44s %10.3f ms\n", "executing", t->worst.exec / 1000.0);
+
+     for (int r = 0; r < MAX_IDS; r++) {
+         if (t->worst.ready_by[r] > 0) {
+             parts[n++] = (cause_t){ id, (uint8_t)r, 0, "preempted by", t->worst.ready_by[r] };
+         }
+         if (t->worst.mutex_by[r] > 0) {
+             parts[n++] = (cause_t){ id, (uint8_t)r, 0,
+                                     (r == t->worst.mutex_owner) ? "mutex wait, owner running:" :
+                                                                   "mutex wait, owner displaced by",
+                                     t->worst.mutex_by[r] };
+         }
+     }
+     for (int reason = 0; reason < NUM_REASONS; reason++) {
+         if (reason != BLOCK_REASON_MUTEX && t->worst.blocked[reason] > 0) {
+             parts[n++] = (cause_t){ id, TRACE_NO_TASK, 1, reason_names[reason], t->worst.blocked[reason] };
+         }
+     }
+
+     qsort(parts, (size_t)n, sizeof(cause_t), cause_cmp);
+     for (int i = 0; i < n; i++) {
+         char label[64];
+         if (parts[i].by == TRACE_NO_TASK && !parts[i].blocked) {
+             snprintf(label, sizeof(label), "context switch");
+         } else if (!parts[i].blocked) {
+             snprintf(label, sizeof(label), "%s %s", parts[i].kind, task_name(parts[i].by));
+         } else {
+             snprintf(label, sizeof(label), "blocked on %s", parts[i].kind);
+         }
+         printf("    %-44s %10.3f ms\n", label, parts[i].time / 1000.0);
+     }
+ }
+
+ /**
+  * Print all reports
+  */
+ static void report(uint64_t events) {
+     uint8_t order[MAX_IDS];
+     int count = 0;
+
+     for (int id = 0; id < MAX_IDS; id++) {
+         if (tasks[id].jobs > 0) {
+             order[count++] = (uint8_t)id;
+         }
+     }
+     qsort(order, (size_t)count, sizeof(uint8_t), task_rank_cmp);
+
+     printf("=== Trace analysis: %llu events, %d tasks with jobs ===\n\n",
+            (unsigned long long)events, count);
+
+     printf("Response times (ranked by deadline misses, then worst response)\n");
+     printf("  %-16s %8s %7s %10s %10s %10s %10s\n",
+            "task", "jobs", "misses", "avg ms", "p99 ms", "worst ms", "deadline");
+     for (int i = 0; i < count; i++) {
+         const job_state_t* t = &tasks[order[i]];
+         double deadline = known[order[i]] ? infos[order[i]].deadline * header.tick_us / 1000.0 : 0.0;
+         printf("  %-16s %8llu %7llu %10.3f %10.3f %10.3f %10.3f\n",
+                task_name(order[i]), (unsigned long long)t->jobs, (unsigned long long)t->misses,
+                t->total_response / 1000.0 / (double)t->jobs,
+                percentile(t, 0.99) / 1000.0, t->worst_response / 1000.0, deadline);
+     }
+
+     /* Blocking by cause across all jobs */
+     size_t cap = (size_t)count * (2 * MAX_IDS + NUM_REASONS);
+     cause_t* causes = malloc((cap > 0 ? cap : 1) * sizeof(cause_t));
+     size_t n = 0;
+     if (causes == NULL) {
+         fprintf(stderr, "trace_analyze: out of memory\n");
+         exit(1);
+     }
+     for (int i = 0; i < count; i++) {
+         const breakdown_t* b = &tasks[order[i]].total;
+         for (int r = 0; r < MAX_IDS; r++) {
+             if (b->ready_by[r] > 0) {
+                 causes[n++] = (cause_t){ order[i], (uint8_t)r, 0, "preempted by", b->ready_by[r] };
+             }
+             if (b->mutex_by[r] > 0) {
+                 causes[n++] = (cause_t){ order[i], (uint8_t)r, 0, "mutex wait while running:", b->mutex_by[r] };
+             }
+         }
+         for (int reason = 0; reason < NUM_REASONS; reason++) {
+             if (reason != BLOCK_REASON_MUTEX && reason != BLOCK_REASON_DELAY && b->blocked[reason] > 0) {
+                 causes[n++] = (cause_t){ order[i], TRACE_NO_TASK, 1, reason_names[reason], b->blocked[reason] };
+             }
+         }
+     }
+     qsort(causes, n, sizeof(cause_t), cause_cmp);
+
+     printf("\nTop blocking causes (time jobs spent off the CPU)\n");
+     for (size_t i = 0; i < n && i < (size_t)top_n; i++) {
+         char label[64];
+         if (causes[i].by == TRACE_NO_TASK && !causes[i].blocked) {
+             snprintf(label, sizeof(label), "context switch");
+         } else if (!causes[i].blocked) {
+             snprintf(label, sizeof(label), "%s %s", causes[i].kind, task_name(causes[i].by));
+         } else {
+             snprintf(label, sizeof(label), "blocked on %s", causes[i].kind);
+         }
+         printf("  %-16s %-44s %10.3f ms\n", task_name(causes[i].victim), label, causes[i].time / 1000.0);
+     }
+     free(causes);
+
+     /* Priority inversions */
+     qsort(inversions, inversion_count, sizeof(inversion_t), inversion_cmp);
+     printf("\nPriority inversions: %zu intervals (ranked by unbounded time)\n", inversion_count);
+     for (size_t i = 0; i < inversion_count && i < (size_t)top_n; i++) {
+         const inversion_t* inv = &inversions[i];
+         printf("  at %10.3f ms: %-12s waited %8.3f ms on %-12s unbounded %8.3f ms",
+                inv->start / 1000.0, task_name(inv->high), inv->duration / 1000.0,
+                task_name(inv->owner), inv->unbounded / 1000.0);
+         if (inv->worst_intruder != TRACE_NO_TASK) {
+             printf(" (mostly %s)", task_name(inv->worst_intruder));
+         }
+         printf("\n");
+     }
+
+     /* Critical paths */
+     printf("\nCritical paths of worst jobs\n");
+     for (int i = 0; i < count && i < top_n; i++) {
+         print_critical_path(order[i]);
+     }
+ }
+
+ /* ------------------------------------------------------------------ */
+ /* Main                                                                */
+ /* ------------------------------------------------------------------ */
+
+ /**
+  * Read the header and task table
+  */
+ static int read_header(FILE* in) {
+     if (fread(&header, sizeof(header), 1, in) != 1 ||
+         header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+         fprintf(stderr, "trace_analyze: not a version %d trace file\n", TRACE_VERSION);
+         return -1;
+     }
+
+     for (uint32_t i = 0; i < header.task_count; i++) {
+         trace_task_info_t info;
+         if (fread(&info, sizeof(info), 1, in) != 1) {
+             fprintf(stderr, "trace_analyze: truncated task table\n");
+             return -1;
+         }
+         info.name[MAX_TASK_NAME_LEN - 1] = '\0';
+         infos[info.id] = info;
+         known[info.id] = 1;
+     }
+
+     return 0;
+ }
+
+ /**
+  * Main entry point
+  */
+ int main(int argc, char* argv[]) {
+     worker_t workers[MAX_THREADS];
+     int opt;
+
+     while ((opt = getopt(argc, argv, "j:n:c:")) != -1) {
+         switch (opt) {
+             case 'j': num_workers = atoi(optarg); break;
+             case 'n': top_n = atoi(optarg); break;
+             case 'c': chunk_events = (uint32_t)strtoul(optarg, NULL, 0); break;
+             default:
+                 fprintf(stderr, "Usage: %s [-j threads] [-n top] [-c chunk_events] <trace>\n", argv[0]);
+                 return 1;
+         }
+     }
+
+     if (optind != argc - 1 || chunk_events == 0 || top_n <= 0) {
+         fprintf(stderr, "Usage: %s [-j threads] [-n top] [-c chunk_events] <trace>\n", argv[0]);
+         return 1;
+     }
+
+     if (num_workers <= 0) {
+         long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+         num_workers = (cpus > 0) ? (int)cpus : 1;
+     }
+     if (num_workers > MAX_THREADS) {
+         num_workers = MAX_THREADS;
+     }
+
+     FILE* in = fopen(argv[optind], "rb");
+     if (in == NULL) {
+         fprintf(stderr, "trace_analyze: cannot open %s\n", argv[optind]);
+         return 1;
+     }
+     if (read_header(in) != 0) {
+         fclose(in);
+         return 1;
+     }
+
+     for (int i = 0; i < CHUNK_SLOTS; i++) {
+         slots[i].events = malloc(chunk_events * sizeof(trace_event_t));
+         slots[i].owners = malloc(chunk_events);
+         if (slots[i].events == NULL || slots[i].owners == NULL) {
+             fprintf(stderr, "trace_analyze: out of memory\n");
+             return 1;
+         }
+     }
+
+     for (int i = 0; i < num_workers; i++) {
+         workers[i].index = i;
+         pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+     }
+
+     /* Producer: read, annotate and publish chunks in order */
+     uint64_t total = 0;
+     for (uint64_t seq = 0;; seq++) {
+         chunk_t* chunk = &slots[seq % CHUNK_SLOTS];
+
+         pthread_mutex_lock(&lock);
+         while (chunk->refs > 0) {
+             pthread_cond_wait(&cond, &lock);
+         }
+         pthread_mutex_unlock(&lock);
+
+         chunk->count = (uint32_t)fread(chunk->events, sizeof(trace_event_t), chunk_events, in);
+         if (chunk->count == 0) {
+             break;
+         }
+         total += chunk->count;
+         annotate(chunk);
+
+         pthread_mutex_lock(&lock);
+         chunk->refs = num_workers;
+         published = seq + 1;
+         pthread_cond_broadcast(&cond);
+         pthread_mutex_unlock(&lock);
+     }
+
+     pthread_mutex_lock(&lock);
+     finished = 1;
+     pthread_cond_broadcast(&cond);
+     pthread_mutex_unlock(&lock);
+
+     for (int i = 0; i < num_workers; i++) {
+         pthread_join(workers[i].thread, NULL);
+     }
+     fclose(in);
+
+     report(total);
+
+     for (int i = 0; i < CHUNK_SLOTS; i++) {
+         free(slots[i].events);
+         free(slots[i].owners);
+     }
+     free(inversions);
+
+     return 0;
+ }